@@ -52,6 +52,7 @@
 #include <private/qqmltypeloader_p.h>
 #include <private/qqmlengine_p.h>
 #include <private/qqmlcompiler_p.h>
+#include <QMutex>
 #endif
 
 #ifdef CONST
@@ -1799,6 +1800,7 @@ static void initMetaObjectResolver(QV4::IR::MemberExpressionResolver *resolver,
 
 static QV4::IR::Type resolveQmlType(QQmlEnginePrivate *qmlEngine, QV4::IR::MemberExpressionResolver *resolver, QV4::IR::Member *member)
 {
+    QMutexLocker locker(&qmlEngine->memberResolutionMutex);
     QV4::IR::Type result = QV4::IR::VarType;
 
     QQmlType *type = static_cast<QQmlType*>(resolver->data);
@@ -1840,8 +1842,9 @@ static void initQmlTypeResolver(QV4::IR::MemberExpressionResolver *resolver, QQm
     resolver->flags = 0;
 }
 
-static QV4::IR::Type resolveImportNamespace(QQmlEnginePrivate *, QV4::IR::MemberExpressionResolver *resolver, QV4::IR::Member *member)
+static QV4::IR::Type resolveImportNamespace(QQmlEnginePrivate *qmlEngine, QV4::IR::MemberExpressionResolver *resolver, QV4::IR::Member *member)
 {
+    QMutexLocker locker(&qmlEngine->memberResolutionMutex);
     QV4::IR::Type result = QV4::IR::VarType;
     QQmlTypeNameCache *typeNamespace = static_cast<QQmlTypeNameCache*>(resolver->extraData);
     void *importNamespace = resolver->data;
@@ -1879,6 +1882,7 @@ static void initImportNamespaceResolver(QV4::IR::MemberExpressionResolver *resol
 
 static QV4::IR::Type resolveMetaObjectProperty(QQmlEnginePrivate *qmlEngine, QV4::IR::MemberExpressionResolver *resolver, QV4::IR::Member *member)
 {
+    QMutexLocker locker(qmlEngine ? &qmlEngine->memberResolutionMutex : 0);
     QV4::IR::Type result = QV4::IR::VarType;
     QQmlPropertyCache *metaObject = static_cast<QQmlPropertyCache*>(resolver->data);
 
@@ -225,8 +225,11 @@ bool QQmlTypeCompiler::compile()
 
         QV4::ExecutionEngine *v4 = engine->v4engine();
         QScopedPointer<QV4::EvalInstructionSelection> isel(v4->iselFactory->create(engine, v4->executableAllocator, &document->jsModule, &document->jsGenerator));
-        isel->setUseFastLookups(false);
         document->javaScriptCompilationUnit = isel->compile(/*generated unit data*/false);
+        // The member resolvers in the IR of QML documents call into the engine, and the IR
+        // is released together with the compiled data.
+        if (QV4::RecompilationData *recompilationData = document->javaScriptCompilationUnit->recompilationData)
+            recompilationData->backgroundRecompilation = false;
     }
 
     // Generate QML compiled type data structures
@@ -48,9 +48,11 @@
 #include <private/qv4objectproto_p.h>
 #include <private/qv4lookup_p.h>
 #include <private/qv4regexpobject_p.h>
+#include <private/qv4isel_p.h>
 #endif
 #include <private/qqmlirbuilder_p.h>
 #include <QCoreApplication>
+#include <QFile>
 
 #include <algorithm>
 
@@ -64,6 +66,7 @@ namespace CompiledData {
 CompilationUnit::~CompilationUnit()
 {
     unlink();
+    delete recompilationData;
 }
 
 QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
@@ -76,23 +79,14 @@ QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
     runtimeStrings = (QV4::StringValue *)malloc(data->stringTableSize * sizeof(QV4::StringValue));
     // memset the strings to 0 in case a GC run happens while we're within the loop below
     memset(runtimeStrings, 0, data->stringTableSize * sizeof(QV4::StringValue));
-    for (uint i = 0; i < data->stringTableSize; ++i)
-        runtimeStrings[i] = engine->newIdentifier(data->stringAt(i));
+    if (!resolvesRuntimeStringsLazily()) {
+        for (uint i = 0; i < data->stringTableSize; ++i)
+            resolveRuntimeString(i);
+    }
 
     runtimeRegularExpressions = new QV4::Value[data->regexpTableSize];
-    // memset the regexps to 0 in case a GC run happens while we're within the loop below
-    memset(runtimeRegularExpressions, 0, data->regexpTableSize * sizeof(QV4::Value));
-    for (uint i = 0; i < data->regexpTableSize; ++i) {
-        const CompiledData::RegExp *re = data->regexpAt(i);
-        int flags = 0;
-        if (re->flags & CompiledData::RegExp::RegExp_Global)
-            flags |= IR::RegExp::RegExp_Global;
-        if (re->flags & CompiledData::RegExp::RegExp_IgnoreCase)
-            flags |= IR::RegExp::RegExp_IgnoreCase;
-        if (re->flags & CompiledData::RegExp::RegExp_Multiline)
-            flags |= IR::RegExp::RegExp_Multiline;
-        runtimeRegularExpressions[i] = engine->newRegExpObject(data->stringAt(re->stringIndex), flags);
-    }
+    for (uint i = 0; i < data->regexpTableSize; ++i)
+        runtimeRegularExpressions[i] = QV4::Primitive::emptyValue();
 
     if (data->lookupTableSize) {
         runtimeLookups = new QV4::Lookup[data->lookupTableSize];
@@ -117,12 +111,15 @@ QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
                 l->classList[j] = 0;
             l->level = -1;
             l->index = UINT_MAX;
-            l->name = runtimeStrings[compiledLookups[i].nameIndex].asString();
+            l->name = runtimeString(compiledLookups[i].nameIndex).asString();
             if (type == CompiledData::Lookup::Type_IndexedGetter || type == CompiledData::Lookup::Type_IndexedSetter)
                 l->engine = engine;
         }
     }
 
+    if (recompilationData && recompilationData->typeFeedbackSlotCount)
+        runtimeTypeFeedback = (uchar *)calloc(recompilationData->typeFeedbackSlotCount, sizeof(uchar));
+
     if (data->jsClassTableSize) {
         runtimeClasses = (QV4::InternalClass**)malloc(data->jsClassTableSize * sizeof(QV4::InternalClass*));
 
@@ -131,7 +128,7 @@ QV4::Function *CompilationUnit::linkToEngine(ExecutionEngine *engine)
             const CompiledData::JSClassMember *member = data->jsClassAt(i, &memberCount);
             QV4::InternalClass *klass = engine->objectClass;
             for (int j = 0; j < memberCount; ++j, ++member)
-                klass = klass->addMember(runtimeStrings[member->nameOffset].asString(), member->isAccessor ? QV4::Attr_Accessor : QV4::Attr_Data);
+                klass = klass->addMember(runtimeString(member->nameOffset).asString(), member->isAccessor ? QV4::Attr_Accessor : QV4::Attr_Data);
 
             runtimeClasses[i] = klass;
         }
@@ -156,8 +153,21 @@ void CompilationUnit::unlink()
     if (engine)
         engine->compilationUnits.erase(engine->compilationUnits.find(this));
     engine = 0;
-    if (data && !(data->flags & QV4::CompiledData::Unit::StaticData))
+    if (runtimeLookups) {
+        static const bool showLookupStats = !qgetenv("QV4_LOOKUP_STATS").isEmpty();
+        const CompiledData::Lookup *compiledLookups = data->lookupTable();
+        for (uint i = 0; i < data->lookupTableSize; ++i) {
+            if (showLookupStats)
+                runtimeLookups[i].dumpStatistics(fileName(), data->stringAt(compiledLookups[i].nameIndex));
+            runtimeLookups[i].releaseCaches();
+        }
+    }
+    if (mappedFile) {
+        delete mappedFile;
+        mappedFile = 0;
+    } else if (data && !(data->flags & QV4::CompiledData::Unit::StaticData)) {
         free(data);
+    }
     data = 0;
     free(runtimeStrings);
     runtimeStrings = 0;
@@ -167,10 +177,40 @@ void CompilationUnit::unlink()
     runtimeRegularExpressions = 0;
     free(runtimeClasses);
     runtimeClasses = 0;
+    free(runtimeTypeFeedback);
+    runtimeTypeFeedback = 0;
     qDeleteAll(runtimeFunctions);
     runtimeFunctions.clear();
 }
 
+void CompilationUnit::releaseRecompilationIR()
+{
+    if (recompilationData)
+        recompilationData->module.reset();
+}
+
+void CompilationUnit::resolveRuntimeString(uint index)
+{
+    Q_ASSERT(engine);
+    Q_ASSERT(index < data->stringTableSize);
+    runtimeStrings[index] = engine->newIdentifier(data->stringAt(index));
+}
+
+void CompilationUnit::resolveRuntimeRegularExpression(uint index)
+{
+    Q_ASSERT(engine);
+    Q_ASSERT(index < data->regexpTableSize);
+    const CompiledData::RegExp *re = data->regexpAt(index);
+    int flags = 0;
+    if (re->flags & CompiledData::RegExp::RegExp_Global)
+        flags |= IR::RegExp::RegExp_Global;
+    if (re->flags & CompiledData::RegExp::RegExp_IgnoreCase)
+        flags |= IR::RegExp::RegExp_IgnoreCase;
+    if (re->flags & CompiledData::RegExp::RegExp_Multiline)
+        flags |= IR::RegExp::RegExp_Multiline;
+    runtimeRegularExpressions[index] = engine->newRegExpObject(data->stringAt(re->stringIndex), flags);
+}
+
 void CompilationUnit::markObjects(QV4::ExecutionEngine *e)
 {
     for (uint i = 0; i < data->stringTableSize; ++i)
@@ -50,6 +50,8 @@
 
 QT_BEGIN_NAMESPACE
 
+class QFile;
+
 namespace QmlIR {
 struct Document;
 }
@@ -61,6 +63,7 @@ struct Function;
 
 struct Function;
 struct ExecutionContext;
+struct RecompilationData;
 
 namespace CompiledData {
 
@@ -142,6 +145,16 @@ struct String
 
 static const char magic_str[] = "qv4cdata";
 
+// Bump this whenever the meaning of compiled data or generated byte code changes
+// in a way that the layout of the structures doesn't reveal, so that compilation
+// units cached on disk by an earlier build aren't used.
+enum { DataStructureVersion = 1 };
+
+// Bump this whenever the code generated for the same source changes, for example
+// by a new or modified optimization pass, the inliner, or the binding dependency
+// flags. Like DataStructureVersion it is part of the disk cache build id.
+enum { CompilerRevision = 2 };
+
 struct Unit
 {
     char magic[8];
@@ -226,7 +239,8 @@ struct Function
         UsesArgumentsObject = 0x2,
         IsStrict            = 0x4,
         IsNamedExpression   = 0x8,
-        HasCatchOrWith      = 0x10
+        HasCatchOrWith      = 0x10,
+        HasStaticQmlDependencies = 0x20 // Only depends on the properties in its dependency tables
     };
 
     quint32 index; // in CompilationUnit's function table
@@ -584,6 +598,9 @@ struct Q_QML_PRIVATE_EXPORT CompilationUnit
         , runtimeLookups(0)
         , runtimeRegularExpressions(0)
         , runtimeClasses(0)
+        , mappedFile(0)
+        , recompilationData(0)
+        , runtimeTypeFeedback(0)
     {}
     virtual ~CompilationUnit();
 #endif
@@ -607,15 +624,54 @@ struct Q_QML_PRIVATE_EXPORT CompilationUnit
     QV4::InternalClass **runtimeClasses;
     QVector<QV4::Function *> runtimeFunctions;
 
+    // Set when data points into a memory mapped file, which is then owned by the unit.
+    QFile *mappedFile;
+
+    // Set when the interpreter records type feedback for this unit, see EvalInstructionSelection.
+    RecompilationData *recompilationData;
+    uchar *runtimeTypeFeedback; // Array, one entry per recorded binop
+
+    // Runtime strings and regular expressions are created on first use, unless the
+    // backend accesses them directly from generated code.
+    QV4::StringValue &runtimeString(uint index)
+    {
+        QV4::StringValue &str = runtimeStrings[index];
+        if (Q_UNLIKELY(!str))
+            resolveRuntimeString(index);
+        return str;
+    }
+    QV4::ReturnedValue runtimeRegularExpression(uint index)
+    {
+        if (Q_UNLIKELY(runtimeRegularExpressions[index].isEmpty()))
+            resolveRuntimeRegularExpression(index);
+        return runtimeRegularExpressions[index].asReturnedValue();
+    }
+
     QV4::Function *linkToEngine(QV4::ExecutionEngine *engine);
     void unlink();
 
     virtual QV4::ExecutableAllocator::ChunkOfPages *chunkForFunction(int /*functionIndex*/) { return 0; }
 
+    // Used when a function of another unit was recompiled into this one: makes the function
+    // run the code generated here.
+    virtual void replaceCode(int /*functionIndex*/, QV4::Function * /*runtimeFunction*/) {}
+    // Drops the IR kept for recompiling functions, for when the data it refers to goes away.
+    void releaseRecompilationIR();
+
+    // Used by the disk cache. Only backends that generate position independent
+    // code can save and restore it, the others return false.
+    virtual bool saveBackendCode(QByteArray * /*code*/) const { return false; }
+    virtual bool loadBackendCode(const char * /*code*/, uint /*size*/) { return false; }
+
     void markObjects(QV4::ExecutionEngine *e);
 
 protected:
     virtual void linkBackendToEngine(QV4::ExecutionEngine *engine) = 0;
+    virtual bool resolvesRuntimeStringsLazily() const { return false; }
+
+private:
+    void resolveRuntimeString(uint index);
+    void resolveRuntimeRegularExpression(uint index);
 #endif // V4_BOOTSTRAP
 };
 
@@ -44,6 +44,9 @@
 #include <qv4isel_p.h>
 #include <private/qv4string_p.h>
 #include <private/qv4value_inl_p.h>
+#ifndef V4_BOOTSTRAP
+#include <private/qqmlpropertycache_p.h>
+#endif
 
 QV4::Compiler::StringTableGenerator::StringTableGenerator()
 {
@@ -302,6 +305,79 @@ QV4::CompiledData::Unit *QV4::Compiler::JSUnitGenerator::generateUnit()
     return unit;
 }
 
+#ifndef V4_BOOTSTRAP
+namespace {
+// Operations on values of these types never call back into JavaScript
+bool isPrimitive(const QV4::IR::Expr *e)
+{
+    return e->type != QV4::IR::UnknownType && !(e->type & (QV4::IR::QObjectType | QV4::IR::VarType));
+}
+
+bool isOperand(QV4::IR::Expr *e)
+{
+    return e->asTemp() || e->asConst();
+}
+
+// Whether evaluating e can depend on a QML property that is not in the dependency
+// tables of the function. Anything that may look up names, call functions or read
+// properties of objects other than the scope and context object counts as dynamic.
+bool hasDynamicDependencies(QV4::IR::Expr *e)
+{
+    using namespace QV4::IR;
+
+    if (isOperand(e) || e->asString() || e->asRegExp())
+        return false;
+    if (Name *n = e->asName()) {
+        return n->builtin != Name::builtin_qml_context_object
+                && n->builtin != Name::builtin_qml_scope_object
+                && !(n->id && *n->id == QStringLiteral("this"));
+    }
+    if (Member *m = e->asMember()) {
+        if (!m->property || m->attachedPropertiesIdOrEnumValue != 0)
+            return true;
+        if (m->property->isConstant())
+            return false;
+        return m->kind != Member::MemberOfQmlContextObject && m->kind != Member::MemberOfQmlScopeObject;
+    }
+    if (Unop *u = e->asUnop())
+        return !isOperand(u->expr) || !isPrimitive(u->expr);
+    if (Binop *b = e->asBinop())
+        return !isOperand(b->left) || !isOperand(b->right) || !isPrimitive(b->left) || !isPrimitive(b->right);
+    if (Convert *c = e->asConvert())
+        return !isOperand(c->expr) || !isPrimitive(c->expr);
+    return true;
+}
+
+bool hasStaticQmlDependencies(QV4::IR::Function *irFunction)
+{
+    using namespace QV4::IR;
+
+    if (irFunction->hasDirectEval || irFunction->hasWith)
+        return false;
+
+    foreach (BasicBlock *bb, irFunction->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        foreach (Stmt *s, bb->statements()) {
+            if (Move *move = s->asMove()) {
+                if (!move->target->asTemp() || hasDynamicDependencies(move->source))
+                    return false;
+            } else if (CJump *cjump = s->asCJump()) {
+                if (hasDynamicDependencies(cjump->cond))
+                    return false;
+            } else if (Ret *ret = s->asRet()) {
+                if (!isOperand(ret->expr))
+                    return false;
+            } else if (!s->asJump() && !s->asPhi()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}
+#endif // V4_BOOTSTRAP
+
 int QV4::Compiler::JSUnitGenerator::writeFunction(char *f, int index, QV4::IR::Function *irFunction)
 {
     QV4::CompiledData::Function *function = (QV4::CompiledData::Function *)f;
@@ -321,6 +397,10 @@ int QV4::Compiler::JSUnitGenerator::writeFunction(char *f, int index, QV4::IR::F
         function->flags |= CompiledData::Function::IsNamedExpression;
     if (irFunction->hasTry || irFunction->hasWith)
         function->flags |= CompiledData::Function::HasCatchOrWith;
+#ifndef V4_BOOTSTRAP
+    if (hasStaticQmlDependencies(irFunction))
+        function->flags |= CompiledData::Function::HasStaticQmlDependencies;
+#endif
     function->nFormals = irFunction->formals.size();
     function->formalsOffset = currentOffset;
     currentOffset += function->nFormals * sizeof(quint32);
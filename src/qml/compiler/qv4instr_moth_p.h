@@ -64,6 +64,7 @@ QT_BEGIN_NAMESPACE
     F(StoreName, storeName) \
     F(LoadElement, loadElement) \
     F(LoadElementLookup, loadElementLookup) \
+    F(LoadArrayElement, loadArrayElement) \
     F(StoreElement, storeElement) \
     F(StoreElementLookup, storeElementLookup) \
     F(LoadProperty, loadProperty) \
@@ -99,7 +100,9 @@ QT_BEGIN_NAMESPACE
     F(CallBuiltinDefineArray, callBuiltinDefineArray) \
     F(CallBuiltinDefineObjectLiteral, callBuiltinDefineObjectLiteral) \
     F(CallBuiltinSetupArgumentsObject, callBuiltinSetupArgumentsObject) \
+    F(CallBuiltinArgumentCount, callBuiltinArgumentCount) \
     F(CallBuiltinConvertThisToObject, callBuiltinConvertThisToObject) \
+    F(CallBuiltinIsClosure, callBuiltinIsClosure) \
     F(CreateValue, createValue) \
     F(CreateProperty, createProperty) \
     F(ConstructPropertyLookup, constructPropertyLookup) \
@@ -345,6 +348,12 @@ union Instr
         Param index;
         Param result;
     };
+    struct instr_loadArrayElement {
+        MOTH_INSTR_HEADER
+        Param base;
+        Param index;
+        Param result;
+    };
     struct instr_storeElement {
         MOTH_INSTR_HEADER
         Param base;
@@ -502,9 +511,20 @@ union Instr
         MOTH_INSTR_HEADER
         Param result;
     };
+    struct instr_callBuiltinArgumentCount {
+        MOTH_INSTR_HEADER
+        Param result;
+    };
     struct instr_callBuiltinConvertThisToObject {
         MOTH_INSTR_HEADER
     };
+    struct instr_callBuiltinIsClosure {
+        MOTH_INSTR_HEADER
+        int functionId;
+        int scopeDepth;
+        Param value;
+        Param result;
+    };
     struct instr_createValue {
         MOTH_INSTR_HEADER
         quint32 argc;
@@ -602,12 +622,14 @@ union Instr
         Param lhs;
         Param rhs;
         Param result;
+        int feedbackSlot;
     };
     struct instr_add {
         MOTH_INSTR_HEADER
         Param lhs;
         Param rhs;
         Param result;
+        int feedbackSlot;
     };
     struct instr_bitAnd {
         MOTH_INSTR_HEADER
@@ -674,12 +696,14 @@ union Instr
         Param lhs;
         Param rhs;
         Param result;
+        int feedbackSlot;
     };
     struct instr_sub {
         MOTH_INSTR_HEADER
         Param lhs;
         Param rhs;
         Param result;
+        int feedbackSlot;
     };
     struct instr_binopContext {
         MOTH_INSTR_HEADER
@@ -729,6 +753,7 @@ union Instr
     instr_storeName storeName;
     instr_loadElement loadElement;
     instr_loadElementLookup loadElementLookup;
+    instr_loadArrayElement loadArrayElement;
     instr_storeElement storeElement;
     instr_storeElementLookup storeElementLookup;
     instr_loadProperty loadProperty;
@@ -764,7 +789,9 @@ union Instr
     instr_callBuiltinDefineArray callBuiltinDefineArray;
     instr_callBuiltinDefineObjectLiteral callBuiltinDefineObjectLiteral;
     instr_callBuiltinSetupArgumentsObject callBuiltinSetupArgumentsObject;
+    instr_callBuiltinArgumentCount callBuiltinArgumentCount;
     instr_callBuiltinConvertThisToObject callBuiltinConvertThisToObject;
+    instr_callBuiltinIsClosure callBuiltinIsClosure;
     instr_createValue createValue;
     instr_createProperty createProperty;
     instr_constructPropertyLookup constructPropertyLookup;
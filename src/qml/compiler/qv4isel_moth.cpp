@@ -330,6 +330,30 @@ InstructionSelection::~InstructionSelection()
 {
 }
 
+void InstructionSelection::prepare(int functionIndex)
+{
+    IR::Function *function = irModule->functions[functionIndex];
+
+    IR::Optimizer opt(function);
+    opt.run(qmlEngine);
+    if (opt.isInSSA()) {
+        static const bool doStackSlotAllocation =
+                qgetenv("QV4_NO_INTERPRETER_STACK_SLOT_ALLOCATION").isEmpty();
+
+        if (doStackSlotAllocation) {
+            AllocateStackSlots(opt.lifeTimeIntervals()).forFunction(function);
+        } else {
+            opt.convertOutOfSSA();
+            ConvertTemps().toStackSlots(function);
+        }
+        opt.showMeTheCode(function);
+    } else {
+        ConvertTemps().toStackSlots(function);
+    }
+
+    optionalJumps[functionIndex] = opt.calculateOptionalJumps();
+}
+
 void InstructionSelection::run(int functionIndex)
 {
     IR::Function *function = irModule->functions[functionIndex];
@@ -353,24 +377,7 @@ void InstructionSelection::run(int functionIndex)
     qSwap(codeNext, _codeNext);
     qSwap(codeEnd, _codeEnd);
 
-    IR::Optimizer opt(_function);
-    opt.run(qmlEngine);
-    if (opt.isInSSA()) {
-        static const bool doStackSlotAllocation =
-                qgetenv("QV4_NO_INTERPRETER_STACK_SLOT_ALLOCATION").isEmpty();
-
-        if (doStackSlotAllocation) {
-            AllocateStackSlots(opt.lifeTimeIntervals()).forFunction(_function);
-        } else {
-            opt.convertOutOfSSA();
-            ConvertTemps().toStackSlots(_function);
-        }
-        opt.showMeTheCode(_function);
-    } else {
-        ConvertTemps().toStackSlots(_function);
-    }
-
-    QSet<IR::Jump *> removableJumps = opt.calculateOptionalJumps();
+    QSet<IR::Jump *> removableJumps = optionalJumps.at(functionIndex);
     qSwap(_removableJumps, removableJumps);
 
     IR::Stmt *cs = 0;
@@ -472,7 +479,7 @@ void InstructionSelection::callProperty(IR::Expr *base, const QString &name, IR:
     if (useFastLookups) {
         Instruction::CallPropertyLookup call;
         call.base = getParam(base);
-        call.lookupIndex = registerGetterLookup(name);
+        call.lookupIndex = registerGetterLookup(name, _lookupSite);
         prepareCallArgs(args, call.argc);
         call.callData = callDataStart();
         call.result = getResultParam(result);
@@ -517,7 +524,7 @@ void InstructionSelection::constructActivationProperty(IR::Name *func,
 {
     if (useFastLookups && func->global) {
         Instruction::ConstructGlobalLookup call;
-        call.index = registerGlobalGetterLookup(*func->id);
+        call.index = registerGlobalGetterLookup(*func->id, _lookupSite);
         prepareCallArgs(args, call.argc);
         call.callData = callDataStart();
         call.result = getResultParam(result);
@@ -537,7 +544,7 @@ void InstructionSelection::constructProperty(IR::Temp *base, const QString &name
     if (useFastLookups) {
         Instruction::ConstructPropertyLookup call;
         call.base = getParam(base);
-        call.index = registerGetterLookup(name);
+        call.index = registerGetterLookup(name, _lookupSite);
         prepareCallArgs(args, call.argc);
         call.callData = callDataStart();
         call.result = getResultParam(result);
@@ -636,7 +643,7 @@ void InstructionSelection::getActivationProperty(const IR::Name *name, IR::Temp
 {
     if (useFastLookups && name->global) {
         Instruction::GetGlobalLookup load;
-        load.index = registerGlobalGetterLookup(*name->id);
+        load.index = registerGlobalGetterLookup(*name->id, _lookupSite);
         load.result = getResultParam(temp);
         addInstruction(load);
         return;
@@ -669,7 +676,7 @@ void InstructionSelection::getProperty(IR::Expr *base, const QString &name, IR::
     if (useFastLookups) {
         Instruction::GetLookup load;
         load.base = getParam(base);
-        load.index = registerGetterLookup(name);
+        load.index = registerGetterLookup(name, _lookupSite);
         load.result = getResultParam(target);
         addInstruction(load);
         return;
@@ -687,7 +694,7 @@ void InstructionSelection::setProperty(IR::Expr *source, IR::Expr *targetBase,
     if (useFastLookups) {
         Instruction::SetLookup store;
         store.base = getParam(targetBase);
-        store.index = registerSetterLookup(targetName);
+        store.index = registerSetterLookup(targetName, _lookupSite);
         store.source = getParam(source);
         addInstruction(store);
         return;
@@ -728,9 +735,20 @@ void InstructionSelection::getQObjectProperty(IR::Expr *base, int propertyIndex,
 
 void InstructionSelection::getElement(IR::Expr *base, IR::Expr *index, IR::Temp *target)
 {
+    if (index->type & IR::NumberType) {
+        // Numeric subscripts are almost always reads from dense arrays (typically
+        // indexed by a loop counter), so use the guarded direct read.
+        Instruction::LoadArrayElement load;
+        load.base = getParam(base);
+        load.index = getParam(index);
+        load.result = getResultParam(target);
+        addInstruction(load);
+        return;
+    }
+
     if (useFastLookups) {
         Instruction::LoadElementLookup load;
-        load.lookup = registerIndexedGetterLookup();
+        load.lookup = registerIndexedGetterLookup(_lookupSite);
         load.base = getParam(base);
         load.index = getParam(index);
         load.result = getResultParam(target);
@@ -749,7 +767,7 @@ void InstructionSelection::setElement(IR::Expr *source, IR::Expr *targetBase,
 {
     if (useFastLookups) {
         Instruction::StoreElementLookup store;
-        store.lookup = registerIndexedSetterLookup();
+        store.lookup = registerIndexedSetterLookup(_lookupSite);
         store.base = getParam(targetBase);
         store.index = getParam(targetIndex);
         store.source = getParam(source);
@@ -870,6 +888,7 @@ Param InstructionSelection::binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR
         add.lhs = getParam(leftSource);
         add.rhs = getParam(rightSource);
         add.result = getResultParam(target);
+        add.feedbackSlot = _feedbackSlot;
         addInstruction(add);
         return add.result;
     }
@@ -878,6 +897,7 @@ Param InstructionSelection::binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR
         sub.lhs = getParam(leftSource);
         sub.rhs = getParam(rightSource);
         sub.result = getResultParam(target);
+        sub.feedbackSlot = _feedbackSlot;
         addInstruction(sub);
         return sub.result;
     }
@@ -886,6 +906,7 @@ Param InstructionSelection::binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR
         mul.lhs = getParam(leftSource);
         mul.rhs = getParam(rightSource);
         mul.result = getResultParam(target);
+        mul.feedbackSlot = _feedbackSlot;
         addInstruction(mul);
         return mul.result;
     }
@@ -996,6 +1017,7 @@ Param InstructionSelection::binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR
         binop.lhs = getParam(leftSource);
         binop.rhs = getParam(rightSource);
         binop.result = getResultParam(target);
+        binop.feedbackSlot = _feedbackSlot;
         Q_ASSERT(binop.alu);
         addInstruction(binop);
         return binop.result;
@@ -1062,6 +1084,7 @@ void InstructionSelection::visitCJump(IR::CJump *s)
     if (IR::Temp *t = s->cond->asTemp()) {
         condition = getResultParam(t);
     } else if (IR::Binop *b = s->cond->asBinop()) {
+        _feedbackSlot = b->feedbackSlot;
         condition = binopHelper(b->op, b->left, b->right, /*target*/0);
     } else {
         Q_UNIMPLEMENTED();
@@ -1107,7 +1130,7 @@ void InstructionSelection::callBuiltinInvalid(IR::Name *func, IR::ExprList *args
 {
     if (useFastLookups && func->global) {
         Instruction::CallGlobalLookup call;
-        call.index = registerGlobalGetterLookup(*func->id);
+        call.index = registerGlobalGetterLookup(*func->id, _lookupSite);
         prepareCallArgs(args, call.argc);
         call.callData = callDataStart();
         call.result = getResultParam(result);
@@ -1404,6 +1427,13 @@ void InstructionSelection::callBuiltinSetupArgumentObject(IR::Temp *result)
     addInstruction(call);
 }
 
+void InstructionSelection::callBuiltinArgumentCount(IR::Temp *result)
+{
+    Instruction::CallBuiltinArgumentCount call;
+    call.result = getResultParam(result);
+    addInstruction(call);
+}
+
 
 void QV4::Moth::InstructionSelection::callBuiltinConvertThisToObject()
 {
@@ -1411,6 +1441,16 @@ void QV4::Moth::InstructionSelection::callBuiltinConvertThisToObject()
     addInstruction(call);
 }
 
+void InstructionSelection::callBuiltinIsClosure(IR::Expr *value, int functionId, int scopeDepth, IR::Temp *result)
+{
+    Instruction::CallBuiltinIsClosure call;
+    call.functionId = functionId;
+    call.scopeDepth = scopeDepth;
+    call.value = getParam(value);
+    call.result = getResultParam(result);
+    addInstruction(call);
+}
+
 ptrdiff_t InstructionSelection::addInstructionHelper(Instr::Type type, Instr &instr)
 {
 
@@ -1508,3 +1548,109 @@ void CompilationUnit::linkBackendToEngine(QV4::ExecutionEngine *engine)
         runtimeFunctions[i] = runtimeFunction;
     }
 }
+
+namespace {
+
+#ifdef MOTH_THREADED_INTERPRETER
+#define MOTH_INSTR_COUNT(I, FMT) + 1
+enum { InstructionCount = 0 FOR_EACH_MOTH_INSTR(MOTH_INSTR_COUNT) };
+#undef MOTH_INSTR_COUNT
+
+// The threaded interpreter stores the addresses of the instruction handlers in the
+// byte code. Those are only valid within this process, so on disk the instruction
+// type is stored instead.
+bool relocateCode(uchar *code, uint size, bool toDisk)
+{
+    void **jumpTable = VME::instructionJumpTable();
+    QHash<void *, int> instructionTypes;
+    if (toDisk) {
+        instructionTypes.reserve(InstructionCount);
+        for (int i = 0; i < InstructionCount; ++i)
+            instructionTypes.insert(jumpTable[i], i);
+    }
+
+    uint offset = 0;
+    while (offset < size) {
+        if (size - offset < sizeof(Instr::instr_common))
+            return false;
+        Instr *instr = reinterpret_cast<Instr *>(code + offset);
+        int type = -1;
+        if (toDisk) {
+            type = instructionTypes.value(instr->common.code, -1);
+            if (type == -1)
+                return false;
+            instr->common.code = reinterpret_cast<void *>(quintptr(type));
+        } else {
+            type = int(reinterpret_cast<quintptr>(instr->common.code));
+            if (type < 0 || type >= InstructionCount)
+                return false;
+            instr->common.code = jumpTable[type];
+        }
+        offset += Instr::size(static_cast<Instr::Type>(type));
+    }
+    return offset == size;
+}
+#endif
+
+} // anonymous namespace
+
+bool CompilationUnit::saveBackendCode(QByteArray *code) const
+{
+    // Layout: quint64 count, followed by count times (quint64 size, size bytes padded to 8),
+    // so that every piece of code stays suitably aligned for executing it in place.
+    const quint64 count = codeRefs.size();
+    code->append(reinterpret_cast<const char *>(&count), sizeof(count));
+    foreach (const QByteArray &ref, codeRefs) {
+        const quint64 size = ref.size();
+        code->append(reinterpret_cast<const char *>(&size), sizeof(size));
+        const int start = code->size();
+        code->append(ref);
+#ifdef MOTH_THREADED_INTERPRETER
+        if (!relocateCode(reinterpret_cast<uchar *>(code->data() + start), size, /*toDisk*/true))
+            return false;
+#else
+        Q_UNUSED(start);
+#endif
+        code->append(QByteArray(int(((size + 7) & ~7) - size), '\0'));
+    }
+    return true;
+}
+
+// The code must stay valid for the lifetime of the unit's data, as the interpreter
+// executes it in place where possible.
+bool CompilationUnit::loadBackendCode(const char *code, uint size)
+{
+    const char *end = code + size;
+    quint64 count = 0;
+    if (size < sizeof(count))
+        return false;
+    memcpy(&count, code, sizeof(count));
+    code += sizeof(count);
+    if (data && count != data->functionTableSize)
+        return false;
+
+    QVector<QByteArray> refs;
+    refs.reserve(count);
+    for (quint64 i = 0; i < count; ++i) {
+        quint64 refSize = 0;
+        if (quint64(end - code) < sizeof(refSize))
+            return false;
+        memcpy(&refSize, code, sizeof(refSize));
+        code += sizeof(refSize);
+        if (quint64(end - code) < refSize)
+            return false;
+#ifdef MOTH_THREADED_INTERPRETER
+        // Handler addresses differ between processes, so the code needs a private copy.
+        QByteArray ref(code, refSize);
+        if (!relocateCode(reinterpret_cast<uchar *>(ref.data()), refSize, /*toDisk*/false))
+            return false;
+#else
+        QByteArray ref = QByteArray::fromRawData(code, refSize);
+#endif
+        refs.append(ref);
+        code += qMin<quint64>((refSize + 7) & ~7, end - code);
+    }
+
+    codeRefs = refs;
+    return true;
+}
@@ -59,8 +59,14 @@ struct CompilationUnit : public QV4::CompiledData::CompilationUnit
     virtual ~CompilationUnit();
     virtual void linkBackendToEngine(QV4::ExecutionEngine *engine);
 
+    virtual bool saveBackendCode(QByteArray *code) const;
+    virtual bool loadBackendCode(const char *code, uint size);
+
     QVector<QByteArray> codeRefs;
 
+protected:
+    virtual bool resolvesRuntimeStringsLazily() const { return true; }
+
 };
 
 class Q_QML_EXPORT InstructionSelection:
@@ -71,6 +77,7 @@ public:
     InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator);
     ~InstructionSelection();
 
+    virtual void prepare(int functionIndex);
     virtual void run(int functionIndex);
 
 protected:
@@ -101,7 +108,9 @@ protected:
     virtual void callBuiltinDefineArray(IR::Temp *result, IR::ExprList *args);
     virtual void callBuiltinDefineObjectLiteral(IR::Temp *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray);
     virtual void callBuiltinSetupArgumentObject(IR::Temp *result);
+    virtual void callBuiltinArgumentCount(IR::Temp *result);
     virtual void callBuiltinConvertThisToObject();
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionId, int scopeDepth, IR::Temp *result);
     virtual void callValue(IR::Temp *value, IR::ExprList *args, IR::Temp *result);
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Temp *result);
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Temp *result);
@@ -191,11 +200,23 @@ private:
 class Q_QML_EXPORT ISelFactory: public EvalISelFactory
 {
 public:
+    // With recordTypeFeedback set, compiled units keep what the engine needs to recompile
+    // their hot functions, and the interpreter records operand types for them.
+    ISelFactory(bool recordTypeFeedback = false) : recordTypeFeedback(recordTypeFeedback) {}
     virtual ~ISelFactory() {}
     virtual EvalInstructionSelection *create(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator)
-    { return new InstructionSelection(qmlEngine, execAllocator, module, jsGenerator); }
+    {
+        InstructionSelection *isel = new InstructionSelection(qmlEngine, execAllocator, module, jsGenerator);
+        isel->setRecordTypeFeedback(recordTypeFeedback);
+        return isel;
+    }
     virtual bool jitCompileRegexps() const
     { return false; }
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading()
+    { return new CompilationUnit; }
+
+private:
+    bool recordTypeFeedback;
 };
 
 template<int InstrT>
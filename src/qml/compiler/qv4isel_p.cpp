@@ -42,12 +42,19 @@
 #include "qv4jsir_p.h"
 #include "qv4isel_p.h"
 #include "qv4isel_util_p.h"
+#include "qv4ssa_p.h"
 #include <private/qv4value_inl_p.h>
 #ifndef V4_BOOTSTRAP
 #include <private/qqmlpropertycache_p.h>
 #endif
 
 #include <QString>
+#ifndef V4_BOOTSTRAP
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#endif
 
 namespace {
 Q_GLOBAL_STATIC_WITH_ARGS(QTextStream, qout, (stderr, QIODevice::WriteOnly));
@@ -59,9 +66,16 @@ using namespace QV4::IR;
 
 EvalInstructionSelection::EvalInstructionSelection(QV4::ExecutableAllocator *execAllocator, Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator)
     : useFastLookups(true)
+    , recordTypeFeedback(false)
     , executableAllocator(execAllocator)
     , irModule(module)
+    , linkedUnit(0)
+    , linkedLookupSites(0)
+    , recordedLookupSites(0)
+    , typeFeedback(0)
+    , unresolved(false)
 {
+    optionalJumps.resize(module->functions.size());
     if (!jsGenerator) {
         jsGenerator = new QV4::Compiler::JSUnitGenerator(module);
         ownJSGenerator.reset(jsGenerator);
@@ -79,19 +93,352 @@ EvalInstructionSelection::~EvalInstructionSelection()
 EvalISelFactory::~EvalISelFactory()
 {}
 
+RecompilationData::RecompilationData()
+    : useFastLookups(true)
+    , typeFeedbackSlotCount(0)
+    , backgroundRecompilation(true)
+{
+}
+
+RecompilationData::~RecompilationData()
+{
+    foreach (QV4::CompiledData::CompilationUnit *unit, recompiledUnits)
+        unit->deref();
+}
+
+static bool recordsTypeFeedback(IR::AluOp op)
+{
+    switch (op) {
+    case IR::OpAdd:
+    case IR::OpSub:
+    case IR::OpMul:
+    case IR::OpDiv:
+    case IR::OpMod:
+    case IR::OpGt:
+    case IR::OpLt:
+    case IR::OpGe:
+    case IR::OpLe:
+    case IR::OpEqual:
+    case IR::OpNotEqual:
+    case IR::OpStrictEqual:
+    case IR::OpStrictNotEqual:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Numbers the binary operations whose operand types the interpreter records, and returns
+// how many there are.
+static int assignTypeFeedbackSlots(IR::Module *module)
+{
+    int slotCount = 0;
+    foreach (IR::Function *function, module->functions) {
+        foreach (IR::BasicBlock *block, function->basicBlocks()) {
+            if (block->isRemoved())
+                continue;
+            foreach (IR::Stmt *s, block->statements()) {
+                IR::Binop *b = 0;
+                if (IR::Move *m = s->asMove())
+                    b = m->source->asBinop();
+                else if (IR::CJump *j = s->asCJump())
+                    b = j->cond->asBinop();
+                if (b && recordsTypeFeedback(b->op))
+                    b->feedbackSlot = slotCount++;
+            }
+        }
+    }
+    return slotCount;
+}
+
+// The field numbering the property access of an expression, if it may get a lookup.
+static int *lookupSite(IR::Expr *e)
+{
+    if (IR::Call *c = e->asCall())
+        e = c->base;
+    else if (IR::New *n = e->asNew())
+        e = n->base;
+    if (IR::Member *m = e->asMember())
+        return &m->lookupSite;
+    if (IR::Subscript *ss = e->asSubscript())
+        return &ss->lookupSite;
+    if (IR::Name *n = e->asName())
+        return &n->lookupSite;
+    return 0;
+}
+
+// Instruction selection creates at most one lookup for a statement.
+static int *lookupSite(IR::Stmt *s)
+{
+    if (IR::Move *m = s->asMove()) {
+        if (int *site = lookupSite(m->target))
+            return site;
+        return lookupSite(m->source);
+    }
+    if (IR::Exp *e = s->asExp())
+        return lookupSite(e->expr);
+    return 0;
+}
+
+// Numbers the property accesses, so that recompiled code can use the lookup the
+// interpreter used for the same access. Returns how many there are.
+static int assignLookupSites(IR::Module *module)
+{
+    int siteCount = 0;
+    foreach (IR::Function *function, module->functions) {
+        foreach (IR::BasicBlock *block, function->basicBlocks()) {
+            if (block->isRemoved())
+                continue;
+            foreach (IR::Stmt *s, block->statements()) {
+                if (int *site = lookupSite(s))
+                    *site = siteCount++;
+            }
+        }
+    }
+    return siteCount;
+}
+
+#ifndef V4_BOOTSTRAP
+namespace {
+// Fewer functions than this are not worth waking up another thread.
+enum { MinimumFunctionsPerThread = 8 };
+Q_GLOBAL_STATIC(QThreadPool, prepareFunctionsThreadPool)
+}
+
+struct EvalInstructionSelection::PrepareFunctionsJob : public QRunnable
+{
+    PrepareFunctionsJob(EvalInstructionSelection *isel, QAtomicInt *nextFunction, QSemaphore *finished)
+        : isel(isel), nextFunction(nextFunction), finished(finished)
+    {}
+
+    void run()
+    {
+        isel->prepareFunctions(nextFunction);
+        finished->release();
+    }
+
+    EvalInstructionSelection *isel;
+    QAtomicInt *nextFunction;
+    QSemaphore *finished;
+};
+
+void EvalInstructionSelection::prepareFunctions(QAtomicInt *nextFunction)
+{
+    const int functionCount = irModule->functions.size();
+    for (int i = nextFunction->fetchAndAddRelaxed(1); i < functionCount; i = nextFunction->fetchAndAddRelaxed(1))
+        prepare(i);
+}
+#endif // V4_BOOTSTRAP
+
+// The functions of a module are optimized independently of each other, so they are spread
+// over a thread pool. Instruction selection registers strings and lookups with the unit
+// generator, and stays on the calling thread.
+void EvalInstructionSelection::prepareFunctions()
+{
+    const int functionCount = irModule->functions.size();
+#ifndef V4_BOOTSTRAP
+    static const bool parallel = qgetenv("QV4_NO_PARALLEL_ISEL").isEmpty();
+    const int threadCount = qMin(functionCount / MinimumFunctionsPerThread, QThread::idealThreadCount());
+    if (parallel && threadCount > 1) {
+        // Functions share the module's memory pool, which is not thread-safe.
+        foreach (IR::Function *function, irModule->functions)
+            function->pool = irModule->newFunctionPool();
+
+        QAtomicInt nextFunction(0);
+        QSemaphore finished;
+        const int helperCount = threadCount - 1;
+        for (int i = 0; i < helperCount; ++i)
+            prepareFunctionsThreadPool()->start(new PrepareFunctionsJob(this, &nextFunction, &finished));
+        prepareFunctions(&nextFunction);
+        finished.acquire(helperCount);
+        return;
+    }
+#endif // V4_BOOTSTRAP
+    for (int i = 0; i < functionCount; ++i)
+        prepare(i);
+}
+
 QV4::CompiledData::CompilationUnit *EvalInstructionSelection::compile(bool generateUnitData)
 {
+    static const bool doInlining = qgetenv("QV4_NO_INLINING").isEmpty();
+    if (doInlining)
+        IR::Inliner(irModule).run();
+
+    RecompilationData *recompilationData = 0;
+    if (recordTypeFeedback) {
+        // The backend optimizes the IR in place, so take the copy before running it.
+        recompilationData = new RecompilationData;
+        recompilationData->typeFeedbackSlotCount = assignTypeFeedbackSlots(irModule);
+        recompilationData->lookupSites.fill(-1, assignLookupSites(irModule));
+        recompilationData->module.reset(irModule->clone());
+        recompilationData->useFastLookups = useFastLookups;
+        recordedLookupSites = &recompilationData->lookupSites;
+    }
+
+    prepareFunctions();
     for (int i = 0; i < irModule->functions.size(); ++i)
         run(i);
 
+    recordedLookupSites = 0;
+
     QV4::CompiledData::CompilationUnit *unit = backendCompileStep();
     if (generateUnitData)
         unit->data = jsGenerator->generateUnit();
+#ifndef V4_BOOTSTRAP
+    unit->recompilationData = recompilationData;
+#else
+    Q_ASSERT(!recompilationData);
+#endif
+    return unit;
+}
+
+QV4::CompiledData::CompilationUnit *EvalInstructionSelection::recompile(int functionIndex, const QV4::CompiledData::Unit *linkedUnit, const QVector<int> &lookupSites, const uchar *typeFeedback)
+{
+    Q_ASSERT(linkedUnit);
+    this->linkedUnit = linkedUnit;
+    this->linkedLookupSites = &lookupSites;
+    this->typeFeedback = typeFeedback;
+    unresolved = false;
+
+    prepare(functionIndex);
+    run(functionIndex);
+
+    QV4::CompiledData::CompilationUnit *unit = backendCompileStep();
+    if (unresolved) {
+        delete unit;
+        return 0;
+    }
     return unit;
 }
 
+int EvalInstructionSelection::resolveString(const QString &str)
+{
+    if (linkedStrings.isEmpty()) {
+        for (uint i = 0; i < linkedUnit->stringTableSize; ++i)
+            linkedStrings.insert(linkedUnit->stringAt(i), i);
+    }
+    QHash<QString, int>::ConstIterator it = linkedStrings.constFind(str);
+    if (it == linkedStrings.constEnd()) {
+        unresolved = true;
+        return 0;
+    }
+    return *it;
+}
+
+uint EvalInstructionSelection::registerLookup(uint type, const QString &name, int site)
+{
+    if (linkedUnit)
+        return resolveLookup(type, name, site);
+
+    uint index;
+    switch (type) {
+    case QV4::CompiledData::Lookup::Type_IndexedGetter:
+        index = jsGenerator->registerIndexedGetterLookup();
+        break;
+    case QV4::CompiledData::Lookup::Type_IndexedSetter:
+        index = jsGenerator->registerIndexedSetterLookup();
+        break;
+    case QV4::CompiledData::Lookup::Type_Getter:
+        index = jsGenerator->registerGetterLookup(name);
+        break;
+    case QV4::CompiledData::Lookup::Type_Setter:
+        index = jsGenerator->registerSetterLookup(name);
+        break;
+    default:
+        Q_ASSERT(type == QV4::CompiledData::Lookup::Type_GlobalGetter);
+        index = jsGenerator->registerGlobalGetterLookup(name);
+        break;
+    }
+    if (recordedLookupSites && site >= 0)
+        (*recordedLookupSites)[site] = index;
+    return index;
+}
+
+uint EvalInstructionSelection::resolveLookup(uint type, const QString &name, int site)
+{
+    const bool indexed = type == QV4::CompiledData::Lookup::Type_IndexedGetter
+            || type == QV4::CompiledData::Lookup::Type_IndexedSetter;
+    const QV4::CompiledData::Lookup *lookups = linkedUnit->lookupTable();
+
+    // The lookup the interpreter used here has seen the same objects.
+    if (site >= 0 && site < linkedLookupSites->size()) {
+        const int index = linkedLookupSites->at(site);
+        if (index >= 0 && lookups[index].type_and_flags == type
+                && (indexed || linkedUnit->stringAt(lookups[index].nameIndex) == name))
+            return index;
+    }
+
+    // The interpreter's code has no lookup for this access, as it was optimized
+    // differently. Share one for the same property.
+    for (uint i = 0; i < linkedUnit->lookupTableSize; ++i) {
+        if (lookups[i].type_and_flags == type
+                && (indexed || linkedUnit->stringAt(lookups[i].nameIndex) == name))
+            return i;
+    }
+    unresolved = true;
+    return 0;
+}
+
+int EvalInstructionSelection::resolveRegExp(IR::RegExp *regexp)
+{
+    uint flags = 0;
+    if (regexp->flags & IR::RegExp::RegExp_Global)
+        flags |= QV4::CompiledData::RegExp::RegExp_Global;
+    if (regexp->flags & IR::RegExp::RegExp_IgnoreCase)
+        flags |= QV4::CompiledData::RegExp::RegExp_IgnoreCase;
+    if (regexp->flags & IR::RegExp::RegExp_Multiline)
+        flags |= QV4::CompiledData::RegExp::RegExp_Multiline;
+
+    for (uint i = 0; i < linkedUnit->regexpTableSize; ++i) {
+        const QV4::CompiledData::RegExp *re = linkedUnit->regexpAt(i);
+        if (re->flags == flags && linkedUnit->stringAt(re->stringIndex) == *regexp->value)
+            return i;
+    }
+    unresolved = true;
+    return 0;
+}
+
+int EvalInstructionSelection::resolveJSClass(int count, IR::ExprList *args)
+{
+    // Same walk over the object literal's arguments as JSUnitGenerator::registerJSClass
+    QVector<QPair<QString, bool> > members;
+    IR::ExprList *it = args;
+    for (int i = 0; i < count; ++i, it = it->next) {
+        IR::Name *name = it->expr->asName();
+        it = it->next;
+
+        const bool isData = it->expr->asConst()->value;
+        it = it->next;
+
+        members.append(qMakePair(*name->id, !isData));
+
+        if (!isData)
+            it = it->next;
+    }
+
+    for (uint i = 0; i < linkedUnit->jsClassTableSize; ++i) {
+        int memberCount = 0;
+        const QV4::CompiledData::JSClassMember *member = linkedUnit->jsClassAt(i, &memberCount);
+        if (memberCount != count)
+            continue;
+        int j = 0;
+        for (; j < memberCount; ++j, ++member) {
+            if (bool(member->isAccessor) != members.at(j).second
+                    || linkedUnit->stringAt(member->nameOffset) != members.at(j).first)
+                break;
+        }
+        if (j == memberCount)
+            return i;
+    }
+    unresolved = true;
+    return 0;
+}
+
 void IRDecoder::visitMove(IR::Move *s)
 {
+    const int *site = lookupSite(s);
+    _lookupSite = site ? *site : -1;
+
     if (IR::Name *n = s->target->asName()) {
         if (s->source->asTemp() || s->source->asConst()) {
             setActivationProperty(s->source, *n->id);
@@ -178,6 +525,7 @@ void IRDecoder::visitMove(IR::Move *s)
                 return;
             }
         } else if (IR::Binop *b = s->source->asBinop()) {
+            _feedbackSlot = b->feedbackSlot;
             binop(b->op, b->left, b->right, t);
             return;
         } else if (IR::Call *c = s->source->asCall()) {
@@ -237,6 +585,9 @@ IRDecoder::~IRDecoder()
 
 void IRDecoder::visitExp(IR::Exp *s)
 {
+    const int *site = lookupSite(s);
+    _lookupSite = site ? *site : -1;
+
     if (IR::Call *c = s->expr->asCall()) {
         // These are calls where the result is ignored.
         if (c->base->asName()) {
@@ -393,10 +744,24 @@ void IRDecoder::callBuiltin(IR::Call *call, IR::Temp *result)
         callBuiltinSetupArgumentObject(result);
         return;
 
+    case IR::Name::builtin_argument_count:
+        callBuiltinArgumentCount(result);
+        return;
+
     case IR::Name::builtin_convert_this_to_object:
         callBuiltinConvertThisToObject();
         return;
 
+    case IR::Name::builtin_is_closure: {
+        IR::ExprList *args = call->args;
+        IR::Expr *value = args->expr;
+        args = args->next;
+        const int functionId = args->expr->asConst()->value;
+        args = args->next;
+        const int scopeDepth = args->expr->asConst()->value;
+        callBuiltinIsClosure(value, functionId, scopeDepth, result);
+    } return;
+
     default:
         break;
     }
@@ -49,6 +49,8 @@
 
 #include <qglobal.h>
 #include <QHash>
+#include <QSet>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 
@@ -59,6 +61,55 @@ namespace QV4 {
 class ExecutableAllocator;
 struct Function;
 
+// Operand types seen by the interpreter for a binary operation. The left operand's types
+// are kept in the low four bits, the right operand's in the high four bits.
+namespace TypeFeedback {
+enum {
+    Int32 = 0x1,
+    Double = 0x2,
+    String = 0x4,
+    Other = 0x8,
+
+    Number = Int32 | Double,
+    RightShift = 4,
+    OperandMask = 0xf
+};
+
+inline uchar left(uchar feedback) { return feedback & OperandMask; }
+inline uchar right(uchar feedback) { return feedback >> RightShift; }
+
+// Both operands were always int32.
+inline bool isInt32(uchar feedback)
+{ return feedback && left(feedback) == Int32 && right(feedback) == Int32; }
+
+// Both operands were always numbers.
+inline bool isNumber(uchar feedback)
+{ return feedback && !(left(feedback) & ~Number) && !(right(feedback) & ~Number); }
+
+// The operation never saw two numbers, so inlining number arithmetic won't pay off.
+inline bool hasNoNumbers(uchar feedback)
+{ return feedback && (!(left(feedback) & Number) || !(right(feedback) & Number)); }
+}
+
+// Kept with units that were compiled for the interpreter while recording type feedback,
+// so that their hot functions can be compiled again with the JIT.
+struct Q_QML_PRIVATE_EXPORT RecompilationData
+{
+    RecompilationData();
+    ~RecompilationData();
+
+    // Unoptimized copy of the IR the unit was compiled from.
+    QScopedPointer<IR::Module> module;
+    bool useFastLookups;
+    int typeFeedbackSlotCount;
+    // The lookup the interpreter's code uses for each lookup site of the IR, or -1.
+    QVector<int> lookupSites;
+    // Whether functions may be recompiled on another thread than the engine's.
+    bool backgroundRecompilation;
+    // Units holding the code of recompiled functions.
+    QVector<QV4::CompiledData::CompilationUnit *> recompiledUnits;
+};
+
 class Q_QML_PRIVATE_EXPORT EvalInstructionSelection
 {
 public:
@@ -67,27 +118,64 @@ public:
 
     QV4::CompiledData::CompilationUnit *compile(bool generateUnitData = true);
 
+    // Compiles a single function again, using the type feedback recorded by the interpreter.
+    // Strings, lookups, regular expressions and classes are not registered with a generator
+    // but resolved against the tables of the unit that is already linked, so the generated
+    // code runs against that unit. Returns null if anything can't be resolved.
+    QV4::CompiledData::CompilationUnit *recompile(int functionIndex, const QV4::CompiledData::Unit *linkedUnit, const QVector<int> &lookupSites, const uchar *typeFeedback);
+
     void setUseFastLookups(bool b) { useFastLookups = b; }
+    void setRecordTypeFeedback(bool b) { recordTypeFeedback = b; }
 
-    int registerString(const QString &str) { return jsGenerator->registerString(str); }
-    uint registerIndexedGetterLookup() { return jsGenerator->registerIndexedGetterLookup(); }
-    uint registerIndexedSetterLookup() { return jsGenerator->registerIndexedSetterLookup(); }
-    uint registerGetterLookup(const QString &name) { return jsGenerator->registerGetterLookup(name); }
-    uint registerSetterLookup(const QString &name) { return jsGenerator->registerSetterLookup(name); }
-    uint registerGlobalGetterLookup(const QString &name) { return jsGenerator->registerGlobalGetterLookup(name); }
-    int registerRegExp(IR::RegExp *regexp) { return jsGenerator->registerRegExp(regexp); }
-    int registerJSClass(int count, IR::ExprList *args) { return jsGenerator->registerJSClass(count, args); }
+    int registerString(const QString &str) { return linkedUnit ? resolveString(str) : jsGenerator->registerString(str); }
+    // The site is the lookupSite of the IR expression the lookup is created for.
+    uint registerIndexedGetterLookup(int site) { return registerLookup(QV4::CompiledData::Lookup::Type_IndexedGetter, QString(), site); }
+    uint registerIndexedSetterLookup(int site) { return registerLookup(QV4::CompiledData::Lookup::Type_IndexedSetter, QString(), site); }
+    uint registerGetterLookup(const QString &name, int site) { return registerLookup(QV4::CompiledData::Lookup::Type_Getter, name, site); }
+    uint registerSetterLookup(const QString &name, int site) { return registerLookup(QV4::CompiledData::Lookup::Type_Setter, name, site); }
+    uint registerGlobalGetterLookup(const QString &name, int site) { return registerLookup(QV4::CompiledData::Lookup::Type_GlobalGetter, name, site); }
+    int registerRegExp(IR::RegExp *regexp) { return linkedUnit ? resolveRegExp(regexp) : jsGenerator->registerRegExp(regexp); }
+    int registerJSClass(int count, IR::ExprList *args) { return linkedUnit ? resolveJSClass(count, args) : jsGenerator->registerJSClass(count, args); }
     QV4::Compiler::JSUnitGenerator *jsUnitGenerator() const { return jsGenerator; }
 
 protected:
+    // Optimizes the IR of a function and allocates its temps, and stores the jumps that
+    // run() can leave out in optionalJumps. It must not touch anything but the function,
+    // as different functions are prepared concurrently.
+    virtual void prepare(int functionIndex) = 0;
     virtual void run(int functionIndex) = 0;
     virtual QV4::CompiledData::CompilationUnit *backendCompileStep() = 0;
 
+    uchar typeFeedbackAt(int slot) const { return typeFeedback && slot >= 0 ? typeFeedback[slot] : 0; }
+
     bool useFastLookups;
+    bool recordTypeFeedback;
     QV4::ExecutableAllocator *executableAllocator;
     QV4::Compiler::JSUnitGenerator *jsGenerator;
     QScopedPointer<QV4::Compiler::JSUnitGenerator> ownJSGenerator;
     IR::Module *irModule;
+    QVector<QSet<IR::Jump *> > optionalJumps;
+
+private:
+    void prepareFunctions();
+#ifndef V4_BOOTSTRAP
+    struct PrepareFunctionsJob;
+    void prepareFunctions(QAtomicInt *nextFunction);
+#endif
+
+    uint registerLookup(uint type, const QString &name, int site);
+
+    int resolveString(const QString &str);
+    uint resolveLookup(uint type, const QString &name, int site);
+    int resolveRegExp(IR::RegExp *regexp);
+    int resolveJSClass(int count, IR::ExprList *args);
+
+    const QV4::CompiledData::Unit *linkedUnit;
+    const QVector<int> *linkedLookupSites;
+    QVector<int> *recordedLookupSites;
+    const uchar *typeFeedback;
+    QHash<QString, int> linkedStrings;
+    bool unresolved;
 };
 
 class Q_QML_PRIVATE_EXPORT EvalISelFactory
@@ -96,13 +184,16 @@ public:
     virtual ~EvalISelFactory() = 0;
     virtual EvalInstructionSelection *create(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator) = 0;
     virtual bool jitCompileRegexps() const = 0;
+    // Returns an empty compilation unit that code can be loaded into from the
+    // disk cache, or null if the backend doesn't support that.
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading() { return 0; }
 };
 
 namespace IR {
 class Q_QML_PRIVATE_EXPORT IRDecoder: protected IR::StmtVisitor
 {
 public:
-    IRDecoder() : _function(0) {}
+    IRDecoder() : _function(0), _feedbackSlot(-1), _lookupSite(-1) {}
     virtual ~IRDecoder() = 0;
 
     virtual void visitPhi(IR::Phi *) {}
@@ -133,7 +224,9 @@ public: // to implement by subclasses:
     virtual void callBuiltinDefineArray(IR::Temp *result, IR::ExprList *args) = 0;
     virtual void callBuiltinDefineObjectLiteral(IR::Temp *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray) = 0;
     virtual void callBuiltinSetupArgumentObject(IR::Temp *result) = 0;
+    virtual void callBuiltinArgumentCount(IR::Temp *result) = 0;
     virtual void callBuiltinConvertThisToObject() = 0;
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionId, int scopeDepth, IR::Temp *result) = 0;
     virtual void callValue(IR::Temp *value, IR::ExprList *args, IR::Temp *result) = 0;
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Temp *result) = 0;
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Temp *result) = 0;
@@ -168,6 +261,8 @@ protected:
     virtual void callBuiltin(IR::Call *c, IR::Temp *result);
 
     IR::Function *_function; // subclass needs to set
+    int _feedbackSlot; // of the binop being selected
+    int _lookupSite; // of the property access being selected
 };
 } // namespace IR
 
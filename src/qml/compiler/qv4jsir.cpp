@@ -275,6 +275,252 @@ struct RemoveSharedExpressions: IR::StmtVisitor, IR::ExprVisitor
     }
 };
 
+// Copies functions statement by statement. Strings are interned again in the copied
+// function, so that nothing points back into the original module.
+struct CloneFunction: IR::StmtVisitor, IR::ExprVisitor
+{
+    Function *function; // the copy
+    QHash<BasicBlock *, BasicBlock *> blocks;
+    Stmt *clonedStmt;
+    Expr *clonedExpr;
+
+    CloneFunction(): function(0), clonedStmt(0), clonedExpr(0) {}
+
+    void operator()(Function *original, Function *copy)
+    {
+        function = copy;
+        blocks.clear();
+
+        copy->tempCount = original->tempCount;
+        copy->maxNumberOfArguments = original->maxNumberOfArguments;
+        foreach (const QString *formal, original->formals)
+            copy->formals.append(string(formal));
+        foreach (const QString *local, original->locals)
+            copy->locals.append(string(local));
+        copy->insideWithOrCatch = original->insideWithOrCatch;
+        copy->hasDirectEval = original->hasDirectEval;
+        copy->usesArgumentsObject = original->usesArgumentsObject;
+        copy->usesThis = original->usesThis;
+        copy->isStrict = original->isStrict;
+        copy->isNamedExpression = original->isNamedExpression;
+        copy->hasTry = original->hasTry;
+        copy->hasWith = original->hasWith;
+        copy->line = original->line;
+        copy->column = original->column;
+        copy->idObjectDependencies = original->idObjectDependencies;
+        copy->contextObjectPropertyDependencies = original->contextObjectPropertyDependencies;
+        copy->scopeObjectPropertyDependencies = original->scopeObjectPropertyDependencies;
+
+        // Blocks refer to each other, so create all of them before filling them in.
+        foreach (BasicBlock *block, original->basicBlocks())
+            blocks.insert(block, copy->newBasicBlock(0, 0));
+
+        foreach (BasicBlock *block, original->basicBlocks()) {
+            BasicBlock *newBlock = blocks.value(block);
+            if (block->isRemoved()) {
+                copy->removeBasicBlock(newBlock);
+                continue;
+            }
+
+            newBlock->catchBlock = blocks.value(block->catchBlock);
+            newBlock->setContainingGroup(blocks.value(block->containingGroup()));
+            if (block->isGroupStart())
+                newBlock->markAsGroupStart();
+            newBlock->setExceptionHandler(block->isExceptionHandler());
+            newBlock->nextLocation = block->nextLocation;
+            foreach (BasicBlock *in, block->in)
+                newBlock->in.append(blocks.value(in));
+            foreach (BasicBlock *out, block->out)
+                newBlock->out.append(blocks.value(out));
+
+            QVector<Stmt *> statements;
+            statements.reserve(block->statementCount());
+            foreach (Stmt *s, block->statements())
+                statements.append(clone(s));
+            newBlock->setStatements(statements);
+        }
+    }
+
+    const QString *string(const QString *s)
+    {
+        return s ? function->newString(*s) : 0;
+    }
+
+    Stmt *clone(Stmt *s)
+    {
+        s->accept(this);
+        clonedStmt->id = s->id;
+        clonedStmt->location = s->location;
+        return clonedStmt;
+    }
+
+    template <typename _Expr>
+    _Expr *clone(_Expr *expr)
+    {
+        if (!expr)
+            return 0;
+        Expr *c = 0;
+        qSwap(clonedExpr, c);
+        expr->accept(this);
+        qSwap(clonedExpr, c);
+        c->type = expr->type;
+        return static_cast<_Expr *>(c);
+    }
+
+    ExprList *clone(ExprList *list)
+    {
+        if (!list)
+            return 0;
+        ExprList *clonedList = function->New<ExprList>();
+        clonedList->init(clone(list->expr), clone(list->next));
+        return clonedList;
+    }
+
+    // statements
+    virtual void visitExp(Exp *s)
+    {
+        Exp *e = function->New<Exp>();
+        e->init(clone(s->expr));
+        clonedStmt = e;
+    }
+
+    virtual void visitMove(Move *s)
+    {
+        Move *m = function->New<Move>();
+        m->init(clone(s->target), clone(s->source));
+        m->swap = s->swap;
+        clonedStmt = m;
+    }
+
+    virtual void visitJump(Jump *s)
+    {
+        Jump *j = function->New<Jump>();
+        j->init(blocks.value(s->target));
+        clonedStmt = j;
+    }
+
+    virtual void visitCJump(CJump *s)
+    {
+        CJump *j = function->New<CJump>();
+        j->init(clone(s->cond), blocks.value(s->iftrue), blocks.value(s->iffalse));
+        clonedStmt = j;
+    }
+
+    virtual void visitRet(Ret *s)
+    {
+        Ret *r = function->New<Ret>();
+        r->init(clone(s->expr));
+        clonedStmt = r;
+    }
+
+    virtual void visitPhi(Phi *s)
+    {
+        Phi *p = function->New<Phi>();
+        p->targetTemp = clone(s->targetTemp);
+        p->d = new Stmt::Data;
+        foreach (Expr *incoming, s->d->incoming)
+            p->d->incoming.append(clone(incoming));
+        clonedStmt = p;
+    }
+
+    // expressions
+    virtual void visitConst(Const *e)
+    {
+        clonedExpr = CloneExpr::cloneConst(e, function);
+    }
+
+    virtual void visitString(String *e)
+    {
+        String *s = function->New<String>();
+        s->init(string(e->value));
+        clonedExpr = s;
+    }
+
+    virtual void visitRegExp(RegExp *e)
+    {
+        RegExp *r = function->New<RegExp>();
+        r->init(string(e->value), e->flags);
+        clonedExpr = r;
+    }
+
+    virtual void visitName(Name *e)
+    {
+        Name *n = CloneExpr::cloneName(e, function);
+        n->id = string(e->id);
+        clonedExpr = n;
+    }
+
+    virtual void visitTemp(Temp *e)
+    {
+        Temp *t = CloneExpr::cloneTemp(e, function);
+        t->isArgumentsOrEval = e->isArgumentsOrEval;
+        t->isReadOnly = e->isReadOnly;
+        clonedExpr = t;
+    }
+
+    virtual void visitClosure(Closure *e)
+    {
+        Closure *c = function->New<Closure>();
+        c->init(e->value, string(e->functionName));
+        clonedExpr = c;
+    }
+
+    virtual void visitConvert(Convert *e)
+    {
+        Convert *c = function->New<Convert>();
+        c->init(clone(e->expr), e->type);
+        clonedExpr = c;
+    }
+
+    virtual void visitUnop(Unop *e)
+    {
+        Unop *u = function->New<Unop>();
+        u->init(e->op, clone(e->expr));
+        clonedExpr = u;
+    }
+
+    virtual void visitBinop(Binop *e)
+    {
+        Binop *b = function->New<Binop>();
+        b->init(e->op, clone(e->left), clone(e->right));
+        b->feedbackSlot = e->feedbackSlot;
+        clonedExpr = b;
+    }
+
+    virtual void visitCall(Call *e)
+    {
+        Call *c = function->New<Call>();
+        c->init(clone(e->base), clone(e->args));
+        clonedExpr = c;
+    }
+
+    virtual void visitNew(New *e)
+    {
+        New *n = function->New<New>();
+        n->init(clone(e->base), clone(e->args));
+        clonedExpr = n;
+    }
+
+    virtual void visitSubscript(Subscript *e)
+    {
+        Subscript *s = function->New<Subscript>();
+        s->init(clone(e->base), clone(e->index));
+        s->lookupSite = e->lookupSite;
+        clonedExpr = s;
+    }
+
+    virtual void visitMember(Member *e)
+    {
+        Member *m = function->New<Member>();
+        m->init(clone(e->base), string(e->name), e->property, e->kind, e->attachedPropertiesIdOrEnumValue);
+        m->memberIsEnum = e->memberIsEnum;
+        m->freeOfSideEffects = e->freeOfSideEffects;
+        m->inhibitTypeConversionOnWrite = e->inhibitTypeConversionOnWrite;
+        m->lookupSite = e->lookupSite;
+        clonedExpr = m;
+    }
+};
+
 static QString dumpStart(const Expr *e) {
     if (e->type == UnknownType)
 //        return QStringLiteral("**UNKNOWN**");
@@ -382,6 +628,7 @@ void Name::initGlobal(const QString *id, quint32 line, quint32 column)
     this->freeOfSideEffects = false;
     this->line = line;
     this->column = column;
+    this->lookupSite = -1;
 }
 
 void Name::init(const QString *id, quint32 line, quint32 column)
@@ -393,6 +640,7 @@ void Name::init(const QString *id, quint32 line, quint32 column)
     this->freeOfSideEffects = false;
     this->line = line;
     this->column = column;
+    this->lookupSite = -1;
 }
 
 void Name::init(Builtin builtin, quint32 line, quint32 column)
@@ -404,6 +652,7 @@ void Name::init(Builtin builtin, quint32 line, quint32 column)
     this->freeOfSideEffects = false;
     this->line = line;
     this->column = column;
+    this->lookupSite = -1;
 }
 
 static const char *builtin_to_string(Name::Builtin b)
@@ -439,8 +688,12 @@ static const char *builtin_to_string(Name::Builtin b)
         return "builtin_define_object_literal";
     case IR::Name::builtin_setup_argument_object:
         return "builtin_setup_argument_object";
+    case IR::Name::builtin_argument_count:
+        return "builtin_argument_count";
     case IR::Name::builtin_convert_this_to_object:
         return "builtin_convert_this_to_object";
+    case IR::Name::builtin_is_closure:
+        return "builtin_is_closure";
     case IR::Name::builtin_qml_id_array:
         return "builtin_qml_id_array";
     case IR::Name::builtin_qml_imported_scripts_object:
@@ -652,6 +905,14 @@ Function *Module::newFunction(const QString &name, Function *outer)
 Module::~Module()
 {
     qDeleteAll(functions);
+    qDeleteAll(functionPools);
+}
+
+QQmlJS::MemoryPool *Module::newFunctionPool()
+{
+    QQmlJS::MemoryPool *functionPool = new QQmlJS::MemoryPool;
+    functionPools.append(functionPool);
+    return functionPool;
 }
 
 void Module::setFileName(const QString &name)
@@ -663,6 +924,32 @@ void Module::setFileName(const QString &name)
     }
 }
 
+Module *Module::clone() const
+{
+    Module *copy = new Module(debugMode);
+    copy->fileName = fileName;
+    copy->isQmlModule = isQmlModule;
+
+    QHash<Function *, Function *> copies;
+    foreach (Function *f, functions) {
+        Function *newFunction = new Function(copy, 0, *f->name);
+        copy->functions.append(newFunction);
+        copies.insert(f, newFunction);
+    }
+    copy->rootFunction = copies.value(rootFunction);
+
+    CloneFunction cloneFunction;
+    foreach (Function *f, functions) {
+        Function *newFunction = copies.value(f);
+        newFunction->outer = copies.value(f->outer);
+        foreach (Function *nested, f->nestedFunctions)
+            newFunction->nestedFunctions.append(copies.value(nested));
+        cloneFunction(f, newFunction);
+    }
+
+    return copy;
+}
+
 Function::Function(Module *module, Function *outer, const QString &name)
     : module(module)
     , pool(&module->pool)
@@ -1173,7 +1460,9 @@ void CloneExpr::visitUnop(Unop *e)
 
 void CloneExpr::visitBinop(Binop *e)
 {
-    cloned = block->BINOP(e->op, clone(e->left), clone(e->right));
+    Binop *b = static_cast<Binop *>(block->BINOP(e->op, clone(e->left), clone(e->right)));
+    b->feedbackSlot = e->feedbackSlot;
+    cloned = b;
 }
 
 void CloneExpr::visitCall(Call *e)
@@ -1188,13 +1477,17 @@ void CloneExpr::visitNew(New *e)
 
 void CloneExpr::visitSubscript(Subscript *e)
 {
-    cloned = block->SUBSCRIPT(clone(e->base), clone(e->index));
+    Subscript *s = static_cast<Subscript *>(block->SUBSCRIPT(clone(e->base), clone(e->index)));
+    s->lookupSite = e->lookupSite;
+    cloned = s;
 }
 
 void CloneExpr::visitMember(Member *e)
 {
     Expr *clonedBase = clone(e->base);
-    cloned = block->MEMBER(clonedBase, e->name, e->property, e->kind, e->attachedPropertiesIdOrEnumValue);
+    Member *m = static_cast<Member *>(block->MEMBER(clonedBase, e->name, e->property, e->kind, e->attachedPropertiesIdOrEnumValue));
+    m->lookupSite = e->lookupSite;
+    cloned = m;
 }
 
 } // end of namespace IR
@@ -354,7 +354,9 @@ struct Name: Expr {
         builtin_define_array,
         builtin_define_object_literal,
         builtin_setup_argument_object,
+        builtin_argument_count,
         builtin_convert_this_to_object,
+        builtin_is_closure,
         builtin_qml_id_array,
         builtin_qml_imported_scripts_object,
         builtin_qml_context_object,
@@ -368,6 +370,7 @@ struct Name: Expr {
     bool freeOfSideEffects : 1;
     quint32 line;
     quint32 column;
+    int lookupSite; // see Subscript::lookupSite
 
     void initGlobal(const QString *id, quint32 line, quint32 column);
     void init(const QString *id, quint32 line, quint32 column);
@@ -481,12 +484,14 @@ struct Binop: Expr {
     AluOp op;
     Expr *left; // Temp or Const
     Expr *right; // Temp or Const
+    int feedbackSlot; // index in the unit's type feedback, or -1 if none is recorded
 
     void init(AluOp op, Expr *left, Expr *right)
     {
         this->op = op;
         this->left = left;
         this->right = right;
+        this->feedbackSlot = -1;
     }
 
     virtual void accept(ExprVisitor *v) { v->visitBinop(this); }
@@ -542,11 +547,15 @@ struct New: Expr {
 struct Subscript: Expr {
     Expr *base;
     Expr *index;
+    // Numbers the property accesses of a unit that records type feedback, so that a
+    // recompiled function uses the lookups the interpreter used. -1 if not numbered.
+    int lookupSite;
 
     void init(Expr *base, Expr *index)
     {
         this->base = base;
         this->index = index;
+        this->lookupSite = -1;
     }
 
     virtual void accept(ExprVisitor *v) { v->visitSubscript(this); }
@@ -580,6 +589,8 @@ struct Member: Expr {
 
     uchar kind: 3; // MemberKind
 
+    int lookupSite; // see Subscript::lookupSite
+
     void setEnumValue(int value) {
         kind = MemberOfEnum;
         attachedPropertiesIdOrEnumValue = value;
@@ -600,6 +611,7 @@ struct Member: Expr {
         this->freeOfSideEffects = false;
         this->inhibitTypeConversionOnWrite = property != 0;
         this->kind = kind;
+        this->lookupSite = -1;
     }
 
     virtual void accept(ExprVisitor *v) { v->visitMember(this); }
@@ -746,6 +758,8 @@ struct Phi: Stmt {
 
 struct Q_QML_PRIVATE_EXPORT Module {
     QQmlJS::MemoryPool pool;
+    // Pools of functions that got one of their own, see newFunctionPool().
+    QVector<QQmlJS::MemoryPool *> functionPools;
     QVector<Function *> functions;
     Function *rootFunction;
     QString fileName;
@@ -762,6 +776,14 @@ struct Q_QML_PRIVATE_EXPORT Module {
     ~Module();
 
     void setFileName(const QString &name);
+
+    // Returns a memory pool for a single function, so that the function's IR can be
+    // transformed concurrently with that of the others.
+    QQmlJS::MemoryPool *newFunctionPool();
+
+    // Returns a deep copy that shares nothing with this module, so it stays valid after
+    // this one has been optimized or deleted.
+    Module *clone() const;
 };
 
 struct BasicBlock {
@@ -1082,6 +1104,7 @@ public:
         newName->freeOfSideEffects = n->freeOfSideEffects;
         newName->line = n->line;
         newName->column = n->column;
+        newName->lookupSite = n->lookupSite;
         return newName;
     }
 
@@ -1111,7 +1134,7 @@ protected:
     virtual void visitSubscript(Subscript *);
     virtual void visitMember(Member *);
 
-private:
+protected:
     IR::BasicBlock *block;
     IR::Expr *cloned;
 };
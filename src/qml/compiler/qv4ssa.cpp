@@ -3476,6 +3476,556 @@ void optimizeSSA(IR::Function *function, DefUsesCalculator &defUses, DominatorTr
     W.cleanup(function);
 }
 
+// Proves that an element read of an array gets an index in [0, length), so it can't miss and run
+// an indexed accessor on the prototype chain, which could change the array. That holds for a
+// counter starting at a non-negative integer and only stepping up by one, when the read is only
+// reached after a condition checked that the counter is below the length of the array.
+class ElementIndexBounds
+{
+    IR::Function *function;
+    const DefUsesCalculator &defUses;
+    const DominatorTree &df;
+
+public:
+    ElementIndexBounds(IR::Function *function, const DefUsesCalculator &defUses,
+                       const DominatorTree &df)
+        : function(function)
+        , defUses(defUses)
+        , df(df)
+    {}
+
+    // The length is held by a read of "length" of one of the arrays, or by a constant not larger
+    // than length.
+    bool isInBounds(Expr *index, BasicBlock *block, const QSet<UntypedTemp> &arrays,
+                    int length) const
+    {
+        Temp *counter = counterOf(index);
+        if (!counter || !isUpCounter(counter))
+            return false;
+
+        for (BasicBlock *bb = block; !bb->in.isEmpty(); bb = df.immediateDominator(bb)) {
+            if (bb->in.size() != 1)
+                continue;
+            Stmt *terminator = bb->in.first()->terminator();
+            CJump *test = terminator ? terminator->asCJump() : 0;
+            if (test && test->iftrue == bb && test->iffalse != bb
+                    && isBelowLength(test->cond, counter, arrays, length))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    Move *moveDefining(Expr *e) const
+    {
+        Temp *t = unescapableTemp(e, function);
+        Stmt *s = t ? defUses.defStmt(*t) : 0;
+        Move *m = s ? s->asMove() : 0;
+        return m && !m->swap ? m : 0;
+    }
+
+    // Follows copies, "+x" and conversions to double, which all keep the value of a number.
+    Expr *valueOf(Expr *e) const
+    {
+        while (Move *m = moveDefining(e)) {
+            if (m->source->asTemp()) {
+                e = m->source;
+            } else if (Unop *u = m->source->asUnop()) {
+                if (u->op != OpUPlus)
+                    break;
+                e = u->expr;
+            } else if (Convert *c = m->source->asConvert()) {
+                if (c->type != DoubleType)
+                    break;
+                e = c->expr;
+            } else {
+                break;
+            }
+        }
+        return e;
+    }
+
+    Temp *counterOf(Expr *e) const
+    {
+        Temp *t = unescapableTemp(valueOf(e), function);
+        Stmt *s = t ? defUses.defStmt(*t) : 0;
+        return s && s->asPhi() ? t : 0;
+    }
+
+    bool isSameCounter(Expr *e, Temp *counter) const
+    {
+        Temp *t = counterOf(e);
+        return t && UntypedTemp(*t) == UntypedTemp(*counter);
+    }
+
+    Const *constantOf(Expr *e) const
+    {
+        if (Const *c = e->asConst())
+            return c;
+        Move *m = moveDefining(e);
+        return m ? m->source->asConst() : 0;
+    }
+
+    // Every value coming into the counter's phi is a non-negative integer, or the counter plus one.
+    bool isUpCounter(Temp *counter) const
+    {
+        Phi *phi = defUses.defStmt(*counter)->asPhi();
+        foreach (Expr *incoming, phi->d->incoming) {
+            if (Const *c = constantOf(incoming)) {
+                if (!(c->type & NumberType) || c->value < 0 || c->value != int(c->value))
+                    return false;
+                continue;
+            }
+            Move *m = moveDefining(incoming);
+            Binop *step = m ? m->source->asBinop() : 0;
+            if (!step || step->op != OpAdd)
+                return false;
+            if (!(isOne(step->right) && isSameCounter(step->left, counter))
+                    && !(isOne(step->left) && isSameCounter(step->right, counter)))
+                return false;
+        }
+        return true;
+    }
+
+    bool isBelowLength(Expr *cond, Temp *counter, const QSet<UntypedTemp> &arrays,
+                       int length) const
+    {
+        Binop *comparison = cond->asBinop();
+        if (!comparison) {
+            Move *m = moveDefining(cond);
+            comparison = m ? m->source->asBinop() : 0;
+        }
+        if (!comparison)
+            return false;
+        if (comparison->op == OpLt)
+            return isSameCounter(comparison->left, counter)
+                    && holdsLength(comparison->right, arrays, length);
+        if (comparison->op == OpGt)
+            return isSameCounter(comparison->right, counter)
+                    && holdsLength(comparison->left, arrays, length);
+        return false;
+    }
+
+    bool holdsLength(Expr *e, const QSet<UntypedTemp> &arrays, int length) const
+    {
+        e = valueOf(e);
+        if (Const *c = e->asConst())
+            return (c->type & NumberType) && c->value <= length;
+        Move *m = moveDefining(e);
+        Member *member = m ? m->source->asMember() : 0;
+        if (!member || member->kind != Member::UnspecifiedMember || member->property
+                || *member->name != QLatin1String("length"))
+            return false;
+        Temp *base = unescapableTemp(member->base, function);
+        return base && arrays.contains(*base);
+    }
+
+    static bool isOne(Expr *e)
+    {
+        Const *c = e->asConst();
+        return c && (c->type & NumberType) && c->value == 1;
+    }
+};
+
+// Scalar replacement of object literals, array literals and arguments objects that do not escape
+// the function: reads of their properties are replaced by the values stored in them, and the
+// allocation is removed. An allocation escapes as soon as it is used for anything else than
+// reading or writing a property known at compile time, or being copied to another temp.
+//
+// Properties can only be written when the allocation and all its uses are in one basic block, so
+// the stored values can be tracked in statement order without having to insert phi nodes.
+class ScalarReplacement
+{
+    enum { LengthSlot = -1 };
+
+    enum AccessKind {
+        Read,
+        ElementRead, // of an array element, at an index only known at run time
+        Write,
+        Copy
+    };
+
+    struct Access {
+        Access(Stmt *stmt = 0, AccessKind kind = Read, int slot = 0)
+            : stmt(stmt), kind(kind), slot(slot), replacement(0)
+        {}
+
+        Stmt *stmt;
+        AccessKind kind;
+        int slot;
+        Expr *replacement;
+    };
+
+    IR::Function *function;
+    DefUsesCalculator &defUses;
+    const DominatorTree &df;
+    QBitArray assignedFormals;
+
+    // State for the allocation being looked at:
+    Name::Builtin kind;
+    QVector<const QString *> keys;
+    QVector<Expr *> values; // 0 for a hole
+    QVector<Access> accesses;
+    QSet<UntypedTemp> aliases;
+
+public:
+    ScalarReplacement(IR::Function *function, DefUsesCalculator &defUses, const DominatorTree &df)
+        : function(function)
+        , defUses(defUses)
+        , df(df)
+        , kind(Name::builtin_invalid)
+    {}
+
+    void run()
+    {
+        QVector<QPair<Move *, BasicBlock *> > allocations;
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                if (Move *m = s->asMove()) {
+                    if (isAllocation(m))
+                        allocations.append(qMakePair(m, bb));
+                    else if (Temp *t = m->target->asTemp())
+                        if (t->kind == Temp::Formal)
+                            markFormalAssigned(t->index);
+                }
+            }
+        }
+
+        // Outer literals are created after the inner ones they contain. Replacing them first
+        // turns the inner literal's only use into reads, so it can be replaced too.
+        for (int i = allocations.size() - 1; i >= 0; --i)
+            tryReplace(allocations.at(i).first, allocations.at(i).second);
+    }
+
+private:
+    bool isAllocation(Move *m) const
+    {
+        if (!unescapableTemp(m->target, function))
+            return false;
+        Call *c = m->source->asCall();
+        Name *n = c ? c->base->asName() : 0;
+        if (!n)
+            return false;
+        return n->builtin == Name::builtin_define_object_literal
+                || n->builtin == Name::builtin_define_array
+                || n->builtin == Name::builtin_setup_argument_object;
+    }
+
+    void markFormalAssigned(unsigned index)
+    {
+        if (int(index) >= assignedFormals.size())
+            assignedFormals.resize(index + 1);
+        assignedFormals.setBit(index);
+    }
+
+    bool isStorable(Expr *e) const
+    {
+        return e->asConst() || unescapableTemp(e, function);
+    }
+
+    bool isAlias(Expr *e) const
+    {
+        Temp *t = e->asTemp();
+        return t && aliases.contains(*t);
+    }
+
+    void tryReplace(Move *allocation, BasicBlock *allocationBlock)
+    {
+        Call *call = allocation->source->asCall();
+        kind = call->base->asName()->builtin;
+        keys.clear();
+        values.clear();
+        accesses.clear();
+        aliases.clear();
+
+        if (!collectValues(call))
+            return;
+
+        // Find all uses, following copies.
+        QVector<Temp *> worklist;
+        worklist.append(allocation->target->asTemp());
+        aliases.insert(*worklist.first());
+        QSet<Stmt *> seen;
+        bool hasWrites = false;
+        bool hasElementReads = false;
+        while (!worklist.isEmpty()) {
+            Temp *alias = worklist.last();
+            worklist.removeLast();
+            foreach (Stmt *use, defUses.uses(*alias)) {
+                if (seen.contains(use))
+                    continue;
+                seen.insert(use);
+
+                Access access;
+                if (!classify(use, &access))
+                    return;
+                if (access.kind == Copy) {
+                    Temp *copy = use->asMove()->target->asTemp();
+                    aliases.insert(*copy);
+                    worklist.append(copy);
+                } else if (access.kind == Write) {
+                    hasWrites = true;
+                } else if (access.kind == ElementRead) {
+                    hasElementReads = true;
+                }
+                accesses.append(access);
+            }
+        }
+
+        if (hasElementReads) {
+            // The array has to stay. When nothing is stored into it, its length is still known,
+            // unless an element read hits a hole or an index past the end: that runs an indexed
+            // accessor on the prototype chain, which can change the array.
+            if (hasWrites || values.contains(0))
+                return;
+            ElementIndexBounds bounds(function, defUses, df);
+            foreach (const Access &access, accesses) {
+                if (access.kind != ElementRead)
+                    continue;
+                Move *m = access.stmt->asMove();
+                if (!bounds.isInBounds(m->source->asSubscript()->index,
+                                       defUses.defStmtBlock(*m->target->asTemp()), aliases,
+                                       values.size()))
+                    return;
+            }
+            for (int i = 0, ei = accesses.size(); i != ei; ++i) {
+                Access &access = accesses[i];
+                if (access.kind == Read && access.slot == LengthSlot && resolveRead(&access))
+                    replaceRead(access);
+            }
+            return;
+        }
+
+        if (hasWrites) {
+            // Replay the block, so every read sees the last value written before it.
+            QHash<Stmt *, int> accessIndex;
+            for (int i = 0, ei = accesses.size(); i != ei; ++i)
+                accessIndex.insert(accesses.at(i).stmt, i);
+            int found = 0;
+            foreach (Stmt *s, allocationBlock->statements()) {
+                QHash<Stmt *, int>::const_iterator it = accessIndex.constFind(s);
+                if (it == accessIndex.constEnd())
+                    continue;
+                ++found;
+                Access &access = accesses[it.value()];
+                if (access.kind == Write)
+                    values[access.slot] = access.stmt->asMove()->source;
+                else if (access.kind == Read && !resolveRead(&access))
+                    return;
+            }
+            if (found != accesses.size())
+                return;
+        } else {
+            for (int i = 0, ei = accesses.size(); i != ei; ++i)
+                if (accesses.at(i).kind == Read && !resolveRead(&accesses[i]))
+                    return;
+        }
+
+        // Nothing escapes, so rewrite the reads and drop everything else.
+        foreach (const Access &access, accesses) {
+            Move *m = access.stmt->asMove();
+            switch (access.kind) {
+            case Read:
+                replaceRead(access);
+                break;
+            case ElementRead:
+                Q_UNREACHABLE();
+                break;
+            case Copy: {
+                BasicBlock *bb = defUses.defStmtBlock(*m->target->asTemp());
+                defUses.removeDefUses(m);
+                bb->removeStatement(m);
+            } break;
+            case Write:
+                defUses.removeDefUses(m);
+                allocationBlock->removeStatement(m);
+                break;
+            }
+        }
+        defUses.removeDefUses(allocation);
+        allocationBlock->removeStatement(allocation);
+    }
+
+    void replaceRead(const Access &access)
+    {
+        Move *m = access.stmt->asMove();
+        defUses.removeUse(m, *sourceBase(m)->asTemp());
+        if (Subscript *subscript = m->source->asSubscript())
+            if (Temp *index = subscript->index->asTemp())
+                defUses.removeUse(m, *index);
+        m->source = access.replacement;
+        if (Temp *t = unescapableTemp(access.replacement, function))
+            defUses.addUse(*t, m);
+    }
+
+    bool collectValues(Call *call)
+    {
+        ExprList *args = call->args;
+        switch (kind) {
+        case Name::builtin_define_object_literal: {
+            // The arguments are the number of key/value pairs, followed by a name, a
+            // "has value" flag and the value (or a getter and a setter) per pair, followed by the
+            // array entries.
+            const int count = args->expr->asConst()->value;
+            args = args->next;
+            for (int i = 0; i < count; ++i) {
+                keys.append(args->expr->asName()->id);
+                args = args->next;
+                if (!args->expr->asConst()->value)
+                    return false; // accessor property
+                args = args->next;
+                if (!isStorable(args->expr))
+                    return false;
+                values.append(args->expr);
+                args = args->next;
+            }
+            return !args;
+        }
+        case Name::builtin_define_array:
+            for (; args; args = args->next) {
+                if (args->expr->type == MissingType)
+                    values.append(0);
+                else if (isStorable(args->expr))
+                    values.append(args->expr);
+                else
+                    return false;
+            }
+            return true;
+        case Name::builtin_setup_argument_object:
+            return true;
+        default:
+            Q_UNREACHABLE();
+            return false;
+        }
+    }
+
+    static Expr *sourceBase(Move *m)
+    {
+        if (Member *member = m->source->asMember())
+            return member->base;
+        return m->source->asSubscript()->base;
+    }
+
+    bool classify(Stmt *use, Access *access) const
+    {
+        Move *m = use->asMove();
+        if (!m || m->swap)
+            return false;
+
+        if (isAlias(m->source)) {
+            if (!unescapableTemp(m->target, function))
+                return false;
+            *access = Access(use, Copy);
+            return true;
+        }
+
+        if (m->target->asTemp()) {
+            *access = Access(use, Read);
+            if (resolveSlot(m->source, /*isWrite*/ false, &access->slot))
+                return true;
+            Subscript *subscript = m->source->asSubscript();
+            if (kind != Name::builtin_define_array || !subscript || !isAlias(subscript->base)
+                    || isAlias(subscript->index))
+                return false;
+            access->kind = ElementRead;
+            return true;
+        }
+
+        if (!isStorable(m->source))
+            return false;
+        *access = Access(use, Write);
+        return resolveSlot(m->target, /*isWrite*/ true, &access->slot);
+    }
+
+    bool resolveSlot(Expr *e, bool isWrite, int *slot) const
+    {
+        if (Member *member = e->asMember()) {
+            if (!isAlias(member->base) || member->kind != Member::UnspecifiedMember || member->property)
+                return false;
+            if (kind == Name::builtin_define_object_literal) {
+                for (int i = 0, ei = keys.size(); i != ei; ++i) {
+                    if (*keys.at(i) == *member->name) {
+                        *slot = i;
+                        return true;
+                    }
+                }
+                return false;
+            }
+            if (isWrite || *member->name != QLatin1String("length"))
+                return false;
+            *slot = LengthSlot;
+            return true;
+        }
+
+        if (Subscript *subscript = e->asSubscript()) {
+            if (!isAlias(subscript->base) || kind == Name::builtin_define_object_literal)
+                return false;
+            Const *c = constantIndex(subscript->index);
+            if (!c || !(c->type & NumberType) || c->value < 0 || c->value != int(c->value))
+                return false;
+            const int index = int(c->value);
+            if (kind == Name::builtin_define_array) {
+                *slot = index;
+                return index < values.size();
+            }
+            // arguments[i] is the (unmodified) formal parameter i, or undefined when there are
+            // fewer arguments, which is what the formal holds then as well.
+            if (isWrite || index >= function->formals.size()
+                    || (index < assignedFormals.size() && assignedFormals.testBit(index)))
+                return false;
+            *slot = index;
+            return true;
+        }
+
+        return false;
+    }
+
+    // The code generator always puts subscript indexes in a temp, and constants are only
+    // propagated later on.
+    Const *constantIndex(Expr *index) const
+    {
+        if (Const *c = index->asConst())
+            return c;
+        if (Temp *t = unescapableTemp(index, function))
+            if (Stmt *s = defUses.defStmt(*t))
+                if (Move *m = s->asMove())
+                    return m->source->asConst();
+        return 0;
+    }
+
+    bool resolveRead(Access *access)
+    {
+        Expr *value = 0;
+        if (access->slot == LengthSlot) {
+            if (kind == Name::builtin_define_array) {
+                Const *c = function->New<Const>();
+                c->init(NumberType, values.size());
+                value = c;
+            } else {
+                Name *argumentCount = function->New<Name>();
+                argumentCount->init(Name::builtin_argument_count, 0, 0);
+                argumentCount->freeOfSideEffects = true;
+                Call *c = function->New<Call>();
+                c->init(argumentCount, 0);
+                value = c;
+            }
+        } else if (kind == Name::builtin_setup_argument_object) {
+            Temp *formal = function->New<Temp>();
+            formal->init(Temp::Formal, access->slot, 0);
+            value = formal;
+        } else if (Expr *stored = values.at(access->slot)) {
+            value = clone(stored, function);
+        } else {
+            return false; // a hole: the value comes from the prototype chain
+        }
+
+        access->replacement = value;
+        return true;
+    }
+};
+
 class InputOutputCollector: protected StmtVisitor, protected ExprVisitor {
     IR::Function *function;
 
@@ -3483,56 +4033,538 @@ public:
     QList<Temp> inputs;
     QList<Temp> outputs;
 
-    InputOutputCollector(IR::Function *f): function(f) {}
+    InputOutputCollector(IR::Function *f): function(f) {}
+
+    void collect(Stmt *s) {
+        inputs.clear();
+        outputs.clear();
+        s->accept(this);
+    }
+
+protected:
+    virtual void visitConst(Const *) {}
+    virtual void visitString(IR::String *) {}
+    virtual void visitRegExp(IR::RegExp *) {}
+    virtual void visitName(Name *) {}
+    virtual void visitTemp(Temp *e) {
+        if (unescapableTemp(e, function))
+            inputs.append(*e);
+    }
+    virtual void visitClosure(Closure *) {}
+    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
+    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
+    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
+    virtual void visitCall(Call *e) {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+    virtual void visitNew(New *e) {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
+    virtual void visitMember(Member *e) { e->base->accept(this); }
+    virtual void visitExp(Exp *s) { s->expr->accept(this); }
+    virtual void visitMove(Move *s) {
+        s->source->accept(this);
+        if (Temp *t = s->target->asTemp()) {
+            if (unescapableTemp(t, function))
+                outputs.append(*t);
+            else
+                s->target->accept(this);
+        } else {
+            s->target->accept(this);
+        }
+    }
+    virtual void visitJump(Jump *) {}
+    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
+    virtual void visitRet(Ret *s) { s->expr->accept(this); }
+    virtual void visitPhi(Phi *) {
+        // Handled separately
+    }
+};
+
+// A natural loop: the header and all blocks that can reach one of its back edges without passing
+// through the header. Back edges that jump to the same header are treated as one loop.
+struct NaturalLoop
+{
+    NaturalLoop()
+        : header(0)
+    {}
+
+    BasicBlock *header;
+    QVector<BasicBlock *> latches;
+    QVector<BasicBlock *> blocks;
+    std::vector<bool> body; // BasicBlock index -> is part of the loop
+
+    bool contains(BasicBlock *bb) const
+    {
+        return static_cast<size_t>(bb->index()) < body.size() && body[bb->index()];
+    }
+
+    // The only block outside the loop that jumps to the header, provided it has no other
+    // successors. After critical edge splitting this exists for every loop with a single entry.
+    BasicBlock *preheader() const
+    {
+        BasicBlock *candidate = 0;
+        foreach (BasicBlock *pred, header->in) {
+            if (contains(pred))
+                continue;
+            if (candidate)
+                return 0;
+            candidate = pred;
+        }
+        if (candidate && candidate->out.size() == 1)
+            return candidate;
+        return 0;
+    }
+};
+
+bool innerLoopFirst(const NaturalLoop &l1, const NaturalLoop &l2)
+{
+    return l1.blocks.size() < l2.blocks.size();
+}
+
+QVector<NaturalLoop> findLoops(IR::Function *function, const DominatorTree &df)
+{
+    QVector<NaturalLoop> loops;
+
+    foreach (BasicBlock *header, function->basicBlocks()) {
+        if (header->isRemoved())
+            continue;
+
+        NaturalLoop loop;
+        foreach (BasicBlock *pred, header->in)
+            if (pred == header || df.dominates(header, pred))
+                loop.latches.append(pred);
+        if (loop.latches.isEmpty())
+            continue;
+
+        loop.header = header;
+        loop.body.resize(function->basicBlockCount(), false);
+        loop.body[header->index()] = true;
+        loop.blocks.append(header);
+
+        QVector<BasicBlock *> worklist = loop.latches;
+        while (!worklist.isEmpty()) {
+            BasicBlock *bb = worklist.last();
+            worklist.removeLast();
+            if (loop.body[bb->index()])
+                continue;
+            loop.body[bb->index()] = true;
+            loop.blocks.append(bb);
+            foreach (BasicBlock *pred, bb->in)
+                if (!pred->isRemoved())
+                    worklist.append(pred);
+        }
+
+        loops.append(loop);
+    }
+
+    // Inner loops come first, so whatever gets hoisted out of an inner loop can then be hoisted
+    // out of the enclosing loop too.
+    std::stable_sort(loops.begin(), loops.end(), innerLoopFirst);
+    return loops;
+}
+
+// Types the counter of a counting loop, like "for (var i = 0; i < n; ++i)", as int32 when the loop
+// condition proves that stepping it cannot overflow. Type inference alone types such a counter as a
+// double, because the result of an addition is a double in general.
+class InductionVariables
+{
+    IR::Function *function;
+    const DefUsesCalculator &defUses;
+
+public:
+    InductionVariables(IR::Function *function, const DefUsesCalculator &defUses)
+        : function(function)
+        , defUses(defUses)
+    {}
+
+    void run(const QVector<NaturalLoop> &loops)
+    {
+        foreach (const NaturalLoop &loop, loops) {
+            if (loop.latches.size() != 1 || loop.header->in.size() != 2)
+                continue;
+
+            // The loop must be left through the header's condition, when it is false.
+            CJump *exit = loop.header->terminator() ? loop.header->terminator()->asCJump() : 0;
+            if (!exit || !loop.contains(exit->iftrue) || loop.contains(exit->iffalse))
+                continue;
+            Binop *condition = exit->cond->asBinop();
+            if (!condition) {
+                if (Temp *t = unescapableTemp(exit->cond, function))
+                    if (Stmt *s = defUses.defStmt(*t))
+                        if (Move *m = s->asMove())
+                            condition = m->source->asBinop();
+            }
+            if (!condition)
+                continue;
+
+            const int backEdge = loop.header->in.indexOf(loop.latches.first());
+            foreach (Stmt *s, loop.header->statements()) {
+                Phi *phi = s->asPhi();
+                if (!phi)
+                    break;
+                tryCounter(phi, backEdge, condition);
+            }
+        }
+    }
+
+private:
+    void tryCounter(Phi *phi, int backEdge, Binop *condition)
+    {
+        Temp *counter = phi->targetTemp;
+        if (counter->type == SInt32Type || phi->d->incoming.size() != 2)
+            return;
+        if (phi->d->incoming.at(1 - backEdge)->type != SInt32Type)
+            return;
+
+        // The value coming in over the back edge must be the counter plus or minus one.
+        Temp *next = unescapableTemp(phi->d->incoming.at(backEdge), function);
+        Move *nextMove = next ? moveDefining(next) : 0;
+        Binop *step = nextMove ? nextMove->source->asBinop() : 0;
+        if (!step)
+            return;
+        int direction = 0;
+        Expr *stepped = 0;
+        if (step->op == OpAdd && isOne(step->right)) {
+            direction = 1;
+            stepped = step->left;
+        } else if (step->op == OpAdd && isOne(step->left)) {
+            direction = 1;
+            stepped = step->right;
+        } else if (step->op == OpSub && isOne(step->right)) {
+            direction = -1;
+            stepped = step->left;
+        } else {
+            return;
+        }
+
+        // ++i and i++ step "+i" rather than i itself.
+        Unop *plus = 0;
+        Temp *plusTemp = 0;
+        if (!isSameTemp(stepped, counter)) {
+            plusTemp = unescapableTemp(stepped, function);
+            Move *plusMove = plusTemp ? moveDefining(plusTemp) : 0;
+            plus = plusMove ? plusMove->source->asUnop() : 0;
+            if (!plus || plus->op != OpUPlus || !isSameTemp(plus->expr, counter))
+                return;
+        }
+
+        // Now check that the condition keeps the counter away from the end of the int32 range.
+        AluOp op = condition->op;
+        Expr *bound = condition->right;
+        if (!isSameTemp(condition->left, counter)) {
+            if (!isSameTemp(condition->right, counter))
+                return;
+            bound = condition->left;
+            switch (op) {
+            case OpLt: op = OpGt; break;
+            case OpLe: op = OpGe; break;
+            case OpGt: op = OpLt; break;
+            case OpGe: op = OpLe; break;
+            default: return;
+            }
+        }
+        if (bound->type != SInt32Type)
+            return;
+        Const *constBound = bound->asConst();
+        if (direction > 0) {
+            if (op == OpLe) {
+                if (!constBound || constBound->value >= INT_MAX)
+                    return;
+            } else if (op != OpLt) {
+                return;
+            }
+        } else {
+            if (op == OpGe) {
+                if (!constBound || constBound->value <= INT_MIN)
+                    return;
+            } else if (op != OpGt) {
+                return;
+            }
+        }
+
+        PropagateTempTypes propagator(defUses);
+        propagator.run(*counter, SInt32Type);
+        propagator.run(*next, SInt32Type);
+        step->type = SInt32Type;
+        if (plus) {
+            propagator.run(*plusTemp, SInt32Type);
+            plus->type = SInt32Type;
+        }
+    }
+
+    Move *moveDefining(Temp *t) const
+    {
+        Stmt *s = defUses.defStmt(*t);
+        return s ? s->asMove() : 0;
+    }
+
+    static bool isOne(Expr *e)
+    {
+        Const *c = e->asConst();
+        return c && (c->type & NumberType) && c->value == 1;
+    }
+
+    static bool isSameTemp(Expr *e, Temp *t)
+    {
+        Temp *other = e->asTemp();
+        return other && UntypedTemp(*other) == UntypedTemp(*t);
+    }
+};
+
+// Moves loop-invariant computations into the preheader of their loop. Only expressions without
+// side effects are hoisted: arithmetic on numbers and booleans, copies, and the length of an array
+// that the function allocated and whose length can't change. Anything else that can call out to
+// JavaScript (a conversion of an object, a property read, a call) stays in the loop.
+class LoopInvariantCodeMotion
+{
+    struct LocalArray {
+        LocalArray(int length = 0, bool fixedLength = false)
+            : length(length)
+            , fixedLength(fixedLength)
+        {}
+
+        int length; // of the array literal
+        bool fixedLength;
+        QVector<QPair<Move *, BasicBlock *> > elementReads;
+    };
+
+    IR::Function *function;
+    const DefUsesCalculator &defUses;
+    const DominatorTree &df;
+    QSet<UntypedTemp> definedInLoop;
+    // Arrays allocated by the function that nothing else gets a reference to.
+    QHash<UntypedTemp, LocalArray> localArrays;
+
+public:
+    LoopInvariantCodeMotion(IR::Function *function, const DefUsesCalculator &defUses,
+                            const DominatorTree &df)
+        : function(function)
+        , defUses(defUses)
+        , df(df)
+    {}
+
+    void run(const QVector<NaturalLoop> &loops)
+    {
+        if (!loops.isEmpty())
+            findLocalArrays();
+
+        foreach (const NaturalLoop &loop, loops) {
+            BasicBlock *preheader = loop.preheader();
+            if (!preheader)
+                continue;
+
+            definedInLoop.clear();
+            foreach (BasicBlock *bb, loop.blocks) {
+                foreach (Stmt *s, bb->statements()) {
+                    if (Move *m = s->asMove()) {
+                        if (Temp *t = m->target->asTemp())
+                            definedInLoop.insert(*t);
+                    } else if (Phi *phi = s->asPhi()) {
+                        definedInLoop.insert(*phi->targetTemp);
+                    }
+                }
+            }
+
+            for (bool changed = true; changed; ) {
+                changed = false;
+                foreach (BasicBlock *bb, loop.blocks) {
+                    for (int i = 0; i < bb->statementCount(); ) {
+                        Move *m = bb->statements().at(i)->asMove();
+                        Temp *target = m && !m->swap ? unescapableTemp(m->target, function) : 0;
+                        if (target && isHoistable(m->source)) {
+                            bb->removeStatement(i);
+                            preheader->insertStatementBeforeTerminator(m);
+                            definedInLoop.remove(*target);
+                            changed = true;
+                        } else {
+                            ++i;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    bool isLocalArray(Expr *e) const
+    {
+        Temp *t = unescapableTemp(e, function);
+        return t && localArrays.contains(*t);
+    }
+
+    // Allocations are only used as the base of element reads, element stores and reads of the
+    // length. Any other use, like a call, a phi or a return, lets the array escape.
+    //
+    // The length of an array literal without holes stays fixed when elements are only stored at
+    // constant indexes below its length, and no element read can miss and run an indexed accessor
+    // on the prototype chain.
+    void findLocalArrays()
+    {
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                Move *m = s->asMove();
+                Temp *t = m ? unescapableTemp(m->target, function) : 0;
+                Call *c = t ? m->source->asCall() : 0;
+                Name *n = c ? c->base->asName() : 0;
+                if (!n || n->builtin != Name::builtin_define_array)
+                    continue;
+                LocalArray array(0, true);
+                for (ExprList *it = c->args; it; it = it->next, ++array.length)
+                    if (it->expr->type == MissingType)
+                        array.fixedLength = false;
+                localArrays.insert(*t, array);
+            }
+        }
+        if (localArrays.isEmpty())
+            return;
+
+        InputOutputCollector collector(function);
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                if (Phi *phi = s->asPhi()) {
+                    foreach (Expr *e, phi->d->incoming)
+                        if (Temp *t = e->asTemp())
+                            localArrays.remove(*t);
+                    continue;
+                }
+                if (Move *m = s->asMove())
+                    if (isLocalArrayAccess(m, bb))
+                        continue;
+                collector.collect(s);
+                foreach (const Temp &t, collector.inputs)
+                    localArrays.remove(t);
+            }
+        }
+
+        ElementIndexBounds bounds(function, defUses, df);
+        for (QHash<UntypedTemp, LocalArray>::iterator it = localArrays.begin(),
+             end = localArrays.end(); it != end; ++it) {
+            LocalArray &array = it.value();
+            QSet<UntypedTemp> arrays;
+            arrays.insert(it.key());
+            for (int i = 0, ei = array.elementReads.size(); i != ei && array.fixedLength; ++i) {
+                Move *read = array.elementReads.at(i).first;
+                if (!bounds.isInBounds(read->source->asSubscript()->index,
+                                       array.elementReads.at(i).second, arrays, array.length))
+                    array.fixedLength = false;
+            }
+        }
+    }
+
+    bool isLocalArrayAccess(Move *m, BasicBlock *bb)
+    {
+        if (m->swap)
+            return false;
+        if (m->target->asTemp()) {
+            if (Member *member = m->source->asMember())
+                return isLocalArray(member->base) && isArrayLength(member);
+            if (Subscript *subscript = m->source->asSubscript()) {
+                if (!isLocalArray(subscript->base) || isLocalArray(subscript->index))
+                    return false;
+                localArrays[*subscript->base->asTemp()].elementReads.append(qMakePair(m, bb));
+                return true;
+            }
+            return false;
+        }
+        Subscript *subscript = m->target->asSubscript();
+        if (!subscript || !isLocalArray(subscript->base) || isLocalArray(subscript->index)
+                || isLocalArray(m->source))
+            return false;
+        LocalArray &array = localArrays[*subscript->base->asTemp()];
+        Const *c = constantIndex(subscript->index);
+        if (!c || !(c->type & NumberType) || c->value < 0 || c->value >= array.length
+                || c->value != int(c->value))
+            array.fixedLength = false;
+        return true;
+    }
+
+    Const *constantIndex(Expr *index) const
+    {
+        if (Const *c = index->asConst())
+            return c;
+        if (Temp *t = unescapableTemp(index, function))
+            if (Stmt *s = defUses.defStmt(*t))
+                if (Move *m = s->asMove())
+                    return m->source->asConst();
+        return 0;
+    }
 
-    void collect(Stmt *s) {
-        inputs.clear();
-        outputs.clear();
-        s->accept(this);
+    static bool isArrayLength(Member *member)
+    {
+        return member->kind == Member::UnspecifiedMember && !member->property
+                && *member->name == QLatin1String("length");
     }
 
-protected:
-    virtual void visitConst(Const *) {}
-    virtual void visitString(IR::String *) {}
-    virtual void visitRegExp(IR::RegExp *) {}
-    virtual void visitName(Name *) {}
-    virtual void visitTemp(Temp *e) {
-        if (unescapableTemp(e, function))
-            inputs.append(*e);
+    bool isInvariant(Expr *e) const
+    {
+        if (e->asConst())
+            return true;
+        if (Temp *t = unescapableTemp(e, function))
+            return !definedInLoop.contains(*t);
+        return false;
     }
-    virtual void visitClosure(Closure *) {}
-    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
-    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
-    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
-    virtual void visitCall(Call *e) {
-        e->base->accept(this);
-        for (ExprList *it = e->args; it; it = it->next)
-            it->expr->accept(this);
+
+    bool isInvariantArrayLength(Member *member) const
+    {
+        if (!isArrayLength(member) || !isInvariant(member->base))
+            return false;
+        Temp *base = unescapableTemp(member->base, function);
+        QHash<UntypedTemp, LocalArray>::const_iterator it = localArrays.constFind(*base);
+        return it != localArrays.constEnd() && it->fixedLength;
     }
-    virtual void visitNew(New *e) {
-        e->base->accept(this);
-        for (ExprList *it = e->args; it; it = it->next)
-            it->expr->accept(this);
+
+    static bool isPrimitive(Expr *e)
+    {
+        return (e->type & NumberType) || e->type == BoolType;
     }
-    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
-    virtual void visitMember(Member *e) { e->base->accept(this); }
-    virtual void visitExp(Exp *s) { s->expr->accept(this); }
-    virtual void visitMove(Move *s) {
-        s->source->accept(this);
-        if (Temp *t = s->target->asTemp()) {
-            if (unescapableTemp(t, function))
-                outputs.append(*t);
-            else
-                s->target->accept(this);
-        } else {
-            s->target->accept(this);
+
+    bool isHoistable(Expr *source) const
+    {
+        if (source->asConst() || source->asTemp())
+            return isInvariant(source);
+
+        if (Member *member = source->asMember())
+            return isInvariantArrayLength(member);
+
+        if (Convert *c = source->asConvert())
+            return isPrimitive(c) && isPrimitive(c->expr) && isInvariant(c->expr);
+
+        if (Unop *u = source->asUnop()) {
+            switch (u->op) {
+            case OpNot:
+            case OpUMinus:
+            case OpUPlus:
+            case OpCompl:
+                return isPrimitive(u->expr) && isInvariant(u->expr);
+            default:
+                return false;
+            }
         }
-    }
-    virtual void visitJump(Jump *) {}
-    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
-    virtual void visitRet(Ret *s) { s->expr->accept(this); }
-    virtual void visitPhi(Phi *) {
-        // Handled separately
+
+        if (Binop *b = source->asBinop()) {
+            switch (b->op) {
+            case OpInstanceof:
+            case OpIn:
+            case OpAnd:
+            case OpOr:
+                return false;
+            default:
+                return isPrimitive(b->left) && isPrimitive(b->right)
+                        && isInvariant(b->left) && isInvariant(b->right);
+            }
+        }
+
+        return false;
     }
 };
 
@@ -3859,6 +4891,13 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine)
         cleanupPhis(defUses);
 //        showMeTheCode(function);
 
+        static bool doOpt = qgetenv("QV4_NO_OPT").isEmpty();
+        if (doOpt) {
+//            qout << "Replacing non-escaping allocations..." << endl;
+            ScalarReplacement(function, defUses, df).run();
+//            showMeTheCode(function);
+        }
+
 //        qout << "Running type inference..." << endl;
         TypeInference(qmlEngine, defUses).run(function);
 //        showMeTheCode(function);
@@ -3867,6 +4906,12 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine)
         ReverseInference(defUses).run(function);
 //        showMeTheCode(function);
 
+        if (doOpt) {
+//            qout << "Typing loop counters..." << endl;
+            InductionVariables(function, defUses).run(findLoops(function, df));
+//            showMeTheCode(function);
+        }
+
 //        qout << "Doing type propagation..." << endl;
         TypePropagation(defUses).run(function);
 //        showMeTheCode(function);
@@ -3876,7 +4921,6 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine)
         splitCriticalEdges(function, df);
 //        showMeTheCode(function);
 
-        static bool doOpt = qgetenv("QV4_NO_OPT").isEmpty();
         if (doOpt) {
 //            qout << "Running SSA optimization..." << endl;
             optimizeSSA(function, defUses, df);
@@ -3894,6 +4938,12 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine)
         cleanupBasicBlocks(function);
 //        showMeTheCode(function);
 
+        if (doOpt) {
+//            qout << "Hoisting loop invariants..." << endl;
+            LoopInvariantCodeMotion(function, defUses, df).run(findLoops(function, df));
+//            showMeTheCode(function);
+        }
+
 //        qout << "Doing block scheduling..." << endl;
 //        df.dumpImmediateDominators();
         startEndLoops = BlockScheduler(function, df).go();
@@ -4016,6 +5066,466 @@ void Optimizer::showMeTheCode(IR::Function *function)
     ::showMeTheCode(function);
 }
 
+namespace {
+
+enum {
+    // Statements of a callee's body, the initialization of its locals included.
+    MaxInlinedStatementCount = 24,
+    // Upper bound for the code a single caller can grow by.
+    MaxInlinedStatementsPerCaller = 240
+};
+
+// Checks whether a function's body can be copied into another function of the same unit, and
+// collects the names it looks up in its scope.
+class InlineCandidateChecker: protected StmtVisitor, protected ExprVisitor
+{
+public:
+    InlineCandidateChecker()
+        : freeNames(0)
+        , ok(true)
+    {}
+
+    bool check(Function *function, QSet<QString> *freeNames)
+    {
+        this->freeNames = freeNames;
+        ok = true;
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                s->accept(this);
+                if (!ok)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+protected:
+    virtual void visitConst(Const *) {}
+    virtual void visitString(IR::String *) {}
+    virtual void visitRegExp(IR::RegExp *) {}
+
+    virtual void visitName(Name *e)
+    {
+        switch (e->builtin) {
+        case Name::builtin_invalid:
+            if (e->id)
+                freeNames->insert(*e->id);
+            else
+                ok = false;
+            break;
+        case Name::builtin_typeof:
+        case Name::builtin_delete:
+        case Name::builtin_throw:
+        case Name::builtin_foreach_iterator_object:
+        case Name::builtin_foreach_next_property_name:
+        case Name::builtin_define_array:
+        case Name::builtin_define_object_literal:
+            break;
+        default:
+            // Anything touching the scope, the arguments or this belongs to the callee's frame.
+            ok = false;
+            break;
+        }
+    }
+
+    virtual void visitTemp(Temp *e)
+    {
+        if (e->scope != 0)
+            ok = false;
+        else if (e->kind != Temp::Formal && e->kind != Temp::Local && e->kind != Temp::VirtualRegister)
+            ok = false;
+    }
+
+    virtual void visitClosure(Closure *) { ok = false; }
+    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
+    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
+    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
+
+    virtual void visitCall(Call *e)
+    {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+
+    virtual void visitNew(New *e)
+    {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+
+    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
+    virtual void visitMember(Member *e) { e->base->accept(this); }
+
+    virtual void visitExp(Exp *s) { s->expr->accept(this); }
+    virtual void visitMove(Move *s) { s->target->accept(this); s->source->accept(this); }
+    virtual void visitJump(Jump *) {}
+    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
+    virtual void visitRet(Ret *s) { s->expr->accept(this); }
+    virtual void visitPhi(Phi *) { ok = false; }
+
+private:
+    QSet<QString> *freeNames;
+    bool ok;
+};
+
+// Clones the callee's expressions into the caller, renaming the callee's arguments, locals and
+// temporaries to fresh temporaries of the caller.
+class InlinedExprCloner: public CloneExpr
+{
+public:
+    InlinedExprCloner(const QVector<unsigned> &formals, const QVector<unsigned> &locals,
+                      unsigned tempBase)
+        : formals(formals)
+        , locals(locals)
+        , tempBase(tempBase)
+    {}
+
+protected:
+    // Strings are interned again in the caller, the callee may be optimized concurrently.
+    virtual void visitString(IR::String *e)
+    {
+        cloned = block->STRING(block->function->newString(*e->value));
+    }
+
+    virtual void visitRegExp(IR::RegExp *e)
+    {
+        cloned = block->REGEXP(block->function->newString(*e->value), e->flags);
+    }
+
+    virtual void visitName(Name *e)
+    {
+        Name *name = cloneName(e, block->function);
+        if (name->id)
+            name->id = block->function->newString(*name->id);
+        cloned = name;
+    }
+
+    virtual void visitTemp(Temp *e)
+    {
+        Q_ASSERT(e->scope == 0);
+        switch (e->kind) {
+        case Temp::Formal:
+            cloned = block->TEMP(formals.at(e->index));
+            break;
+        case Temp::Local:
+            cloned = block->TEMP(locals.at(e->index));
+            break;
+        default:
+            Q_ASSERT(e->kind == Temp::VirtualRegister);
+            cloned = block->TEMP(tempBase + e->index);
+            break;
+        }
+    }
+
+    virtual void visitMember(Member *e)
+    {
+        Expr *clonedBase = clone(e->base);
+        cloned = block->MEMBER(clonedBase, block->function->newString(*e->name), e->property,
+                               e->kind, e->attachedPropertiesIdOrEnumValue);
+    }
+
+private:
+    const QVector<unsigned> &formals;
+    const QVector<unsigned> &locals;
+    unsigned tempBase;
+};
+
+} // anonymous namespace
+
+Inliner::Inliner(Module *module)
+    : module(module)
+{}
+
+void Inliner::run()
+{
+    // QML modules have no root function to declare anything, and the debugger wants every frame.
+    if (module->isQmlModule || module->debugMode || !module->rootFunction)
+        return;
+
+    collectCandidates();
+    if (candidates.isEmpty())
+        return;
+
+    QSet<Function *> inlinable;
+    foreach (const Candidate &candidate, candidates)
+        inlinable.insert(candidate.function);
+
+    // Candidates keep their own body: calls to them from outside the unit go through the regular
+    // function. Calls found in inlined code are inlined in turn, within the caller's budget.
+    foreach (Function *caller, module->functions) {
+        if (caller != module->rootFunction && !inlinable.contains(caller))
+            inlineCallsIn(caller);
+    }
+}
+
+// Function declarations of global code end up as moves of their closure to a name, and are
+// called by that name from the other functions of the unit.
+void Inliner::collectCandidates()
+{
+    Function *root = module->rootFunction;
+
+    QHash<unsigned, int> closureTemps;
+    QSet<QString> declaredTwice;
+    QHash<QString, int> declarations;
+    foreach (BasicBlock *bb, root->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        foreach (Stmt *s, bb->statements()) {
+            Move *m = s->asMove();
+            if (!m)
+                continue;
+            int functionIndex = -1;
+            if (Closure *closure = m->source->asClosure()) {
+                functionIndex = closure->value;
+            } else if (Temp *t = m->source->asTemp()) {
+                if (t->kind == Temp::VirtualRegister)
+                    functionIndex = closureTemps.value(t->index, -1);
+            }
+            if (functionIndex == -1)
+                continue;
+
+            if (Temp *t = m->target->asTemp()) {
+                if (t->kind == Temp::VirtualRegister)
+                    closureTemps.insert(t->index, functionIndex);
+            } else if (Name *n = m->target->asName()) {
+                if (n->builtin != Name::builtin_invalid || !n->id)
+                    continue;
+                if (declarations.contains(*n->id))
+                    declaredTwice.insert(*n->id);
+                declarations.insert(*n->id, functionIndex);
+            }
+        }
+    }
+
+    InlineCandidateChecker checker;
+    for (QHash<QString, int>::const_iterator it = declarations.constBegin(); it != declarations.constEnd(); ++it) {
+        if (declaredTwice.contains(it.key()))
+            continue;
+
+        Function *f = module->functions.at(it.value());
+        if (f->outer != root || !f->nestedFunctions.isEmpty() || f->hasDirectEval
+                || f->usesArgumentsObject || f->usesThis || f->hasTry || f->hasWith
+                || f->isNamedExpression)
+            continue;
+
+        int statementCount = 0;
+        foreach (BasicBlock *bb, f->basicBlocks())
+            if (!bb->isRemoved())
+                statementCount += bb->statementCount();
+        if (statementCount > MaxInlinedStatementCount)
+            continue;
+
+        Candidate candidate;
+        candidate.function = f;
+        candidate.functionIndex = it.value();
+        candidate.statementCount = statementCount;
+        if (!checker.check(f, &candidate.freeNames))
+            continue;
+        // A call to itself would have to go through the guard again.
+        if (candidate.freeNames.contains(it.key()))
+            continue;
+        candidates.insert(it.key(), candidate);
+    }
+}
+
+void Inliner::inlineCallsIn(Function *caller)
+{
+    // Names declared between the caller and the global code would shadow the callee, or the
+    // names the callee uses.
+    QSet<QString> scopeNames;
+    int scopeDepth = 0;
+    Function *f = caller;
+    for (; f && f != module->rootFunction; f = f->outer) {
+        if (f->hasDirectEval || f->hasTry || f->hasWith || f->insideWithOrCatch)
+            return;
+        foreach (const QString *formal, f->formals)
+            scopeNames.insert(*formal);
+        foreach (const QString *local, f->locals)
+            scopeNames.insert(*local);
+        if (f->isNamedExpression && f->name)
+            scopeNames.insert(*f->name);
+        ++scopeDepth;
+    }
+    if (!f)
+        return;
+
+    int budget = MaxInlinedStatementsPerCaller;
+
+    // Inlining appends blocks, which get visited in turn.
+    for (int i = 0; i < caller->basicBlockCount(); ++i) {
+        BasicBlock *bb = caller->basicBlock(i);
+        if (bb->isRemoved())
+            continue;
+
+        for (int s = 0; s < bb->statementCount(); ++s) {
+            Stmt *stmt = bb->statements().at(s);
+            Call *call = 0;
+            Temp *target = 0;
+            if (Move *m = stmt->asMove()) {
+                call = m->source->asCall();
+                target = m->target->asTemp();
+                if (!target)
+                    continue;
+            } else if (Exp *e = stmt->asExp()) {
+                call = e->expr->asCall();
+            }
+            if (!call)
+                continue;
+
+            Name *name = call->base->asName();
+            if (!name || name->builtin != Name::builtin_invalid || !name->id)
+                continue;
+            QHash<QString, Candidate>::const_iterator it = candidates.constFind(*name->id);
+            if (it == candidates.constEnd() || scopeNames.contains(*name->id))
+                continue;
+
+            const Candidate &candidate = *it;
+            if (candidate.statementCount > budget || candidate.function->isStrict != caller->isStrict)
+                continue;
+            if (candidate.freeNames.intersects(scopeNames))
+                continue;
+
+            bool simpleArguments = true;
+            for (ExprList *arg = call->args; arg; arg = arg->next)
+                simpleArguments &= arg->expr->asTemp() || arg->expr->asConst();
+            if (!simpleArguments)
+                continue;
+
+            inlineCall(bb, s, call, target, candidate, scopeDepth);
+            budget -= candidate.statementCount;
+            // The rest of the block has moved to a block of its own.
+            break;
+        }
+    }
+}
+
+// Turns
+//     t = call f(args)
+// into
+//     f' = f
+//     ok = is_closure(f', functionIndex, scopeDepth)
+//     cjump ok, inlined body of f, call block
+//   call block:
+//     t = call f'(args)
+//     jump join
+//   inlined body of f, with its return turned into:
+//     t = return value
+//     jump join
+//   join:
+//     rest of the original block
+void Inliner::inlineCall(BasicBlock *bb, int statementIndex, Call *call, Temp *target,
+                         const Candidate &candidate, int scopeDepth)
+{
+    Function *caller = bb->function;
+    Function *callee = candidate.function;
+    BasicBlock *group = bb->containingGroup();
+    BasicBlock *catchBlock = bb->catchBlock;
+    Stmt *callStmt = bb->statements().at(statementIndex);
+    const QQmlJS::AST::SourceLocation location = callStmt->location;
+    Name *calleeName = call->base->asName();
+
+    // Split the block after the call.
+    BasicBlock *join = caller->newBasicBlock(group, catchBlock);
+    join->setStatements(bb->statements().mid(statementIndex + 1));
+    while (bb->statementCount() > statementIndex)
+        bb->removeStatement(bb->statementCount() - 1);
+    foreach (BasicBlock *successor, bb->out) {
+        successor->in.replace(successor->in.indexOf(bb), join);
+        join->out.append(successor);
+    }
+    bb->out.clear();
+
+    // The guard.
+    const unsigned calleeTemp = bb->newTemp();
+    bb->MOVE(bb->TEMP(calleeTemp), calleeName)->location = location;
+
+    ExprList *guardArgs = caller->New<ExprList>();
+    guardArgs->init(bb->TEMP(calleeTemp), caller->New<ExprList>());
+    guardArgs->next->init(bb->CONST(SInt32Type, candidate.functionIndex), caller->New<ExprList>());
+    guardArgs->next->next->init(bb->CONST(SInt32Type, scopeDepth));
+    Name *isClosure = bb->NAME(Name::builtin_is_closure, calleeName->line, calleeName->column);
+    isClosure->freeOfSideEffects = true;
+    const unsigned guardTemp = bb->newTemp();
+    bb->MOVE(bb->TEMP(guardTemp), bb->CALL(isClosure, guardArgs))->location = location;
+
+    // The fallback is the original call.
+    BasicBlock *callBlock = caller->newBasicBlock(group, catchBlock);
+    call->base = callBlock->TEMP(calleeTemp);
+    Stmt *fallback = target ? callBlock->MOVE(target, call) : callBlock->EXP(call);
+    fallback->location = location;
+    callBlock->JUMP(join)->location = location;
+
+    // The callee's arguments and locals become temporaries of the caller.
+    CloneExpr cloneArgument(bb);
+    QVector<unsigned> formals(callee->formals.size());
+    ExprList *arg = call->args;
+    for (int i = 0; i < formals.size(); ++i) {
+        formals[i] = bb->newTemp();
+        Expr *value = arg ? cloneArgument(arg->expr) : bb->CONST(UndefinedType, 0);
+        bb->MOVE(bb->TEMP(formals.at(i)), value)->location = location;
+        if (arg)
+            arg = arg->next;
+    }
+    QVector<unsigned> locals(callee->locals.size());
+    for (int i = 0; i < locals.size(); ++i)
+        locals[i] = bb->newTemp();
+    const unsigned tempBase = caller->tempCount;
+    caller->tempCount += callee->tempCount;
+    caller->maxNumberOfArguments = qMax(caller->maxNumberOfArguments, callee->maxNumberOfArguments);
+
+    // Blocks refer to each other, so create all of them before filling them in.
+    QHash<BasicBlock *, BasicBlock *> blocks;
+    foreach (BasicBlock *calleeBlock, callee->basicBlocks()) {
+        if (!calleeBlock->isRemoved())
+            blocks.insert(calleeBlock, caller->newBasicBlock(0, catchBlock));
+    }
+
+    InlinedExprCloner cloneInlined(formals, locals, tempBase);
+    foreach (BasicBlock *calleeBlock, callee->basicBlocks()) {
+        if (calleeBlock->isRemoved())
+            continue;
+
+        BasicBlock *inlinedBlock = blocks.value(calleeBlock);
+        if (BasicBlock *calleeGroup = calleeBlock->containingGroup())
+            inlinedBlock->setContainingGroup(blocks.value(calleeGroup));
+        else
+            inlinedBlock->setContainingGroup(group);
+        if (calleeBlock->isGroupStart())
+            inlinedBlock->markAsGroupStart();
+
+        cloneInlined.setBasicBlock(inlinedBlock);
+        foreach (Stmt *s, calleeBlock->statements()) {
+            Stmt *copy = 0;
+            if (Move *m = s->asMove()) {
+                copy = inlinedBlock->MOVE(cloneInlined(m->target), cloneInlined(m->source));
+            } else if (Exp *e = s->asExp()) {
+                copy = inlinedBlock->EXP(cloneInlined(e->expr));
+            } else if (Jump *j = s->asJump()) {
+                copy = inlinedBlock->JUMP(blocks.value(j->target));
+            } else if (CJump *cj = s->asCJump()) {
+                copy = inlinedBlock->CJUMP(cloneInlined(cj->cond), blocks.value(cj->iftrue),
+                                           blocks.value(cj->iffalse));
+            } else if (Ret *r = s->asRet()) {
+                if (target) {
+                    Stmt *result = inlinedBlock->MOVE(CloneExpr::cloneTemp(target, caller),
+                                                      cloneInlined(r->expr));
+                    result->location = s->location;
+                }
+                copy = inlinedBlock->JUMP(join);
+            } else {
+                Q_UNREACHABLE();
+            }
+            copy->location = s->location;
+        }
+    }
+
+    bb->CJUMP(bb->TEMP(guardTemp), blocks.value(callee->basicBlock(0)), callBlock)->location = location;
+}
+
 static inline bool overlappingStorage(const Temp &t1, const Temp &t2)
 {
     // This is the same as the operator==, but for one detail: memory locations are not sensitive
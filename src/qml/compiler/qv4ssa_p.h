@@ -163,6 +163,35 @@ private:
     QHash<BasicBlock *, BasicBlock *> startEndLoops;
 };
 
+// Replaces calls to small function declarations of a JavaScript compilation unit by a copy of the
+// callee's body. Every inlined call site is guarded by a check that the name still refers to the
+// declared closure, with a regular call as the fallback, so reassigning the function is harmless.
+class Q_QML_PRIVATE_EXPORT Inliner
+{
+    Q_DISABLE_COPY(Inliner)
+
+public:
+    Inliner(Module *module);
+
+    void run();
+
+private:
+    struct Candidate {
+        Function *function;
+        int functionIndex;
+        int statementCount;
+        QSet<QString> freeNames;
+    };
+
+    void collectCandidates();
+    void inlineCallsIn(Function *caller);
+    void inlineCall(BasicBlock *bb, int statementIndex, Call *call, Temp *target,
+                    const Candidate &candidate, int scopeDepth);
+
+    Module *module;
+    QHash<QString, Candidate> candidates;
+};
+
 class MoveMapping
 {
     struct Move {
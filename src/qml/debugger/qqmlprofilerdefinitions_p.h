@@ -67,6 +67,8 @@ struct QQmlProfilerDefinitions {
         Complete, // end of transmission
         PixmapCacheEvent,
         SceneGraphFrame,
+        HeapStatistics,
+        JavascriptCallTree, // depth, file, function, line, total time, self time
 
         MaximumMessage
     };
@@ -126,6 +128,13 @@ struct QQmlProfilerDefinitions {
 
         MaximumSceneGraphFrameType
     };
+
+    enum HeapStatisticsType {
+        HeapSizeClass,      // item size, chunks, chunk memory, used, free, allocated since GC
+        HeapLargeItems,     // count, memory
+
+        MaximumHeapStatisticsType
+    };
 };
 
 QT_END_NAMESPACE
@@ -108,6 +108,9 @@ public:
 public slots:
     virtual void debuggerPaused(QV4::Debugging::Debugger *debugger, QV4::Debugging::PauseReason reason);
     virtual void sourcesCollected(QV4::Debugging::Debugger *debugger, QStringList sources, int requestSequenceNr);
+    virtual void heapSnapshotChunk(QV4::Debugging::Debugger *debugger, QByteArray chunk, int requestSequenceNr);
+    virtual void heapSnapshotTaken(QV4::Debugging::Debugger *debugger, bool success, QString fileName,
+                                   int requestSequenceNr);
 
 private:
     QV4DebugServicePrivate *debugServicePrivate;
@@ -959,6 +962,30 @@ public:
         // response will be send by
     }
 };
+
+class V8HeapSnapshotRequest: public V8CommandHandler
+{
+public:
+    V8HeapSnapshotRequest(): V8CommandHandler(QStringLiteral("heapsnapshot")) {}
+
+    virtual void handleRequest()
+    {
+        //decypher the payload:
+        QJsonObject arguments = req.value(QStringLiteral("arguments")).toObject();
+        QString fileName = arguments.value(QStringLiteral("file")).toString();
+
+        QV4::Debugging::Debugger *debugger = debugServicePrivate->debuggerAgent.firstDebugger();
+        if (!debugger) {
+            createErrorResponse(QStringLiteral("no engine to take a heap snapshot of"));
+            return;
+        }
+
+        // do it:
+        debugger->takeHeapSnapshot(requestSequenceNr(), fileName);
+
+        // the chunks and the response will be sent by QV4DebuggerAgent
+    }
+};
 } // anonymous namespace
 
 QV4DebugServicePrivate::QV4DebugServicePrivate()
@@ -978,6 +1005,7 @@ QV4DebugServicePrivate::QV4DebugServicePrivate()
     addHandler(new V8DisconnectRequest);
     addHandler(new V8SetExceptionBreakRequest);
     addHandler(new V8ScriptsRequest);
+    addHandler(new V8HeapSnapshotRequest);
 
     // TODO: evaluate
 }
@@ -1188,6 +1216,42 @@ void QV4DebuggerAgent::sourcesCollected(QV4::Debugging::Debugger *debugger, QStr
     debugServicePrivate->send(response);
 }
 
+void QV4DebuggerAgent::heapSnapshotChunk(QV4::Debugging::Debugger *debugger, QByteArray chunk, int requestSequenceNr)
+{
+    Q_UNUSED(debugger);
+
+    QJsonObject body;
+    body[QLatin1String("request_seq")] = requestSequenceNr;
+    body[QLatin1String("chunk")] = QString::fromUtf8(chunk);
+
+    QJsonObject event;
+    event[QLatin1String("type")] = QStringLiteral("event");
+    event[QLatin1String("event")] = QStringLiteral("heapSnapshotChunk");
+    event[QLatin1String("body")] = body;
+    debugServicePrivate->send(event);
+}
+
+void QV4DebuggerAgent::heapSnapshotTaken(QV4::Debugging::Debugger *debugger, bool success, QString fileName,
+                                         int requestSequenceNr)
+{
+    // Without a file, the snapshot was sent in heapSnapshotChunk events before.
+    QJsonObject body;
+    if (!fileName.isEmpty())
+        body[QLatin1String("file")] = fileName;
+
+    QJsonObject response;
+    response[QLatin1String("success")] = success;
+    response[QLatin1String("running")] = debugger->state() == QV4::Debugging::Debugger::Running;
+    if (success)
+        response[QLatin1String("body")] = body;
+    else
+        response[QLatin1String("message")] = QStringLiteral("could not take a heap snapshot");
+    response[QLatin1String("command")] = QStringLiteral("heapsnapshot");
+    response[QLatin1String("request_seq")] = requestSequenceNr;
+    response[QLatin1String("type")] = QStringLiteral("response");
+    debugServicePrivate->send(response);
+}
+
 void QV4DebugService::handleV8Request(const QByteArray &payload)
 {
     Q_D(QV4DebugService);
@@ -46,7 +46,7 @@
 QT_BEGIN_NAMESPACE
 
 QV4ProfilerAdapter::QV4ProfilerAdapter(QQmlProfilerService *service, QV4::ExecutionEngine *engine) :
-    QQmlAbstractProfilerAdapter(service)
+    QQmlAbstractProfilerAdapter(service), callTreeTime(-1)
 {
     engine->enableProfiler();
     connect(this, SIGNAL(profilingEnabled()), engine->profiler, SLOT(startProfiling()));
@@ -58,8 +58,12 @@ QV4ProfilerAdapter::QV4ProfilerAdapter(QQmlProfilerService *service, QV4::Execut
     connect(this, SIGNAL(dataRequested()), engine->profiler, SLOT(reportData()));
     connect(this, SIGNAL(referenceTimeKnown(QElapsedTimer)),
             engine->profiler, SLOT(setTimer(QElapsedTimer)));
-    connect(engine->profiler, SIGNAL(dataReady(QList<QV4::Profiling::FunctionCallProperties>)),
-            this, SLOT(receiveData(QList<QV4::Profiling::FunctionCallProperties>)));
+    connect(engine->profiler, SIGNAL(dataReady(QList<QV4::Profiling::FunctionCallProperties>,
+                                               QList<QV4::Profiling::HeapStatisticsProperties>,
+                                               QList<QV4::Profiling::CallTreeEntryProperties>)),
+            this, SLOT(receiveData(QList<QV4::Profiling::FunctionCallProperties>,
+                                   QList<QV4::Profiling::HeapStatisticsProperties>,
+                                   QList<QV4::Profiling::CallTreeEntryProperties>)));
 }
 
 
@@ -67,14 +71,16 @@ qint64 QV4ProfilerAdapter::sendMessages(qint64 until, QList<QByteArray> &message
 {
     QByteArray message;
     while (true) {
-        while (!stack.empty() && (data.empty() || stack.top() <= data.front().start)) {
+        while (!stack.empty() && (data.empty() || stack.top() <= data.front().start)
+               && (heapData.empty() || stack.top() <= heapData.front().timestamp)) {
             if (stack.top() > until)
                 return stack.top();
             QQmlDebugStream d(&message, QIODevice::WriteOnly);
             d << stack.pop() << RangeEnd << Javascript;
             messages.append(message);
         }
-        while (!data.empty() && (stack.empty() || data.front().start < stack.top())) {
+        while (!data.empty() && (stack.empty() || data.front().start < stack.top())
+               && (heapData.empty() || data.front().start <= heapData.front().timestamp)) {
             if (data.front().start > until)
                 return data.front().start;
             const QV4::Profiling::FunctionCallProperties &props = data.front();
@@ -94,14 +100,63 @@ qint64 QV4ProfilerAdapter::sendMessages(qint64 until, QList<QByteArray> &message
             stack.push(props.end);
             data.pop_front();
         }
-        if (stack.empty() && data.empty())
+        while (!heapData.empty() && (stack.empty() || heapData.front().timestamp < stack.top())
+               && (data.empty() || heapData.front().timestamp < data.front().start)) {
+            if (heapData.front().timestamp > until)
+                return heapData.front().timestamp;
+            appendHeapStatistics(heapData.front(), messages);
+            heapData.pop_front();
+        }
+        if (stack.empty() && data.empty() && heapData.empty()) {
+            // the sampled call tree covers the whole session, it goes last
+            if (!callTree.empty()) {
+                if (callTreeTime > until)
+                    return callTreeTime;
+                foreach (const QV4::Profiling::CallTreeEntryProperties &entry, callTree) {
+                    QQmlDebugStream d(&message, QIODevice::WriteOnly);
+                    d << callTreeTime << JavascriptCallTree << entry.depth << entry.file
+                      << entry.name << entry.line << entry.totalTime << entry.selfTime;
+                    messages.append(message);
+                    message.clear();
+                }
+                callTree.clear();
+            }
             return -1;
+        }
+    }
+}
+
+void QV4ProfilerAdapter::appendHeapStatistics(const QV4::Profiling::HeapStatisticsProperties &props,
+                                              QList<QByteArray> &messages)
+{
+    foreach (const QV4::MemoryManager::SizeClassStatistics &sizeClass, props.statistics.sizeClasses) {
+        QByteArray message;
+        QQmlDebugStream d(&message, QIODevice::WriteOnly);
+        d << props.timestamp << HeapStatistics << HeapSizeClass << sizeClass.itemSize
+          << sizeClass.chunks << qint64(sizeClass.chunkMemory) << sizeClass.usedItems
+          << sizeClass.freeItems << sizeClass.allocationsSinceGC;
+        messages.append(message);
     }
+
+    QByteArray message;
+    QQmlDebugStream d(&message, QIODevice::WriteOnly);
+    d << props.timestamp << HeapStatistics << HeapLargeItems << props.statistics.largeItems
+      << qint64(props.statistics.largeItemMemory);
+    messages.append(message);
 }
 
-void QV4ProfilerAdapter::receiveData(const QList<QV4::Profiling::FunctionCallProperties> &new_data)
+void QV4ProfilerAdapter::receiveData(const QList<QV4::Profiling::FunctionCallProperties> &new_data,
+                                     const QList<QV4::Profiling::HeapStatisticsProperties> &new_heapData,
+                                     const QList<QV4::Profiling::CallTreeEntryProperties> &new_callTree)
 {
     data = new_data;
+    heapData = new_heapData;
+    callTree = new_callTree;
+    callTreeTime = 0;
+    if (!data.isEmpty())
+        callTreeTime = qMax(callTreeTime, data.last().end);
+    if (!heapData.isEmpty())
+        callTreeTime = qMax(callTreeTime, heapData.last().timestamp);
     stack.clear();
     service->dataReady(this);
 }
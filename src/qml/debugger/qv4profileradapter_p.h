@@ -71,10 +71,18 @@ public:
     virtual qint64 sendMessages(qint64 until, QList<QByteArray> &messages);
 
 public slots:
-    void receiveData(const QList<QV4::Profiling::FunctionCallProperties> &);
+    void receiveData(const QList<QV4::Profiling::FunctionCallProperties> &,
+                     const QList<QV4::Profiling::HeapStatisticsProperties> &,
+                     const QList<QV4::Profiling::CallTreeEntryProperties> &);
 
 private:
+    void appendHeapStatistics(const QV4::Profiling::HeapStatisticsProperties &props,
+                              QList<QByteArray> &messages);
+
     QList<QV4::Profiling::FunctionCallProperties> data;
+    QList<QV4::Profiling::HeapStatisticsProperties> heapData;
+    QList<QV4::Profiling::CallTreeEntryProperties> callTree;
+    qint64 callTreeTime;
     QStack<qint64> stack;
 };
 
@@ -81,6 +81,11 @@ void CompilationUnit::linkBackendToEngine(ExecutionEngine *engine)
     }
 }
 
+void CompilationUnit::replaceCode(int functionIndex, QV4::Function *runtimeFunction)
+{
+    runtimeFunction->code = (ReturnedValue (*)(QV4::ExecutionContext *, const uchar *)) codeRefs[functionIndex].code().executableAddress();
+}
+
 QV4::ExecutableAllocator::ChunkOfPages *CompilationUnit::chunkForFunction(int functionIndex)
 {
     if (functionIndex < 0 || functionIndex >= codeRefs.count())
@@ -398,6 +403,12 @@ Assembler::Jump Assembler::branchDouble(bool invertCondition, IR::AluOp op,
     Q_ASSERT(isPregOrConst(right));
     Q_ASSERT(left->asConst() == 0 || right->asConst() == 0);
 
+    return branchDouble(invertCondition, op, toDoubleRegister(left), toDoubleRegister(right));
+}
+
+Assembler::Jump Assembler::branchDouble(bool invertCondition, IR::AluOp op,
+                                        FPRegisterID left, FPRegisterID right)
+{
     Assembler::DoubleCondition cond;
     switch (op) {
     case IR::OpGt: cond = Assembler::DoubleGreaterThan; break;
@@ -414,7 +425,7 @@ Assembler::Jump Assembler::branchDouble(bool invertCondition, IR::AluOp op,
     if (invertCondition)
         cond = JSC::MacroAssembler::invert(cond);
 
-    return JSC::MacroAssembler::branchDouble(cond, toDoubleRegister(left), toDoubleRegister(right));
+    return JSC::MacroAssembler::branchDouble(cond, left, right);
 }
 
 
@@ -77,6 +77,7 @@ struct CompilationUnit : public QV4::CompiledData::CompilationUnit
     virtual void linkBackendToEngine(QV4::ExecutionEngine *engine);
 
     virtual QV4::ExecutableAllocator::ChunkOfPages *chunkForFunction(int functionIndex);
+    virtual void replaceCode(int functionIndex, QV4::Function *runtimeFunction);
 
     // Coderef + execution engine
 
@@ -502,6 +503,7 @@ public:
                                 IR::BasicBlock *falseBlock);
     Jump genTryDoubleConversion(IR::Expr *src, Assembler::FPRegisterID dest);
     Assembler::Jump branchDouble(bool invertCondition, IR::AluOp op, IR::Expr *left, IR::Expr *right);
+    Assembler::Jump branchDouble(bool invertCondition, IR::AluOp op, FPRegisterID left, FPRegisterID right);
 
     Pointer loadTempAddress(RegisterID baseReg, IR::Temp *t);
     Pointer loadStringAddress(RegisterID reg, const QString &string);
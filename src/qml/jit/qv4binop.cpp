@@ -53,6 +53,34 @@ inline bool isPregOrConst(IR::Expr *e)
         return t->kind == IR::Temp::PhysicalRegister;
     return e->asConst() != 0;
 }
+
+inline bool isComparison(IR::AluOp op)
+{
+    return op >= IR::OpGt && op <= IR::OpStrictNotEqual;
+}
+
+inline bool canBeNumber(IR::Expr *e)
+{
+    switch (e->type) {
+    case IR::SInt32Type:
+    case IR::UInt32Type:
+    case IR::DoubleType:
+        return true;
+    case IR::VarType:
+        return e->asTemp() != 0;
+    default:
+        return false;
+    }
+}
+
+// The inline paths used with type feedback need both operands to possibly be numbers and
+// at least one of them to be untyped. The register allocator then treats the operation as
+// a call, so no registers are live across it other than the ones holding the operands.
+inline bool canInlineWithFeedback(IR::Expr *leftSource, IR::Expr *rightSource)
+{
+    return canBeNumber(leftSource) && canBeNumber(rightSource)
+            && (leftSource->type == IR::VarType || rightSource->type == IR::VarType);
+}
 } // anonymous namespace
 
 
@@ -126,8 +154,20 @@ void Binop::generate(IR::Expr *lhs, IR::Expr *rhs, IR::Temp *target)
     }
 
     Assembler::Jump done;
-    if (lhs->type != IR::StringType && rhs->type != IR::StringType)
-        done = genInlineBinop(lhs, rhs, target);
+    Assembler::Jump int32Done;
+    if (lhs->type != IR::StringType && rhs->type != IR::StringType) {
+        // Type feedback from the interpreter, if any, tells which inline paths are worth it.
+        // Each of them falls through to the next one, and finally to the call below, when
+        // the operands turn out to be of other types.
+        if (TypeFeedback::isInt32(feedback))
+            int32Done = genInlineInt32Binop(lhs, rhs, target);
+        if (isComparison(op)) {
+            if (TypeFeedback::isNumber(feedback))
+                done = genInlineCompare(lhs, rhs, target);
+        } else if (!TypeFeedback::hasNoNumbers(feedback)) {
+            done = genInlineBinop(lhs, rhs, target);
+        }
+    }
 
     // TODO: inline var===null and var!==null
     Binop::OpInfo info = Binop::operation(op);
@@ -153,7 +193,8 @@ void Binop::generate(IR::Expr *lhs, IR::Expr *rhs, IR::Temp *target)
 
     if (done.isSet())
         done.link(as);
-
+    if (int32Done.isSet())
+        int32Done.link(as);
 }
 
 void Binop::doubleBinop(IR::Expr *lhs, IR::Expr *rhs, IR::Temp *target)
@@ -487,4 +528,102 @@ Assembler::Jump Binop::genInlineBinop(IR::Expr *leftSource, IR::Expr *rightSourc
     return done;
 }
 
+// Int32 arithmetic for operations that only ever saw int32 operands in the interpreter.
+// Falls through when an operand isn't an int32 or when the result overflows.
+Assembler::Jump Binop::genInlineInt32Binop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target)
+{
+    Assembler::Jump done;
+    if (op != IR::OpAdd && op != IR::OpSub && op != IR::OpMul)
+        return done;
+    if (!canInlineWithFeedback(leftSource, rightSource) || target->type != IR::VarType)
+        return done;
+    if (leftSource->type != IR::VarType && leftSource->type != IR::SInt32Type)
+        return done;
+    if (rightSource->type != IR::VarType && rightSource->type != IR::SInt32Type)
+        return done;
+
+    Assembler::JumpList bailOut;
+    IR::Expr *operands[] = { leftSource, rightSource };
+    for (int i = 0; i < 2; ++i) {
+        if (operands[i]->type != IR::VarType)
+            continue;
+        Assembler::Pointer tagAddr = as->loadTempAddress(Assembler::ScratchRegister, operands[i]->asTemp());
+        tagAddr.offset += 4;
+        as->load32(tagAddr, Assembler::ScratchRegister);
+        bailOut.append(as->branch32(Assembler::NotEqual, Assembler::ScratchRegister,
+                                    Assembler::TrustedImm32(Value::_Integer_Type)));
+    }
+
+    Assembler::RegisterID l = as->toInt32Register(leftSource, Assembler::ReturnValueRegister);
+    as->move(l, Assembler::ReturnValueRegister);
+    Assembler::RegisterID r = as->toInt32Register(rightSource, Assembler::ScratchRegister);
+
+    switch (op) {
+    case IR::OpAdd:
+        bailOut.append(as->branchAdd32(Assembler::Overflow, r, Assembler::ReturnValueRegister));
+        break;
+    case IR::OpSub:
+        bailOut.append(as->branchSub32(Assembler::Overflow, r, Assembler::ReturnValueRegister));
+        break;
+    case IR::OpMul:
+        bailOut.append(as->branchMul32(Assembler::Overflow, r, Assembler::ReturnValueRegister));
+        // A zero result might have to be -0, which isn't an int32.
+        bailOut.append(as->branchTest32(Assembler::Zero, Assembler::ReturnValueRegister));
+        break;
+    default:
+        Q_UNREACHABLE();
+    }
+
+    as->storeInt32(Assembler::ReturnValueRegister, target);
+    done = as->jump();
+    bailOut.link(as);
+    return done;
+}
+
+// Comparison of two numbers, for operations that only ever saw numbers in the interpreter.
+// Falls through when an operand isn't a number.
+Assembler::Jump Binop::genInlineCompare(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target)
+{
+    if (!canInlineWithFeedback(leftSource, rightSource))
+        return Assembler::Jump();
+
+    Assembler::FPRegisterID lReg = getFreeFPReg(rightSource, 2);
+    Assembler::FPRegisterID rReg = getFreeFPReg(leftSource, 4);
+    Assembler::Jump leftIsNoDbl = as->genTryDoubleConversion(leftSource, lReg);
+    Assembler::Jump rightIsNoDbl = as->genTryDoubleConversion(rightSource, rReg);
+
+    as->move(Assembler::TrustedImm32(0), Assembler::ReturnValueRegister);
+    Assembler::Jump isFalse = as->branchDouble(true, op, lReg, rReg);
+    as->move(Assembler::TrustedImm32(1), Assembler::ReturnValueRegister);
+    isFalse.link(as);
+    as->storeBool(Assembler::ReturnValueRegister, target);
+    Assembler::Jump done = as->jump();
+
+    if (leftIsNoDbl.isSet())
+        leftIsNoDbl.link(as);
+    if (rightIsNoDbl.isSet())
+        rightIsNoDbl.link(as);
+    return done;
+}
+
+// Same as genInlineCompare, but for conditional jumps.
+void Binop::genInlineCJump(IR::Expr *leftSource, IR::Expr *rightSource, IR::BasicBlock *iftrue, IR::BasicBlock *iffalse)
+{
+    if (!canInlineWithFeedback(leftSource, rightSource))
+        return;
+
+    Assembler::FPRegisterID lReg = getFreeFPReg(rightSource, 2);
+    Assembler::FPRegisterID rReg = getFreeFPReg(leftSource, 4);
+    Assembler::Jump leftIsNoDbl = as->genTryDoubleConversion(leftSource, lReg);
+    Assembler::Jump rightIsNoDbl = as->genTryDoubleConversion(rightSource, rReg);
+
+    as->addPatch(iftrue, as->branchDouble(false, op, lReg, rReg));
+    as->addPatch(iffalse, as->jump());
+
+    if (leftIsNoDbl.isSet())
+        leftIsNoDbl.link(as);
+    if (rightIsNoDbl.isSet())
+        rightIsNoDbl.link(as);
+}
+
 #endif
@@ -53,15 +53,19 @@ namespace QV4 {
 namespace JIT {
 
 struct Binop {
-    Binop(Assembler *assembler, IR::AluOp operation)
+    Binop(Assembler *assembler, IR::AluOp operation, uchar typeFeedback = 0)
         : as(assembler)
         , op(operation)
+        , feedback(typeFeedback)
     {}
 
     void generate(IR::Expr *lhs, IR::Expr *rhs, IR::Temp *target);
     void doubleBinop(IR::Expr *lhs, IR::Expr *rhs, IR::Temp *target);
     bool int32Binop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target);
     Assembler::Jump genInlineBinop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target);
+    Assembler::Jump genInlineInt32Binop(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target);
+    Assembler::Jump genInlineCompare(IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target);
+    void genInlineCJump(IR::Expr *leftSource, IR::Expr *rightSource, IR::BasicBlock *iftrue, IR::BasicBlock *iffalse);
 
     typedef Assembler::Jump (Binop::*MemRegOp)(Assembler::Address, Assembler::RegisterID);
     typedef Assembler::Jump (Binop::*ImmRegOp)(Assembler::TrustedImm32, Assembler::RegisterID);
@@ -223,6 +227,7 @@ struct Binop {
 
     Assembler *as;
     IR::AluOp op;
+    uchar feedback; // see QV4::TypeFeedback
 };
 
 }
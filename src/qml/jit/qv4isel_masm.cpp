@@ -42,6 +42,7 @@
 #include "qv4isel_masm_p.h"
 #include "qv4runtime_p.h"
 #include "qv4object_p.h"
+#include "qv4arraydata_p.h"
 #include "qv4functionobject_p.h"
 #include "qv4regexpobject_p.h"
 #include "qv4lookup_p.h"
@@ -298,29 +299,36 @@ static QVector<int> getFpRegisters()
 }
 #endif
 
-void InstructionSelection::run(int functionIndex)
+void InstructionSelection::prepare(int functionIndex)
 {
     IR::Function *function = irModule->functions[functionIndex];
-    QVector<Lookup> lookups;
-    qSwap(_function, function);
 
-    IR::Optimizer opt(_function);
+    IR::Optimizer opt(function);
     opt.run(qmlEngine);
 
 #ifdef REGALLOC_IS_SUPPORTED
     static const bool withRegisterAllocator = qgetenv("QV4_NO_REGALLOC").isEmpty();
     if (opt.isInSSA() && withRegisterAllocator) {
-        RegisterAllocator(getIntRegisters(), getFpRegisters()).run(_function, opt);
+        RegisterAllocator(getIntRegisters(), getFpRegisters()).run(function, opt);
     } else
 #endif // REGALLOC_IS_SUPPORTED
     {
         if (opt.isInSSA())
             // No register allocator available for this platform, or env. var was set, so:
             opt.convertOutOfSSA();
-        ConvertTemps().toStackSlots(_function);
+        ConvertTemps().toStackSlots(function);
     }
-    IR::Optimizer::showMeTheCode(_function);
-    QSet<IR::Jump *> removableJumps = opt.calculateOptionalJumps();
+    IR::Optimizer::showMeTheCode(function);
+    optionalJumps[functionIndex] = opt.calculateOptionalJumps();
+}
+
+void InstructionSelection::run(int functionIndex)
+{
+    IR::Function *function = irModule->functions[functionIndex];
+    QVector<Lookup> lookups;
+    qSwap(_function, function);
+
+    QSet<IR::Jump *> removableJumps = optionalJumps.at(functionIndex);
     qSwap(_removableJumps, removableJumps);
 
     Assembler* oldAssembler = _as;
@@ -393,7 +401,7 @@ void InstructionSelection::callBuiltinInvalid(IR::Name *func, IR::ExprList *args
     prepareCallData(args, 0);
 
     if (useFastLookups && func->global) {
-        uint index = registerGlobalGetterLookup(*func->id);
+        uint index = registerGlobalGetterLookup(*func->id, _lookupSite);
         generateFunctionCall(result, Runtime::callGlobalLookup,
                              Assembler::ContextRegister,
                              Assembler::TrustedImm32(index),
@@ -609,11 +617,23 @@ void InstructionSelection::callBuiltinSetupArgumentObject(IR::Temp *result)
     generateFunctionCall(result, Runtime::setupArgumentsObject, Assembler::ContextRegister);
 }
 
+void InstructionSelection::callBuiltinArgumentCount(IR::Temp *result)
+{
+    generateFunctionCall(result, Runtime::argumentCount, Assembler::ContextRegister);
+}
+
 void InstructionSelection::callBuiltinConvertThisToObject()
 {
     generateFunctionCall(Assembler::Void, Runtime::convertThisToObject, Assembler::ContextRegister);
 }
 
+void InstructionSelection::callBuiltinIsClosure(IR::Expr *value, int functionId, int scopeDepth, IR::Temp *result)
+{
+    generateFunctionCall(result, Runtime::isClosure, Assembler::ContextRegister,
+                         Assembler::PointerToValue(value), Assembler::TrustedImm32(functionId),
+                         Assembler::TrustedImm32(scopeDepth));
+}
+
 void InstructionSelection::callValue(IR::Temp *value, IR::ExprList *args, IR::Temp *result)
 {
     Q_ASSERT(value);
@@ -708,7 +728,7 @@ void InstructionSelection::loadRegexp(IR::RegExp *sourceRegexp, IR::Temp *target
 void InstructionSelection::getActivationProperty(const IR::Name *name, IR::Temp *temp)
 {
     if (useFastLookups && name->global) {
-        uint index = registerGlobalGetterLookup(*name->id);
+        uint index = registerGlobalGetterLookup(*name->id, _lookupSite);
         generateLookupCall(temp, index, qOffsetOf(QV4::Lookup, globalGetter), Assembler::ContextRegister, Assembler::Void);
         return;
     }
@@ -731,7 +751,7 @@ void InstructionSelection::initClosure(IR::Closure *closure, IR::Temp *target)
 void InstructionSelection::getProperty(IR::Expr *base, const QString &name, IR::Temp *target)
 {
     if (useFastLookups) {
-        uint index = registerGetterLookup(name);
+        uint index = registerGetterLookup(name, _lookupSite);
         generateLookupCall(target, index, qOffsetOf(QV4::Lookup, getter), Assembler::PointerToValue(base), Assembler::Void);
     } else {
         generateFunctionCall(target, Runtime::getProperty, Assembler::ContextRegister,
@@ -752,7 +772,7 @@ void InstructionSelection::setProperty(IR::Expr *source, IR::Expr *targetBase,
                                        const QString &targetName)
 {
     if (useFastLookups) {
-        uint index = registerSetterLookup(targetName);
+        uint index = registerSetterLookup(targetName, _lookupSite);
         generateLookupCall(Assembler::Void, index, qOffsetOf(QV4::Lookup, setter),
                            Assembler::PointerToValue(targetBase),
                            Assembler::PointerToValue(source));
@@ -769,24 +789,118 @@ void InstructionSelection::setQObjectProperty(IR::Expr *source, IR::Expr *target
                          Assembler::TrustedImm32(propertyIndex), Assembler::PointerToValue(source));
 }
 
+// Guarded direct read of a numeric index from an ArrayObject with simple array data. Falls
+// through to the generic path when the base isn't such an array, the index isn't an int32
+// within the array's length, or the element is a hole.
+Assembler::JumpList InstructionSelection::genInlineArrayElement(IR::Expr *base, IR::Expr *index, IR::Temp *target)
+{
+    Assembler::JumpList done;
+#if CPU(X86_64)
+    IR::Temp *baseTemp = base->asTemp();
+    if (!baseTemp || baseTemp->type != IR::VarType || baseTemp->kind == IR::Temp::PhysicalRegister)
+        return done;
+    if (target->type != IR::VarType || target->kind == IR::Temp::PhysicalRegister)
+        return done;
+    IR::Const *constIndex = index->asConst();
+    if (constIndex) {
+        if (constIndex->value < 0 || constIndex->value > INT_MAX
+                || constIndex->value != int(constIndex->value))
+            return done;
+    } else if (index->type != IR::SInt32Type && index->type != IR::DoubleType) {
+        return done;
+    }
+
+    Assembler::JumpList bailOut;
+    const Assembler::RegisterID object = Assembler::ReturnValueRegister;
+    const Assembler::RegisterID scratch = Assembler::ScratchRegister;
+
+    _as->load64(_as->loadTempAddress(object, baseTemp), object);
+    _as->move(object, scratch);
+    _as->urshift64(Assembler::TrustedImm32(Value::IsManaged_Shift), scratch);
+    bailOut.append(_as->branchTest64(Assembler::NonZero, scratch));
+    bailOut.append(_as->branchTest64(Assembler::Zero, object));
+
+    _as->loadPtr(Assembler::Address(object, qOffsetOf(QV4::Managed, internalClass)), scratch);
+    _as->loadPtr(Assembler::Address(scratch, qOffsetOf(QV4::InternalClass, vtable)), scratch);
+    bailOut.append(_as->branchPtr(Assembler::NotEqual, scratch,
+                                  Assembler::TrustedImmPtr(ArrayObject::staticVTable())));
+
+    _as->loadPtr(Assembler::Address(object, qOffsetOf(QV4::Object, arrayData)), object);
+    bailOut.append(_as->branchTestPtr(Assembler::Zero, object));
+
+    // Packed array data has no holes, so its elements are loaded without checking them.
+    // Other simple array data is handled by a second copy of the load that does check.
+    Assembler::JumpList packed;
+    _as->loadPtr(Assembler::Address(object, qOffsetOf(QV4::Managed, internalClass)), scratch);
+    _as->loadPtr(Assembler::Address(scratch, qOffsetOf(QV4::InternalClass, vtable)), scratch);
+    packed.append(_as->branchPtr(Assembler::Equal, scratch,
+                                 Assembler::TrustedImmPtr(PackedIntArrayData::staticVTable())));
+    packed.append(_as->branchPtr(Assembler::Equal, scratch,
+                                 Assembler::TrustedImmPtr(PackedDoubleArrayData::staticVTable())));
+    bailOut.append(_as->branch32(Assembler::NotEqual,
+                                 Assembler::Address(object, qOffsetOf(QV4::ArrayData, type)),
+                                 Assembler::TrustedImm32(ArrayData::Simple)));
+
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool packedData = pass == 1;
+        if (packedData)
+            packed.link(_as);
+
+        if (constIndex) {
+            _as->move(Assembler::TrustedImm32(int(constIndex->value)), scratch);
+        } else if (index->type == IR::SInt32Type) {
+            _as->zeroExtend32ToPtr(_as->toInt32Register(index, scratch), scratch);
+        } else {
+            Assembler::FPRegisterID d = _as->toDoubleRegister(index, Assembler::FPGpr0);
+            _as->branchConvertDoubleToInt32(d, scratch, bailOut, Assembler::FPGpr1);
+        }
+        // Unsigned compare, so negative indexes fail the bounds check too.
+        bailOut.append(_as->branch32(Assembler::AboveOrEqual, scratch,
+                                     Assembler::Address(object, qOffsetOf(QV4::SimpleArrayData, len))));
+
+        _as->loadPtr(Assembler::Address(object, qOffsetOf(QV4::ArrayData, data)), object);
+        _as->load64(Assembler::BaseIndex(object, scratch, Assembler::TimesEight), object);
+        if (!packedData) {
+            _as->move(object, scratch);
+            _as->urshift64(Assembler::TrustedImm32(32), scratch);
+            bailOut.append(_as->branch32(Assembler::Equal, scratch, Assembler::TrustedImm32(Value::Empty_Type)));
+        }
+
+        _as->storeReturnValue(target);
+        done.append(_as->jump());
+    }
+    bailOut.link(_as);
+#else
+    Q_UNUSED(base);
+    Q_UNUSED(index);
+    Q_UNUSED(target);
+#endif
+    return done;
+}
+
 void InstructionSelection::getElement(IR::Expr *base, IR::Expr *index, IR::Temp *target)
 {
+    Assembler::JumpList done;
+    if (index->type & IR::NumberType)
+        done = genInlineArrayElement(base, index, target);
+
     if (useFastLookups) {
-        uint lookup = registerIndexedGetterLookup();
+        uint lookup = registerIndexedGetterLookup(_lookupSite);
         generateLookupCall(target, lookup, qOffsetOf(QV4::Lookup, indexedGetter),
                            Assembler::PointerToValue(base),
                            Assembler::PointerToValue(index));
-        return;
+    } else {
+        generateFunctionCall(target, Runtime::getElement, Assembler::ContextRegister,
+                             Assembler::PointerToValue(base), Assembler::PointerToValue(index));
     }
 
-    generateFunctionCall(target, Runtime::getElement, Assembler::ContextRegister,
-                         Assembler::PointerToValue(base), Assembler::PointerToValue(index));
+    done.link(_as);
 }
 
 void InstructionSelection::setElement(IR::Expr *source, IR::Expr *targetBase, IR::Expr *targetIndex)
 {
     if (useFastLookups) {
-        uint lookup = registerIndexedSetterLookup();
+        uint lookup = registerIndexedSetterLookup(_lookupSite);
         generateLookupCall(Assembler::Void, lookup, qOffsetOf(QV4::Lookup, indexedSetter),
                            Assembler::PointerToValue(targetBase), Assembler::PointerToValue(targetIndex),
                            Assembler::PointerToValue(source));
@@ -940,7 +1054,7 @@ void InstructionSelection::unop(IR::AluOp oper, IR::Temp *sourceTemp, IR::Temp *
 
 void InstructionSelection::binop(IR::AluOp oper, IR::Expr *leftSource, IR::Expr *rightSource, IR::Temp *target)
 {
-    QV4::JIT::Binop binop(_as, oper);
+    QV4::JIT::Binop binop(_as, oper, typeFeedbackAt(_feedbackSlot));
     binop.generate(leftSource, rightSource, target);
 }
 
@@ -952,7 +1066,7 @@ void InstructionSelection::callProperty(IR::Expr *base, const QString &name, IR:
     prepareCallData(args, base);
 
     if (useFastLookups) {
-        uint index = registerGetterLookup(name);
+        uint index = registerGetterLookup(name, _lookupSite);
         generateFunctionCall(result, Runtime::callPropertyLookup,
                              Assembler::ContextRegister,
                              Assembler::TrustedImm32(index),
@@ -1274,7 +1388,7 @@ void InstructionSelection::constructActivationProperty(IR::Name *func, IR::ExprL
     prepareCallData(args, 0);
 
     if (useFastLookups && func->global) {
-        uint index = registerGlobalGetterLookup(*func->id);
+        uint index = registerGlobalGetterLookup(*func->id, _lookupSite);
         generateFunctionCall(result, Runtime::constructGlobalLookup,
                              Assembler::ContextRegister,
                              Assembler::TrustedImm32(index), baseAddressForCallData());
@@ -1292,7 +1406,7 @@ void InstructionSelection::constructProperty(IR::Temp *base, const QString &name
 {
     prepareCallData(args, base);
     if (useFastLookups) {
-        uint index = registerGetterLookup(name);
+        uint index = registerGetterLookup(name, _lookupSite);
         generateFunctionCall(result, Runtime::constructPropertyLookup,
                              Assembler::ContextRegister,
                              Assembler::TrustedImm32(index),
@@ -1364,6 +1478,13 @@ void InstructionSelection::visitCJump(IR::CJump *s)
                 && visitCJumpDouble(b->op, b->left, b->right, s->iftrue, s->iffalse))
             return;
 
+        if (b->op >= IR::OpGt && b->op <= IR::OpStrictNotEqual
+                && TypeFeedback::isNumber(typeFeedbackAt(b->feedbackSlot))) {
+            // Falls through to the generic comparison below when an operand is not a number.
+            QV4::JIT::Binop binop(_as, b->op);
+            binop.genInlineCJump(b->left, b->right, s->iftrue, s->iffalse);
+        }
+
         if (b->op == IR::OpStrictEqual || b->op == IR::OpStrictNotEqual) {
             visitCJumpStrict(b, s->iftrue, s->iffalse);
             return;
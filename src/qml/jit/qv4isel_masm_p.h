@@ -70,6 +70,7 @@ public:
     InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator);
     ~InstructionSelection();
 
+    virtual void prepare(int functionIndex);
     virtual void run(int functionIndex);
 
     const void *addConstantTable(QVector<QV4::Primitive> *values);
@@ -97,7 +98,9 @@ protected:
     virtual void callBuiltinDefineArray(IR::Temp *result, IR::ExprList *args);
     virtual void callBuiltinDefineObjectLiteral(IR::Temp *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray);
     virtual void callBuiltinSetupArgumentObject(IR::Temp *result);
+    virtual void callBuiltinArgumentCount(IR::Temp *result);
     virtual void callBuiltinConvertThisToObject();
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionId, int scopeDepth, IR::Temp *result);
     virtual void callValue(IR::Temp *value, IR::ExprList *args, IR::Temp *result);
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Temp *result);
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Temp *result);
@@ -167,6 +170,8 @@ protected:
     void visitCJumpEqual(IR::Binop *binop, IR::BasicBlock *trueBlock, IR::BasicBlock *falseBlock);
 
 private:
+    Assembler::JumpList genInlineArrayElement(IR::Expr *base, IR::Expr *index, IR::Temp *target);
+
     void convertTypeSlowPath(IR::Temp *source, IR::Temp *target);
     void convertTypeToDouble(IR::Temp *source, IR::Temp *target);
     void convertTypeToBool(IR::Temp *source, IR::Temp *target);
@@ -216,7 +216,9 @@ protected: // IRDecoder
     virtual void callBuiltinDefineArray(IR::Temp *, IR::ExprList *) {}
     virtual void callBuiltinDefineObjectLiteral(IR::Temp *, int, IR::ExprList *, IR::ExprList *, bool) {}
     virtual void callBuiltinSetupArgumentObject(IR::Temp *) {}
+    virtual void callBuiltinArgumentCount(IR::Temp *) {}
     virtual void callBuiltinConvertThisToObject() {}
+    virtual void callBuiltinIsClosure(IR::Expr *, int, int, IR::Temp *) {}
 
     virtual void callValue(IR::Temp *value, IR::ExprList *args, IR::Temp *result)
     {
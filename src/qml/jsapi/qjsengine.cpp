@@ -47,6 +47,7 @@
 
 #include "private/qv4engine_p.h"
 #include "private/qv4mm_p.h"
+#include "private/qv4heapsnapshot_p.h"
 #include "private/qv4globalobject_p.h"
 #include "private/qv4script_p.h"
 #include "private/qv4runtime_p.h"
@@ -231,6 +232,57 @@ void QJSEngine::collectGarbage()
     d->m_v4Engine->memoryManager->runGC();
 }
 
+/*
+    Returns statistics about the garbage collected heap, for diagnostics.
+
+    The map contains the number of \c collections run so far, the \c liveMemory
+    in bytes that was left after the last one, and the number and total size in
+    bytes of the \c largeItems, which are allocated separately. For each size of
+    smaller items in use, \c sizeClasses has a map with the \c itemSize, the
+    number of \c chunks, their \c chunkMemory in bytes, the number of
+    \c usedItems and \c freeItems, and the \c allocationsSinceGC.
+
+    Finding the items in use requires a walk over the whole heap.
+*/
+QVariantMap QJSEnginePrivate::heapStatistics(QJSEngine *e)
+{
+    const QV4::MemoryManager::Statistics stats = QV8Engine::getV4(e)->memoryManager->statistics();
+
+    QVariantList sizeClasses;
+    foreach (const QV4::MemoryManager::SizeClassStatistics &sizeClass, stats.sizeClasses) {
+        QVariantMap map;
+        map.insert(QStringLiteral("itemSize"), sizeClass.itemSize);
+        map.insert(QStringLiteral("chunks"), sizeClass.chunks);
+        map.insert(QStringLiteral("chunkMemory"), qulonglong(sizeClass.chunkMemory));
+        map.insert(QStringLiteral("usedItems"), sizeClass.usedItems);
+        map.insert(QStringLiteral("freeItems"), sizeClass.freeItems);
+        map.insert(QStringLiteral("allocationsSinceGC"), sizeClass.allocationsSinceGC);
+        sizeClasses.append(map);
+    }
+
+    QVariantMap result;
+    result.insert(QStringLiteral("collections"), stats.collections);
+    result.insert(QStringLiteral("liveMemory"), qulonglong(stats.liveMemoryAfterGC));
+    result.insert(QStringLiteral("largeItems"), stats.largeItems);
+    result.insert(QStringLiteral("largeItemMemory"), qulonglong(stats.largeItemMemory));
+    result.insert(QStringLiteral("sizeClasses"), sizeClasses);
+    return result;
+}
+
+void QJSEnginePrivate::setHeapGrowthTrigger(QJSEngine *e, int percent)
+{
+    QV8Engine::getV4(e)->memoryManager->setHeapGrowthTrigger(percent);
+}
+
+bool QJSEnginePrivate::writeHeapSnapshot(QJSEngine *e, QIODevice *device)
+{
+    QV4::HeapSnapshot snapshot(QV8Engine::getV4(e));
+    if (!snapshot.take())
+        return false;
+    snapshot.write(device);
+    return true;
+}
+
 /*!
     Evaluates \a program, using \a lineNumber as the base line number,
     and returns the result of the evaluation.
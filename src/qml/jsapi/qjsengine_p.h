@@ -59,8 +59,9 @@
 
 QT_BEGIN_NAMESPACE
 
+class QIODevice;
 
-class QJSEnginePrivate : public QObjectPrivate
+class Q_QML_PRIVATE_EXPORT QJSEnginePrivate : public QObjectPrivate
 {
     Q_DECLARE_PUBLIC(QJSEngine)
 
@@ -68,6 +69,12 @@ public:
     static QJSEnginePrivate* get(QJSEngine*e) { return e->d_func(); }
 
     QJSEnginePrivate() {}
+
+    // Also usable with a QQmlEngine.
+    static QVariantMap heapStatistics(QJSEngine *e);
+    static void setHeapGrowthTrigger(QJSEngine *e, int percent);
+    // Writes a heap snapshot in the format of the Chrome developer tools.
+    static bool writeHeapSnapshot(QJSEngine *e, QIODevice *device);
 };
 
 QT_END_NAMESPACE
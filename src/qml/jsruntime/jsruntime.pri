@@ -39,10 +39,15 @@ SOURCES += \
     $$PWD/qv4executableallocator.cpp \
     $$PWD/qv4sequenceobject.cpp \
     $$PWD/qv4include.cpp \
+    $$PWD/qv4jsonparsejob.cpp \
     $$PWD/qv4qobjectwrapper.cpp \
     $$PWD/qv4qmlextensions.cpp \
     $$PWD/qv4vme_moth.cpp \
-    $$PWD/qv4profiling.cpp
+    $$PWD/qv4profiling.cpp \
+    $$PWD/qv4heapsnapshot.cpp \
+    $$PWD/qv4tierup.cpp \
+    $$PWD/qv4arraybuffer.cpp \
+    $$PWD/qv4typedarray.cpp
 
 HEADERS += \
     $$PWD/qv4global_p.h \
@@ -86,10 +91,15 @@ HEADERS += \
     $$PWD/qv4executableallocator_p.h \
     $$PWD/qv4sequenceobject_p.h \
     $$PWD/qv4include_p.h \
+    $$PWD/qv4jsonparsejob_p.h \
     $$PWD/qv4qobjectwrapper_p.h \
     $$PWD/qv4qmlextensions_p.h \
     $$PWD/qv4vme_moth_p.h \
-    $$PWD/qv4profiling_p.h
+    $$PWD/qv4profiling_p.h \
+    $$PWD/qv4heapsnapshot_p.h \
+    $$PWD/qv4tierup_p.h \
+    $$PWD/qv4arraybuffer_p.h \
+    $$PWD/qv4typedarray_p.h
 
 }
 
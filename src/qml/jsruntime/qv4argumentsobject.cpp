@@ -110,7 +110,7 @@ bool ArgumentsObject::defineOwnProperty(ExecutionContext *ctx, uint index, const
     fullyCreate();
 
     Scope scope(ctx);
-    Property *pd = arrayData->getProperty(index);
+    const Property *pd = arrayData->getProperty(index);
     Property map;
     PropertyAttributes mapAttrs;
     bool isMapped = false;
@@ -122,8 +122,7 @@ bool ArgumentsObject::defineOwnProperty(ExecutionContext *ctx, uint index, const
         mapAttrs = arrayData->attributes(index);
         map.copy(*pd, mapAttrs);
         setArrayAttributes(index, Attr_Data);
-        pd = arrayData->getProperty(index);
-        pd->value = mappedArguments[index];
+        arrayData->getPropertyForWrite(index)->value = mappedArguments[index];
     }
 
     bool strict = ctx->strictMode;
@@ -139,8 +138,7 @@ bool ArgumentsObject::defineOwnProperty(ExecutionContext *ctx, uint index, const
 
         if (attrs.isWritable()) {
             setArrayAttributes(index, mapAttrs);
-            pd = arrayData->getProperty(index);
-            pd->copy(map, mapAttrs);
+            arrayData->getPropertyForWrite(index)->copy(map, mapAttrs);
         }
     }
 
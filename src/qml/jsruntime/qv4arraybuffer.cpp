@@ -0,0 +1,153 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4arraybuffer_p.h"
+#include "qv4typedarray_p.h"
+#include "qv4scopedvalue_p.h"
+#include "qv4mm_p.h"
+#include "qv4variantobject_p.h"
+
+using namespace QV4;
+
+DEFINE_OBJECT_VTABLE(ArrayBufferCtor);
+DEFINE_OBJECT_VTABLE(ArrayBuffer);
+
+ArrayBufferCtor::ArrayBufferCtor(ExecutionContext *scope)
+    : FunctionObject(scope, QStringLiteral("ArrayBuffer"))
+{
+    setVTable(staticVTable());
+}
+
+ReturnedValue ArrayBufferCtor::construct(Managed *m, CallData *callData)
+{
+    ExecutionEngine *v4 = m->engine();
+    Scope scope(v4);
+    ScopedValue l(scope, callData->argument(0));
+    // byte arrays from C++ are passed as variants, their contents are shared
+    if (VariantObject *v = l->as<VariantObject>()) {
+        if (v->data.userType() == QMetaType::QByteArray)
+            return Encode(v4->newArrayBuffer(v->data.toByteArray()));
+    }
+    double dl = l->toInteger();
+    if (v4->hasException)
+        return Encode::undefined();
+    uint len = (uint)qBound(0., dl, (double)INT_MAX);
+    if (len != dl)
+        return v4->currentContext()->throwRangeError(QStringLiteral("ArrayBuffer constructor: invalid length"));
+
+    return Encode(v4->newArrayBuffer(len));
+}
+
+ReturnedValue ArrayBufferCtor::call(Managed *that, CallData *)
+{
+    return that->engine()->currentContext()->throwTypeError();
+}
+
+ReturnedValue ArrayBufferCtor::method_isView(CallContext *ctx)
+{
+    bool isView = ctx->callData->argc && ctx->callData->args[0].as<TypedArray>();
+    return Encode(isView);
+}
+
+ArrayBuffer::ArrayBuffer(ExecutionEngine *engine, uint length)
+    : Object(engine->arrayBufferClass)
+    , data(int(length), 0)
+{
+    engine->memoryManager->changeUnmanagedHeapSizeUsage(data.size());
+}
+
+ArrayBuffer::ArrayBuffer(ExecutionEngine *engine, const QByteArray &bytes)
+    : Object(engine->arrayBufferClass)
+    , data(bytes)
+{
+    engine->memoryManager->changeUnmanagedHeapSizeUsage(data.size());
+}
+
+void ArrayBuffer::destroy(Managed *m)
+{
+    ArrayBuffer *b = static_cast<ArrayBuffer *>(m);
+    b->engine()->memoryManager->changeUnmanagedHeapSizeUsage(-qptrdiff(b->data.size()));
+    b->~ArrayBuffer();
+}
+
+void ArrayBufferPrototype::init(ExecutionEngine *engine, ObjectRef ctor)
+{
+    Scope scope(engine);
+    ScopedObject o(scope);
+    ctor->defineReadonlyProperty(engine->id_length, Primitive::fromInt32(1));
+    ctor->defineReadonlyProperty(engine->id_prototype, (o = this));
+    ctor->defineDefaultProperty(QStringLiteral("isView"), ArrayBufferCtor::method_isView, 1);
+    defineDefaultProperty(QStringLiteral("constructor"), (o = ctor));
+    defineAccessorProperty(QStringLiteral("byteLength"), method_get_byteLength, 0);
+    defineDefaultProperty(QStringLiteral("slice"), method_slice, 2);
+}
+
+ReturnedValue ArrayBufferPrototype::method_get_byteLength(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<ArrayBuffer> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteLength());
+}
+
+ReturnedValue ArrayBufferPrototype::method_slice(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<ArrayBuffer> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    double len = a->byteLength();
+    ScopedValue v(scope, ctx->argument(0));
+    double start = v->toInteger();
+    v = ctx->argument(1);
+    double end = v->isUndefined() ? len : v->toInteger();
+    if (scope.engine->hasException)
+        return Encode::undefined();
+
+    double first = (start < 0) ? qMax(len + start, 0.) : qMin(start, len);
+    double final = (end < 0) ? qMax(len + end, 0.) : qMin(end, len);
+    int newLen = int(qMax(final - first, 0.));
+
+    return Encode(ctx->engine->newArrayBuffer(a->data.mid(int(first), newLen)));
+}
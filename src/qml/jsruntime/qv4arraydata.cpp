@@ -49,6 +49,43 @@ const ArrayVTable SimpleArrayData::static_vtbl =
 {
     DEFINE_MANAGED_VTABLE_INT(SimpleArrayData),
     SimpleArrayData::Simple,
+    SimpleArrayData::Generic,
+    SimpleArrayData::reallocate,
+    SimpleArrayData::get,
+    SimpleArrayData::put,
+    SimpleArrayData::putArray,
+    SimpleArrayData::del,
+    SimpleArrayData::setAttribute,
+    SimpleArrayData::attribute,
+    SimpleArrayData::push_front,
+    SimpleArrayData::pop_front,
+    SimpleArrayData::truncate,
+    SimpleArrayData::length
+};
+
+const ArrayVTable PackedDoubleArrayData::static_vtbl =
+{
+    DEFINE_MANAGED_VTABLE_INT(PackedDoubleArrayData),
+    SimpleArrayData::Simple,
+    SimpleArrayData::PackedDouble,
+    SimpleArrayData::reallocate,
+    SimpleArrayData::get,
+    SimpleArrayData::put,
+    SimpleArrayData::putArray,
+    SimpleArrayData::del,
+    SimpleArrayData::setAttribute,
+    SimpleArrayData::attribute,
+    SimpleArrayData::push_front,
+    SimpleArrayData::pop_front,
+    SimpleArrayData::truncate,
+    SimpleArrayData::length
+};
+
+const ArrayVTable PackedIntArrayData::static_vtbl =
+{
+    DEFINE_MANAGED_VTABLE_INT(PackedIntArrayData),
+    SimpleArrayData::Simple,
+    SimpleArrayData::PackedInt,
     SimpleArrayData::reallocate,
     SimpleArrayData::get,
     SimpleArrayData::put,
@@ -66,6 +103,7 @@ const ArrayVTable SparseArrayData::static_vtbl =
 {
     DEFINE_MANAGED_VTABLE_INT(SparseArrayData),
     ArrayData::Sparse,
+    ArrayData::Generic,
     SparseArrayData::reallocate,
     SparseArrayData::get,
     SparseArrayData::put,
@@ -124,6 +162,14 @@ void ArrayData::realloc(Object *o, Type newType, uint offset, uint alloc, bool e
         newData->attrs = enforceAttributes ? reinterpret_cast<PropertyAttributes *>(newData->data + alloc) + offset : 0;
         newData->offset = offset;
         newData->len = d ? static_cast<SimpleArrayData *>(d)->len : 0;
+        // new array data is empty and therefore packed, copies keep the kind of their elements
+        ElementKind kind = PackedInt;
+        if (enforceAttributes)
+            kind = Generic;
+        else if (d)
+            kind = static_cast<SimpleArrayData *>(d)->elementKind();
+        if (kind != Generic)
+            newData->setElementKind(kind);
         o->arrayData = newData;
     } else {
         size += sizeof(SparseArrayData);
@@ -219,6 +265,41 @@ void SimpleArrayData::markObjects(Managed *d, ExecutionEngine *e)
         dd->data[i].mark(e);
 }
 
+void PackedDoubleArrayData::markObjects(Managed *, ExecutionEngine *)
+{
+    // numbers only, nothing to mark
+}
+
+void SimpleArrayData::setElementKind(ElementKind kind)
+{
+    ExecutionEngine *e = internalClass->engine;
+    switch (kind) {
+    case PackedInt:
+        internalClass = e->packedIntArrayDataClass;
+        break;
+    case PackedDouble:
+        internalClass = e->packedDoubleArrayDataClass;
+        break;
+    case Generic:
+        internalClass = e->simpleArrayDataClass;
+        break;
+    }
+}
+
+void SimpleArrayData::updateElementKind(uint index, const Value &value)
+{
+    ElementKind kind;
+    if (index > len || !value.isNumber())
+        kind = Generic; // a hole, or a value the garbage collector has to see
+    else if (!value.isInteger())
+        kind = PackedDouble;
+    else
+        return;
+
+    if (kind > elementKind())
+        setElementKind(kind);
+}
+
 ReturnedValue SimpleArrayData::get(const ArrayData *d, uint index)
 {
     const SimpleArrayData *dd = static_cast<const SimpleArrayData *>(d);
@@ -232,6 +313,7 @@ bool SimpleArrayData::put(Object *o, uint index, ValueRef value)
     SimpleArrayData *dd = static_cast<SimpleArrayData *>(o->arrayData);
     Q_ASSERT(index >= dd->len || !dd->attrs || !dd->attrs[index].isAccessor());
     // ### honour attributes
+    dd->prepareStore(index, *value);
     dd->data[index] = value;
     if (index >= dd->len) {
         if (dd->attrs)
@@ -248,6 +330,7 @@ bool SimpleArrayData::del(Object *o, uint index)
         return true;
 
     if (!dd->attrs || dd->attrs[index].isConfigurable()) {
+        dd->prepareStore(index, Primitive::emptyValue());
         dd->data[index] = Primitive::emptyValue();
         if (dd->attrs)
             dd->attrs[index] = Attr_Data;
@@ -272,6 +355,8 @@ void SimpleArrayData::push_front(Object *o, Value *values, uint n)
 {
     SimpleArrayData *dd = static_cast<SimpleArrayData *>(o->arrayData);
     Q_ASSERT(!dd->attrs);
+    for (uint i = 0; i < n; ++i)
+        dd->prepareStore(0, values[i]);
     for (int i = n - 1; i >= 0; --i) {
         if (!dd->offset) {
             getHeadRoom(o);
@@ -336,6 +421,10 @@ bool SimpleArrayData::putArray(Object *o, uint index, Value *values, uint n)
         reallocate(o, index + n + 1, false);
         dd = static_cast<SimpleArrayData *>(o->arrayData);
     }
+    // The values end up contiguous from index on, so only a gap before index can leave a
+    // hole. Every value is checked at index, index + i would count the values as holes.
+    for (uint i = 0; i < n; ++i)
+        dd->prepareStore(index, values[i]);
     for (uint i = dd->len; i < index; ++i)
         dd->data[i] = Primitive::emptyValue();
     for (uint i = 0; i < n; ++i)
@@ -617,7 +706,8 @@ Property *ArrayData::insert(Object *o, uint index, bool isAccessor)
                 d = static_cast<SimpleArrayData *>(o->arrayData);
             }
             if (index >= d->len) {
-                // mark possible hole in the array
+                // mark possible hole in the array, the value itself is checked by the caller
+                d->prepareStore(index, Primitive::fromInt32(0));
                 for (uint i = d->len; i < index; ++i)
                     d->data[i] = Primitive::emptyValue();
                 d->len = index + 1;
@@ -755,6 +845,8 @@ void ArrayData::sort(ExecutionContext *context, ObjectRef thisObject, const Valu
         thisObject->arrayData = 0;
         ArrayData::realloc(thisObject, ArrayData::Simple, 0, sparse->sparse->nEntries(), sparse->attrs ? true : false);
         SimpleArrayData *d = static_cast<SimpleArrayData *>(thisObject->arrayData);
+        if (d->elementKind() != Generic)
+            d->setElementKind(Generic);
 
         SparseArrayNode *n = sparse->sparse->begin();
         uint i = 0;
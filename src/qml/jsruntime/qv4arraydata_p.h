@@ -64,6 +64,7 @@ struct ArrayVTable
 {
     ManagedVTable managedVTable;
     uint type;
+    uint elementKind;
     ArrayData *(*reallocate)(Object *o, uint n, bool enforceAttributes);
     ReturnedValue (*get)(const ArrayData *d, uint index);
     bool (*put)(Object *o, uint index, ValueRef value);
@@ -92,6 +93,14 @@ struct Q_QML_EXPORT ArrayData : public Managed
         Custom = 3
     };
 
+    // What the elements of dense array data are known to be. The packed kinds have no
+    // holes and hold only numbers, so the garbage collector doesn't need to scan them.
+    enum ElementKind {
+        PackedInt,
+        PackedDouble,
+        Generic
+    };
+
     uint alloc;
     Type type;
     PropertyAttributes *attrs;
@@ -125,7 +134,8 @@ struct Q_QML_EXPORT ArrayData : public Managed
             return Primitive::emptyValue().asReturnedValue();
         return vtable()->get(this, i);
     }
-    inline Property *getProperty(uint index) const;
+    inline const Property *getProperty(uint index) const;
+    inline Property *getPropertyForWrite(uint index);
 
     static void ensureAttributes(Object *o);
     static void realloc(Object *o, Type newType, uint offset, uint alloc, bool enforceAttributes);
@@ -146,6 +156,16 @@ struct Q_QML_EXPORT SimpleArrayData : public ArrayData
     uint len;
     uint offset;
 
+    ElementKind elementKind() const { return ElementKind(vtable()->elementKind); }
+    void setElementKind(ElementKind kind);
+
+    // Has to be called before storing value at index without going through the vtable.
+    void prepareStore(uint index, const Value &value) {
+        if (vtable()->elementKind != Generic)
+            updateElementKind(index, value);
+    }
+    void updateElementKind(uint index, const Value &value);
+
     static void getHeadRoom(Object *o);
     static ArrayData *reallocate(Object *o, uint n, bool enforceAttributes);
 
@@ -164,6 +184,20 @@ struct Q_QML_EXPORT SimpleArrayData : public ArrayData
     static uint length(const ArrayData *d);
 };
 
+// Simple array data holding numbers only. Stores of anything else go back to SimpleArrayData.
+struct Q_QML_EXPORT PackedDoubleArrayData : public SimpleArrayData
+{
+    V4_ARRAYDATA
+
+    static void markObjects(Managed *d, ExecutionEngine *e);
+};
+
+// Simple array data holding integers only, doubles turn it into PackedDoubleArrayData.
+struct Q_QML_EXPORT PackedIntArrayData : public PackedDoubleArrayData
+{
+    V4_ARRAYDATA
+};
+
 struct Q_QML_EXPORT SparseArrayData : public ArrayData
 {
     V4_ARRAYDATA
@@ -195,7 +229,7 @@ struct Q_QML_EXPORT SparseArrayData : public ArrayData
 };
 
 
-inline Property *ArrayData::getProperty(uint index) const
+inline const Property *ArrayData::getProperty(uint index) const
 {
     if (!this)
         return 0;
@@ -203,13 +237,25 @@ inline Property *ArrayData::getProperty(uint index) const
         const SimpleArrayData *that = static_cast<const SimpleArrayData *>(this);
         if (index >= that->len || data[index].isEmpty())
             return 0;
-        return reinterpret_cast<Property *>(data + index);
+        return reinterpret_cast<const Property *>(data + index);
     } else {
         SparseArrayNode *n = static_cast<const SparseArrayData *>(this)->sparse->findNode(index);
         if (!n)
             return 0;
-        return reinterpret_cast<Property *>(data + n->value);
+        return reinterpret_cast<const Property *>(data + n->value);
+    }
+}
+
+// The caller may store anything into the property, so packed array data turns generic.
+inline Property *ArrayData::getPropertyForWrite(uint index)
+{
+    const Property *p = getProperty(index);
+    if (p && type != Sparse) {
+        SimpleArrayData *that = static_cast<SimpleArrayData *>(this);
+        if (that->elementKind() != Generic)
+            that->setElementKind(Generic);
     }
+    return const_cast<Property *>(p);
 }
 
 }
@@ -45,8 +45,12 @@
 #include "qv4function_p.h"
 #include "qv4instr_moth_p.h"
 #include "qv4runtime_p.h"
+#include "qv4heapsnapshot_p.h"
+#include <private/qv8engine_p.h>
 #include <iostream>
 
+#include <QFile>
+
 #include <algorithm>
 
 using namespace QV4;
@@ -109,6 +113,75 @@ public:
                                   Q_ARG(int, seq));
     }
 };
+
+// Passes everything written to it on to the agent.
+class HeapSnapshotChunkDevice: public QIODevice
+{
+    Debugger *debugger;
+    const int seq;
+
+public:
+    HeapSnapshotChunkDevice(Debugger *debugger, int seq)
+        : debugger(debugger)
+        , seq(seq)
+    {}
+
+protected:
+    qint64 readData(char *, qint64) { return -1; }
+
+    qint64 writeData(const char *data, qint64 len)
+    {
+        QMetaObject::invokeMethod(debugger->agent(), "heapSnapshotChunk", Qt::QueuedConnection,
+                                  Q_ARG(QV4::Debugging::Debugger*, debugger),
+                                  Q_ARG(QByteArray, QByteArray(data, int(len))),
+                                  Q_ARG(int, seq));
+        return len;
+    }
+};
+
+class HeapSnapshotJob: public Debugger::Job
+{
+    QV4::ExecutionEngine *engine;
+    const int seq;
+    const QString fileName;
+
+public:
+    HeapSnapshotJob(QV4::ExecutionEngine *engine, int seq, const QString &fileName)
+        : engine(engine)
+        , seq(seq)
+        , fileName(fileName)
+    {}
+
+    ~HeapSnapshotJob() {}
+
+    void run()
+    {
+        // The snapshot is either written to the given file, or sent along in chunks.
+        Debugger *debugger = engine->debugger;
+        bool success = false;
+        HeapSnapshot snapshot(engine);
+        if (snapshot.take()) {
+            if (fileName.isEmpty()) {
+                HeapSnapshotChunkDevice device(debugger, seq);
+                device.open(QIODevice::WriteOnly);
+                snapshot.write(&device);
+                success = true;
+            } else {
+                QFile file(fileName);
+                if (file.open(QIODevice::WriteOnly)) {
+                    snapshot.write(&file);
+                    success = file.error() == QFile::NoError;
+                }
+            }
+        }
+
+        QMetaObject::invokeMethod(debugger->agent(), "heapSnapshotTaken", Qt::QueuedConnection,
+                                  Q_ARG(QV4::Debugging::Debugger*, debugger),
+                                  Q_ARG(bool, success),
+                                  Q_ARG(QString, fileName),
+                                  Q_ARG(int, seq));
+    }
+};
 }
 
 Debugger::Debugger(QV4::ExecutionEngine *engine)
@@ -122,14 +195,19 @@ Debugger::Debugger(QV4::ExecutionEngine *engine)
     , m_breakOnThrow(false)
     , m_returnedValue(Primitive::undefinedValue())
     , m_gatherSources(0)
+    , m_heapSnapshot(0)
     , m_runningJob(0)
 {
     qMetaTypeId<Debugger*>();
     qMetaTypeId<PauseReason>();
+
+    // As a child of the public engine the runner follows it to other threads.
+    m_jobRunner = new DebuggerJobRunner(this, engine->v8Engine ? engine->v8Engine->publicEngine() : 0);
 }
 
 Debugger::~Debugger()
 {
+    delete m_jobRunner;
     detachFromAgent();
 }
 
@@ -163,6 +241,32 @@ void Debugger::gatherSources(int requestSequenceNr)
     }
 }
 
+void Debugger::takeHeapSnapshot(int requestSequenceNr, const QString &fileName)
+{
+    QMutexLocker locker(&m_lock);
+
+    delete m_heapSnapshot;
+    m_heapSnapshot = new HeapSnapshotJob(m_engine, requestSequenceNr, fileName);
+    if (m_state == Paused) {
+        runInEngine_havingLock(m_heapSnapshot);
+        delete m_heapSnapshot;
+        m_heapSnapshot = 0;
+    } else {
+        // An idle engine does not get to the next instruction any time soon.
+        QMetaObject::invokeMethod(m_jobRunner, "runPendingJobs", Qt::QueuedConnection);
+    }
+}
+
+void Debugger::runPendingJobs()
+{
+    QMutexLocker locker(&m_lock);
+    if (m_heapSnapshot) {
+        m_heapSnapshot->run();
+        delete m_heapSnapshot;
+        m_heapSnapshot = 0;
+    }
+}
+
 void Debugger::pause()
 {
     QMutexLocker locker(&m_lock);
@@ -458,6 +562,12 @@ void Debugger::maybeBreakAtInstruction()
         m_gatherSources = 0;
     }
 
+    if (m_heapSnapshot) {
+        m_heapSnapshot->run();
+        delete m_heapSnapshot;
+        m_heapSnapshot = 0;
+    }
+
     switch (m_stepping) {
     case StepOver:
         if (m_currentContext != m_engine->currentContext())
@@ -692,6 +802,22 @@ DebuggerAgent::~DebuggerAgent()
     Q_ASSERT(m_debuggers.isEmpty());
 }
 
+void DebuggerAgent::heapSnapshotChunk(Debugger *debugger, QByteArray chunk, int requestSequenceNr)
+{
+    Q_UNUSED(debugger);
+    Q_UNUSED(chunk);
+    Q_UNUSED(requestSequenceNr);
+}
+
+void DebuggerAgent::heapSnapshotTaken(Debugger *debugger, bool success, QString fileName,
+                                      int requestSequenceNr)
+{
+    Q_UNUSED(debugger);
+    Q_UNUSED(success);
+    Q_UNUSED(fileName);
+    Q_UNUSED(requestSequenceNr);
+}
+
 Debugger::Collector::~Collector()
 {
 }
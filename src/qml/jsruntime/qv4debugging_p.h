@@ -68,6 +68,7 @@ enum PauseReason {
 };
 
 class DebuggerAgent;
+class DebuggerJobRunner;
 
 struct DebuggerBreakPoint {
     DebuggerBreakPoint(QString fileName, int line)
@@ -151,6 +152,10 @@ public:
     DebuggerAgent *agent() const { return m_agent; }
 
     void gatherSources(int requestSequenceNr);
+    // Writes the snapshot to fileName if that is given, otherwise passes it to the agent
+    // in chunks. This happens on the engine's thread, while it is paused, between two
+    // instructions, or from its event loop if it is idle.
+    void takeHeapSnapshot(int requestSequenceNr, const QString &fileName = QString());
     void pause();
     void resume(Speed speed);
 
@@ -170,7 +175,8 @@ public:
     ExecutionState currentExecutionState() const;
 
     bool pauseAtNextOpportunity() const {
-        return m_pauseRequested || m_haveBreakPoints || m_gatherSources || m_stepping >= StepOver;
+        return m_pauseRequested || m_haveBreakPoints || m_gatherSources || m_heapSnapshot
+                || m_stepping >= StepOver;
     }
 
     QVector<StackFrame> stackTrace(int frameLimit = -1) const;
@@ -200,6 +206,9 @@ private:
     void runInEngine(Job *job);
     void runInEngine_havingLock(Debugger::Job *job);
 
+    friend class DebuggerJobRunner;
+    void runPendingJobs();
+
 private:
     QV4::ExecutionEngine *m_engine;
     QV4::ExecutionContext *m_currentContext;
@@ -216,8 +225,25 @@ private:
     QV4::PersistentValue m_returnedValue;
 
     Job *m_gatherSources;
+    Job *m_heapSnapshot;
     Job *m_runningJob;
     QWaitCondition m_jobIsRunning;
+    DebuggerJobRunner *m_jobRunner;
+};
+
+// Lives in the engine's thread, to run jobs from its event loop.
+class DebuggerJobRunner : public QObject
+{
+    Q_OBJECT
+public:
+    DebuggerJobRunner(Debugger *debugger, QObject *parent)
+        : QObject(parent), m_debugger(debugger) {}
+
+public slots:
+    void runPendingJobs() { m_debugger->runPendingJobs(); }
+
+private:
+    Debugger *m_debugger;
 };
 
 class Q_QML_EXPORT DebuggerAgent : public QObject
@@ -246,6 +272,11 @@ public:
                                             QV4::Debugging::PauseReason reason) = 0;
     Q_INVOKABLE virtual void sourcesCollected(QV4::Debugging::Debugger *debugger,
                                               QStringList sources, int requestSequenceNr) = 0;
+    // Snapshots that are not written to a file arrive in chunks, before heapSnapshotTaken().
+    Q_INVOKABLE virtual void heapSnapshotChunk(QV4::Debugging::Debugger *debugger, QByteArray chunk,
+                                               int requestSequenceNr);
+    Q_INVOKABLE virtual void heapSnapshotTaken(QV4::Debugging::Debugger *debugger, bool success,
+                                               QString fileName, int requestSequenceNr);
 
 protected:
     QList<Debugger *> m_debuggers;
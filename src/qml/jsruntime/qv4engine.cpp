@@ -69,6 +69,10 @@
 #include "qv4qobjectwrapper_p.h"
 #include "qv4qmlextensions_p.h"
 #include "qv4memberdata_p.h"
+#include "qv4lookup_p.h"
+#include "qv4tierup_p.h"
+#include "qv4arraybuffer_p.h"
+#include "qv4typedarray_p.h"
 
 #include <QtCore/QTextStream>
 
@@ -159,6 +163,18 @@ quintptr getStackLimit()
     return stackLimit + 256*1024;
 }
 
+#ifdef V4_ENABLE_JIT
+// The number of interpreted calls after which a function is compiled with the JIT.
+// QV4_JIT_THRESHOLD=0 compiles all code with the JIT up front.
+static int jitThreshold()
+{
+    bool ok = false;
+    const int threshold = qgetenv("QV4_JIT_THRESHOLD").toInt(&ok);
+    return ok ? threshold : TierUpCompiler::DefaultCallThreshold;
+}
+#endif
+
+Q_STATIC_ASSERT(int(ExecutionEngine::NTypedArrayTypes) == int(TypedArray::NTypes));
 
 ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     : current(0)
@@ -188,10 +204,16 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
 #ifdef V4_ENABLE_JIT
         static const bool forceMoth = !qgetenv("QV4_FORCE_INTERPRETER").isEmpty();
-        if (forceMoth)
+        static const int callThreshold = jitThreshold();
+        if (forceMoth) {
             factory = new Moth::ISelFactory;
-        else
+        } else if (callThreshold > 0) {
+            // Interpret everything first, and only JIT the functions that turn out to be hot.
+            factory = new Moth::ISelFactory(/*recordTypeFeedback*/true);
+            tierUpCompiler.reset(new TierUpCompiler(this, new JIT::ISelFactory, callThreshold));
+        } else {
             factory = new JIT::ISelFactory;
+        }
 #else // !V4_ENABLE_JIT
         factory = new Moth::ISelFactory;
 #endif // V4_ENABLE_JIT
@@ -216,6 +238,7 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     identifierTable = new IdentifierTable(this);
 
     classPool = new InternalClassPool;
+    lookupStubCache = 0;
 
     emptyClass =  new (classPool) InternalClass(this);
     executionContextClass = InternalClass::create(this, ExecutionContext::staticVTable(), 0);
@@ -268,6 +291,8 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     arrayClass = arrayClass->changePrototype(arrayPrototype);
 
     simpleArrayDataClass = InternalClass::create(this, SimpleArrayData::staticVTable(), 0);
+    packedIntArrayDataClass = InternalClass::create(this, PackedIntArrayData::staticVTable(), 0);
+    packedDoubleArrayDataClass = InternalClass::create(this, PackedDoubleArrayData::staticVTable(), 0);
 
     InternalClass *argsClass = InternalClass::create(this, ArgumentsObject::staticVTable(), objectPrototype);
     argsClass = argsClass->addMember(id_length, Attr_NotEnumerable);
@@ -331,6 +356,15 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
     sequencePrototype = new (memoryManager) SequencePrototype(arrayClass);
 
+    ArrayBufferPrototype *arrayBufferPrototype = new (memoryManager) ArrayBufferPrototype(InternalClass::create(this, ArrayBufferPrototype::staticVTable(), objectPrototype));
+    arrayBufferClass = InternalClass::create(this, ArrayBuffer::staticVTable(), arrayBufferPrototype);
+
+    TypedArrayPrototype *typedArrayPrototypes[NTypedArrayTypes];
+    for (int i = 0; i < NTypedArrayTypes; ++i) {
+        typedArrayPrototypes[i] = new (memoryManager) TypedArrayPrototype(InternalClass::create(this, TypedArrayPrototype::staticVTable(), objectPrototype), TypedArray::Type(i));
+        typedArrayClasses[i] = InternalClass::create(this, TypedArray::staticVTable(), typedArrayPrototypes[i]);
+    }
+
     objectCtor = new (memoryManager) ObjectCtor(rootContext);
     stringCtor = new (memoryManager) StringCtor(rootContext);
     numberCtor = new (memoryManager) NumberCtor(rootContext);
@@ -346,6 +380,9 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     syntaxErrorCtor = new (memoryManager) SyntaxErrorCtor(rootContext);
     typeErrorCtor = new (memoryManager) TypeErrorCtor(rootContext);
     uRIErrorCtor = new (memoryManager) URIErrorCtor(rootContext);
+    arrayBufferCtor = new (memoryManager) ArrayBufferCtor(rootContext);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayCtors[i] = new (memoryManager) TypedArrayCtor(rootContext, TypedArray::Type(i));
 
     objectPrototype->init(this, objectCtor);
     stringPrototype->init(this, stringCtor);
@@ -362,6 +399,9 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     syntaxErrorPrototype->init(this, syntaxErrorCtor);
     typeErrorPrototype->init(this, typeErrorCtor);
     uRIErrorPrototype->init(this, uRIErrorCtor);
+    arrayBufferPrototype->init(this, arrayBufferCtor);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayPrototypes[i]->init(this, typedArrayCtors[i]);
 
     variantPrototype->init();
     static_cast<SequencePrototype *>(sequencePrototype.managed())->init();
@@ -389,6 +429,9 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     globalObject->defineDefaultProperty(QStringLiteral("SyntaxError"), syntaxErrorCtor);
     globalObject->defineDefaultProperty(QStringLiteral("TypeError"), typeErrorCtor);
     globalObject->defineDefaultProperty(QStringLiteral("URIError"), uRIErrorCtor);
+    globalObject->defineDefaultProperty(QStringLiteral("ArrayBuffer"), arrayBufferCtor);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        globalObject->defineDefaultProperty(QString::fromLatin1(TypedArray::operations[i].name), typedArrayCtors[i]);
     ScopedObject o(scope);
     globalObject->defineDefaultProperty(QStringLiteral("Math"), (o = new (memoryManager) MathObject(QV4::InternalClass::create(this, MathObject::staticVTable(), objectPrototype))));
     globalObject->defineDefaultProperty(QStringLiteral("JSON"), (o = new (memoryManager) JsonObject(QV4::InternalClass::create(this, JsonObject::staticVTable(), objectPrototype))));
@@ -417,6 +460,7 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
 ExecutionEngine::~ExecutionEngine()
 {
+    tierUpCompiler.reset();
     delete debugger;
     delete profiler;
     delete m_multiplyWrappedQObjects;
@@ -432,6 +476,7 @@ ExecutionEngine::~ExecutionEngine()
     delete m_qmlExtensions;
     emptyClass->destroy();
     delete classPool;
+    delete lookupStubCache;
     delete bumperPointerAllocator;
     delete regExpCache;
     delete regExpAllocator;
@@ -446,6 +491,7 @@ void ExecutionEngine::enableDebugger()
     Q_ASSERT(!debugger);
     debugger = new Debugging::Debugger(this);
     iselFactory.reset(new Moth::ISelFactory);
+    tierUpCompiler.reset();
 }
 
 void ExecutionEngine::enableProfiler()
@@ -658,6 +704,18 @@ Returned<Object> *ExecutionEngine::newVariantObject(const QVariant &v)
     return o->asReturned<Object>();
 }
 
+Returned<ArrayBuffer> *ExecutionEngine::newArrayBuffer(uint length)
+{
+    ArrayBuffer *object = new (memoryManager) ArrayBuffer(this, length);
+    return object->asReturned<ArrayBuffer>();
+}
+
+Returned<ArrayBuffer> *ExecutionEngine::newArrayBuffer(const QByteArray &array)
+{
+    ArrayBuffer *object = new (memoryManager) ArrayBuffer(this, array);
+    return object->asReturned<ArrayBuffer>();
+}
+
 Returned<Object> *ExecutionEngine::newForEachIteratorObject(ExecutionContext *ctx, const ObjectRef o)
 {
     Object *obj = new (memoryManager) ForEachIteratorObject(ctx, o);
@@ -895,6 +953,9 @@ void ExecutionEngine::markObjects()
     syntaxErrorCtor.mark(this);
     typeErrorCtor.mark(this);
     uRIErrorCtor.mark(this);
+    arrayBufferCtor.mark(this);
+    for (int i = 0; i < NTypedArrayTypes; ++i)
+        typedArrayCtors[i].mark(this);
     sequencePrototype.mark(this);
 
     exceptionValue.mark(this);
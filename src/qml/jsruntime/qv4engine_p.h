@@ -84,10 +84,12 @@ struct RegExpObject;
 struct ErrorObject;
 struct SyntaxErrorObject;
 struct ArgumentsObject;
+struct ArrayBuffer;
 struct ExecutionContext;
 struct ExecutionEngine;
 class MemoryManager;
 class ExecutableAllocator;
+class TierUpCompiler;
 
 struct ObjectPrototype;
 struct StringPrototype;
@@ -110,6 +112,7 @@ struct EvalFunction;
 struct IdentifierTable;
 struct InternalClass;
 struct InternalClassPool;
+struct LookupStubCache;
 class MultiplyWrappedQObjectMap;
 class RegExp;
 class RegExpCache;
@@ -140,6 +143,9 @@ public:
     ExecutableAllocator *executableAllocator;
     ExecutableAllocator *regExpAllocator;
     QScopedPointer<EvalISelFactory> iselFactory;
+    // When set, code is compiled for the interpreter, and the functions that turn out
+    // to be hot are recompiled with the JIT.
+    QScopedPointer<TierUpCompiler> tierUpCompiler;
 
 
     Value *jsStackLimit;
@@ -196,9 +202,13 @@ public:
     Value syntaxErrorCtor;
     Value typeErrorCtor;
     Value uRIErrorCtor;
+    Value arrayBufferCtor;
+    enum { NTypedArrayTypes = 9 }; // == TypedArray::NTypes, without depending on its header
+    Value typedArrayCtors[NTypedArrayTypes];
     Value sequencePrototype;
 
     InternalClassPool *classPool;
+    LookupStubCache *lookupStubCache; // created by the first megamorphic lookup
     InternalClass *emptyClass;
     InternalClass *executionContextClass;
     InternalClass *constructClass;
@@ -207,6 +217,8 @@ public:
     InternalClass *objectClass;
     InternalClass *arrayClass;
     InternalClass *simpleArrayDataClass;
+    InternalClass *packedIntArrayDataClass;
+    InternalClass *packedDoubleArrayDataClass;
     InternalClass *stringObjectClass;
     InternalClass *booleanClass;
     InternalClass *numberClass;
@@ -232,6 +244,9 @@ public:
     InternalClass *variantClass;
     InternalClass *memberDataClass;
 
+    InternalClass *arrayBufferClass;
+    InternalClass *typedArrayClasses[NTypedArrayTypes];
+
     EvalFunction *evalFunction;
     FunctionObject *thrower;
 
@@ -341,6 +356,9 @@ public:
 
     Returned<Object> *newVariantObject(const QVariant &v);
 
+    Returned<ArrayBuffer> *newArrayBuffer(uint length);
+    Returned<ArrayBuffer> *newArrayBuffer(const QByteArray &array);
+
     Returned<Object> *newForEachIteratorObject(ExecutionContext *ctx, const ObjectRef o);
 
     Returned<Object> *qmlContextObject() const;
@@ -143,7 +143,9 @@ bool ExecutableAllocator::ChunkOfPages::contains(Allocation *alloc) const
 }
 
 ExecutableAllocator::ExecutableAllocator()
-    : mutex(QMutex::NonRecursive)
+    : chunkSize(0)
+    , usedSize(0)
+    , mutex(QMutex::NonRecursive)
 {
 }
 
@@ -182,6 +184,7 @@ ExecutableAllocator::Allocation *ExecutableAllocator::allocate(size_t size)
         allocation->size = allocSize;
         allocation->free = true;
         chunk->firstAllocation = allocation;
+        chunkSize += allocSize;
     }
 
     Q_ASSERT(allocation);
@@ -196,6 +199,7 @@ ExecutableAllocator::Allocation *ExecutableAllocator::allocate(size_t size)
             freeAllocations.insert(remainder->size, remainder);
     }
 
+    usedSize += allocation->size;
     return allocation;
 }
 
@@ -206,6 +210,7 @@ void ExecutableAllocator::free(Allocation *allocation)
     Q_ASSERT(allocation);
 
     allocation->free = true;
+    usedSize -= allocation->size;
 
     QMap<quintptr, ChunkOfPages*>::Iterator it = chunks.lowerBound(allocation->addr);
     if (it != chunks.begin())
@@ -224,11 +229,24 @@ void ExecutableAllocator::free(Allocation *allocation)
     if (!chunk->firstAllocation->next) {
         freeAllocations.remove(chunk->firstAllocation->size, chunk->firstAllocation);
         chunks.erase(it);
+        chunkSize -= chunk->pages->size();
         delete chunk;
         return;
     }
 }
 
+size_t ExecutableAllocator::chunkMemory() const
+{
+    QMutexLocker locker(&mutex);
+    return chunkSize;
+}
+
+size_t ExecutableAllocator::usedMemory() const
+{
+    QMutexLocker locker(&mutex);
+    return usedSize;
+}
+
 ExecutableAllocator::ChunkOfPages *ExecutableAllocator::chunkForAllocation(Allocation *allocation) const
 {
     QMutexLocker locker(&mutex);
@@ -105,6 +105,10 @@ public:
     int freeAllocationCount() const { return freeAllocations.count(); }
     int chunkCount() const { return chunks.count(); }
 
+    // The memory mapped for code, and the part of it that is handed out.
+    size_t chunkMemory() const;
+    size_t usedMemory() const;
+
     struct ChunkOfPages
     {
         ChunkOfPages()
@@ -124,6 +128,8 @@ public:
 private:
     QMultiMap<size_t, Allocation*> freeAllocations;
     QMap<quintptr, ChunkOfPages*> chunks;
+    size_t chunkSize;
+    size_t usedSize;
     mutable QMutex mutex;
 };
 
@@ -56,6 +56,9 @@ Function::Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit,
         , compilationUnit(unit)
         , code(codePtr)
         , codeData(0)
+        , interpreterCallCount(0)
+        , interpreterBackEdgeCount(0)
+        , tierUpRequested(false)
 {
     Q_UNUSED(engine);
 
@@ -63,7 +66,7 @@ Function::Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit,
     const quint32 *formalsIndices = compiledFunction->formalsTable();
     // iterate backwards, so we get the right ordering for duplicate names
     for (int i = static_cast<int>(compiledFunction->nFormals - 1); i >= 0; --i) {
-        String *arg = compilationUnit->runtimeStrings[formalsIndices[i]].asString();
+        String *arg = compilationUnit->runtimeString(formalsIndices[i]).asString();
         while (1) {
             InternalClass *newClass = internalClass->addMember(arg, Attr_NotConfigurable);
             if (newClass != internalClass) {
@@ -77,7 +80,7 @@ Function::Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit,
 
     const quint32 *localsIndices = compiledFunction->localsTable();
     for (quint32 i = 0; i < compiledFunction->nLocals; ++i) {
-        String *local = compilationUnit->runtimeStrings[localsIndices[i]].asString();
+        String *local = compilationUnit->runtimeString(localsIndices[i]).asString();
         internalClass = internalClass->addMember(local, Attr_NotConfigurable);
     }
 }
@@ -90,12 +90,17 @@ struct Q_QML_EXPORT Function {
     // first nArguments names in internalClass are the actual arguments
     InternalClass *internalClass;
 
+    // Calls and backward jumps that ran in the interpreter, see TierUpCompiler.
+    uint interpreterCallCount;
+    uint interpreterBackEdgeCount;
+    bool tierUpRequested;
+
     Function(ExecutionEngine *engine, CompiledData::CompilationUnit *unit, const CompiledData::Function *function,
              ReturnedValue (*codePtr)(ExecutionContext *, const uchar *));
     ~Function();
 
     inline StringRef name() {
-        return compilationUnit->runtimeStrings[compiledFunction->nameIndex];
+        return compilationUnit->runtimeString(compiledFunction->nameIndex);
     }
     inline QString sourceFile() const { return compilationUnit->fileName(); }
 
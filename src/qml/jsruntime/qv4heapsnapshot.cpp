@@ -0,0 +1,508 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4heapsnapshot_p.h"
+#include "qv4engine_p.h"
+#include "qv4mm_p.h"
+#include "qv4object_p.h"
+#include "qv4memberdata_p.h"
+#include "qv4internalclass_p.h"
+#include "qv4functionobject_p.h"
+#include "qv4function_p.h"
+#include "qv4regexpobject_p.h"
+#include "qv4regexp_p.h"
+#include "qv4string_p.h"
+#include "qv4qobjectwrapper_p.h"
+
+#include <QBuffer>
+#include <QSet>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+
+using namespace QV4;
+
+namespace {
+
+enum { MaxStringLength = 1024 };
+
+const char snapshotMeta[] =
+        "{\"snapshot\":{\"meta\":{"
+        "\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\",\"edge_count\",\"trace_node_id\"],"
+        "\"node_types\":[[\"hidden\",\"array\",\"string\",\"object\",\"code\",\"closure\",\"regexp\","
+        "\"number\",\"native\",\"synthetic\",\"concatenated string\",\"sliced string\"],"
+        "\"string\",\"number\",\"number\",\"number\",\"number\",\"number\"],"
+        "\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],"
+        "\"edge_types\":[[\"context\",\"element\",\"property\",\"internal\",\"hidden\",\"shortcut\",\"weak\"],"
+        "\"string_or_number\",\"node\"],"
+        "\"trace_function_info_fields\":[\"function_id\",\"name\",\"script_name\",\"script_id\",\"line\",\"column\"],"
+        "\"trace_node_fields\":[\"id\",\"function_info_index\",\"count\",\"size\",\"children\"],"
+        "\"sample_fields\":[\"timestamp_us\",\"last_assigned_id\"],"
+        "\"location_fields\":[\"object_index\",\"script_id\",\"line\",\"column\"]},";
+
+enum { NodeFieldCount = 6 };
+
+void appendJsonString(QByteArray &out, const QString &string)
+{
+    out.append('"');
+    const QChar *ch = string.constData();
+    const QChar *end = ch + string.size();
+    int start = 0;
+    for (const QChar *i = ch; i != end; ++i) {
+        const ushort c = i->unicode();
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        out.append(QString::fromRawData(ch + start, (i - ch) - start).toUtf8());
+        start = (i - ch) + 1;
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            out.append("\\u00");
+            out.append("0123456789abcdef"[c >> 4]);
+            out.append("0123456789abcdef"[c & 0xf]);
+        }
+    }
+    out.append(QString::fromRawData(ch + start, string.size() - start).toUtf8());
+    out.append('"');
+}
+
+QString contextName(ExecutionContext *ctx)
+{
+    switch (ctx->type) {
+    case ExecutionContext::Type_GlobalContext:
+        return QStringLiteral("(global context)");
+    case ExecutionContext::Type_CatchContext:
+        return QStringLiteral("(catch context)");
+    case ExecutionContext::Type_WithContext:
+        return QStringLiteral("(with context)");
+    case ExecutionContext::Type_QmlContext:
+        return QStringLiteral("(QML context)");
+    default:
+        return QStringLiteral("(function context)");
+    }
+}
+
+QString functionName(FunctionObject *f)
+{
+    // Function::name() may have to create the string, which the heap walk must not do.
+    if (!f->function)
+        return QStringLiteral("(native function)");
+    const QString name = f->function->compilationUnit->data->stringAt(f->function->compiledFunction->nameIndex);
+    return name.isEmpty() ? QStringLiteral("(anonymous function)") : name;
+}
+
+QString qobjectName(QObject *object)
+{
+    QString name = QString::fromUtf8(object->metaObject()->className());
+    if (!object->objectName().isEmpty())
+        name += QLatin1String(" '") + object->objectName() + QLatin1Char('\'');
+    return name;
+}
+
+}
+
+namespace QV4 {
+
+struct HeapSnapshotVisitor : public MemoryManager::HeapVisitor
+{
+    HeapSnapshotVisitor(HeapSnapshot *snapshot)
+        : snapshot(snapshot)
+        , roots(0)
+        , current(-1)
+    {}
+
+    void root(Managed *m)
+    {
+        snapshot->addElementEdge(HeapSnapshot::RootNode, ++roots, m);
+    }
+
+    void object(Managed *m, std::size_t size);
+
+    void reference(Managed *from, Managed *to)
+    {
+        Q_UNUSED(from);
+        if (current < 0 || named.contains(to))
+            return;
+        snapshot->addEdge(current, HeapSnapshot::Edge_Internal,
+                          QString::fromLatin1(to->internalClass->vtable->className), to);
+    }
+
+    void namedEdge(HeapSnapshot::EdgeType type, const QString &name, const Value &value)
+    {
+        if (Managed *m = value.asManaged()) {
+            snapshot->addEdge(current, type, name, m);
+            named.insert(m);
+        }
+    }
+
+    void objectEdges(Object *o);
+    void contextEdges(ExecutionContext *ctx);
+
+    HeapSnapshot *snapshot;
+    int roots;
+    int current; // the node of the object being visited, -1 if it is not recorded
+    QSet<const void *> named; // objects referenced through named edges of the current node
+};
+
+void HeapSnapshotVisitor::object(Managed *m, std::size_t size)
+{
+    named.clear();
+    const ManagedVTable *vtable = m->internalClass->vtable;
+    const quint64 id = quintptr(m) | 1;
+
+    if (vtable == MemberData::staticVTable()) {
+        snapshot->m_memberDataSize.insert(m, size);
+        current = -1;
+        return;
+    }
+
+    if (vtable->isString) {
+        String *s = static_cast<String *>(m);
+        if (s->largestSubLength)
+            current = snapshot->addNode(m, HeapSnapshot::Node_ConcatenatedString, QStringLiteral("(concatenated string)"), id, size);
+        else
+            current = snapshot->addNode(m, HeapSnapshot::Node_String, s->toQString().left(MaxStringLength), id, size);
+        return;
+    }
+
+    if (vtable->isExecutionContext) {
+        ExecutionContext *ctx = static_cast<ExecutionContext *>(m);
+        current = snapshot->addNode(m, HeapSnapshot::Node_Hidden, contextName(ctx), id, size);
+        contextEdges(ctx);
+        return;
+    }
+
+    if (vtable->isArrayData) {
+        current = snapshot->addNode(m, HeapSnapshot::Node_Array, QStringLiteral("(object elements)"), id, size);
+        return;
+    }
+
+    if (!vtable->isObject) {
+        current = snapshot->addNode(m, HeapSnapshot::Node_Hidden,
+                                    QLatin1String("system / ") + QLatin1String(vtable->className), id, size);
+        return;
+    }
+
+    Object *o = static_cast<Object *>(m);
+    if (FunctionObject *f = m->asFunctionObject()) {
+        current = snapshot->addNode(m, HeapSnapshot::Node_Closure, functionName(f), id, size);
+        if (f->scope) {
+            snapshot->addEdge(current, HeapSnapshot::Edge_Context, QStringLiteral("context"), f->scope);
+            named.insert(f->scope);
+        }
+    } else if (RegExpObject *r = m->as<RegExpObject>()) {
+        current = snapshot->addNode(m, HeapSnapshot::Node_RegExp,
+                                    r->value ? r->value->pattern() : QString(), id, size);
+    } else if (QObjectWrapper *wrapper = m->as<QObjectWrapper>()) {
+        QObject *object = wrapper->object();
+        current = snapshot->addNode(m, HeapSnapshot::Node_Object,
+                                    QLatin1String("QObjectWrapper ") + (object ? qobjectName(object) : QStringLiteral("(deleted)")),
+                                    id, size);
+        if (object) {
+            snapshot->addNativeObject(object);
+            snapshot->addEdge(current, HeapSnapshot::Edge_Internal, QStringLiteral("qobject"), object);
+        }
+    } else {
+        QString name = m->className();
+        if (name.isEmpty())
+            name = QLatin1String(vtable->className);
+        current = snapshot->addNode(m, HeapSnapshot::Node_Object, name, id, size);
+    }
+    objectEdges(o);
+}
+
+void HeapSnapshotVisitor::objectEdges(Object *o)
+{
+    InternalClass *ic = o->internalClass;
+    snapshot->m_nodes[current].members = o->memberData.d();
+
+    // Objects with the same InternalClass share a node for it.
+    if (!snapshot->m_nodeIndex.contains(ic)) {
+        QStringList names;
+        for (uint i = 0; i < ic->size; ++i) {
+            String *name = ic->nameMap.at(i);
+            if (!name)
+                continue;
+            if (names.size() == 8) {
+                names.append(QStringLiteral("..."));
+                break;
+            }
+            names.append(name->toQString());
+        }
+        snapshot->addNode(ic, HeapSnapshot::Node_Hidden,
+                          QLatin1String("system / InternalClass {") + names.join(QStringLiteral(", ")) + QLatin1Char('}'),
+                          quintptr(ic), sizeof(InternalClass));
+    }
+    snapshot->addEdge(current, HeapSnapshot::Edge_Internal, QStringLiteral("map"), ic);
+
+    if (ic->prototype) {
+        snapshot->addEdge(current, HeapSnapshot::Edge_Property, QStringLiteral("__proto__"), ic->prototype);
+        named.insert(ic->prototype);
+    }
+
+    const uint memberCount = qMin(ic->size, o->memberData.size());
+    for (uint i = 0; i < memberCount; ++i) {
+        String *name = ic->nameMap.at(i);
+        if (!name)
+            continue;
+        const QString propertyName = name->toQString();
+        if (ic->propertyData.at(i).isAccessor() && i + 1 < memberCount) {
+            namedEdge(HeapSnapshot::Edge_Property, QLatin1String("get ") + propertyName, o->memberData[i]);
+            namedEdge(HeapSnapshot::Edge_Property, QLatin1String("set ") + propertyName, o->memberData[i + 1]);
+        } else {
+            namedEdge(HeapSnapshot::Edge_Property, propertyName, o->memberData[i]);
+        }
+    }
+}
+
+void HeapSnapshotVisitor::contextEdges(ExecutionContext *ctx)
+{
+    if (ctx->outer) {
+        snapshot->addEdge(current, HeapSnapshot::Edge_Internal, QStringLiteral("outer"), ctx->outer);
+        named.insert(ctx->outer);
+    }
+    namedEdge(HeapSnapshot::Edge_Internal, QStringLiteral("this"), ctx->callData->thisObject);
+
+    if (ctx->type < ExecutionContext::Type_CallContext)
+        return;
+    CallContext *c = static_cast<CallContext *>(ctx);
+    if (!c->function || !c->function->function)
+        return;
+
+    // formals are in reverse order
+    const int nFormals = c->formalCount();
+    for (int i = 0; i < nFormals && i < c->callData->argc; ++i) {
+        if (String *name = c->formals()[nFormals - i - 1])
+            namedEdge(HeapSnapshot::Edge_Context, name->toQString(), c->callData->args[i]);
+    }
+    for (unsigned i = 0, ei = c->variableCount(); i < ei; ++i) {
+        if (String *name = c->variables()[i])
+            namedEdge(HeapSnapshot::Edge_Context, name->toQString(), c->locals[i]);
+    }
+    if (c->activation) {
+        snapshot->addEdge(current, HeapSnapshot::Edge_Internal, QStringLiteral("activation"), c->activation);
+        named.insert(c->activation);
+    }
+}
+
+}
+
+HeapSnapshot::HeapSnapshot(ExecutionEngine *engine)
+    : m_engine(engine)
+{
+}
+
+bool HeapSnapshot::take()
+{
+    m_nodes.clear();
+    m_nodeIndex.clear();
+    m_memberDataSize.clear();
+    m_strings.clear();
+    m_stringIndex.clear();
+
+    addNode(m_engine, Node_Synthetic, QStringLiteral("(GC roots)"), 1, 0);
+    // The QObjects of wrappers and their parents, which show who owns a wrapper.
+    addNode(this, Node_Synthetic, QStringLiteral("(QObject tree)"), 3, 0);
+    addElementEdge(RootNode, 0, this);
+
+    HeapSnapshotVisitor visitor(this);
+    if (!m_engine->memoryManager->visitHeap(&visitor)) {
+        m_nodes.clear();
+        m_nodeIndex.clear();
+        return false;
+    }
+
+    resolveEdges();
+    return true;
+}
+
+int HeapSnapshot::edgeCount() const
+{
+    int count = 0;
+    for (QVector<Node>::const_iterator i = m_nodes.constBegin(), ei = m_nodes.constEnd(); i != ei; ++i)
+        count += i->edges.size();
+    return count;
+}
+
+int HeapSnapshot::addString(const QString &string)
+{
+    QHash<QString, int>::const_iterator it = m_stringIndex.constFind(string);
+    if (it != m_stringIndex.constEnd())
+        return *it;
+    m_strings.append(string);
+    m_stringIndex.insert(string, m_strings.size() - 1);
+    return m_strings.size() - 1;
+}
+
+int HeapSnapshot::addNode(const void *key, NodeType type, const QString &name, quint64 id, quint64 selfSize)
+{
+    Node node;
+    node.type = type;
+    node.name = addString(name);
+    node.id = id;
+    node.selfSize = selfSize;
+    node.members = 0;
+    m_nodes.append(node);
+    m_nodeIndex.insert(key, m_nodes.size() - 1);
+    return m_nodes.size() - 1;
+}
+
+void HeapSnapshot::addEdge(int from, EdgeType type, const QString &name, const void *to)
+{
+    Edge edge;
+    edge.type = type;
+    edge.nameOrIndex = addString(name);
+    edge.to = to;
+    m_nodes[from].edges.append(edge);
+}
+
+void HeapSnapshot::addElementEdge(int from, int index, const void *to)
+{
+    Edge edge;
+    edge.type = Edge_Element;
+    edge.nameOrIndex = index;
+    edge.to = to;
+    m_nodes[from].edges.append(edge);
+}
+
+int HeapSnapshot::addNativeObject(QObject *object)
+{
+    QHash<const void *, int>::const_iterator it = m_nodeIndex.constFind(object);
+    if (it != m_nodeIndex.constEnd())
+        return *it;
+
+    const int node = addNode(object, Node_Native, qobjectName(object), quintptr(object) & ~quintptr(1), 0);
+    if (QObject *parent = object->parent())
+        addEdge(addNativeObject(parent), Edge_Internal, QStringLiteral("child"), object);
+    else
+        addElementEdge(QObjectTreeNode, m_nodes.at(QObjectTreeNode).edges.size(), object);
+    return node;
+}
+
+// Drops edges to objects that are not in the snapshot, like member data,
+// and replaces the targets by node indices.
+void HeapSnapshot::resolveEdges()
+{
+    for (QVector<Node>::iterator i = m_nodes.begin(), ei = m_nodes.end(); i != ei; ++i) {
+        if (i->members)
+            i->selfSize += m_memberDataSize.value(i->members);
+
+        QVector<Edge> edges;
+        edges.reserve(i->edges.size());
+        foreach (const Edge &edge, i->edges) {
+            QHash<const void *, int>::const_iterator it = m_nodeIndex.constFind(edge.to);
+            if (it == m_nodeIndex.constEnd())
+                continue;
+            Edge resolved = edge;
+            resolved.to = reinterpret_cast<const void *>(quintptr(*it));
+            edges.append(resolved);
+        }
+        i->edges = edges;
+    }
+}
+
+void HeapSnapshot::write(QIODevice *device) const
+{
+    QByteArray out(snapshotMeta);
+    out.reserve(64 * 1024);
+    out.append("\"node_count\":" + QByteArray::number(m_nodes.size()));
+    out.append(",\"edge_count\":" + QByteArray::number(edgeCount()));
+    out.append(",\"trace_function_count\":0},\n\"nodes\":[");
+
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        const Node &node = m_nodes.at(i);
+        if (i)
+            out.append(",\n");
+        out.append(QByteArray::number(node.type)).append(',')
+                .append(QByteArray::number(node.name)).append(',')
+                .append(QByteArray::number(node.id)).append(',')
+                .append(QByteArray::number(node.selfSize)).append(',')
+                .append(QByteArray::number(node.edges.size())).append(",0");
+        if (out.size() > 60 * 1024) {
+            device->write(out);
+            out.clear();
+        }
+    }
+
+    out.append("],\n\"edges\":[");
+    bool first = true;
+    for (QVector<Node>::const_iterator i = m_nodes.constBegin(), ei = m_nodes.constEnd(); i != ei; ++i) {
+        foreach (const Edge &edge, i->edges) {
+            if (!first)
+                out.append(",\n");
+            first = false;
+            out.append(QByteArray::number(edge.type)).append(',')
+                    .append(QByteArray::number(edge.nameOrIndex)).append(',')
+                    .append(QByteArray::number(quint64(quintptr(edge.to)) * NodeFieldCount));
+        }
+        if (out.size() > 60 * 1024) {
+            device->write(out);
+            out.clear();
+        }
+    }
+
+    out.append("],\n\"trace_function_infos\":[],\"trace_tree\":[],\"samples\":[],\"locations\":[],\n\"strings\":[");
+    for (int i = 0; i < m_strings.size(); ++i) {
+        if (i)
+            out.append(",\n");
+        appendJsonString(out, m_strings.at(i));
+        if (out.size() > 60 * 1024) {
+            device->write(out);
+            out.clear();
+        }
+    }
+    out.append("]}\n");
+    device->write(out);
+}
+
+QByteArray HeapSnapshot::toJson() const
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    write(&buffer);
+    return buffer.data();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4HEAPSNAPSHOT_H
+#define QV4HEAPSNAPSHOT_H
+
+#include "qv4global_p.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QIODevice;
+class QObject;
+
+namespace QV4 {
+
+struct ExecutionEngine;
+struct Managed;
+
+// Records the object graph of the JS heap and writes it in the .heapsnapshot
+// format of the Chrome developer tools, which computes the retained sizes.
+class Q_QML_PRIVATE_EXPORT HeapSnapshot
+{
+public:
+    // in the order of the node_types and edge_types of the format
+    enum NodeType {
+        Node_Hidden,
+        Node_Array,
+        Node_String,
+        Node_Object,
+        Node_Code,
+        Node_Closure,
+        Node_RegExp,
+        Node_Number,
+        Node_Native,
+        Node_Synthetic,
+        Node_ConcatenatedString,
+        Node_SlicedString
+    };
+
+    enum EdgeType {
+        Edge_Context,
+        Edge_Element,
+        Edge_Property,
+        Edge_Internal,
+        Edge_Hidden,
+        Edge_Shortcut,
+        Edge_Weak
+    };
+
+    struct Edge {
+        EdgeType type;
+        int nameOrIndex; // an index into the strings, or an element index
+        const void *to;
+    };
+
+    struct Node {
+        NodeType type;
+        int name;
+        quint64 id;
+        quint64 selfSize;
+        const void *members; // the member data of objects is counted as part of the object
+        QVector<Edge> edges;
+    };
+
+    HeapSnapshot(ExecutionEngine *engine);
+
+    // Collects garbage and records the remaining heap. Returns false if the
+    // garbage collector is blocked.
+    bool take();
+
+    int nodeCount() const { return m_nodes.size(); }
+    int edgeCount() const;
+
+    void write(QIODevice *device) const;
+    QByteArray toJson() const;
+
+private:
+    friend struct HeapSnapshotVisitor;
+
+    enum { RootNode, QObjectTreeNode };
+
+    int addString(const QString &string);
+    int addNode(const void *key, NodeType type, const QString &name, quint64 id, quint64 selfSize);
+    void addEdge(int from, EdgeType type, const QString &name, const void *to);
+    void addElementEdge(int from, int index, const void *to);
+    int addNativeObject(QObject *object);
+    void resolveEdges();
+
+    ExecutionEngine *m_engine;
+    QVector<Node> m_nodes;
+    QHash<const void *, int> m_nodeIndex;
+    QHash<const void *, quint64> m_memberDataSize;
+    QVector<QString> m_strings;
+    QHash<QString, int> m_stringIndex;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QV4HEAPSNAPSHOT_H
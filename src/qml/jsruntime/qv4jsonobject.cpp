@@ -50,6 +50,7 @@
 #include <qstringlist.h>
 
 #include <wtf/MathExtras.h>
+#include <double-conversion.h>
 
 using namespace QV4;
 
@@ -68,7 +69,7 @@ static int indent = 0;
 
 DEFINE_OBJECT_VTABLE(JsonObject);
 
-class JsonParser
+class JsonParser : public JsonScanner
 {
 public:
     JsonParser(ExecutionContext *context, const QChar *json, int length);
@@ -76,32 +77,37 @@ public:
     ReturnedValue parse(QJsonParseError *error);
 
 private:
-    inline bool eatSpace();
-    inline QChar nextToken();
+    // Members and elements are collected in batches of this size on the JS stack
+    // before they are stored into their object or array.
+    enum { MemberBatchSize = 16, ElementBatchSize = 64 };
 
     ReturnedValue parseObject();
     ReturnedValue parseArray();
-    bool parseMember(ObjectRef o);
-    bool parseString(QString *string);
+    String *parseName(uint memberIndex);
+    void storeMembers(Scoped<Object> &o, InternalClass *klass, String **keys, const uint *slots, Value *values, int count);
     bool parseValue(ValueRef val);
-    bool parseNumber(ValueRef val);
 
     ExecutionContext *context;
-    const QChar *head;
-    const QChar *json;
-    const QChar *end;
 
     int nestingLevel;
-    QJsonParseError::ParseError lastError;
+
+    // The class of the last object parsed at each nesting level. Arrays of
+    // records mostly repeat the same keys in the same order, so this predicts
+    // the names of the next object's members.
+    QVector<InternalClass *> shapes;
 };
 
 static const int nestingLimit = 1024;
 
 
+JsonScanner::JsonScanner(const QChar *json, int length)
+    : head(json), json(json), end(json + length), lastError(QJsonParseError::NoError)
+{
+}
+
 JsonParser::JsonParser(ExecutionContext *context, const QChar *json, int length)
-    : context(context), head(json), json(json), nestingLevel(0), lastError(QJsonParseError::NoError)
+    : JsonScanner(json, length), context(context), nestingLevel(0)
 {
-    end = json + length;
 }
 
 
@@ -132,21 +138,7 @@ ws = *(
 
 */
 
-enum {
-    Space = 0x20,
-    Tab = 0x09,
-    LineFeed = 0x0a,
-    Return = 0x0d,
-    BeginArray = 0x5b,
-    BeginObject = 0x7b,
-    EndArray = 0x5d,
-    EndObject = 0x7d,
-    NameSeparator = 0x3a,
-    ValueSeparator = 0x2c,
-    Quote = 0x22
-};
-
-bool JsonParser::eatSpace()
+bool JsonScanner::eatSpace()
 {
     while (json < end) {
         if (*json > Space)
@@ -161,7 +153,7 @@ bool JsonParser::eatSpace()
     return (json < end);
 }
 
-QChar JsonParser::nextToken()
+QChar JsonScanner::nextToken()
 {
     if (!eatSpace())
         return 0;
@@ -225,6 +217,8 @@ ReturnedValue JsonParser::parse(QJsonParseError *error)
 /*
     object = begin-object [ member *( value-separator member ) ]
     end-object
+
+    member = string name-separator value
 */
 
 ReturnedValue JsonParser::parseObject()
@@ -237,12 +231,46 @@ ReturnedValue JsonParser::parseObject()
     BEGIN << "parseObject pos=" << json;
     Scope scope(context);
 
-    ScopedObject o(scope, context->engine->newObject());
+    if (shapes.size() <= nestingLevel)
+        shapes.resize(nestingLevel + 1);
+
+    // The internal class is built up while parsing, and the object is only
+    // created once the first batch of members is complete, so its member data
+    // gets allocated with the right size and the values are stored directly.
+    ScopedObject o(scope);
+    InternalClass *klass = context->engine->objectClass;
+    String *keys[MemberBatchSize];
+    uint slots[MemberBatchSize];
+    Value *values = scope.alloc(MemberBatchSize);
+    for (int i = 0; i < MemberBatchSize; ++i)
+        values[i] = Primitive::undefinedValue();
+    int count = 0;
 
     QChar token = nextToken();
     while (token == Quote) {
-        if (!parseMember(o))
+        BEGIN << "parseMember";
+        String *key = parseName(klass->size);
+        if (!key)
+            return Encode::undefined();
+        token = nextToken();
+        if (token != NameSeparator) {
+            lastError = QJsonParseError::MissingNameSeparator;
             return Encode::undefined();
+        }
+        if (!parseValue(ValueRef(values[count])))
+            return Encode::undefined();
+
+        uint slot = UINT_MAX;
+        if (key->asArrayIndex() == UINT_MAX)
+            klass = klass->addMember(key, Attr_Data, &slot);
+        keys[count] = key;
+        slots[count] = slot;
+        if (++count == MemberBatchSize) {
+            storeMembers(o, klass, keys, slots, values, count);
+            count = 0;
+        }
+        END;
+
         token = nextToken();
         if (token != ValueSeparator)
             break;
@@ -259,42 +287,65 @@ ReturnedValue JsonParser::parseObject()
         return Encode::undefined();
     }
 
+    storeMembers(o, klass, keys, slots, values, count);
+    shapes[nestingLevel] = klass;
+
     END;
 
     --nestingLevel;
     return o.asReturnedValue();
 }
 
+void JsonParser::storeMembers(Scoped<Object> &o, InternalClass *klass, String **keys, const uint *slots, Value *values, int count)
+{
+    if (!o) {
+        o = context->engine->newObject(klass);
+    } else if (o->internalClass != klass) {
+        o->internalClass = klass;
+        o->ensureMemberIndex(klass->size);
+    }
+
+    // Duplicate keys map to the same slot, so the last value wins.
+    for (int i = 0; i < count; ++i) {
+        if (slots[i] == UINT_MAX)
+            o->putIndexed(keys[i]->asArrayIndex(), ValueRef(values[i]));
+        else
+            o->memberData[slots[i]] = values[i];
+    }
+}
+
 /*
-    member = string name-separator value
+    Parses a member name into an identifier. Names without escape sequences
+    are compared against the name the previous object at this nesting level
+    had at the same position, which avoids creating a string when it matches.
 */
-bool JsonParser::parseMember(ObjectRef o)
+String *JsonParser::parseName(uint memberIndex)
 {
-    BEGIN << "parseMember";
-    Scope scope(context);
+    const QChar *start = json;
+    while (json < end && *json != Quote && *json != '\\' && json->unicode() > 0x1f)
+        ++json;
 
-    QString key;
-    if (!parseString(&key))
-        return false;
-    QChar token = nextToken();
-    if (token != NameSeparator) {
-        lastError = QJsonParseError::MissingNameSeparator;
-        return false;
-    }
-    ScopedValue val(scope);
-    if (!parseValue(val))
-        return false;
+    if (json < end && *json == Quote) {
+        int length = json - start;
+        ++json;
 
-    ScopedString s(scope, context->engine->newIdentifier(key));
-    uint idx = s->asArrayIndex();
-    if (idx < UINT_MAX) {
-        o->putIndexed(idx, val);
-    } else {
-        o->insertMember(s, val);
+        const InternalClass *shape = shapes.at(nestingLevel);
+        if (shape && memberIndex < shape->size) {
+            String *expected = shape->nameMap.at(memberIndex);
+            if (expected) {
+                QString name = expected->toQString();
+                if (name.length() == length && !memcmp(name.constData(), start, length * sizeof(QChar)))
+                    return expected;
+            }
+        }
+        return context->engine->newIdentifier(QString(start, length));
     }
 
-    END;
-    return true;
+    json = start;
+    QString key;
+    if (!parseString(&key))
+        return 0;
+    return context->engine->newIdentifier(key);
 }
 
 /*
@@ -318,12 +369,17 @@ ReturnedValue JsonParser::parseArray()
     if (*json == EndArray) {
         nextToken();
     } else {
+        Value *values = scope.alloc(ElementBatchSize);
+        for (int i = 0; i < ElementBatchSize; ++i)
+            values[i] = Primitive::undefinedValue();
+        array->arrayCreate();
+
         uint index = 0;
+        int count = 0;
         while (1) {
-            ScopedValue val(scope);
-            if (!parseValue(val))
+            if (!parseValue(ValueRef(values[count])))
                 return Encode::undefined();
-            array->arraySet(index, val);
+            ++count;
             QChar token = nextToken();
             if (token == EndArray)
                 break;
@@ -334,8 +390,14 @@ ReturnedValue JsonParser::parseArray()
                     lastError = QJsonParseError::MissingValueSeparator;
                 return Encode::undefined();
             }
-            ++index;
+            if (count == ElementBatchSize) {
+                array->arrayPut(index, values, count);
+                index += count;
+                count = 0;
+            }
         }
+        array->arrayPut(index, values, count);
+        array->setArrayLengthUnchecked(index + count);
     }
 
     DEBUG << "size =" << array->getLength();
@@ -356,51 +418,26 @@ bool JsonParser::parseValue(ValueRef val)
 
     switch ((json++)->unicode()) {
     case 'n':
-        if (end - json < 3) {
-            lastError = QJsonParseError::IllegalValue;
+        if (!scanLiteral("ull"))
             return false;
-        }
-        if (*json++ == 'u' &&
-            *json++ == 'l' &&
-            *json++ == 'l') {
-            *val = Primitive::nullValue();
-            DEBUG << "value: null";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
+        *val = Primitive::nullValue();
+        DEBUG << "value: null";
+        END;
+        return true;
     case 't':
-        if (end - json < 3) {
-            lastError = QJsonParseError::IllegalValue;
+        if (!scanLiteral("rue"))
             return false;
-        }
-        if (*json++ == 'r' &&
-            *json++ == 'u' &&
-            *json++ == 'e') {
-            *val = Primitive::fromBoolean(true);
-            DEBUG << "value: true";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
+        *val = Primitive::fromBoolean(true);
+        DEBUG << "value: true";
+        END;
+        return true;
     case 'f':
-        if (end - json < 4) {
-            lastError = QJsonParseError::IllegalValue;
+        if (!scanLiteral("alse"))
             return false;
-        }
-        if (*json++ == 'a' &&
-            *json++ == 'l' &&
-            *json++ == 's' &&
-            *json++ == 'e') {
-            *val = Primitive::fromBoolean(false);
-            DEBUG << "value: false";
-            END;
-            return true;
-        }
-        lastError = QJsonParseError::IllegalValue;
-        return false;
+        *val = Primitive::fromBoolean(false);
+        DEBUG << "value: false";
+        END;
+        return true;
     case Quote: {
         QString value;
         if (!parseString(&value))
@@ -444,6 +481,20 @@ bool JsonParser::parseValue(ValueRef val)
 
 
 
+/*
+    Scans the rest of the literal null, true or false, after its first character.
+*/
+bool JsonScanner::scanLiteral(const char *rest)
+{
+    for (; *rest; ++rest, ++json) {
+        if (json >= end || *json != QLatin1Char(*rest)) {
+            lastError = QJsonParseError::IllegalValue;
+            return false;
+        }
+    }
+    return true;
+}
+
 /*
         number = [ minus ] int [ frac ] [ exp ]
         decimal-point = %x2E       ; .
@@ -458,7 +509,7 @@ bool JsonParser::parseValue(ValueRef val)
 
 */
 
-bool JsonParser::parseNumber(ValueRef val)
+bool JsonScanner::parseNumber(ValueRef val)
 {
     BEGIN << "parseNumber" << *json;
 
@@ -495,29 +546,38 @@ bool JsonParser::parseNumber(ValueRef val)
             ++json;
     }
 
-    QString number(start, json - start);
-    DEBUG << "numberstring" << number;
+    int length = json - start;
+    DEBUG << "numberstring" << QString(start, length);
 
     if (isInt) {
-        bool ok;
-        int n = number.toInt(&ok);
-        if (ok && n < (1<<25) && n > -(1<<25)) {
-            *val = Primitive::fromInt32(n);
-            END;
-            return true;
+        // small integers are accumulated directly, -0 has to stay a double
+        const QChar *digit = start;
+        bool negative = (*digit == '-');
+        if (negative)
+            ++digit;
+        if (json > digit && json - digit <= 8) {
+            int n = 0;
+            for (; digit < json; ++digit)
+                n = n * 10 + (digit->unicode() - '0');
+            if (n < (1<<25) && (n || !negative)) {
+                *val = Primitive::fromInt32(negative ? -n : n);
+                END;
+                return true;
+            }
         }
     }
 
-    bool ok;
-    double d;
-    d = number.toDouble(&ok);
+    static const double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS,
+                                                                      0.0, std::numeric_limits<double>::quiet_NaN(), 0, 0);
+    int processed = 0;
+    double d = converter.StringToDouble(reinterpret_cast<const double_conversion::uc16 *>(start), length, &processed);
 
-    if (!ok) {
+    if (!length || processed != length) {
         lastError = QJsonParseError::IllegalNumber;
         return false;
     }
 
-    * val = Primitive::fromDouble(d);
+    *val = Primitive::fromDouble(d);
 
     END;
     return true;
@@ -603,14 +663,17 @@ static inline bool scanEscapeSequence(const QChar *&json, const QChar *end, uint
 }
 
 
-bool JsonParser::parseString(QString *string)
+bool JsonScanner::parseString(QString *string)
 {
     BEGIN << "parse string stringPos=" << json;
 
+    // unescaped characters are appended in runs
+    const QChar *run = json;
     while (json < end) {
         if (*json == '"')
             break;
         else if (*json == '\\') {
+            string->append(run, json - run);
             uint ch = 0;
             if (!scanEscapeSequence(json, end, &ch)) {
                 lastError = QJsonParseError::IllegalEscapeSequence;
@@ -622,15 +685,16 @@ bool JsonParser::parseString(QString *string)
             } else {
                 *string += QChar(ch);
             }
+            run = json;
         } else {
             if (json->unicode() <= 0x1f) {
                 lastError = QJsonParseError::IllegalEscapeSequence;
                 return false;
             }
-            *string += *json;
             ++json;
         }
     }
+    string->append(run, json - run);
     ++json;
 
     if (json > end) {
@@ -650,67 +714,80 @@ struct Stringify
     QVector<String *> propertyList;
     QString gap;
     QString indent;
+    String *toJSONName;
+
+    // the whole result is appended to this buffer
+    QString result;
 
     QStack<Object *> stack;
 
-    Stringify(ExecutionContext *ctx) : ctx(ctx), replacerFunction(0) {}
+    Stringify(ExecutionContext *ctx)
+        : ctx(ctx), replacerFunction(0), toJSONName(ctx->engine->newIdentifier(QStringLiteral("toJSON"))) {}
 
-    QString Str(const QString &key, ValueRef v);
-    QString JA(ArrayObjectRef a);
-    QString JO(ObjectRef o);
+    bool Str(const QString &key, ValueRef v);
+    void JA(ArrayObjectRef a);
+    void JO(ObjectRef o);
 
-    QString makeMember(const QString &key, ValueRef v);
+    void member(const QString &key, ValueRef v, bool *first);
+    void quote(const QString &str);
 };
 
-static QString quote(const QString &str)
+void Stringify::quote(const QString &str)
 {
-    QString product = QStringLiteral("\"");
-    for (int i = 0; i < str.length(); ++i) {
-        QChar c = str.at(i);
-        switch (c.unicode()) {
+    result.reserve(result.length() + str.length() + 2);
+    result += QLatin1Char('"');
+    const QChar *run = str.constData();
+    const QChar *end = run + str.length();
+    for (const QChar *c = run; c < end; ++c) {
+        ushort u = c->unicode();
+        if (u > '\\' || (u >= 0x20 && u != '"' && u != '\\'))
+            continue;
+        result.append(run, c - run);
+        run = c + 1;
+        switch (u) {
         case '"':
-            product += QStringLiteral("\\\"");
+            result += QStringLiteral("\\\"");
             break;
         case '\\':
-            product += QStringLiteral("\\\\");
+            result += QStringLiteral("\\\\");
             break;
         case '\b':
-            product += QStringLiteral("\\b");
+            result += QStringLiteral("\\b");
             break;
         case '\f':
-            product += QStringLiteral("\\f");
+            result += QStringLiteral("\\f");
             break;
         case '\n':
-            product += QStringLiteral("\\n");
+            result += QStringLiteral("\\n");
             break;
         case '\r':
-            product += QStringLiteral("\\r");
+            result += QStringLiteral("\\r");
             break;
         case '\t':
-            product += QStringLiteral("\\t");
+            result += QStringLiteral("\\t");
             break;
         default:
-            if (c.unicode() <= 0x1f) {
-                product += QStringLiteral("\\u00");
-                product += c.unicode() > 0xf ? QLatin1Char('1') : QLatin1Char('0');
-                product += QLatin1Char("0123456789abcdef"[c.unicode() & 0xf]);
-            } else {
-                product += c;
-            }
+            result += QStringLiteral("\\u00");
+            result += u > 0xf ? QLatin1Char('1') : QLatin1Char('0');
+            result += QLatin1Char("0123456789abcdef"[u & 0xf]);
         }
     }
-    product += QLatin1Char('"');
-    return product;
+    result.append(run, end - run);
+    result += QLatin1Char('"');
 }
 
-QString Stringify::Str(const QString &key, ValueRef v)
+/*
+    Appends the serialization of v to the result. Returns false and leaves the
+    result untouched if v does not have a JSON representation.
+*/
+bool Stringify::Str(const QString &key, ValueRef v)
 {
     Scope scope(ctx);
 
     ScopedValue value(scope, *v);
     ScopedObject o(scope, value);
     if (o) {
-        ScopedString s(scope, ctx->engine->newString(QStringLiteral("toJSON")));
+        ScopedString s(scope, toJSONName);
         Scoped<FunctionObject> toJSON(scope, o->get(s));
         if (!!toJSON) {
             ScopedCallData callData(scope, 1);
@@ -740,16 +817,30 @@ QString Stringify::Str(const QString &key, ValueRef v)
             value = b->value;
     }
 
-    if (value->isNull())
-        return QStringLiteral("null");
-    if (value->isBoolean())
-        return value->booleanValue() ? QStringLiteral("true") : QStringLiteral("false");
-    if (value->isString())
-        return quote(value->stringValue()->toQString());
+    if (value->isNull()) {
+        result += QStringLiteral("null");
+        return true;
+    }
+    if (value->isBoolean()) {
+        result += value->booleanValue() ? QStringLiteral("true") : QStringLiteral("false");
+        return true;
+    }
+    if (value->isString()) {
+        quote(value->stringValue()->toQString());
+        return true;
+    }
 
     if (value->isNumber()) {
         double d = value->toNumber();
-        return std::isfinite(d) ? value->toString(ctx)->toQString() : QStringLiteral("null");
+        if (std::isfinite(d)) {
+            char str[100];
+            double_conversion::StringBuilder builder(str, sizeof(str));
+            double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortest(d, &builder);
+            result += QLatin1String(builder.Finalize());
+        } else {
+            result += QStringLiteral("null");
+        }
+        return true;
     }
 
     o = value.asReturnedValue();
@@ -757,44 +848,52 @@ QString Stringify::Str(const QString &key, ValueRef v)
         if (!o->asFunctionObject()) {
             if (o->asArrayObject()) {
                 ScopedArrayObject a(scope, o);
-                return JA(a);
+                JA(a);
             } else {
-                return JO(o);
+                JO(o);
             }
+            return true;
         }
     }
 
-    return QString();
+    return false;
 }
 
-QString Stringify::makeMember(const QString &key, ValueRef v)
+void Stringify::member(const QString &key, ValueRef v, bool *first)
 {
-    QString strP = Str(key, v);
-    if (!strP.isEmpty()) {
-        QString member = quote(key) + QLatin1Char(':');
-        if (!gap.isEmpty())
-            member += QLatin1Char(' ');
-        member += strP;
-        return member;
+    int rollback = result.length();
+    if (!*first)
+        result += QLatin1Char(',');
+    if (!gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += indent;
     }
-    return QString();
+    quote(key);
+    result += QLatin1Char(':');
+    if (!gap.isEmpty())
+        result += QLatin1Char(' ');
+
+    if (Str(key, v))
+        *first = false;
+    else
+        result.truncate(rollback);
 }
 
-QString Stringify::JO(ObjectRef o)
+void Stringify::JO(ObjectRef o)
 {
     if (stack.contains(o.getPointer())) {
         ctx->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(ctx);
 
-    QString result;
     stack.push(o.getPointer());
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('{');
+    bool first = true;
     if (propertyList.isEmpty()) {
         ObjectIterator it(scope, o, ObjectIterator::EnumerableOnly);
         ScopedValue name(scope);
@@ -804,10 +903,7 @@ QString Stringify::JO(ObjectRef o)
             name = it.nextPropertyNameAsString(val);
             if (name->isNull())
                 break;
-            QString key = name->toQString();
-            QString member = makeMember(key, val);
-            if (!member.isEmpty())
-                partial += member;
+            member(name->toQString(), val, &first);
         }
     } else {
         ScopedString s(scope);
@@ -817,69 +913,61 @@ QString Stringify::JO(ObjectRef o)
             ScopedValue v(scope, o->get(s, &exists));
             if (!exists)
                 continue;
-            QString member = makeMember(s->toQString(), v);
-            if (!member.isEmpty())
-                partial += member;
+            member(s->toQString(), v, &first);
         }
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("{}");
-    } else if (gap.isEmpty()) {
-        result = QStringLiteral("{") + partial.join(QLatin1Char(',')) + QStringLiteral("}");
-    } else {
-        QString separator = QStringLiteral(",\n") + indent;
-        result = QStringLiteral("{\n") + indent + partial.join(separator) + QStringLiteral("\n") + stepback + QStringLiteral("}");
+    if (!first && !gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += stepback;
     }
+    result += QLatin1Char('}');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
-QString Stringify::JA(ArrayObjectRef a)
+void Stringify::JA(ArrayObjectRef a)
 {
     if (stack.contains(a.getPointer())) {
         ctx->throwTypeError();
-        return QString();
+        return;
     }
 
     Scope scope(a->engine());
 
-    QString result;
     stack.push(a.getPointer());
     QString stepback = indent;
     indent += gap;
 
-    QStringList partial;
+    result += QLatin1Char('[');
     uint len = a->getLength();
     ScopedValue v(scope);
     for (uint i = 0; i < len; ++i) {
+        if (i)
+            result += QLatin1Char(',');
+        if (!gap.isEmpty()) {
+            result += QLatin1Char('\n');
+            result += indent;
+        }
         bool exists;
         v = a->getIndexed(i, &exists);
-        if (!exists) {
-            partial += QStringLiteral("null");
-            continue;
-        }
-        QString strP = Str(QString::number(i), v);
-        if (!strP.isEmpty())
-            partial += strP;
-        else
-            partial += QStringLiteral("null");
+        // the key is only observable through toJSON and the replacer
+        QString key;
+        if (exists && (replacerFunction || v->isObject()))
+            key = QString::number(i);
+        if (!exists || !Str(key, v))
+            result += QStringLiteral("null");
     }
 
-    if (partial.isEmpty()) {
-        result = QStringLiteral("[]");
-    } else if (gap.isEmpty()) {
-        result = QStringLiteral("[") + partial.join(QLatin1Char(',')) + QStringLiteral("]");
-    } else {
-        QString separator = QStringLiteral(",\n") + indent;
-        result = QStringLiteral("[\n") + indent + partial.join(separator) + QStringLiteral("\n") + stepback + QStringLiteral("]");
+    if (len && !gap.isEmpty()) {
+        result += QLatin1Char('\n');
+        result += stepback;
     }
+    result += QLatin1Char(']');
 
     indent = stepback;
     stack.pop();
-    return result;
 }
 
 
@@ -951,10 +1039,9 @@ ReturnedValue JsonObject::method_stringify(CallContext *ctx)
 
 
     ScopedValue arg0(scope, ctx->argument(0));
-    QString result = stringify.Str(QString(), arg0);
-    if (result.isEmpty() || scope.engine->hasException)
+    if (!stringify.Str(QString(), arg0) || scope.engine->hasException)
         return Encode::undefined();
-    return ctx->engine->newString(result)->asReturnedValue();
+    return ctx->engine->newString(stringify.result)->asReturnedValue();
 }
 
 
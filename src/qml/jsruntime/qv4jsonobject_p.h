@@ -43,6 +43,7 @@
 
 #include "qv4object_p.h"
 #include <qjsonarray.h>
+#include <qjsondocument.h>
 #include <qjsonobject.h>
 #include <qjsonvalue.h>
 
@@ -50,6 +51,42 @@ QT_BEGIN_NAMESPACE
 
 namespace QV4 {
 
+// The lexical part of the JSON parser, which doesn't need an engine. JSON.parse() builds
+// the values while it scans, Qt.parseJson() scans on another thread.
+class JsonScanner
+{
+public:
+    JsonScanner(const QChar *json, int length);
+
+protected:
+    enum {
+        Space = 0x20,
+        Tab = 0x09,
+        LineFeed = 0x0a,
+        Return = 0x0d,
+        BeginArray = 0x5b,
+        BeginObject = 0x7b,
+        EndArray = 0x5d,
+        EndObject = 0x7d,
+        NameSeparator = 0x3a,
+        ValueSeparator = 0x2c,
+        Quote = 0x22
+    };
+
+    bool eatSpace();
+    QChar nextToken();
+
+    bool scanLiteral(const char *rest);
+    bool parseString(QString *string);
+    bool parseNumber(ValueRef val);
+
+    const QChar *head;
+    const QChar *json;
+    const QChar *end;
+
+    QJsonParseError::ParseError lastError;
+};
+
 struct JsonObject : Object {
     Q_MANAGED_TYPE(JsonObject)
     V4_OBJECT
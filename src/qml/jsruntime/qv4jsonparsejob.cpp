@@ -0,0 +1,382 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4jsonparsejob_p.h"
+#include "qv4scopedvalue_p.h"
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qthreadpool.h>
+
+#include <private/qqmlengine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4functionobject_p.h>
+#include <private/qv4arrayobject_p.h>
+#include <private/qv4jsonobject_p.h>
+#include <private/qv4context_p.h>
+#include <private/qqmlcontextwrapper_p.h>
+#include <private/qv8engine_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Shared between the job and its runnable, so that a runnable finishing
+// after the job was deleted does not touch it.
+struct QV4JsonParseJob::Guard
+{
+    Guard(QV4JsonParseJob *job) : job(job) {}
+
+    QMutex mutex;
+    QV4JsonParseJob *job;
+};
+
+// Splits JSON text into tokens. It uses the scanner of JSON.parse(), and accepts the same
+// grammar with the same errors.
+class QV4JsonParseJob::Tokenizer : public QV4::JsonScanner
+{
+public:
+    Tokenizer(const QString &text, QVector<Token> *tokens, QStringList *strings)
+        : JsonScanner(text.constData(), text.length())
+        , m_depth(0), m_tokens(tokens), m_strings(strings)
+    {}
+
+    QJsonParseError parse()
+    {
+        eatSpace();
+        bool ok = parseValue();
+        // some input left
+        if (ok && eatSpace()) {
+            lastError = QJsonParseError::IllegalValue;
+            ok = false;
+        }
+
+        QJsonParseError result;
+        if (ok) {
+            result.error = QJsonParseError::NoError;
+            result.offset = 0;
+        } else {
+            result.error = lastError == QJsonParseError::NoError ? QJsonParseError::IllegalValue : lastError;
+            result.offset = int(json - head);
+            m_tokens->clear();
+            m_strings->clear();
+        }
+        return result;
+    }
+
+private:
+    enum { MaxDepth = 1024 };
+
+    void append(Token::Type type, double number = 0, int string = -1)
+    {
+        Token token;
+        token.type = type;
+        token.number = number;
+        token.string = string;
+        m_tokens->append(token);
+    }
+
+    bool fail(QJsonParseError::ParseError error)
+    {
+        lastError = error;
+        return false;
+    }
+
+    bool parseValue()
+    {
+        switch ((json++)->unicode()) {
+        case 'n':
+            if (!scanLiteral("ull"))
+                return false;
+            append(Token::Null);
+            return true;
+        case 't':
+            if (!scanLiteral("rue"))
+                return false;
+            append(Token::True);
+            return true;
+        case 'f':
+            if (!scanLiteral("alse"))
+                return false;
+            append(Token::False);
+            return true;
+        case Quote:
+            return appendString(Token::String);
+        case BeginArray:
+            return parseArray();
+        case BeginObject:
+            return parseObject();
+        case EndArray:
+            return fail(QJsonParseError::MissingObject);
+        default: {
+            --json;
+            QV4::Value number = QV4::Primitive::undefinedValue();
+            if (!parseNumber(QV4::ValueRef(number)))
+                return false;
+            append(Token::Number, number.toNumber());
+            return true;
+        }
+        }
+    }
+
+    bool parseArray()
+    {
+        if (++m_depth > MaxDepth)
+            return fail(QJsonParseError::DeepNesting);
+        append(Token::BeginArray);
+        if (!eatSpace())
+            return fail(QJsonParseError::UnterminatedArray);
+        if (*json == EndArray) {
+            nextToken();
+        } else {
+            for (;;) {
+                if (!parseValue())
+                    return false;
+                const QChar token = nextToken();
+                if (token == EndArray)
+                    break;
+                if (token != ValueSeparator)
+                    return fail(eatSpace() ? QJsonParseError::MissingValueSeparator
+                                           : QJsonParseError::UnterminatedArray);
+            }
+        }
+        append(Token::End);
+        --m_depth;
+        return true;
+    }
+
+    bool parseObject()
+    {
+        if (++m_depth > MaxDepth)
+            return fail(QJsonParseError::DeepNesting);
+        append(Token::BeginObject);
+        QChar token = nextToken();
+        while (token == Quote) {
+            if (!appendString(Token::Name))
+                return false;
+            if (nextToken() != NameSeparator)
+                return fail(QJsonParseError::MissingNameSeparator);
+            if (!parseValue())
+                return false;
+            token = nextToken();
+            if (token != ValueSeparator)
+                break;
+            token = nextToken();
+            if (token == EndObject)
+                return fail(QJsonParseError::MissingObject);
+        }
+        if (token != EndObject)
+            return fail(QJsonParseError::UnterminatedObject);
+        append(Token::End);
+        --m_depth;
+        return true;
+    }
+
+    bool appendString(Token::Type type)
+    {
+        QString string;
+        if (!parseString(&string))
+            return false;
+        append(type, 0, m_strings->size());
+        m_strings->append(string);
+        return true;
+    }
+
+    int m_depth;
+    QVector<Token> *m_tokens;
+    QStringList *m_strings;
+};
+
+class QV4JsonParseJob::Runnable : public QRunnable
+{
+public:
+    Runnable(const QSharedPointer<Guard> &guard, const QString &text)
+        : m_guard(guard), m_text(text) {}
+
+    void run()
+    {
+        QVector<Token> tokens;
+        QStringList strings;
+        const QJsonParseError error = Tokenizer(m_text, &tokens, &strings).parse();
+        m_text.clear();
+
+        QMutexLocker locker(&m_guard->mutex);
+        if (QV4JsonParseJob *job = m_guard->job) {
+            job->m_tokens.swap(tokens);
+            job->m_strings.swap(strings);
+            job->m_error = error;
+            QMetaObject::invokeMethod(job, "finished", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    QSharedPointer<Guard> m_guard;
+    QString m_text;
+};
+
+QV4JsonParseJob::QV4JsonParseJob(QQmlContextData *context, const QV4::ValueRef callback)
+    : m_guard(new Guard(this)), m_hasContext(context != 0), m_context(context)
+{
+    m_callbackFunction = callback;
+}
+
+QV4JsonParseJob::~QV4JsonParseJob()
+{
+    QMutexLocker locker(&m_guard->mutex);
+    m_guard->job = 0;
+}
+
+void QV4JsonParseJob::finished()
+{
+    deleteLater();
+
+    // the engine is gone, or the context that asked for the result
+    QV4::ExecutionEngine *v4 = m_callbackFunction.engine();
+    if (!v4)
+        return;
+    if (m_hasContext && (!m_context.contextData() || !m_context.contextData()->isValid()))
+        return;
+
+    QV4::Scope scope(v4);
+    QV4::ScopedFunctionObject f(scope, m_callbackFunction.value());
+    if (!f)
+        return;
+
+    QV4::ScopedCallData callData(scope, 2);
+    callData->thisObject = v4->globalObject->asReturnedValue();
+    if (m_error.error == QJsonParseError::NoError) {
+        int pos = 0;
+        callData->args[0] = createValue(v4, &pos);
+        callData->args[1] = QV4::Primitive::nullValue();
+    } else {
+        callData->args[0] = QV4::Primitive::undefinedValue();
+        callData->args[1] = v4->newSyntaxErrorObject(QStringLiteral("Qt.parseJson(): %1 at offset %2")
+                                                     .arg(m_error.errorString()).arg(m_error.offset));
+    }
+    m_tokens.clear();
+    m_strings.clear();
+
+    QV4::ExecutionContext *ctx = v4->currentContext();
+    f->call(callData);
+    if (scope.hasException()) {
+        QQmlError error = QV4::ExecutionEngine::catchExceptionAsQmlError(ctx);
+        QQmlEnginePrivate::warning(QQmlEnginePrivate::get(v4->v8Engine->engine()), error);
+    }
+}
+
+// Creates the value that starts at the token at pos, and moves pos past its tokens.
+// Members are stored in the order of the text like JSON.parse() does, so for
+// duplicate names the last value wins.
+QV4::ReturnedValue QV4JsonParseJob::createValue(QV4::ExecutionEngine *v4, int *pos) const
+{
+    const Token &token = m_tokens.at((*pos)++);
+    switch (token.type) {
+    case Token::Null:
+        return QV4::Encode::null();
+    case Token::False:
+        return QV4::Encode(false);
+    case Token::True:
+        return QV4::Encode(true);
+    case Token::Number:
+        return QV4::Encode(token.number);
+    case Token::String:
+        return v4->newString(m_strings.at(token.string))->asReturnedValue();
+    case Token::BeginArray: {
+        QV4::Scope scope(v4);
+        QV4::Scoped<QV4::ArrayObject> a(scope, v4->newArrayObject());
+        QV4::ScopedValue v(scope);
+        while (m_tokens.at(*pos).type != Token::End)
+            a->push_back((v = createValue(v4, pos)));
+        ++*pos;
+        return a.asReturnedValue();
+    }
+    case Token::BeginObject: {
+        // Members are defined rather than assigned, so "__proto__" and the setters of
+        // Object.prototype are left alone, and array indexes go into the array data.
+        QV4::Scope scope(v4);
+        QV4::ScopedObject o(scope, v4->newObject());
+        QV4::ScopedString s(scope);
+        QV4::ScopedValue v(scope);
+        while (m_tokens.at(*pos).type != Token::End) {
+            s = v4->newIdentifier(m_strings.at(m_tokens.at((*pos)++).string));
+            v = createValue(v4, pos);
+            const uint index = s->asArrayIndex();
+            if (index != UINT_MAX) {
+                o->putIndexed(index, v);
+                continue;
+            }
+            const uint member = o->internalClass->find(s);
+            if (member < UINT_MAX)
+                o->memberData[member] = *v;
+            else
+                o->insertMember(s, v);
+        }
+        ++*pos;
+        return o.asReturnedValue();
+    }
+    case Token::Name:
+    case Token::End:
+        break;
+    }
+    Q_UNREACHABLE();
+    return QV4::Encode::undefined();
+}
+
+/*
+    Documented in qqmlengine.cpp
+*/
+QV4::ReturnedValue QV4JsonParseJob::method_parseJson(QV4::CallContext *ctx)
+{
+    if (ctx->callData->argc != 2 || !ctx->callData->args[1].asFunctionObject())
+        V4THROW_ERROR("Qt.parseJson(): Invalid arguments");
+
+    QV4::ExecutionEngine *v4 = ctx->engine;
+    QV4::Scope scope(v4);
+    QString text = ctx->callData->args[0].toQString();
+    if (scope.hasException())
+        return QV4::Encode::undefined();
+
+    QV4::ScopedValue callback(scope, ctx->callData->args[1]);
+    QV4JsonParseJob *job = new QV4JsonParseJob(QV4::QmlContextWrapper::callingContext(v4), callback);
+    QThreadPool::globalInstance()->start(new Runnable(job->m_guard, text));
+
+    return QV4::Encode::undefined();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4JSONPARSEJOB_P_H
+#define QV4JSONPARSEJOB_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qobject.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvector.h>
+
+#include <private/qqmlcontext_p.h>
+
+#include <private/qv4value_inl_p.h>
+#include <private/qv4persistent_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Parses JSON text on a thread pool thread. Only the creation of the JS objects
+// and the call of the callback happen on the engine's thread.
+class QV4JsonParseJob : public QObject
+{
+    Q_OBJECT
+public:
+    static QV4::ReturnedValue method_parseJson(QV4::CallContext *ctx);
+
+private Q_SLOTS:
+    void finished();
+
+private:
+    struct Guard;
+    class Runnable;
+    class Tokenizer;
+
+    // The parsed text as a flat list of values in source order, unlike a QJsonObject,
+    // which sorts its members and drops duplicates. Arrays and objects are followed by
+    // their elements and an End token, the values of members are preceded by a Name.
+    struct Token
+    {
+        enum Type { Null, False, True, Number, String, Name, BeginArray, BeginObject, End };
+
+        Type type;
+        double number;
+        int string; // index in m_strings
+    };
+
+    QV4JsonParseJob(QQmlContextData *context, const QV4::ValueRef callback);
+    ~QV4JsonParseJob();
+
+    QV4::ReturnedValue createValue(QV4::ExecutionEngine *v4, int *pos) const;
+
+    QSharedPointer<Guard> m_guard;
+
+    // written by the runnable before finished() is queued
+    QVector<Token> m_tokens;
+    QStringList m_strings;
+    QJsonParseError m_error;
+
+    QV4::PersistentValue m_callbackFunction;
+
+    bool m_hasContext;
+    QQmlGuardedContextData m_context;
+};
+
+QT_END_NAMESPACE
+
+#endif // QV4JSONPARSEJOB_P_H
@@ -41,6 +41,11 @@
 #include "qv4lookup_p.h"
 #include "qv4functionobject_p.h"
 #include "qv4scopedvalue_p.h"
+#include "qv4qobjectwrapper_p.h"
+#include "qv4typedarray_p.h"
+#include <private/qqmlpropertycache_p.h>
+
+#include <QtCore/qdebug.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -108,15 +113,188 @@ ReturnedValue Lookup::lookup(Object *obj, PropertyAttributes *attrs)
     return Primitive::emptyValue().asReturnedValue();
 }
 
+bool Lookup::toCacheEntry(LookupCacheEntry *entry) const
+{
+    if (getter == getter0 || globalGetter == globalGetter0 || setter == setter0) {
+        entry->kind = LookupCacheEntry::Data;
+        entry->level = 0;
+    } else if (getter == getter1 || globalGetter == globalGetter1) {
+        entry->kind = LookupCacheEntry::Data;
+        entry->level = 1;
+    } else if (getter == getter2 || globalGetter == globalGetter2) {
+        entry->kind = LookupCacheEntry::Data;
+        entry->level = 2;
+    } else if (getter == getterAccessor0 || globalGetter == globalGetterAccessor0) {
+        entry->kind = LookupCacheEntry::Accessor;
+        entry->level = 0;
+    } else if (getter == getterAccessor1 || globalGetter == globalGetterAccessor1) {
+        entry->kind = LookupCacheEntry::Accessor;
+        entry->level = 1;
+    } else if (getter == getterAccessor2 || globalGetter == globalGetterAccessor2) {
+        entry->kind = LookupCacheEntry::Accessor;
+        entry->level = 2;
+    } else if (getter == arrayLengthGetter) {
+        // the length is a member of every array
+        entry->kind = LookupCacheEntry::Data;
+        entry->level = 0;
+    } else if (setter == setterInsert0) {
+        entry->kind = LookupCacheEntry::Insert;
+        entry->level = 0;
+    } else if (setter == setterInsert1) {
+        entry->kind = LookupCacheEntry::Insert;
+        entry->level = 1;
+    } else if (setter == setterInsert2) {
+        entry->kind = LookupCacheEntry::Insert;
+        entry->level = 2;
+    } else {
+        return false;
+    }
+
+    for (uint i = 0; i < LookupCacheEntry::ChainLength; ++i)
+        entry->classList[i] = i <= entry->level ? classList[i] : 0;
+    entry->newClass = entry->kind == LookupCacheEntry::Insert ? classList[3] : 0;
+    entry->index = index;
+    return true;
+}
+
+bool Lookup::addCacheEntry(const LookupCacheEntry &entry)
+{
+    LookupPolymorphicCache *cache = polymorphicCache;
+    if (!cache) {
+        cache = polymorphicCache = new LookupPolymorphicCache;
+        cache->count = 0;
+        cache->megamorphic = false;
+    }
+    if (cache->megamorphic)
+        return false;
+    if (cache->count == LookupPolymorphicCache::MaxEntries) {
+        cache->megamorphic = true;
+        return false;
+    }
+    cache->entries[cache->count++] = entry;
+    return true;
+}
+
+LookupStubCache::Entry *Lookup::stubCacheSlot(bool setter, InternalClass *internalClass) const
+{
+    ExecutionEngine *engine = internalClass->engine;
+    if (!engine->lookupStubCache)
+        engine->lookupStubCache = new LookupStubCache();
+    name->makeIdentifier();
+    const uint slot = LookupStubCache::hash(internalClass, name->identifier);
+    return (setter ? engine->lookupStubCache->setters : engine->lookupStubCache->getters) + slot;
+}
+
+void Lookup::releaseCaches()
+{
+    delete polymorphicCache;
+    polymorphicCache = 0;
+    releasePropertyCache();
+}
+
+void Lookup::releasePropertyCache()
+{
+    if (getter == QObjectWrapper::lookupGetter)
+        getter = getterGeneric;
+    else if (setter == QObjectWrapper::lookupSetter)
+        setter = setterGeneric;
+    else
+        return;
+    propertyCache->release();
+    propertyCache = 0;
+    propertyData = 0;
+}
+
+void Lookup::dumpStatistics(const QString &fileName, const QString &name) const
+{
+    if (!hitCount && !missCount)
+        return;
+    const char *state = "monomorphic";
+    if (polymorphicCache)
+        state = polymorphicCache->megamorphic ? "megamorphic" : "polymorphic";
+    if (getter == getterUncacheable || setter == setterUncacheable)
+        state = "uncacheable";
+#ifdef V4_LOOKUP_HIT_STATS
+    qDebug() << "Lookup of" << name << "in" << fileName << "is" << state
+             << "with" << hitCount << "hits and" << missCount << "misses.";
+#else
+    qDebug() << "Lookup of" << name << "in" << fileName << "is" << state
+             << "with" << missCount << "misses.";
+#endif
+}
+
+// The entry of a polymorphic or megamorphic lookup for objects of o's class, if any.
+static inline const LookupCacheEntry *cachedEntry(const Lookup *l, bool setter, Object *o)
+{
+    const LookupPolymorphicCache *cache = l->polymorphicCache;
+    if (!cache)
+        return 0;
+    if (cache->megamorphic) {
+        const LookupStubCache::Entry *slot = l->stubCacheSlot(setter, o->internalClass);
+        if (slot->internalClass == o->internalClass && slot->identifier == l->name->identifier)
+            return &slot->cacheEntry;
+        return 0;
+    }
+    for (uint i = 0; i < cache->count; ++i) {
+        if (cache->entries[i].classList[0] == o->internalClass)
+            return &cache->entries[i];
+    }
+    return 0;
+}
+
+// Called when a polymorphic lookup sees an object whose property can't be cached, like
+// a QObject property or the length of a string. The classes seen so far stay cached, all
+// other objects are looked up directly from now on instead of being resolved every time.
+static void makeUncacheable(Lookup *l, bool hadClass, const LookupCacheEntry &current, bool setter)
+{
+    if (!l->polymorphicCache && hadClass)
+        l->addCacheEntry(current);
+    if (setter)
+        l->setter = Lookup::setterUncacheable;
+    else
+        l->getter = Lookup::getterUncacheable;
+}
+
+static inline ReturnedValue getCached(const LookupCacheEntry &entry, Object *holder, const Value &thisObject)
+{
+    if (entry.kind == LookupCacheEntry::Data)
+        return holder->memberData[entry.index].asReturnedValue();
+
+    Scope scope(holder->engine());
+    FunctionObject *getter = holder->propertyAt(entry.index)->getter();
+    if (!getter)
+        return Encode::undefined();
+
+    ScopedCallData callData(scope, 0);
+    callData->thisObject = thisObject;
+    return getter->call(callData);
+}
+
+static inline void putCached(const LookupCacheEntry &entry, Object *o, const ValueRef value)
+{
+    if (entry.kind == LookupCacheEntry::Insert) {
+        if (entry.index >= o->memberData.size())
+            o->ensureMemberIndex(entry.index);
+        o->memberData[entry.index] = *value;
+        o->internalClass = entry.newClass;
+        return;
+    }
+    o->memberData[entry.index] = *value;
+}
+
 ReturnedValue Lookup::indexedGetterGeneric(Lookup *l, const ValueRef object, const ValueRef index)
 {
     if (object->isObject() && index->asArrayIndex() < UINT_MAX) {
+        if (object->objectValue()->as<TypedArray>()) {
+            l->indexedGetter = indexedGetterTypedArray;
+            return indexedGetterTypedArray(l, object, index);
+        }
         l->indexedGetter = indexedGetterObjectInt;
         return indexedGetterObjectInt(l, object, index);
     }
+    ++l->missCount;
     return indexedGetterFallback(l, object, index);
 }
-
 ReturnedValue Lookup::indexedGetterFallback(Lookup *l, const ValueRef object, const ValueRef index)
 {
     Q_UNUSED(l);
@@ -173,23 +351,81 @@ ReturnedValue Lookup::indexedGetterObjectInt(Lookup *l, const ValueRef object, c
     Object *o = object->objectValue();
     if (o->arrayData && o->arrayData->type == ArrayData::Simple) {
         if (idx < static_cast<SimpleArrayData *>(o->arrayData)->len)
-            if (!o->arrayData->data[idx].isEmpty())
+            if (!o->arrayData->data[idx].isEmpty()) {
+                V4_LOOKUP_HIT(l);
                 return o->arrayData->data[idx].asReturnedValue();
+            }
     }
 
+    l->indexedGetter = indexedGetterPolymorphic;
+    return indexedGetterPolymorphic(l, object, index);
+}
+
+// Handles the other kinds of array data, and strings.
+ReturnedValue Lookup::indexedGetterPolymorphic(Lookup *l, const ValueRef object, const ValueRef index)
+{
+    uint idx = index->asArrayIndex();
+    if (idx != UINT_MAX) {
+        if (Object *o = object->asObject()) {
+            ArrayData *arrayData = o->arrayData;
+            if (arrayData && !arrayData->hasAttributes()) {
+                if (arrayData->type == ArrayData::Simple) {
+                    if (idx < static_cast<SimpleArrayData *>(arrayData)->len && !arrayData->data[idx].isEmpty()) {
+                        V4_LOOKUP_HIT(l);
+                        return arrayData->data[idx].asReturnedValue();
+                    }
+                } else if (arrayData->type == ArrayData::Sparse) {
+                    ReturnedValue v = arrayData->get(idx);
+                    if (v != Primitive::emptyValue().asReturnedValue()) {
+                        V4_LOOKUP_HIT(l);
+                        return v;
+                    }
+                }
+            }
+        } else if (String *str = object->asString()) {
+            if (idx < uint(str->length())) {
+                V4_LOOKUP_HIT(l);
+                return l->engine->newString(str->toQString().mid(idx, 1))->asReturnedValue();
+            }
+        }
+    }
+
+    ++l->missCount;
     return indexedGetterFallback(l, object, index);
 }
 
+ReturnedValue Lookup::indexedGetterTypedArray(Lookup *l, const ValueRef object, const ValueRef index)
+{
+    uint idx = index->asArrayIndex();
+    if (Object *o = object->asObject()) {
+        if (TypedArray *a = o->as<TypedArray>()) {
+            if (idx < a->length()) {
+                V4_LOOKUP_HIT(l);
+                return a->type().read(a->constData(), idx);
+            }
+        }
+    }
+
+    l->indexedGetter = indexedGetterPolymorphic;
+    return indexedGetterPolymorphic(l, object, index);
+}
+
 void Lookup::indexedSetterGeneric(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v)
 {
     if (object->isObject()) {
         Object *o = object->objectValue();
+        if (o->as<TypedArray>() && index->asArrayIndex() < UINT_MAX) {
+            l->indexedSetter = indexedSetterTypedArray;
+            indexedSetterTypedArray(l, object, index, v);
+            return;
+        }
         if (o->arrayData && o->arrayData->type == ArrayData::Simple && index->asArrayIndex() < UINT_MAX) {
             l->indexedSetter = indexedSetterObjectInt;
             indexedSetterObjectInt(l, object, index, v);
             return;
         }
     }
+    ++l->missCount;
     indexedSetterFallback(l, object, index, v);
 }
 
@@ -206,6 +442,7 @@ void Lookup::indexedSetterFallback(Lookup *l, const ValueRef object, const Value
         if (o->arrayData && o->arrayData->type == ArrayData::Simple) {
             SimpleArrayData *s = static_cast<SimpleArrayData *>(o->arrayData);
             if (s && idx < s->len && !s->data[idx].isEmpty()) {
+                s->prepareStore(idx, *value);
                 s->data[idx] = value;
                 return;
             }
@@ -230,15 +467,68 @@ void Lookup::indexedSetterObjectInt(Lookup *l, const ValueRef object, const Valu
     if (o->arrayData && o->arrayData->type == ArrayData::Simple) {
         SimpleArrayData *s = static_cast<SimpleArrayData *>(o->arrayData);
         if (idx < s->len && !s->data[idx].isEmpty()) {
+            V4_LOOKUP_HIT(l);
+            s->prepareStore(idx, *v);
             s->data[idx] = v;
             return;
         }
     }
+    l->indexedSetter = indexedSetterPolymorphic;
+    indexedSetterPolymorphic(l, object, index, v);
+}
+
+// Stores into existing elements of the other kinds of array data.
+void Lookup::indexedSetterPolymorphic(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v)
+{
+    uint idx = index->asArrayIndex();
+    if (idx != UINT_MAX) {
+        if (Object *o = object->asObject()) {
+            ArrayData *arrayData = o->arrayData;
+            if (arrayData && !arrayData->hasAttributes()) {
+                if (arrayData->type == ArrayData::Simple) {
+                    SimpleArrayData *s = static_cast<SimpleArrayData *>(arrayData);
+                    if (idx < s->len && !s->data[idx].isEmpty()) {
+                        V4_LOOKUP_HIT(l);
+                        s->prepareStore(idx, *v);
+                        s->data[idx] = v;
+                        return;
+                    }
+                } else if (arrayData->type == ArrayData::Sparse && !arrayData->isEmpty(idx)) {
+                    V4_LOOKUP_HIT(l);
+                    arrayData->vtable()->put(o, idx, v);
+                    return;
+                }
+            }
+        }
+    }
+
+    ++l->missCount;
+    indexedSetterFallback(l, object, index, v);
+}
+
+// Stores numbers into the elements of a typed array, anything else needs a conversion that may throw.
+void Lookup::indexedSetterTypedArray(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v)
+{
+    uint idx = index->asArrayIndex();
+    if (v->isNumber()) {
+        if (Object *o = object->asObject()) {
+            if (TypedArray *a = o->as<TypedArray>()) {
+                if (idx < a->length()) {
+                    V4_LOOKUP_HIT(l);
+                    a->type().write(a->writableData(), idx, v->toNumber());
+                    return;
+                }
+            }
+        }
+    }
+
+    ++l->missCount;
     indexedSetterFallback(l, object, index, v);
 }
 
 ReturnedValue Lookup::getterGeneric(QV4::Lookup *l, const ValueRef object)
 {
+    ++l->missCount;
     if (Object *o = object->asObject())
         return o->getLookup(l);
 
@@ -288,146 +578,156 @@ ReturnedValue Lookup::getterGeneric(QV4::Lookup *l, const ValueRef object)
     return Encode::undefined();
 }
 
-ReturnedValue Lookup::getterTwoClasses(Lookup *l, const ValueRef object)
+// Called when a specialized getter sees a new class. The classes seen so far are
+// kept in a polymorphic cache, once that is full the engine's stub cache is used.
+ReturnedValue Lookup::getterAddClass(Lookup *l, const ValueRef object)
 {
-    Lookup l1 = *l;
+    ++l->missCount;
+    LookupCacheEntry current;
+    const bool hadClass = l->toCacheEntry(&current);
 
-    if (l1.getter == Lookup::getter0 || l1.getter == Lookup::getter1) {
-        if (Object *o = object->asObject()) {
-            ReturnedValue v = o->getLookup(l);
-            Lookup l2 = *l;
-
-            if (l2.getter == Lookup::getter0 || l2.getter == Lookup::getter1) {
-                // if we have a getter0, make sure it comes first
-                if (l2.getter == Lookup::getter0)
-                    qSwap(l1, l2);
-
-                l->classList[0] = l1.classList[0];
-                l->classList[1] = l1.classList[1];
-                l->classList[2] = l2.classList[0];
-                l->classList[3] = l2.classList[1];
-                l->index = l1.index;
-                l->index2 = l2.index;
-
-                if (l1.getter == Lookup::getter0) {
-                    l->getter = (l2.getter == Lookup::getter0) ? Lookup::getter0getter0 : Lookup::getter0getter1;
-                } else {
-                    Q_ASSERT(l1.getter == Lookup::getter1 && l2.getter == Lookup::getter1);
-                    l->getter = Lookup::getter1getter1;
-                }
-                return v;
-            }
-        }
+    Object *o = object->asObject();
+    if (!o) {
+        makeUncacheable(l, hadClass, current, false);
+        return getterFallback(l, object);
     }
 
-    l->getter = getterFallback;
-    return getterFallback(l, object);
-}
+    // Resolve on a copy, the lookup may be used again while a getter runs.
+    Lookup resolved = *l;
+    resolved.getter = getterGeneric;
+    ReturnedValue v = o->getLookup(&resolved);
 
-ReturnedValue Lookup::getterFallback(Lookup *l, const ValueRef object)
-{
-    QV4::Scope scope(l->name->engine());
-    QV4::ScopedObject o(scope, object->toObject(scope.engine->currentContext()));
-    if (!o)
-        return Encode::undefined();
-    QV4::ScopedString s(scope, l->name);
-    return o->get(s);
+    LookupCacheEntry entry;
+    if (!resolved.toCacheEntry(&entry)) {
+        resolved.releasePropertyCache();
+        makeUncacheable(l, hadClass, current, false);
+        return v;
+    }
+    if (!l->polymorphicCache && hadClass)
+        l->addCacheEntry(current);
+    if (l->addCacheEntry(entry)) {
+        l->getter = getterPolymorphic;
+        return v;
+    }
+
+    l->getter = getterMegamorphic;
+    LookupStubCache::Entry *slot = l->stubCacheSlot(false, entry.classList[0]);
+    slot->internalClass = entry.classList[0];
+    slot->identifier = l->name->identifier;
+    slot->cacheEntry = entry;
+    return v;
 }
 
-ReturnedValue Lookup::getter0(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getterPolymorphic(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass)
-            return o->memberData[l->index].asReturnedValue();
+        const LookupPolymorphicCache *cache = l->polymorphicCache;
+        for (uint i = 0; i < cache->count; ++i) {
+            if (Object *holder = cache->entries[i].match(o)) {
+                V4_LOOKUP_HIT(l);
+                return getCached(cache->entries[i], holder, *object);
+            }
+        }
     }
-    return getterTwoClasses(l, object);
+    return getterAddClass(l, object);
 }
 
-ReturnedValue Lookup::getter1(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getterMegamorphic(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass &&
-            l->classList[1] == o->prototype()->internalClass)
-            return o->prototype()->memberData[l->index].asReturnedValue();
+        const LookupStubCache::Entry *slot = l->stubCacheSlot(false, o->internalClass);
+        if (slot->internalClass == o->internalClass && slot->identifier == l->name->identifier) {
+            if (Object *holder = slot->cacheEntry.match(o)) {
+                V4_LOOKUP_HIT(l);
+                return getCached(slot->cacheEntry, holder, *object);
+            }
+        }
     }
-    return getterTwoClasses(l, object);
+    return getterAddClass(l, object);
 }
 
-ReturnedValue Lookup::getter2(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getterFallback(Lookup *l, const ValueRef object)
+{
+    QV4::Scope scope(l->name->engine());
+    QV4::ScopedObject o(scope, object->toObject(scope.engine->currentContext()));
+    if (!o)
+        return Encode::undefined();
+    QV4::ScopedString s(scope, l->name);
+    return o->get(s);
+}
+
+ReturnedValue Lookup::getterUncacheable(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass) {
-            o = o->prototype();
-            if (l->classList[1] == o->internalClass) {
-                o = o->prototype();
-                if (l->classList[2] == o->internalClass)
-                    return o->memberData[l->index].asReturnedValue();
+        if (const LookupCacheEntry *entry = cachedEntry(l, false, o)) {
+            if (Object *holder = entry->match(o)) {
+                V4_LOOKUP_HIT(l);
+                return getCached(*entry, holder, *object);
             }
         }
     }
-    l->getter = getterFallback;
+    ++l->missCount;
     return getterFallback(l, object);
 }
 
-ReturnedValue Lookup::getter0getter0(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getter0(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass)
+        if (l->classList[0] == o->internalClass) {
+            V4_LOOKUP_HIT(l);
             return o->memberData[l->index].asReturnedValue();
-        if (l->classList[2] == o->internalClass)
-            return o->memberData[l->index2].asReturnedValue();
+        }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
-ReturnedValue Lookup::getter0getter1(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getter1(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass)
-            return o->memberData[l->index].asReturnedValue();
-        if (l->classList[2] == o->internalClass &&
-            l->classList[3] == o->prototype()->internalClass)
-            return o->prototype()->memberData[l->index2].asReturnedValue();
+        if (l->classList[0] == o->internalClass &&
+            l->classList[1] == o->prototype()->internalClass) {
+            V4_LOOKUP_HIT(l);
+            return o->prototype()->memberData[l->index].asReturnedValue();
+        }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
-ReturnedValue Lookup::getter1getter1(Lookup *l, const ValueRef object)
+ReturnedValue Lookup::getter2(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
         // we can safely cast to a QV4::Object here. If object is actually a string,
         // the internal class won't match
         Object *o = object->objectValue();
-        if (l->classList[0] == o->internalClass &&
-            l->classList[1] == o->prototype()->internalClass)
-            return o->prototype()->memberData[l->index].asReturnedValue();
-        if (l->classList[2] == o->internalClass &&
-            l->classList[3] == o->prototype()->internalClass)
-            return o->prototype()->memberData[l->index2].asReturnedValue();
-        return getterFallback(l, object);
+        if (l->classList[0] == o->internalClass) {
+            o = o->prototype();
+            if (l->classList[1] == o->internalClass) {
+                o = o->prototype();
+                if (l->classList[2] == o->internalClass) {
+                    V4_LOOKUP_HIT(l);
+                    return o->memberData[l->index].asReturnedValue();
+                }
+            }
+        }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
-
 ReturnedValue Lookup::getterAccessor0(Lookup *l, const ValueRef object)
 {
     if (object->isManaged()) {
@@ -435,6 +735,7 @@ ReturnedValue Lookup::getterAccessor0(Lookup *l, const ValueRef object)
         // the internal class won't match
         Object *o = object->objectValue();
         if (l->classList[0] == o->internalClass) {
+            V4_LOOKUP_HIT(l);
             Scope scope(o->engine());
             FunctionObject *getter = o->propertyAt(l->index)->getter();
             if (!getter)
@@ -445,8 +746,7 @@ ReturnedValue Lookup::getterAccessor0(Lookup *l, const ValueRef object)
             return getter->call(callData);
         }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
 ReturnedValue Lookup::getterAccessor1(Lookup *l, const ValueRef object)
@@ -457,6 +757,7 @@ ReturnedValue Lookup::getterAccessor1(Lookup *l, const ValueRef object)
         Object *o = object->objectValue();
         if (l->classList[0] == o->internalClass &&
             l->classList[1] == o->prototype()->internalClass) {
+            V4_LOOKUP_HIT(l);
             Scope scope(o->engine());
             FunctionObject *getter = o->prototype()->propertyAt(l->index)->getter();
             if (!getter)
@@ -467,8 +768,7 @@ ReturnedValue Lookup::getterAccessor1(Lookup *l, const ValueRef object)
             return getter->call(callData);
         }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
 ReturnedValue Lookup::getterAccessor2(Lookup *l, const ValueRef object)
@@ -482,6 +782,7 @@ ReturnedValue Lookup::getterAccessor2(Lookup *l, const ValueRef object)
             if (l->classList[1] == o->internalClass) {
                 o = o->prototype();
                 if (l->classList[2] == o->internalClass) {
+                    V4_LOOKUP_HIT(l);
                     Scope scope(o->engine());
                     FunctionObject *getter = o->propertyAt(l->index)->getter();
                     if (!getter)
@@ -494,16 +795,17 @@ ReturnedValue Lookup::getterAccessor2(Lookup *l, const ValueRef object)
             }
         }
     }
-    l->getter = getterFallback;
-    return getterFallback(l, object);
+    return getterAddClass(l, object);
 }
 
 ReturnedValue Lookup::primitiveGetter0(Lookup *l, const ValueRef object)
 {
     if (object->type() == l->type) {
         Object *o = l->proto;
-        if (l->classList[0] == o->internalClass)
+        if (l->classList[0] == o->internalClass) {
+            V4_LOOKUP_HIT(l);
             return o->memberData[l->index].asReturnedValue();
+        }
     }
     l->getter = getterGeneric;
     return getterGeneric(l, object);
@@ -514,8 +816,10 @@ ReturnedValue Lookup::primitiveGetter1(Lookup *l, const ValueRef object)
     if (object->type() == l->type) {
         Object *o = l->proto;
         if (l->classList[0] == o->internalClass &&
-            l->classList[1] == o->prototype()->internalClass)
+            l->classList[1] == o->prototype()->internalClass) {
+            V4_LOOKUP_HIT(l);
             return o->prototype()->memberData[l->index].asReturnedValue();
+        }
     }
     l->getter = getterGeneric;
     return getterGeneric(l, object);
@@ -526,6 +830,7 @@ ReturnedValue Lookup::primitiveGetterAccessor0(Lookup *l, const ValueRef object)
     if (object->type() == l->type) {
         Object *o = l->proto;
         if (l->classList[0] == o->internalClass) {
+            V4_LOOKUP_HIT(l);
             Scope scope(o->engine());
             FunctionObject *getter = o->propertyAt(l->index)->getter();
             if (!getter)
@@ -546,6 +851,7 @@ ReturnedValue Lookup::primitiveGetterAccessor1(Lookup *l, const ValueRef object)
         Object *o = l->proto;
         if (l->classList[0] == o->internalClass &&
             l->classList[1] == o->prototype()->internalClass) {
+            V4_LOOKUP_HIT(l);
             Scope scope(o->engine());
             FunctionObject *getter = o->prototype()->propertyAt(l->index)->getter();
             if (!getter)
@@ -562,25 +868,28 @@ ReturnedValue Lookup::primitiveGetterAccessor1(Lookup *l, const ValueRef object)
 
 ReturnedValue Lookup::stringLengthGetter(Lookup *l, const ValueRef object)
 {
-    if (String *s = object->asString())
+    if (String *s = object->asString()) {
+        V4_LOOKUP_HIT(l);
         return Encode(s->length());
+    }
 
-    l->getter = getterGeneric;
-    return getterGeneric(l, object);
+    return getterAddClass(l, object);
 }
 
 ReturnedValue Lookup::arrayLengthGetter(Lookup *l, const ValueRef object)
 {
-    if (ArrayObject *a = object->asArrayObject())
+    if (ArrayObject *a = object->asArrayObject()) {
+        V4_LOOKUP_HIT(l);
         return a->memberData[ArrayObject::LengthPropertyIndex].asReturnedValue();
+    }
 
-    l->getter = getterGeneric;
-    return getterGeneric(l, object);
+    return getterAddClass(l, object);
 }
 
 
 ReturnedValue Lookup::globalGetterGeneric(Lookup *l, ExecutionContext *ctx)
 {
+    ++l->missCount;
     Object *o = ctx->engine->globalObject;
     PropertyAttributes attrs;
     ReturnedValue v = l->lookup(o, &attrs);
@@ -608,25 +917,84 @@ ReturnedValue Lookup::globalGetterGeneric(Lookup *l, ExecutionContext *ctx)
     return ctx->throwReferenceError(n);
 }
 
+// The global object only changes its class when globals are added, so the
+// classes seen are usually not seen again. Keeping them is still cheaper than
+// looking the name up each time they change.
+ReturnedValue Lookup::globalGetterAddClass(Lookup *l, ExecutionContext *ctx)
+{
+    LookupCacheEntry current;
+    const bool hadClass = l->toCacheEntry(&current);
+
+    Lookup resolved = *l;
+    resolved.globalGetter = globalGetterGeneric;
+    ReturnedValue v = globalGetterGeneric(&resolved, ctx);
+    l->missCount = resolved.missCount;
+
+    LookupCacheEntry entry;
+    if (!resolved.toCacheEntry(&entry))
+        return v;
+    if (!l->polymorphicCache && hadClass)
+        l->addCacheEntry(current);
+    if (l->addCacheEntry(entry)) {
+        l->globalGetter = globalGetterPolymorphic;
+        return v;
+    }
+
+    l->globalGetter = globalGetterMegamorphic;
+    LookupStubCache::Entry *slot = l->stubCacheSlot(false, entry.classList[0]);
+    slot->internalClass = entry.classList[0];
+    slot->identifier = l->name->identifier;
+    slot->cacheEntry = entry;
+    return v;
+}
+
+ReturnedValue Lookup::globalGetterPolymorphic(Lookup *l, ExecutionContext *ctx)
+{
+    Object *o = ctx->engine->globalObject;
+    const LookupPolymorphicCache *cache = l->polymorphicCache;
+    for (uint i = 0; i < cache->count; ++i) {
+        if (Object *holder = cache->entries[i].match(o)) {
+            V4_LOOKUP_HIT(l);
+            return getCached(cache->entries[i], holder, Primitive::undefinedValue());
+        }
+    }
+    return globalGetterAddClass(l, ctx);
+}
+
+ReturnedValue Lookup::globalGetterMegamorphic(Lookup *l, ExecutionContext *ctx)
+{
+    Object *o = ctx->engine->globalObject;
+    const LookupStubCache::Entry *slot = l->stubCacheSlot(false, o->internalClass);
+    if (slot->internalClass == o->internalClass && slot->identifier == l->name->identifier) {
+        if (Object *holder = slot->cacheEntry.match(o)) {
+            V4_LOOKUP_HIT(l);
+            return getCached(slot->cacheEntry, holder, Primitive::undefinedValue());
+        }
+    }
+    return globalGetterAddClass(l, ctx);
+}
+
 ReturnedValue Lookup::globalGetter0(Lookup *l, ExecutionContext *ctx)
 {
     Object *o = ctx->engine->globalObject;
-    if (l->classList[0] == o->internalClass)
+    if (l->classList[0] == o->internalClass) {
+        V4_LOOKUP_HIT(l);
         return o->memberData[l->index].asReturnedValue();
+    }
 
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 ReturnedValue Lookup::globalGetter1(Lookup *l, ExecutionContext *ctx)
 {
     Object *o = ctx->engine->globalObject;
     if (l->classList[0] == o->internalClass &&
-        l->classList[1] == o->prototype()->internalClass)
+        l->classList[1] == o->prototype()->internalClass) {
+        V4_LOOKUP_HIT(l);
         return o->prototype()->memberData[l->index].asReturnedValue();
+    }
 
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 ReturnedValue Lookup::globalGetter2(Lookup *l, ExecutionContext *ctx)
@@ -637,18 +1005,19 @@ ReturnedValue Lookup::globalGetter2(Lookup *l, ExecutionContext *ctx)
         if (l->classList[1] == o->internalClass) {
             o = o->prototype();
             if (l->classList[2] == o->internalClass) {
-                return o->prototype()->memberData[l->index].asReturnedValue();
+                V4_LOOKUP_HIT(l);
+                return o->memberData[l->index].asReturnedValue();
             }
         }
     }
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 ReturnedValue Lookup::globalGetterAccessor0(Lookup *l, ExecutionContext *ctx)
 {
     Object *o = ctx->engine->globalObject;
     if (l->classList[0] == o->internalClass) {
+        V4_LOOKUP_HIT(l);
         Scope scope(o->engine());
         FunctionObject *getter = o->propertyAt(l->index)->getter();
         if (!getter)
@@ -658,8 +1027,7 @@ ReturnedValue Lookup::globalGetterAccessor0(Lookup *l, ExecutionContext *ctx)
         callData->thisObject = Primitive::undefinedValue();
         return getter->call(callData);
     }
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 ReturnedValue Lookup::globalGetterAccessor1(Lookup *l, ExecutionContext *ctx)
@@ -667,6 +1035,7 @@ ReturnedValue Lookup::globalGetterAccessor1(Lookup *l, ExecutionContext *ctx)
     Object *o = ctx->engine->globalObject;
     if (l->classList[0] == o->internalClass &&
         l->classList[1] == o->prototype()->internalClass) {
+        V4_LOOKUP_HIT(l);
         Scope scope(o->engine());
         FunctionObject *getter = o->prototype()->propertyAt(l->index)->getter();
         if (!getter)
@@ -676,8 +1045,7 @@ ReturnedValue Lookup::globalGetterAccessor1(Lookup *l, ExecutionContext *ctx)
         callData->thisObject = Primitive::undefinedValue();
         return getter->call(callData);
     }
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 ReturnedValue Lookup::globalGetterAccessor2(Lookup *l, ExecutionContext *ctx)
@@ -688,6 +1056,7 @@ ReturnedValue Lookup::globalGetterAccessor2(Lookup *l, ExecutionContext *ctx)
         if (l->classList[1] == o->internalClass) {
             o = o->prototype();
             if (l->classList[2] == o->internalClass) {
+                V4_LOOKUP_HIT(l);
                 Scope scope(o->engine());
                 FunctionObject *getter = o->propertyAt(l->index)->getter();
                 if (!getter)
@@ -699,12 +1068,12 @@ ReturnedValue Lookup::globalGetterAccessor2(Lookup *l, ExecutionContext *ctx)
             }
         }
     }
-    l->globalGetter = globalGetterGeneric;
-    return globalGetterGeneric(l, ctx);
+    return globalGetterAddClass(l, ctx);
 }
 
 void Lookup::setterGeneric(Lookup *l, const ValueRef object, const ValueRef value)
 {
+    ++l->missCount;
     Scope scope(l->name->engine());
     ScopedObject o(scope, object);
     if (!o) {
@@ -718,23 +1087,74 @@ void Lookup::setterGeneric(Lookup *l, const ValueRef object, const ValueRef valu
     o->setLookup(l, value);
 }
 
-void Lookup::setterTwoClasses(Lookup *l, const ValueRef object, const ValueRef value)
+// Like getterAddClass(), for setters.
+void Lookup::setterAddClass(Lookup *l, const ValueRef object, const ValueRef value)
 {
-    Lookup l1 = *l;
+    ++l->missCount;
+    LookupCacheEntry current;
+    const bool hadClass = l->toCacheEntry(&current);
 
-    if (Object *o = object->asObject()) {
-        o->setLookup(l, value);
+    Scope scope(l->name->engine());
+    ScopedObject o(scope, object);
+    if (!o) {
+        makeUncacheable(l, hadClass, current, true);
+        setterFallback(l, object, value);
+        return;
+    }
 
-        if (l->setter == Lookup::setter0) {
-            l->setter = setter0setter0;
-            l->classList[1] = l1.classList[0];
-            l->index2 = l1.index;
-            return;
+    Lookup resolved = *l;
+    resolved.setter = setterGeneric;
+    o->setLookup(&resolved, value);
+
+    LookupCacheEntry entry;
+    if (!resolved.toCacheEntry(&entry)) {
+        resolved.releasePropertyCache();
+        makeUncacheable(l, hadClass, current, true);
+        return;
+    }
+    if (!l->polymorphicCache && hadClass)
+        l->addCacheEntry(current);
+    if (l->addCacheEntry(entry)) {
+        l->setter = setterPolymorphic;
+        return;
+    }
+
+    l->setter = setterMegamorphic;
+    LookupStubCache::Entry *slot = l->stubCacheSlot(true, entry.classList[0]);
+    slot->internalClass = entry.classList[0];
+    slot->identifier = l->name->identifier;
+    slot->cacheEntry = entry;
+}
+
+void Lookup::setterPolymorphic(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    Object *o = static_cast<Object *>(object->asManaged());
+    if (o) {
+        const LookupPolymorphicCache *cache = l->polymorphicCache;
+        for (uint i = 0; i < cache->count; ++i) {
+            if (cache->entries[i].match(o)) {
+                V4_LOOKUP_HIT(l);
+                putCached(cache->entries[i], o, value);
+                return;
+            }
         }
     }
+    setterAddClass(l, object, value);
+}
 
-    l->setter = setterFallback;
-    setterFallback(l, object, value);
+void Lookup::setterMegamorphic(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    Object *o = static_cast<Object *>(object->asManaged());
+    if (o) {
+        const LookupStubCache::Entry *slot = l->stubCacheSlot(true, o->internalClass);
+        if (slot->internalClass == o->internalClass && slot->identifier == l->name->identifier
+                && slot->cacheEntry.match(o)) {
+            V4_LOOKUP_HIT(l);
+            putCached(slot->cacheEntry, o, value);
+            return;
+        }
+    }
+    setterAddClass(l, object, value);
 }
 
 void Lookup::setterFallback(Lookup *l, const ValueRef object, const ValueRef value)
@@ -747,15 +1167,31 @@ void Lookup::setterFallback(Lookup *l, const ValueRef object, const ValueRef val
     }
 }
 
+void Lookup::setterUncacheable(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    Object *o = static_cast<Object *>(object->asManaged());
+    if (o) {
+        const LookupCacheEntry *entry = cachedEntry(l, true, o);
+        if (entry && entry->match(o)) {
+            V4_LOOKUP_HIT(l);
+            putCached(*entry, o, value);
+            return;
+        }
+    }
+    ++l->missCount;
+    setterFallback(l, object, value);
+}
+
 void Lookup::setter0(Lookup *l, const ValueRef object, const ValueRef value)
 {
     Object *o = static_cast<Object *>(object->asManaged());
     if (o && o->internalClass == l->classList[0]) {
+        V4_LOOKUP_HIT(l);
         o->memberData[l->index] = *value;
         return;
     }
 
-    setterTwoClasses(l, object, value);
+    setterAddClass(l, object, value);
 }
 
 void Lookup::setterInsert0(Lookup *l, const ValueRef object, const ValueRef value)
@@ -763,6 +1199,7 @@ void Lookup::setterInsert0(Lookup *l, const ValueRef object, const ValueRef valu
     Object *o = static_cast<Object *>(object->asManaged());
     if (o && o->internalClass == l->classList[0]) {
         if (!o->prototype()) {
+            V4_LOOKUP_HIT(l);
             if (l->index >= o->memberData.size())
                 o->ensureMemberIndex(l->index);
             o->memberData[l->index] = *value;
@@ -771,8 +1208,7 @@ void Lookup::setterInsert0(Lookup *l, const ValueRef object, const ValueRef valu
         }
     }
 
-    l->setter = setterFallback;
-    setterFallback(l, object, value);
+    setterAddClass(l, object, value);
 }
 
 void Lookup::setterInsert1(Lookup *l, const ValueRef object, const ValueRef value)
@@ -781,6 +1217,7 @@ void Lookup::setterInsert1(Lookup *l, const ValueRef object, const ValueRef valu
     if (o && o->internalClass == l->classList[0]) {
         Object *p = o->prototype();
         if (p && p->internalClass == l->classList[1]) {
+            V4_LOOKUP_HIT(l);
             if (l->index >= o->memberData.size())
                 o->ensureMemberIndex(l->index);
             o->memberData[l->index] = *value;
@@ -789,8 +1226,7 @@ void Lookup::setterInsert1(Lookup *l, const ValueRef object, const ValueRef valu
         }
     }
 
-    l->setter = setterFallback;
-    setterFallback(l, object, value);
+    setterAddClass(l, object, value);
 }
 
 void Lookup::setterInsert2(Lookup *l, const ValueRef object, const ValueRef value)
@@ -801,6 +1237,7 @@ void Lookup::setterInsert2(Lookup *l, const ValueRef object, const ValueRef valu
         if (p && p->internalClass == l->classList[1]) {
             p = p->prototype();
             if (p && p->internalClass == l->classList[2]) {
+                V4_LOOKUP_HIT(l);
                 if (l->index >= o->memberData.size())
                     o->ensureMemberIndex(l->index);
                 o->memberData[l->index] = *value;
@@ -810,27 +1247,7 @@ void Lookup::setterInsert2(Lookup *l, const ValueRef object, const ValueRef valu
         }
     }
 
-    l->setter = setterFallback;
-    setterFallback(l, object, value);
-}
-
-void Lookup::setter0setter0(Lookup *l, const ValueRef object, const ValueRef value)
-{
-    Object *o = static_cast<Object *>(object->asManaged());
-    if (o) {
-        if (o->internalClass == l->classList[0]) {
-            o->memberData[l->index] = *value;
-            return;
-        }
-        if (o->internalClass == l->classList[1]) {
-            o->memberData[l->index2] = *value;
-            return;
-        }
-    }
-
-    l->setter = setterFallback;
-    setterFallback(l, object, value);
-
+    setterAddClass(l, object, value);
 }
 
 QT_END_NAMESPACE
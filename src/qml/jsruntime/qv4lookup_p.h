@@ -48,11 +48,76 @@
 #include "qv4object_p.h"
 #include "qv4internalclass_p.h"
 
+//#define V4_LOOKUP_HIT_STATS
+
+#ifdef V4_LOOKUP_HIT_STATS
+#define V4_LOOKUP_HIT(l) ++(l)->hitCount
+#else
+#define V4_LOOKUP_HIT(l) do {} while (0)
+#endif
+
 QT_BEGIN_NAMESPACE
 
+class QQmlPropertyCache;
+class QQmlPropertyData;
+
 namespace QV4 {
 
-struct Lookup {
+struct Identifier;
+
+// A cached property access: the classes along the prototype chain, from the
+// object up to the one holding the property, and where the property is found.
+struct LookupCacheEntry {
+    enum { ChainLength = 3 };
+    enum Kind {
+        Data,
+        Accessor,
+        Insert // adds the property to the object, whose prototype chain ends at level
+    };
+
+    InternalClass *classList[ChainLength];
+    InternalClass *newClass; // after an Insert
+    uint level;
+    uint index;
+    Kind kind;
+
+    // Returns the object at level if the classes of o and its prototypes match.
+    inline Object *match(Object *o) const
+    {
+        for (uint i = 0; ; ++i) {
+            if (o->internalClass != classList[i])
+                return 0;
+            if (i == level)
+                return o;
+            // the class of o fixes its prototype
+            o = o->prototype();
+        }
+    }
+};
+
+struct LookupPolymorphicCache {
+    enum { MaxEntries = 8 };
+    LookupCacheEntry entries[MaxEntries];
+    uint count;
+    bool megamorphic; // the entries overflowed, the engine's stub cache is used
+};
+
+// Shared by the megamorphic lookups of an engine, keyed on (InternalClass, Identifier).
+struct LookupStubCache {
+    enum { Size = 512 };
+    struct Entry {
+        InternalClass *internalClass;
+        Identifier *identifier;
+        LookupCacheEntry cacheEntry;
+    };
+    Entry getters[Size];
+    Entry setters[Size];
+
+    static uint hash(InternalClass *internalClass, Identifier *identifier)
+    { return uint((quintptr(internalClass) >> 4) ^ (quintptr(identifier) >> 3)) % Size; }
+};
+
+struct Q_QML_PRIVATE_EXPORT Lookup {
     enum { Size = 4 };
     union {
         ReturnedValue (*indexedGetter)(Lookup *l, const ValueRef object, const ValueRef index);
@@ -70,6 +135,11 @@ struct Lookup {
             Object *proto;
             unsigned type;
         };
+        // a QObject property, for objects with this property cache, which the lookup references
+        struct {
+            QQmlPropertyCache *propertyCache;
+            QQmlPropertyData *propertyData;
+        };
     };
     union {
         int level;
@@ -77,25 +147,35 @@ struct Lookup {
     };
     uint index;
     String *name;
+    // allocated once more than one class is seen, owned by the lookup
+    LookupPolymorphicCache *polymorphicCache;
+    // calls served by the cached classes (only counted with V4_LOOKUP_HIT_STATS defined),
+    // and calls that had to look the property up
+    uint hitCount;
+    uint missCount;
 
     static ReturnedValue indexedGetterGeneric(Lookup *l, const ValueRef object, const ValueRef index);
     static ReturnedValue indexedGetterFallback(Lookup *l, const ValueRef object, const ValueRef index);
     static ReturnedValue indexedGetterObjectInt(Lookup *l, const ValueRef object, const ValueRef index);
+    static ReturnedValue indexedGetterPolymorphic(Lookup *l, const ValueRef object, const ValueRef index);
+    static ReturnedValue indexedGetterTypedArray(Lookup *l, const ValueRef object, const ValueRef index);
 
     static void indexedSetterGeneric(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v);
     static void indexedSetterFallback(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef value);
     static void indexedSetterObjectInt(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v);
+    static void indexedSetterPolymorphic(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v);
+    static void indexedSetterTypedArray(Lookup *l, const ValueRef object, const ValueRef index, const ValueRef v);
 
     static ReturnedValue getterGeneric(Lookup *l, const ValueRef object);
-    static ReturnedValue getterTwoClasses(Lookup *l, const ValueRef object);
+    static ReturnedValue getterAddClass(Lookup *l, const ValueRef object);
+    static ReturnedValue getterPolymorphic(Lookup *l, const ValueRef object);
+    static ReturnedValue getterMegamorphic(Lookup *l, const ValueRef object);
     static ReturnedValue getterFallback(Lookup *l, const ValueRef object);
+    static ReturnedValue getterUncacheable(Lookup *l, const ValueRef object);
 
     static ReturnedValue getter0(Lookup *l, const ValueRef object);
     static ReturnedValue getter1(Lookup *l, const ValueRef object);
     static ReturnedValue getter2(Lookup *l, const ValueRef object);
-    static ReturnedValue getter0getter0(Lookup *l, const ValueRef object);
-    static ReturnedValue getter0getter1(Lookup *l, const ValueRef object);
-    static ReturnedValue getter1getter1(Lookup *l, const ValueRef object);
     static ReturnedValue getterAccessor0(Lookup *l, const ValueRef object);
     static ReturnedValue getterAccessor1(Lookup *l, const ValueRef object);
     static ReturnedValue getterAccessor2(Lookup *l, const ValueRef object);
@@ -108,6 +188,9 @@ struct Lookup {
     static ReturnedValue arrayLengthGetter(Lookup *l, const ValueRef object);
 
     static ReturnedValue globalGetterGeneric(Lookup *l, ExecutionContext *ctx);
+    static ReturnedValue globalGetterAddClass(Lookup *l, ExecutionContext *ctx);
+    static ReturnedValue globalGetterPolymorphic(Lookup *l, ExecutionContext *ctx);
+    static ReturnedValue globalGetterMegamorphic(Lookup *l, ExecutionContext *ctx);
     static ReturnedValue globalGetter0(Lookup *l, ExecutionContext *ctx);
     static ReturnedValue globalGetter1(Lookup *l, ExecutionContext *ctx);
     static ReturnedValue globalGetter2(Lookup *l, ExecutionContext *ctx);
@@ -116,17 +199,31 @@ struct Lookup {
     static ReturnedValue globalGetterAccessor2(Lookup *l, ExecutionContext *ctx);
 
     static void setterGeneric(Lookup *l, const ValueRef object, const ValueRef value);
-    static void setterTwoClasses(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterAddClass(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterPolymorphic(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterMegamorphic(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterFallback(Lookup *l, const ValueRef object, const ValueRef value);
+    static void setterUncacheable(Lookup *l, const ValueRef object, const ValueRef value);
     static void setter0(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterInsert0(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterInsert1(Lookup *l, const ValueRef object, const ValueRef value);
     static void setterInsert2(Lookup *l, const ValueRef object, const ValueRef value);
-    static void setter0setter0(Lookup *l, const ValueRef object, const ValueRef value);
 
     ReturnedValue lookup(ValueRef thisObject, Object *obj, PropertyAttributes *attrs);
     ReturnedValue lookup(Object *obj, PropertyAttributes *attrs);
 
+    // Describes the class this lookup is specialized for, returns false if it is not.
+    bool toCacheEntry(LookupCacheEntry *entry) const;
+    // Returns false once the polymorphic cache is full.
+    bool addCacheEntry(const LookupCacheEntry &entry);
+    // The slot of the engine's stub cache for this lookup's name on objects of the given class.
+    LookupStubCache::Entry *stubCacheSlot(bool setter, InternalClass *internalClass) const;
+
+    void releaseCaches();
+    // Drops the reference to the property cache of a QObject property lookup.
+    void releasePropertyCache();
+    void dumpStatistics(const QString &fileName, const QString &name) const;
+
 };
 
 }
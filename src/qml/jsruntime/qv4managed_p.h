@@ -234,6 +234,8 @@ public:
         Type_ArgumentsObject,
         Type_JsonObject,
         Type_MathObject,
+        Type_ArrayBuffer,
+        Type_TypedArray,
 
         Type_ExecutionContext,
         Type_ForeachIteratorObject,
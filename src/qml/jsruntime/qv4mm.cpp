@@ -44,11 +44,14 @@
 #include "qv4objectproto_p.h"
 #include "qv4mm_p.h"
 #include "qv4qobjectwrapper_p.h"
+#include "qv4regexp_p.h"
+#include "qv4profiling_p.h"
 #include <qqmlengine.h>
 #include "PageAllocation.h"
 #include "StdLibExtras.h"
 
 #include <QTime>
+#include <QElapsedTimer>
 #include <QVector>
 #include <QVector>
 #include <QMap>
@@ -81,15 +84,29 @@ struct MemoryManager::Data
     bool gcBlocked;
     bool aggressiveGC;
     bool gcStats;
+    bool lazySweep;
+    bool incrementalMarkingRequested;
+    bool incrementalMarking; // a marking cycle is in progress
+    int incrementalMarkingBudget; // in msecs, 0 if incremental marking is disabled
+    int incrementalMarkingSlices; // in the current cycle
+    uint markingSlices;
+    int heapGrowthTrigger; // in percent of the live heap, 0 to count allocations per size class
     ExecutionEngine *engine;
 
     enum { MaxItemSize = 512 };
+    enum { MinimumHeapGrowth = 256*1024 };
+    enum { MinimumUnmanagedHeapSizeGCLimit = 128*1024 };
     Managed *smallItems[MaxItemSize/16];
     uint nChunks[MaxItemSize/16];
     uint availableItems[MaxItemSize/16];
     uint allocCount[MaxItemSize/16];
     int totalItems;
     int totalAlloc;
+    std::size_t allocatedMemory; // in small items, since the last collection
+    uint collections;
+    std::size_t liveMemory; // in small items, after the last sweep
+    std::size_t unmanagedHeapSize; // outside of the heap, held by managed objects
+    std::size_t unmanagedHeapSizeGCLimit;
     uint maxShift;
     std::size_t maxChunkSize;
     struct Chunk {
@@ -98,10 +115,15 @@ struct MemoryManager::Data
     };
 
     QVector<Chunk> heapChunks;
+    // chunks that still have to be swept after the last collection, per size class
+    QVector<Chunk> unsweptChunks[MaxItemSize/16];
+    int unsweptChunkCount;
+    std::size_t unsweptMemory;
 
 
     struct LargeItem {
         LargeItem *next;
+        std::size_t size;
         void *data;
 
         Managed *managed() {
@@ -113,6 +135,9 @@ struct MemoryManager::Data
 
     GCDeletable *deletable;
 
+    // objects that are marked but whose children have not been marked yet
+    QVector<Managed *> greyObjects;
+
     // statistics:
 #ifdef DETAILED_MM_STATS
     QVector<unsigned> allocSizeCounters;
@@ -120,9 +145,22 @@ struct MemoryManager::Data
 
     Data()
         : gcBlocked(false)
+        , incrementalMarkingRequested(false)
+        , incrementalMarking(false)
+        , incrementalMarkingBudget(0)
+        , incrementalMarkingSlices(0)
+        , markingSlices(0)
+        , heapGrowthTrigger(0)
         , engine(0)
         , totalItems(0)
         , totalAlloc(0)
+        , allocatedMemory(0)
+        , collections(0)
+        , liveMemory(0)
+        , unmanagedHeapSize(0)
+        , unmanagedHeapSizeGCLimit(MinimumUnmanagedHeapSizeGCLimit)
+        , unsweptChunkCount(0)
+        , unsweptMemory(0)
         , maxShift(6)
         , maxChunkSize(32*1024)
         , largeItems(0)
@@ -134,6 +172,7 @@ struct MemoryManager::Data
         memset(allocCount, 0, sizeof(allocCount));
         aggressiveGC = !qgetenv("QV4_MM_AGGRESSIVE_GC").isEmpty();
         gcStats = !qgetenv("QV4_MM_STATS").isEmpty();
+        lazySweep = !qgetenv("QV4_MM_LAZY_SWEEP").isEmpty();
 
         QByteArray overrideMaxShift = qgetenv("QV4_MM_MAXBLOCK_SHIFT");
         bool ok;
@@ -141,12 +180,36 @@ struct MemoryManager::Data
         if (ok && override <= 11 && override > 0)
             maxShift = override;
 
+        QByteArray incrementalString = qgetenv("QV4_MM_INCREMENTAL_BUDGET");
+        int budget = incrementalString.toInt(&ok);
+        if (ok && budget > 0)
+            incrementalMarkingBudget = budget;
+
+        QByteArray heapGrowthString = qgetenv("QV4_MM_HEAP_GROWTH");
+        int growth = heapGrowthString.toInt(&ok);
+        if (ok && growth > 0)
+            heapGrowthTrigger = growth;
+
         QByteArray maxChunkString = qgetenv("QV4_MM_MAX_CHUNK_SIZE");
         std::size_t tmpMaxChunkSize = maxChunkString.toUInt(&ok);
         if (ok)
             maxChunkSize = tmpMaxChunkSize;
     }
 
+    // Whether a collection is due, or with a divisor > 1, whether that fraction
+    // of the way to the next collection has been allocated.
+    bool collectionDue(std::size_t pos, uint divisor = 1) const
+    {
+        if (heapGrowthTrigger) {
+            // unswept chunks are counted as live, they are not known to be garbage yet
+            const std::size_t liveHeap = liveMemory + unsweptMemory;
+            return allocatedMemory * divisor
+                    > qMax(liveHeap / 100 * heapGrowthTrigger, std::size_t(MinimumHeapGrowth));
+        }
+        return allocCount[pos] * divisor > (availableItems[pos] >> 1)
+                && uint(totalAlloc) * divisor > uint(totalItems >> 1);
+    }
+
     ~Data()
     {
         for (QVector<Chunk>::iterator i = heapChunks.begin(), ei = heapChunks.end(); i != ei; ++i)
@@ -176,7 +239,7 @@ MemoryManager::MemoryManager()
 
 Managed *MemoryManager::alloc(std::size_t size)
 {
-    if (m_d->aggressiveGC)
+    if (m_d->aggressiveGC || m_d->unmanagedHeapSize > m_d->unmanagedHeapSizeGCLimit)
         runGC();
 #ifdef DETAILED_MM_STATS
     willAllocate(size);
@@ -192,6 +255,7 @@ Managed *MemoryManager::alloc(std::size_t size)
         // we use malloc for this
         MemoryManager::Data::LargeItem *item = static_cast<MemoryManager::Data::LargeItem *>(malloc(size + sizeof(MemoryManager::Data::LargeItem)));
         memset(item, 0, size + sizeof(MemoryManager::Data::LargeItem));
+        item->size = size;
         item->next = m_d->largeItems;
         m_d->largeItems = item;
         return item->managed();
@@ -201,12 +265,33 @@ Managed *MemoryManager::alloc(std::size_t size)
     if (m)
         goto found;
 
+    // chunks left over from the last collection come first
+    while (!m_d->unsweptChunks[pos].isEmpty()) {
+        sweepPendingChunk(pos);
+        m = m_d->smallItems[pos];
+        if (m)
+            goto found;
+    }
+
     // try to free up space, otherwise allocate
-    if (m_d->allocCount[pos] > (m_d->availableItems[pos] >> 1) && m_d->totalAlloc > (m_d->totalItems >> 1) && !m_d->aggressiveGC) {
+    if (m_d->collectionDue(pos) && !m_d->aggressiveGC) {
         runGC();
         m = m_d->smallItems[pos];
         if (m)
             goto found;
+    } else if (m_d->incrementalMarkingBudget) {
+        if (m_d->incrementalMarking || m_d->incrementalMarkingRequested) {
+            // Marking has to make progress even if nothing calls runGCSlice(),
+            // so do a slice whenever a free list runs empty during the cycle.
+            runGCSlice();
+            m = m_d->smallItems[pos];
+            if (m)
+                goto found;
+        } else if (m_d->collectionDue(pos, 2)) {
+            // Halfway to the next collection: start marking in the next slice, so
+            // that most of the work is done by the time the collection is due.
+            m_d->incrementalMarkingRequested = true;
+        }
     }
 
     // no free item available, allocate a new chunk
@@ -250,14 +335,64 @@ Managed *MemoryManager::alloc(std::size_t size)
 
     ++m_d->allocCount[pos];
     ++m_d->totalAlloc;
+    m_d->allocatedMemory += size;
     m_d->smallItems[pos] = m->nextFree();
     return m;
 }
 
-void MemoryManager::mark()
+/*
+   Finishes an incremental marking cycle: objects that were marked in an earlier
+   slice may since have been given references to unmarked objects, so all marked
+   objects are scanned again.
+*/
+void MemoryManager::scanMarkedObjects()
 {
-    Value *markBase = m_d->engine->jsStackTop;
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+
+    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i) {
+        char *chunkStart = reinterpret_cast<char *>(i->memory.base());
+        char *chunkEnd = chunkStart + i->memory.size() - i->chunkSize;
+        for (char *chunk = chunkStart; chunk <= chunkEnd; chunk += i->chunkSize) {
+            Managed *m = reinterpret_cast<Managed *>(chunk);
+            if (!m->inUse || !m->markBit)
+                continue;
+            m->internalClass->vtable->markObjects(m, engine);
+            // drain the mark stack right away, to keep its size bounded
+            while (engine->jsStackTop > markBase) {
+                Managed *unmarked = engine->popForGC();
+                unmarked->internalClass->vtable->markObjects(unmarked, engine);
+            }
+        }
+    }
+
+    for (Data::LargeItem *i = m_d->largeItems; i; i = i->next) {
+        Managed *m = i->managed();
+        if (!m->markBit)
+            continue;
+        m->internalClass->vtable->markObjects(m, engine);
+        while (engine->jsStackTop > markBase) {
+            Managed *unmarked = engine->popForGC();
+            unmarked->internalClass->vtable->markObjects(unmarked, engine);
+        }
+    }
+}
+
+void MemoryManager::clearMarkBits()
+{
+    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i) {
+        char *chunkStart = reinterpret_cast<char *>(i->memory.base());
+        char *chunkEnd = chunkStart + i->memory.size() - i->chunkSize;
+        for (char *chunk = chunkStart; chunk <= chunkEnd; chunk += i->chunkSize)
+            reinterpret_cast<Managed *>(chunk)->markBit = 0;
+    }
 
+    for (Data::LargeItem *i = m_d->largeItems; i; i = i->next)
+        i->managed()->markBit = 0;
+}
+
+void MemoryManager::markRoots()
+{
     m_d->engine->markObjects();
 
     PersistentValuePrivate *persistent = m_persistentValues;
@@ -304,6 +439,13 @@ void MemoryManager::mark()
         if (keepAlive)
             qobjectWrapper->getPointer()->mark(m_d->engine);
     }
+}
+
+void MemoryManager::mark()
+{
+    Value *markBase = m_d->engine->jsStackTop;
+
+    markRoots();
 
     // now that we marked all roots, start marking recursively and popping from the mark stack
     while (m_d->engine->jsStackTop > markBase) {
@@ -313,6 +455,113 @@ void MemoryManager::mark()
     }
 }
 
+/*
+   Incremental marking uses the usual tri-color scheme: white objects have no
+   mark bit, grey objects have the mark bit and are on the greyObjects list,
+   black objects have the mark bit and their children have been marked.
+   Slices take objects from the grey list until their time budget is used up.
+
+   Slices are run by the allocator whenever a free list runs empty during a
+   cycle, and by whoever calls runGCSlice() when the engine is idle.
+
+   The mutator runs between slices and may store a reference to a white object
+   into a black one. As there are no write barriers, the invariant is restored
+   when the cycle is finished: runGC() rescans all black objects and the roots,
+   and only then sweeps. That rescan is a linear walk over the whole heap, so
+   the final pause is not shorter than a non-incremental mark. Until stores are
+   tracked, incremental marking is an experiment that is disabled by default.
+*/
+void MemoryManager::startIncrementalMarking()
+{
+    m_d->incrementalMarkingRequested = false;
+    m_d->incrementalMarking = true;
+    m_d->incrementalMarkingSlices = 0;
+
+    sweepPendingChunks();
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    markRoots();
+    while (engine->jsStackTop > markBase)
+        m_d->greyObjects.append(engine->popForGC());
+}
+
+bool MemoryManager::runSweepSlice()
+{
+    if (m_d->gcBlocked || !m_d->unsweptChunkCount)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Without incremental marking, sweeping slices use a budget of 1ms.
+    const int budget = qMax(1, m_d->incrementalMarkingBudget);
+    for (uint pos = 0; pos < MemoryManager::Data::MaxItemSize/16; ++pos) {
+        while (!m_d->unsweptChunks[pos].isEmpty()) {
+            sweepPendingChunk(pos);
+            if (timer.hasExpired(budget))
+                return true;
+        }
+    }
+    deleteDeletables();
+    return false;
+}
+
+bool MemoryManager::runGCSlice()
+{
+    if (m_d->gcBlocked)
+        return false;
+
+    if (runSweepSlice())
+        return true;
+
+    if (!m_d->incrementalMarkingBudget)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!m_d->incrementalMarking) {
+        if (!m_d->incrementalMarkingRequested)
+            return false;
+        startIncrementalMarking();
+    }
+    ++m_d->incrementalMarkingSlices;
+    ++m_d->markingSlices;
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    int count = 0;
+    while (!m_d->greyObjects.isEmpty()) {
+        Managed *m = m_d->greyObjects.last();
+        m_d->greyObjects.removeLast();
+        m->internalClass->vtable->markObjects(m, engine);
+        while (engine->jsStackTop > markBase)
+            m_d->greyObjects.append(engine->popForGC());
+
+        // reading the clock is not free, only do it every now and then
+        if (!(++count % 64) && timer.hasExpired(m_d->incrementalMarkingBudget))
+            return true;
+    }
+
+    runGC();
+    return false;
+}
+
+void MemoryManager::setIncrementalMarkingBudget(int msecs)
+{
+    if (msecs <= 0 && m_d->incrementalMarking)
+        runGC();
+    m_d->incrementalMarkingBudget = qMax(0, msecs);
+    if (!m_d->incrementalMarkingBudget)
+        m_d->incrementalMarkingRequested = false;
+}
+
+int MemoryManager::incrementalMarkingBudget() const
+{
+    return m_d->incrementalMarkingBudget;
+}
+
 void MemoryManager::sweep(bool lastSweep)
 {
     PersistentValuePrivate *weak = m_weakValues;
@@ -345,8 +594,26 @@ void MemoryManager::sweep(bool lastSweep)
         }
     }
 
-    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i)
-        sweep(reinterpret_cast<char*>(i->memory.base()), i->memory.size(), i->chunkSize);
+    // The cache must not hand out regexps that are only destroyed by a lazy sweep later.
+    if (RegExpCache *regExpCache = m_d->engine->regExpCache)
+        regExpCache->removeUnmarked();
+
+    Q_ASSERT(!m_d->unsweptChunkCount || lastSweep);
+    for (uint pos = 0; pos < MemoryManager::Data::MaxItemSize/16; ++pos)
+        m_d->unsweptChunks[pos].clear();
+    m_d->unsweptChunkCount = 0;
+    m_d->unsweptMemory = 0;
+
+    m_d->liveMemory = 0;
+    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i) {
+        if (m_d->lazySweep && !lastSweep) {
+            m_d->unsweptChunks[i->chunkSize >> 4].append(*i);
+            ++m_d->unsweptChunkCount;
+            m_d->unsweptMemory += i->memory.size();
+        } else {
+            sweep(reinterpret_cast<char*>(i->memory.base()), i->memory.size(), i->chunkSize);
+        }
+    }
 
     Data::LargeItem *i = m_d->largeItems;
     Data::LargeItem **last = &m_d->largeItems;
@@ -367,11 +634,43 @@ void MemoryManager::sweep(bool lastSweep)
         i = *last;
     }
 
+    deleteDeletables(lastSweep);
+}
+
+/*
+   With QV4_MM_LAZY_SWEEP set, sweep() only takes care of weak values and large
+   items. The chunks for small items are queued per size class and swept when
+   the free list of that size class runs empty, in runGCSlice(), or at the latest
+   before the next collection starts marking. Each chunk only feeds the free list
+   of its own size class, so this does not change which objects get freed.
+*/
+void MemoryManager::sweepPendingChunk(uint pos)
+{
+    Q_ASSERT(!m_d->unsweptChunks[pos].isEmpty());
+    Data::Chunk chunk = m_d->unsweptChunks[pos].last();
+    m_d->unsweptChunks[pos].removeLast();
+    --m_d->unsweptChunkCount;
+    m_d->unsweptMemory -= chunk.memory.size();
+    sweep(reinterpret_cast<char *>(chunk.memory.base()), chunk.memory.size(), chunk.chunkSize);
+}
+
+void MemoryManager::sweepPendingChunks()
+{
+    if (!m_d->unsweptChunkCount)
+        return;
+    for (uint pos = 0; pos < MemoryManager::Data::MaxItemSize/16; ++pos) {
+        while (!m_d->unsweptChunks[pos].isEmpty())
+            sweepPendingChunk(pos);
+    }
+}
+
+void MemoryManager::deleteDeletables(bool lastCall)
+{
     GCDeletable *deletable = m_d->deletable;
     m_d->deletable = 0;
     while (deletable) {
         GCDeletable *next = deletable->next;
-        deletable->lastCall = lastSweep;
+        deletable->lastCall = lastCall;
         delete deletable;
         deletable = next;
     }
@@ -395,6 +694,7 @@ void MemoryManager::sweep(char *chunkStart, std::size_t chunkSize, size_t size)
         if (m->inUse) {
             if (m->markBit) {
                 m->markBit = 0;
+                m_d->liveMemory += size;
             } else {
 //                qDebug() << "-- collecting it." << m << *f << m->nextFree();
 #ifdef V4_USE_VALGRIND
@@ -435,7 +735,17 @@ void MemoryManager::runGC()
         return;
     }
 
+    // Unswept chunks still carry the mark bits of the last collection.
+    sweepPendingChunks();
+
+    // A pending incremental cycle is always finished.
+    // Objects left on the grey list are marked, so scanMarkedObjects() visits them.
+    const bool finishIncrementalMarking = m_d->incrementalMarking;
+    m_d->greyObjects.clear();
+
     if (!m_d->gcStats) {
+        if (finishIncrementalMarking)
+            scanMarkedObjects();
         mark();
         sweep();
     } else {
@@ -445,6 +755,8 @@ void MemoryManager::runGC()
 
         QTime t;
         t.start();
+        if (finishIncrementalMarking)
+            scanMarkedObjects();
         mark();
         int markTime = t.elapsed();
         t.restart();
@@ -454,17 +766,164 @@ void MemoryManager::runGC()
         int sweepTime = t.elapsed();
 
         qDebug() << "========== GC ==========";
+        if (finishIncrementalMarking)
+            qDebug() << "Finished incremental marking after" << m_d->incrementalMarkingSlices << "slices.";
         qDebug() << "Marked object in" << markTime << "ms.";
         qDebug() << "Sweeped object in" << sweepTime << "ms.";
         qDebug() << "Allocated" << totalMem << "bytes in" << m_d->heapChunks.size() << "chunks.";
         qDebug() << "Used memory before GC:" << usedBefore;
         qDebug() << "Used memory after GC:" << usedAfter;
         qDebug() << "Freed up bytes:" << (usedBefore - usedAfter);
+        if (m_d->lazySweep)
+            qDebug() << "Chunks left for lazy sweeping:" << m_d->unsweptChunkCount;
+        const Statistics stats = statistics();
+        foreach (const SizeClassStatistics &sizeClass, stats.sizeClasses)
+            qDebug() << "  Items of" << sizeClass.itemSize << "bytes:" << sizeClass.chunks << "chunks,"
+                     << sizeClass.usedItems << "used," << sizeClass.freeItems << "free,"
+                     << sizeClass.allocationsSinceGC << "allocated since the last GC.";
+        qDebug() << "  Large items:" << stats.largeItems << "using" << stats.largeItemMemory << "bytes.";
         qDebug() << "======== End GC ========";
     }
 
+    ++m_d->collections;
+
+    if (m_d->engine->profiler && m_d->engine->profiler->tracksHeapStatistics())
+        m_d->engine->profiler->trackHeapStatistics(statistics());
+    m_d->incrementalMarking = false;
+    m_d->incrementalMarkingRequested = false;
+
     memset(m_d->allocCount, 0, sizeof(m_d->allocCount));
     m_d->totalAlloc = 0;
+    m_d->allocatedMemory = 0;
+    // collect again once the unmanaged memory has doubled, unswept chunks may still release some of it
+    m_d->unmanagedHeapSizeGCLimit = qMax(2 * m_d->unmanagedHeapSize,
+                                         std::size_t(Data::MinimumUnmanagedHeapSizeGCLimit));
+}
+
+void MemoryManager::changeUnmanagedHeapSizeUsage(qptrdiff delta)
+{
+    Q_ASSERT(delta >= 0 || std::size_t(-delta) <= m_d->unmanagedHeapSize);
+    m_d->unmanagedHeapSize += delta;
+}
+
+void MemoryManager::setHeapGrowthTrigger(int percent)
+{
+    m_d->heapGrowthTrigger = qMax(0, percent);
+}
+
+int MemoryManager::heapGrowthTrigger() const
+{
+    return m_d->heapGrowthTrigger;
+}
+
+MemoryManager::Statistics MemoryManager::statistics() const
+{
+    SizeClassStatistics sizeClasses[Data::MaxItemSize/16];
+    for (QVector<Data::Chunk>::const_iterator i = m_d->heapChunks.constBegin(), ei = m_d->heapChunks.constEnd(); i != ei; ++i) {
+        SizeClassStatistics &sizeClass = sizeClasses[i->chunkSize >> 4];
+        ++sizeClass.chunks;
+        sizeClass.chunkMemory += i->memory.size();
+        char *chunkStart = reinterpret_cast<char *>(i->memory.base());
+        char *chunkEnd = chunkStart + i->memory.size() - i->chunkSize;
+        for (char *chunk = chunkStart; chunk <= chunkEnd; chunk += i->chunkSize) {
+            if (reinterpret_cast<Managed *>(chunk)->inUse)
+                ++sizeClass.usedItems;
+            else
+                ++sizeClass.freeItems;
+        }
+    }
+
+    Statistics stats;
+    for (uint pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+        SizeClassStatistics &sizeClass = sizeClasses[pos];
+        if (!sizeClass.chunks)
+            continue;
+        sizeClass.itemSize = pos << 4;
+        sizeClass.allocationsSinceGC = m_d->allocCount[pos];
+        stats.sizeClasses.append(sizeClass);
+    }
+
+    for (Data::LargeItem *i = m_d->largeItems; i; i = i->next) {
+        ++stats.largeItems;
+        stats.largeItemMemory += i->size;
+    }
+
+    stats.unmanagedMemory = m_d->unmanagedHeapSize;
+    stats.liveMemoryAfterGC = m_d->liveMemory;
+    stats.collections = m_d->collections;
+    stats.markingSlices = m_d->markingSlices;
+    stats.unsweptChunks = m_d->unsweptChunkCount;
+    return stats;
+}
+
+/*
+   The references of an object are found the same way the marker finds them:
+   markObjects() pushes every unmarked child onto the JS stack. With all mark
+   bits cleared that is every child, so they are popped and unmarked again
+   right away to report them.
+*/
+bool MemoryManager::visitHeap(HeapVisitor *visitor)
+{
+    if (m_d->gcBlocked)
+        return false;
+
+    // Afterwards everything that is in use is reachable.
+    runGC();
+    sweepPendingChunks();
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+
+    clearMarkBits();
+    markRoots();
+    engine->jsStackTop = markBase;
+
+    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i) {
+        char *chunkStart = reinterpret_cast<char *>(i->memory.base());
+        char *chunkEnd = chunkStart + i->memory.size() - i->chunkSize;
+        for (char *chunk = chunkStart; chunk <= chunkEnd; chunk += i->chunkSize) {
+            Managed *m = reinterpret_cast<Managed *>(chunk);
+            if (m->inUse && m->markBit)
+                visitor->root(m);
+        }
+    }
+    for (Data::LargeItem *i = m_d->largeItems; i; i = i->next) {
+        if (i->managed()->markBit)
+            visitor->root(i->managed());
+    }
+
+    clearMarkBits();
+
+    for (QVector<Data::Chunk>::iterator i = m_d->heapChunks.begin(), ei = m_d->heapChunks.end(); i != ei; ++i) {
+        char *chunkStart = reinterpret_cast<char *>(i->memory.base());
+        char *chunkEnd = chunkStart + i->memory.size() - i->chunkSize;
+        for (char *chunk = chunkStart; chunk <= chunkEnd; chunk += i->chunkSize) {
+            Managed *m = reinterpret_cast<Managed *>(chunk);
+            if (!m->inUse)
+                continue;
+            visitor->object(m, i->chunkSize);
+            m->internalClass->vtable->markObjects(m, engine);
+            while (engine->jsStackTop > markBase) {
+                Managed *child = engine->popForGC();
+                child->markBit = 0;
+                visitor->reference(m, child);
+            }
+        }
+    }
+    for (Data::LargeItem *i = m_d->largeItems; i; i = i->next) {
+        Managed *m = i->managed();
+        visitor->object(m, i->size);
+        m->internalClass->vtable->markObjects(m, engine);
+        while (engine->jsStackTop > markBase) {
+            Managed *child = engine->popForGC();
+            child->markBit = 0;
+            visitor->reference(m, child);
+        }
+    }
+
+    // Restore the state a collection leaves behind.
+    clearMarkBits();
+    return true;
 }
 
 uint MemoryManager::getUsedMem()
@@ -495,6 +954,8 @@ MemoryManager::~MemoryManager()
         persistent = n;
     }
 
+    if (m_d->incrementalMarking || m_d->unsweptChunkCount)
+        clearMarkBits();
     sweep(/*lastSweep*/true);
 #ifdef V4_USE_VALGRIND
     VALGRIND_DESTROY_MEMPOOL(this);
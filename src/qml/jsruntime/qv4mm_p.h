@@ -47,6 +47,7 @@
 #include "qv4value_inl_p.h"
 
 #include <QScopedPointer>
+#include <QVector>
 
 //#define DETAILED_MM_STATS
 
@@ -87,6 +88,51 @@ public:
         bool wasBlocked;
     };
 
+    struct SizeClassStatistics
+    {
+        SizeClassStatistics()
+            : itemSize(0), chunks(0), chunkMemory(0), usedItems(0), freeItems(0), allocationsSinceGC(0)
+        {}
+
+        uint itemSize;
+        uint chunks;
+        std::size_t chunkMemory;
+        uint usedItems; // includes garbage in chunks that are not swept yet
+        uint freeItems;
+        uint allocationsSinceGC;
+
+        // the share of items in this size class's chunks that is not used
+        double fragmentation() const
+        { return usedItems + freeItems ? double(freeItems) / (usedItems + freeItems) : 0.; }
+    };
+
+    struct Statistics
+    {
+        Statistics()
+            : largeItems(0), largeItemMemory(0), unmanagedMemory(0), liveMemoryAfterGC(0)
+            , collections(0), markingSlices(0), unsweptChunks(0)
+        {}
+
+        QVector<SizeClassStatistics> sizeClasses; // only the ones that have chunks
+        uint largeItems;
+        std::size_t largeItemMemory;
+        std::size_t unmanagedMemory; // reported with changeUnmanagedHeapSizeUsage()
+        std::size_t liveMemoryAfterGC; // in small items, as of the last sweep
+        uint collections;
+        uint markingSlices; // incremental marking slices
+        uint unsweptChunks; // left for lazy sweeping
+    };
+
+    // Receives the live heap from visitHeap(): first the roots, then every
+    // object followed by the objects it references.
+    struct HeapVisitor
+    {
+        virtual ~HeapVisitor() {}
+        virtual void root(Managed *m) = 0;
+        virtual void object(Managed *m, std::size_t size) = 0;
+        virtual void reference(Managed *from, Managed *to) = 0;
+    };
+
 public:
     MemoryManager();
     ~MemoryManager();
@@ -107,6 +153,34 @@ public:
     void setGCBlocked(bool blockGC);
     void runGC();
 
+    // Incremental marking (experimental): the budget is the time a single slice
+    // may spend marking, in milliseconds. 0 disables incremental marking.
+    void setIncrementalMarkingBudget(int msecs);
+    int incrementalMarkingBudget() const;
+    // Adaptive trigger: collect once the small items allocated since the last
+    // collection exceed the given percentage of the live heap. 0 restores the
+    // default, which is based on the number of allocations per size class.
+    void setHeapGrowthTrigger(int percent);
+    int heapGrowthTrigger() const;
+
+    Statistics statistics() const;
+
+    // Objects that hold memory outside of the garbage collected heap, like the
+    // contents of an ArrayBuffer, report it here. Allocations collect garbage once
+    // it has grown to twice the amount that was left after the last collection.
+    void changeUnmanagedHeapSizeUsage(qptrdiff delta);
+
+    // Collects garbage and walks the remaining heap. Returns false if the
+    // garbage collector is blocked.
+    bool visitHeap(HeapVisitor *visitor);
+
+    // Does pending lazy sweeping and incremental marking work, returns true if
+    // there is more to do.
+    bool runGCSlice();
+    // Only does pending lazy sweeping work. Unlike a marking cycle, it has a
+    // bounded cost, so it can be run from a frame tick.
+    bool runSweepSlice();
+
     void setExecutionEngine(ExecutionEngine *engine);
 
     void dumpStats() const;
@@ -126,9 +200,16 @@ protected:
 
 private:
     void collectFromJSStack() const;
+    void scanMarkedObjects();
+    void clearMarkBits();
+    void startIncrementalMarking();
+    void markRoots();
     void mark();
     void sweep(bool lastSweep = false);
     void sweep(char *chunkStart, std::size_t chunkSize, size_t size);
+    void sweepPendingChunk(uint pos);
+    void sweepPendingChunks();
+    void deleteDeletables(bool lastCall = false);
     uint getUsedMem();
 
 protected:
@@ -250,7 +250,7 @@ void Object::insertMember(const StringRef s, const Property &p, PropertyAttribut
 }
 
 // Section 8.12.1
-Property *Object::__getOwnProperty__(const StringRef name, PropertyAttributes *attrs)
+const Property *Object::__getOwnProperty__(const StringRef name, PropertyAttributes *attrs)
 {
     uint idx = name->asArrayIndex();
     if (idx != UINT_MAX)
@@ -268,9 +268,9 @@ Property *Object::__getOwnProperty__(const StringRef name, PropertyAttributes *a
     return 0;
 }
 
-Property *Object::__getOwnProperty__(uint index, PropertyAttributes *attrs)
+const Property *Object::__getOwnProperty__(uint index, PropertyAttributes *attrs)
 {
-    Property *p = arrayData->getProperty(index);
+    const Property *p = arrayData->getProperty(index);
     if (p) {
         if (attrs)
             *attrs = arrayData->attributes(index);
@@ -288,7 +288,7 @@ Property *Object::__getOwnProperty__(uint index, PropertyAttributes *attrs)
 }
 
 // Section 8.12.2
-Property *Object::__getPropertyDescriptor__(const StringRef name, PropertyAttributes *attrs) const
+const Property *Object::__getPropertyDescriptor__(const StringRef name, PropertyAttributes *attrs) const
 {
     uint idx = name->asArrayIndex();
     if (idx != UINT_MAX)
@@ -311,11 +311,11 @@ Property *Object::__getPropertyDescriptor__(const StringRef name, PropertyAttrib
     return 0;
 }
 
-Property *Object::__getPropertyDescriptor__(uint index, PropertyAttributes *attrs) const
+const Property *Object::__getPropertyDescriptor__(uint index, PropertyAttributes *attrs) const
 {
     const Object *o = this;
     while (o) {
-        Property *p = o->arrayData->getProperty(index);
+        const Property *p = o->arrayData->getProperty(index);
         if (p) {
             if (attrs)
                 *attrs = o->arrayData->attributes(index);
@@ -464,6 +464,13 @@ bool Object::deleteIndexedProperty(Managed *m, uint index)
 ReturnedValue Object::getLookup(Managed *m, Lookup *l)
 {
     Object *o = static_cast<Object *>(m);
+    if (o->vtable()->get != Object::get) {
+        // the internal class does not describe the properties of objects with
+        // their own get(), like the QML wrappers
+        Scope scope(o->engine());
+        ScopedString s(scope, l->name);
+        return o->get(s);
+    }
     PropertyAttributes attrs;
     ReturnedValue v = l->lookup(o, &attrs);
     if (v != Primitive::emptyValue().asReturnedValue()) {
@@ -497,6 +504,12 @@ void Object::setLookup(Managed *m, Lookup *l, const ValueRef value)
     Scope scope(m->engine());
     ScopedObject o(scope, static_cast<Object *>(m));
 
+    if (o->vtable()->put != Object::put) {
+        ScopedString s(scope, l->name);
+        o->put(s, value);
+        return;
+    }
+
     InternalClass *c = o->internalClass;
     uint idx = c->find(l->name);
     if (!o->isArrayObject() || idx != ArrayObject::LengthPropertyIndex) {
@@ -638,11 +651,11 @@ ReturnedValue Object::internalGet(const StringRef name, bool *hasProperty)
 
 ReturnedValue Object::internalGetIndexed(uint index, bool *hasProperty)
 {
-    Property *pd = 0;
+    const Property *pd = 0;
     PropertyAttributes attrs;
     Object *o = this;
     while (o) {
-        Property *p = o->arrayData->getProperty(index);
+        const Property *p = o->arrayData->getProperty(index);
         if (p) {
             pd = p;
             attrs = o->arrayData->attributes(index);
@@ -683,7 +696,7 @@ void Object::internalPut(const StringRef name, const ValueRef value)
     name->makeIdentifier();
 
     uint member = internalClass->find(name.getPointer());
-    Property *pd = 0;
+    const Property *pd = 0;
     PropertyAttributes attrs;
     if (member < UINT_MAX) {
         pd = propertyAt(member);
@@ -709,7 +722,7 @@ void Object::internalPut(const StringRef name, const ValueRef value)
             if (!ok)
                 goto reject;
         } else {
-            pd->value = *value;
+            propertyAt(member)->value = *value;
         }
         return;
     } else if (!prototype()) {
@@ -762,7 +775,7 @@ void Object::internalPutIndexed(uint index, const ValueRef value)
 
     PropertyAttributes attrs;
 
-    Property *pd = arrayData->getProperty(index);
+    const Property *pd = arrayData->getProperty(index);
     if (pd)
         attrs = arrayData->attributes(index);
 
@@ -782,7 +795,7 @@ void Object::internalPutIndexed(uint index, const ValueRef value)
         } else if (!attrs.isWritable())
             goto reject;
         else
-            pd->value = *value;
+            arraySet(index, value);
         return;
     } else if (!prototype()) {
         if (!extensible)
@@ -946,7 +959,7 @@ reject:
 
 bool Object::defineOwnProperty2(ExecutionContext *ctx, uint index, const Property &p, PropertyAttributes attrs)
 {
-    Property *current = 0;
+    const Property *current = 0;
 
     // Clause 1
     {
@@ -992,7 +1005,7 @@ bool Object::__defineOwnProperty__(ExecutionContext *ctx, uint index, const Stri
         current = propertyAt(index);
         cattrs = internalClass->propertyData[index];
     } else {
-        current = arrayData->getProperty(index);
+        current = arrayData->getPropertyForWrite(index);
         cattrs = arrayData->attributes(index);
     }
 
@@ -1025,7 +1038,7 @@ bool Object::__defineOwnProperty__(ExecutionContext *ctx, uint index, const Stri
                 // need to convert the array and the slot
                 initSparseArray();
                 setArrayAttributes(index, cattrs);
-                current = arrayData->getProperty(index);
+                current = arrayData->getPropertyForWrite(index);
             }
             current->setGetter(0);
             current->setSetter(0);
@@ -1036,7 +1049,7 @@ bool Object::__defineOwnProperty__(ExecutionContext *ctx, uint index, const Stri
             if (member.isNull()) {
                 // need to convert the array and the slot
                 setArrayAttributes(index, cattrs);
-                current = arrayData->getProperty(index);
+                current = arrayData->getPropertyForWrite(index);
             }
             current->value = Primitive::undefinedValue();
         }
@@ -1116,6 +1129,7 @@ void Object::copyArrayData(Object *other)
             SimpleArrayData *d = static_cast<SimpleArrayData *>(arrayData);
             d->len = static_cast<SimpleArrayData *>(other->arrayData)->len;
             d->offset = 0;
+            d->setElementKind(static_cast<SimpleArrayData *>(other->arrayData)->elementKind());
         }
         memcpy(arrayData->data, other->arrayData->data, arrayData->alloc*sizeof(Value));
     }
@@ -1196,6 +1210,9 @@ ReturnedValue ArrayObject::getLookup(Managed *m, Lookup *l)
         // special case, as the property is on the object itself
         l->getter = Lookup::arrayLengthGetter;
         ArrayObject *a = static_cast<ArrayObject *>(m);
+        // lets a polymorphic lookup cache the length of arrays of this class
+        l->classList[0] = a->internalClass;
+        l->index = ArrayObject::LengthPropertyIndex;
         return a->memberData[ArrayObject::LengthPropertyIndex].asReturnedValue();
     }
     return Object::getLookup(m, l);
@@ -122,11 +122,11 @@ struct Q_QML_EXPORT Object: Managed {
     Object *prototype() const { return internalClass->prototype; }
     bool setPrototype(Object *proto);
 
-    Property *__getOwnProperty__(const StringRef name, PropertyAttributes *attrs = 0);
-    Property *__getOwnProperty__(uint index, PropertyAttributes *attrs = 0);
+    const Property *__getOwnProperty__(const StringRef name, PropertyAttributes *attrs = 0);
+    const Property *__getOwnProperty__(uint index, PropertyAttributes *attrs = 0);
 
-    Property *__getPropertyDescriptor__(const StringRef name, PropertyAttributes *attrs = 0) const;
-    Property *__getPropertyDescriptor__(uint index, PropertyAttributes *attrs = 0) const;
+    const Property *__getPropertyDescriptor__(const StringRef name, PropertyAttributes *attrs = 0) const;
+    const Property *__getPropertyDescriptor__(uint index, PropertyAttributes *attrs = 0) const;
 
     bool hasProperty(const StringRef name) const;
     bool hasProperty(uint index) const;
@@ -209,6 +209,8 @@ public:
     void setArrayType(ArrayData::Type t) {
         Q_ASSERT(t != ArrayData::Simple && t != ArrayData::Sparse);
         arrayCreate();
+        if (!arrayData->isSparse())
+            static_cast<SimpleArrayData *>(arrayData)->setElementKind(ArrayData::Generic);
         arrayData->type = t;
     }
 
@@ -380,6 +382,8 @@ inline void Object::arraySet(uint index, const Property &p, PropertyAttributes a
     }
     setArrayAttributes(index, attributes);
     Property *pd = ArrayData::insert(this, index, attributes.isAccessor());
+    if (arrayData->type != ArrayData::Sparse)
+        static_cast<SimpleArrayData *>(arrayData)->prepareStore(index, p.value);
     pd->value = p.value;
     if (attributes.isAccessor())
         pd->set = p.set;
@@ -395,7 +399,10 @@ inline void Object::arraySet(uint index, ValueRef value)
         initSparseArray();
     }
     Property *pd = ArrayData::insert(this, index);
-    pd->value = value ? *value : Primitive::undefinedValue();
+    const Value v = value ? *value : Primitive::undefinedValue();
+    if (arrayData->type != ArrayData::Sparse)
+        static_cast<SimpleArrayData *>(arrayData)->prepareStore(index, v);
+    pd->value = v;
     if (isArrayObject() && index >= getLength())
         setArrayLengthUnchecked(index + 1);
 }
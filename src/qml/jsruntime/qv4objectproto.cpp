@@ -165,7 +165,7 @@ ReturnedValue ObjectPrototype::method_getOwnPropertyDescriptor(CallContext *ctx)
     if (scope.hasException())
         return Encode::undefined();
     PropertyAttributes attrs;
-    Property *desc = O->__getOwnProperty__(name, &attrs);
+    const Property *desc = O->__getOwnProperty__(name, &attrs);
     return fromPropertyDescriptor(ctx, desc, attrs);
 }
 
@@ -40,12 +40,50 @@
 ****************************************************************************/
 
 #include "qv4profiling_p.h"
+#include "qv4context_p.h"
+#include "qv4functionobject_p.h"
+
+#include <QThread>
+#include <QVarLengthArray>
 
 QT_BEGIN_NAMESPACE
 
 using namespace QV4;
 using namespace QV4::Profiling;
 
+namespace QV4 {
+namespace Profiling {
+
+// Only counts ticks, the engine thread takes a sample at the next function entry,
+// exit or interpreted loop back edge. Walking the context chain from here while the engine runs is not safe.
+class Sampler : public QThread
+{
+public:
+    Sampler(Profiler *profiler) : m_profiler(profiler) {}
+
+    void stop()
+    {
+        m_stop.store(1);
+        wait();
+    }
+
+protected:
+    void run()
+    {
+        while (!m_stop.load()) {
+            QThread::usleep(m_profiler->m_samplingInterval);
+            m_profiler->m_pendingTicks.fetchAndAddRelaxed(1);
+        }
+    }
+
+private:
+    Profiler *m_profiler;
+    QAtomicInt m_stop;
+};
+
+}
+}
+
 FunctionCallProperties FunctionCall::resolve() const
 {
     FunctionCallProperties props = {
@@ -60,11 +98,106 @@ FunctionCallProperties FunctionCall::resolve() const
 }
 
 
-Profiler::Profiler() : enabled(false)
+Profiler::Profiler() : enabled(false), m_heapStatisticsRequested(false), m_samplingInterval(0), m_sampler(0)
 {
     static int metatype = qRegisterMetaType<QList<QV4::Profiling::FunctionCallProperties> >();
+    static int heapMetatype = qRegisterMetaType<QList<QV4::Profiling::HeapStatisticsProperties> >();
+    static int callTreeMetatype = qRegisterMetaType<QList<QV4::Profiling::CallTreeEntryProperties> >();
     Q_UNUSED(metatype);
+    Q_UNUSED(heapMetatype);
+    Q_UNUSED(callTreeMetatype);
     m_timer.start();
+
+    setSamplingInterval(qgetenv("QV4_PROFILE_SAMPLING").toInt());
+    m_heapStatisticsRequested = !qgetenv("QV4_PROFILE_HEAP").isEmpty();
+}
+
+Profiler::~Profiler()
+{
+    if (m_sampler) {
+        m_sampler->stop();
+        delete m_sampler;
+    }
+    clearCallTree();
+}
+
+void Profiler::setSamplingInterval(int usecs)
+{
+    // can't switch modes while profiling
+    if (!enabled)
+        m_samplingInterval = qMax(0, usecs);
+}
+
+void Profiler::takeSample(ExecutionContext *ctx, int ticks)
+{
+    QVarLengthArray<Function *, 64> frames;
+    for (ExecutionContext *c = ctx; c; c = c->parent) {
+        CallContext *callCtx = c->asCallContext();
+        if (callCtx && callCtx->function && callCtx->function->function)
+            frames.append(callCtx->function->function);
+    }
+    if (frames.isEmpty())
+        return;
+
+    if (m_callTree.isEmpty()) {
+        CallTreeNode root = { 0, -1, -1, 0, 0 };
+        m_callTree.append(root);
+    }
+
+    int node = 0;
+    m_callTree[node].totalSamples += ticks;
+    for (int i = frames.size() - 1; i >= 0; --i) {
+        Function *function = frames.at(i);
+        int child = m_callTree.at(node).firstChild;
+        while (child != -1 && m_callTree.at(child).function != function)
+            child = m_callTree.at(child).nextSibling;
+        if (child == -1) {
+            function->compilationUnit->ref();
+            CallTreeNode added = { function, -1, m_callTree.at(node).firstChild, 0, 0 };
+            child = m_callTree.size();
+            m_callTree.append(added);
+            m_callTree[node].firstChild = child;
+        }
+        node = child;
+        m_callTree[node].totalSamples += ticks;
+    }
+    m_callTree[node].selfSamples += ticks;
+}
+
+void Profiler::clearCallTree()
+{
+    for (int i = 1; i < m_callTree.size(); ++i)
+        m_callTree.at(i).function->compilationUnit->deref();
+    m_callTree.clear();
+}
+
+QList<CallTreeEntryProperties> Profiler::resolveCallTree() const
+{
+    QList<CallTreeEntryProperties> entries;
+    if (m_callTree.isEmpty())
+        return entries;
+
+    const double sampleTime = m_samplingInterval / 1000.0;
+    QVector<QPair<int, int> > pending; // node, depth
+    for (int child = m_callTree.first().firstChild; child != -1; child = m_callTree.at(child).nextSibling)
+        pending.append(qMakePair(child, 0));
+    while (!pending.isEmpty()) {
+        QPair<int, int> next = pending.takeLast();
+        const CallTreeNode &node = m_callTree.at(next.first);
+        CallTreeEntryProperties props = {
+            next.second,
+            node.function->name()->toQString(),
+            node.function->compilationUnit->fileName(),
+            node.function->compiledFunction->location.line,
+            node.function->compiledFunction->location.column,
+            node.totalSamples * sampleTime,
+            node.selfSamples * sampleTime
+        };
+        entries.append(props);
+        for (int child = node.firstChild; child != -1; child = m_callTree.at(child).nextSibling)
+            pending.append(qMakePair(child, next.second + 1));
+    }
+    return entries;
 }
 
 struct FunctionCallComparator {
@@ -75,6 +208,11 @@ struct FunctionCallComparator {
 void Profiler::stopProfiling()
 {
     enabled = false;
+    if (m_sampler) {
+        m_sampler->stop();
+        delete m_sampler;
+        m_sampler = 0;
+    }
     reportData();
 }
 
@@ -87,13 +225,26 @@ void Profiler::reportData()
         FunctionCallProperties props = call.resolve();
         resolved.insert(std::upper_bound(resolved.begin(), resolved.end(), props, comp), props);
     }
-    emit dataReady(resolved);
+    emit dataReady(resolved, m_heapData, resolveCallTree());
+}
+
+void Profiler::trackHeapStatistics(const MemoryManager::Statistics &statistics)
+{
+    HeapStatisticsProperties props = { m_timer.nsecsElapsed(), statistics };
+    m_heapData.append(props);
 }
 
 void Profiler::startProfiling()
 {
     if (!enabled) {
         m_data.clear();
+        m_heapData.clear();
+        clearCallTree();
+        if (m_samplingInterval) {
+            m_pendingTicks.store(0);
+            m_sampler = new Sampler(this);
+            m_sampler->start();
+        }
         enabled = true;
     }
 }
@@ -45,8 +45,10 @@
 #include "qv4global_p.h"
 #include "qv4engine_p.h"
 #include "qv4function_p.h"
+#include "qv4mm_p.h"
 
 #include <QElapsedTimer>
+#include <QAtomicInt>
 
 QT_BEGIN_NAMESPACE
 
@@ -63,6 +65,22 @@ struct FunctionCallProperties {
     int column;
 };
 
+struct HeapStatisticsProperties {
+    qint64 timestamp;
+    MemoryManager::Statistics statistics;
+};
+
+// One function in the call tree aggregated from samples, listed depth first.
+struct CallTreeEntryProperties {
+    int depth;
+    QString name;
+    QString file;
+    int line;
+    int column;
+    double totalTime; // ms
+    double selfTime;  // ms
+};
+
 class FunctionCall {
 public:
 
@@ -106,14 +124,40 @@ private:
         Profiling::FunctionCallProfiler::profileCall(engine->profiler, ctx, function) :\
         function->code(ctx, function->codeData))
 
+class Sampler;
+
 class Q_QML_EXPORT Profiler : public QObject {
     Q_OBJECT
     Q_DISABLE_COPY(Profiler)
 public:
     Profiler();
+    ~Profiler();
 
     bool enabled;
 
+    // Heap statistics are only recorded if requested (also by QV4_PROFILE_HEAP),
+    // as they need a walk over the whole heap after each collection.
+    bool tracksHeapStatistics() const { return enabled && m_heapStatisticsRequested; }
+    void setHeapStatisticsRequested(bool requested) { m_heapStatisticsRequested = requested; }
+    void trackHeapStatistics(const MemoryManager::Statistics &statistics);
+
+    // With a sampling interval (in microseconds, also set by QV4_PROFILE_SAMPLING)
+    // calls are not timed individually. Instead a timer thread counts ticks, and the
+    // engine takes a sample of the JS call stack at the next function entry, exit or
+    // loop back edge. The sample is weighted by the ticks that passed since the
+    // previous one, so long stretches without a check aren't lost.
+    int samplingInterval() const { return m_samplingInterval; }
+    void setSamplingInterval(int usecs);
+
+    void checkSample(ExecutionContext *ctx)
+    {
+        if (m_pendingTicks.load()) {
+            const int ticks = m_pendingTicks.fetchAndStoreRelaxed(0);
+            if (ticks)
+                takeSample(ctx, ticks);
+        }
+    }
+
 public slots:
     void stopProfiling();
     void startProfiling();
@@ -121,13 +165,35 @@ public slots:
     void setTimer(const QElapsedTimer &timer) { m_timer = timer; }
 
 signals:
-    void dataReady(const QList<QV4::Profiling::FunctionCallProperties> &);
+    void dataReady(const QList<QV4::Profiling::FunctionCallProperties> &,
+                   const QList<QV4::Profiling::HeapStatisticsProperties> &,
+                   const QList<QV4::Profiling::CallTreeEntryProperties> &);
 
 private:
+    struct CallTreeNode {
+        Function *function;
+        int firstChild;
+        int nextSibling;
+        uint totalSamples;
+        uint selfSamples;
+    };
+
+    void takeSample(ExecutionContext *ctx, int ticks);
+    void clearCallTree();
+    QList<CallTreeEntryProperties> resolveCallTree() const;
+
     QElapsedTimer m_timer;
     QVector<FunctionCall> m_data;
+    QList<HeapStatisticsProperties> m_heapData;
+    bool m_heapStatisticsRequested;
+
+    int m_samplingInterval;
+    QAtomicInt m_pendingTicks; // sampling intervals elapsed since the last sample
+    Sampler *m_sampler;
+    QVector<CallTreeNode> m_callTree; // the first node is the root
 
     friend class FunctionCallProfiler;
+    friend class Sampler;
 };
 
 class FunctionCallProfiler {
@@ -147,6 +213,15 @@ public:
 
     static ReturnedValue profileCall(Profiler *profiler, ExecutionContext *ctx, Function *function)
     {
+        if (profiler->m_samplingInterval) {
+            // samples are taken when entering and leaving functions, while the
+            // context chain is consistent (the interpreter also checks at back edges)
+            profiler->checkSample(ctx);
+            ReturnedValue result = function->code(ctx, function->codeData);
+            profiler->checkSample(ctx);
+            return result;
+        }
+
         FunctionCallProfiler callProfiler(profiler, function);
         return function->code(ctx, function->codeData);
     }
@@ -162,8 +237,12 @@ public:
 
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCallProperties, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCall, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QV4::Profiling::HeapStatisticsProperties, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QV4::Profiling::CallTreeEntryProperties, Q_MOVABLE_TYPE);
 
 QT_END_NAMESPACE
 Q_DECLARE_METATYPE(QList<QV4::Profiling::FunctionCallProperties>)
+Q_DECLARE_METATYPE(QList<QV4::Profiling::HeapStatisticsProperties>)
+Q_DECLARE_METATYPE(QList<QV4::Profiling::CallTreeEntryProperties>)
 
 #endif // QV4PROFILING_H
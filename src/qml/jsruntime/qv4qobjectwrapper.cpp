@@ -65,6 +65,7 @@
 #include <private/qv4regexpobject_p.h>
 #include <private/qv4scopedvalue_p.h>
 #include <private/qv4mm_p.h>
+#include <private/qv4lookup_p.h>
 
 #include <QtQml/qjsvalue.h>
 #include <QtCore/qjsonarray.h>
@@ -695,6 +696,99 @@ void QObjectWrapper::put(Managed *m, const StringRef name, const ValueRef value)
     }
 }
 
+// The property a lookup can cache for the property cache of the object: only
+// names nothing else shares resolve independently of the calling context.
+static QQmlPropertyData *cacheableProperty(ExecutionEngine *v4, QObject *object, String *name)
+{
+    if (QQmlData::wasDeleted(object))
+        return 0;
+    QQmlData *ddata = QQmlData::get(object, false);
+    if (!ddata || !ddata->propertyCache || !ddata->propertyCache->isUniqueName(name))
+        return 0;
+    if (name->equals(v4->id_destroy) || name->equals(v4->id_toString))
+        return 0;
+    return ddata->propertyCache->property(name, object, 0);
+}
+
+static inline bool hasPropertyCache(QObject *object, QQmlPropertyCache *propertyCache)
+{
+    if (QQmlData::wasDeleted(object))
+        return false;
+    QQmlData *ddata = QQmlData::get(object, false);
+    return ddata && ddata->propertyCache == propertyCache;
+}
+
+ReturnedValue QObjectWrapper::getLookup(Managed *m, Lookup *l)
+{
+    QObjectWrapper *that = static_cast<QObjectWrapper*>(m);
+    ExecutionEngine *v4 = m->engine();
+    QObject *object = that->m_object;
+
+    if (QQmlPropertyData *property = cacheableProperty(v4, object, l->name)) {
+        l->propertyCache = QQmlData::get(object)->propertyCache;
+        l->propertyCache->addref();
+        l->propertyData = property;
+        l->getter = lookupGetter;
+        return getProperty(object, v4->currentContext(), property);
+    }
+
+    Scope scope(v4);
+    ScopedString name(scope, l->name);
+    return get(m, name, 0);
+}
+
+void QObjectWrapper::setLookup(Managed *m, Lookup *l, const ValueRef value)
+{
+    QObjectWrapper *that = static_cast<QObjectWrapper*>(m);
+    ExecutionEngine *v4 = m->engine();
+    QObject *object = that->m_object;
+
+    if (!v4->hasException) {
+        if (QQmlPropertyData *property = cacheableProperty(v4, object, l->name)) {
+            l->propertyCache = QQmlData::get(object)->propertyCache;
+            l->propertyCache->addref();
+            l->propertyData = property;
+            l->setter = lookupSetter;
+            setProperty(object, v4->currentContext(), property, value);
+            return;
+        }
+    }
+
+    Scope scope(v4);
+    ScopedString name(scope, l->name);
+    put(m, name, value);
+}
+
+ReturnedValue QObjectWrapper::lookupGetter(Lookup *l, const ValueRef object)
+{
+    if (QObjectWrapper *wrapper = object->as<QObjectWrapper>()) {
+        QObject *qobject = wrapper->m_object;
+        if (hasPropertyCache(qobject, l->propertyCache)) {
+            V4_LOOKUP_HIT(l);
+            return getProperty(qobject, wrapper->engine()->currentContext(), l->propertyData);
+        }
+    }
+
+    l->releasePropertyCache();
+    return Lookup::getterGeneric(l, object);
+}
+
+void QObjectWrapper::lookupSetter(Lookup *l, const ValueRef object, const ValueRef value)
+{
+    if (QObjectWrapper *wrapper = object->as<QObjectWrapper>()) {
+        QObject *qobject = wrapper->m_object;
+        ExecutionEngine *v4 = wrapper->engine();
+        if (!v4->hasException && hasPropertyCache(qobject, l->propertyCache)) {
+            V4_LOOKUP_HIT(l);
+            setProperty(qobject, v4->currentContext(), l->propertyData, value);
+            return;
+        }
+    }
+
+    l->releasePropertyCache();
+    Lookup::setterGeneric(l, object, value);
+}
+
 PropertyAttributes QObjectWrapper::query(const Managed *m, StringRef name)
 {
     const QObjectWrapper *that = static_cast<const QObjectWrapper*>(m);
@@ -97,6 +97,10 @@ struct Q_QML_EXPORT QObjectWrapper : public QV4::Object
     static ReturnedValue getProperty(QObject *object, ExecutionContext *ctx, int propertyIndex, bool captureRequired);
     void setProperty(ExecutionContext *ctx, int propertyIndex, const ValueRef value);
 
+    // Lookups of a property on objects sharing the property cache the lookup was resolved on.
+    static ReturnedValue lookupGetter(Lookup *l, const ValueRef object);
+    static void lookupSetter(Lookup *l, const ValueRef object, const ValueRef value);
+
 protected:
     static bool isEqualTo(Managed *that, Managed *o);
 
@@ -114,6 +118,8 @@ private:
 
     static ReturnedValue get(Managed *m, const StringRef name, bool *hasProperty);
     static void put(Managed *m, const StringRef name, const ValueRef value);
+    static ReturnedValue getLookup(Managed *m, Lookup *l);
+    static void setLookup(Managed *m, Lookup *l, const ValueRef value);
     static PropertyAttributes query(const Managed *, StringRef name);
     static void advanceIterator(Managed *m, ObjectIterator *it, StringRef name, uint *index, Property *p, PropertyAttributes *attributes);
     static void markObjects(Managed *that, QV4::ExecutionEngine *e);
@@ -53,6 +53,18 @@ RegExpCache::~RegExpCache()
     clear();
 }
 
+void RegExpCache::removeUnmarked()
+{
+    for (RegExpCache::Iterator it = begin(); it != end();) {
+        if (!it.value()->markBit) {
+            it.value()->m_cache = 0;
+            it = erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 DEFINE_MANAGED_VTABLE(RegExp);
 
 uint RegExp::match(const QString &string, int start, uint *matchOffsets)
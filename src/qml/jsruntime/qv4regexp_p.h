@@ -89,6 +89,8 @@ class RegExpCache : public QHash<RegExpCacheKey, RegExp*>
 {
 public:
     ~RegExpCache();
+
+    void removeUnmarked();
 };
 
 class RegExp : public Managed
@@ -54,6 +54,7 @@
 #include "qv4scopedvalue_p.h"
 #include <private/qqmlcontextwrapper_p.h>
 #include "qv4qobjectwrapper_p.h"
+#include "qv4typedarray_p.h"
 #include <private/qv8engine_p.h>
 #endif
 
@@ -271,6 +272,20 @@ ReturnedValue Runtime::closure(ExecutionContext *ctx, int functionId)
     return f->asReturnedValue();
 }
 
+// Used by inlined calls: checks that value still is the closure the inlined body was taken from,
+// created in the scope the caller sees scopeDepth contexts up from ctx.
+ReturnedValue Runtime::isClosure(ExecutionContext *ctx, const ValueRef value, int functionId, int scopeDepth)
+{
+    FunctionObject *f = value->asFunctionObject();
+    if (!f || f->function != ctx->compilationUnit->runtimeFunctions[functionId])
+        return Encode(false);
+
+    ExecutionContext *scope = ctx;
+    for (int i = 0; i < scopeDepth && scope; ++i)
+        scope = scope->outer;
+    return Encode(f->scope == scope);
+}
+
 ReturnedValue Runtime::deleteElement(ExecutionContext *ctx, const ValueRef base, const ValueRef index)
 {
     Scope scope(ctx);
@@ -603,6 +618,25 @@ ReturnedValue Runtime::getElement(ExecutionContext *ctx, const ValueRef object,
     return o->get(name);
 }
 
+ReturnedValue Runtime::getArrayElement(ExecutionContext *ctx, const ValueRef object, const ValueRef index)
+{
+    // Fast path for numeric subscripts into dense arrays: the bounds check and the
+    // hole check are the only guards, everything else goes through getElement().
+    uint idx = index->isInteger() ? static_cast<uint>(index->integerValue()) : index->asArrayIndex();
+    if (Object *o = object->asObject()) {
+        if (o->arrayData && o->arrayData->type == ArrayData::Simple
+                && idx < static_cast<SimpleArrayData *>(o->arrayData)->len) {
+            const Value v = o->arrayData->data[idx];
+            if (!v.isEmpty())
+                return v.asReturnedValue();
+        } else if (TypedArray *a = o->as<TypedArray>()) {
+            if (idx < a->length())
+                return a->type().read(a->constData(), idx);
+        }
+    }
+    return getElement(ctx, object, index);
+}
+
 void Runtime::setElement(ExecutionContext *ctx, const ValueRef object, const ValueRef index, const ValueRef value)
 {
     Scope scope(ctx);
@@ -615,9 +649,16 @@ void Runtime::setElement(ExecutionContext *ctx, const ValueRef object, const Val
         if (o->arrayType() == ArrayData::Simple) {
             SimpleArrayData *s = static_cast<SimpleArrayData *>(o->arrayData);
             if (s && idx < s->len && !s->data[idx].isEmpty()) {
+                s->prepareStore(idx, *value);
                 s->data[idx] = value;
                 return;
             }
+        } else if (value->isNumber()) {
+            if (TypedArray *a = o->as<TypedArray>()) {
+                if (idx < a->length())
+                    a->type().write(a->writableData(), idx, value->toNumber());
+                return;
+            }
         }
         o->putIndexed(idx, value);
         return;
@@ -1192,6 +1233,13 @@ QV4::ReturnedValue Runtime::setupArgumentsObject(ExecutionContext *ctx)
     return (new (c->engine->memoryManager) ArgumentsObject(c))->asReturnedValue();
 }
 
+// Used instead of arguments.length when the arguments object itself is optimized away.
+QV4::ReturnedValue Runtime::argumentCount(ExecutionContext *ctx)
+{
+    Q_ASSERT(ctx->type >= ExecutionContext::Type_CallContext);
+    return Encode(static_cast<CallContext *>(ctx)->realArgumentCount);
+}
+
 #endif // V4_BOOTSTRAP
 
 QV4::ReturnedValue Runtime::increment(const QV4::ValueRef value)
@@ -1275,7 +1323,7 @@ unsigned Runtime::doubleToUInt(const double &d)
 
 ReturnedValue Runtime::regexpLiteral(ExecutionContext *ctx, int id)
 {
-    return ctx->compilationUnit->runtimeRegularExpressions[id].asReturnedValue();
+    return ctx->compilationUnit->runtimeRegularExpression(id);
 }
 
 ReturnedValue Runtime::getQmlIdArray(NoThrowContext *ctx)
@@ -126,6 +126,7 @@ struct Q_QML_PRIVATE_EXPORT Runtime {
     static ReturnedValue getProperty(ExecutionContext *ctx, const ValueRef object, const StringRef name);
     static ReturnedValue getActivationProperty(ExecutionContext *ctx, const StringRef name);
     static ReturnedValue getElement(ExecutionContext *ctx, const ValueRef object, const ValueRef index);
+    static ReturnedValue getArrayElement(ExecutionContext *ctx, const ValueRef object, const ValueRef index);
 
     // typeof
     static ReturnedValue typeofValue(ExecutionContext *ctx, const ValueRef val);
@@ -147,10 +148,12 @@ struct Q_QML_PRIVATE_EXPORT Runtime {
 
     // closures
     static ReturnedValue closure(ExecutionContext *ctx, int functionId);
+    static ReturnedValue isClosure(ExecutionContext *ctx, const ValueRef value, int functionId, int scopeDepth);
 
     // function header
     static void declareVar(ExecutionContext *ctx, bool deletable, const StringRef name);
     static ReturnedValue setupArgumentsObject(ExecutionContext *ctx);
+    static ReturnedValue argumentCount(ExecutionContext *ctx);
     static void convertThisToObject(ExecutionContext *ctx);
 
     // literals
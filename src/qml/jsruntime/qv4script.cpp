@@ -342,6 +342,23 @@ Function *Script::function()
     return vmFunction;
 }
 
+namespace {
+// Scripts imported by QML documents run in the QML context of the importing component, so
+// names that are not declared in the script may refer to ids and context properties. Look
+// them up by name through the scope chain instead of compiling them to global lookups.
+class ImportedScriptCodegen : public QQmlJS::Codegen
+{
+public:
+    ImportedScriptCodegen() : QQmlJS::Codegen(/*strict mode*/false) {}
+
+protected:
+    virtual IR::Expr *fallbackNameLookup(const QString &name, int line, int col)
+    {
+        return _block->NAME(name, line, col);
+    }
+};
+}
+
 QV4::CompiledData::CompilationUnit *Script::precompile(IR::Module *module, Compiler::JSUnitGenerator *unitGenerator, ExecutionEngine *engine, const QUrl &url, const QString &source, QList<QQmlError> *reportedErrors)
 {
     using namespace QQmlJS;
@@ -383,7 +400,7 @@ QV4::CompiledData::CompilationUnit *Script::precompile(IR::Module *module, Compi
         return 0;
     }
 
-    QQmlJS::Codegen cg(/*strict mode*/false);
+    ImportedScriptCodegen cg;
     cg.generateFromProgram(url.toString(), source, program, module, QQmlJS::Codegen::EvalCode);
     errors = cg.qmlErrors();
     if (!errors.isEmpty()) {
@@ -393,7 +410,6 @@ QV4::CompiledData::CompilationUnit *Script::precompile(IR::Module *module, Compi
     }
 
     QScopedPointer<EvalInstructionSelection> isel(engine->iselFactory->create(QQmlEnginePrivate::get(engine), engine->executableAllocator, module, unitGenerator));
-    isel->setUseFastLookups(false);
     return isel->compile(/*generate unit data*/false);
 }
 
@@ -145,7 +145,7 @@ void StringObject::advanceIterator(Managed *m, ObjectIterator *it, StringRef nam
             *index = it->arrayIndex;
             ++it->arrayIndex;
             PropertyAttributes a;
-            Property *pd = s->__getOwnProperty__(*index, &a);
+            const Property *pd = s->__getOwnProperty__(*index, &a);
             if (!(it->flags & ObjectIterator::EnumerableOnly) || a.isEnumerable()) {
                 *attrs = a;
                 p->copy(*pd, a);
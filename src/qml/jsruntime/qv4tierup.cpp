@@ -0,0 +1,191 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4tierup_p.h"
+#include "qv4engine_p.h"
+#include "qv4function_p.h"
+#include <private/qv4isel_p.h>
+#include <private/qqmlengine_p.h>
+
+#include <QRunnable>
+
+using namespace QV4;
+
+struct TierUpCompiler::Job : public QRunnable
+{
+    Job(TierUpCompiler *compiler, Function *function)
+        : compiler(compiler)
+        , function(function)
+        , code(0)
+    {
+        setAutoDelete(false);
+        CompiledData::CompilationUnit *unit = function->compilationUnit;
+        unit->ref();
+        // The interpreter keeps recording while the job runs.
+        typeFeedback = QByteArray(reinterpret_cast<const char *>(unit->runtimeTypeFeedback),
+                                  unit->recompilationData->typeFeedbackSlotCount);
+    }
+
+    ~Job()
+    {
+        delete code;
+        function->compilationUnit->deref();
+    }
+
+    void run()
+    {
+        code = compiler->compile(function, reinterpret_cast<const uchar *>(typeFeedback.constData()));
+        compiler->finished(this);
+    }
+
+    TierUpCompiler *compiler;
+    Function *function;
+    QByteArray typeFeedback;
+    CompiledData::CompilationUnit *code;
+};
+
+TierUpCompiler::TierUpCompiler(ExecutionEngine *engine, EvalISelFactory *factory, uint callThreshold)
+    : m_engine(engine)
+    , m_factory(factory)
+    , m_callThreshold(callThreshold)
+    , m_backEdgeThreshold(callThreshold * BackEdgesPerCall)
+    , m_compiledFunctions(0)
+    , m_finishedJobs(0)
+{
+    Q_ASSERT(callThreshold > 0);
+    m_threadPool.setMaxThreadCount(1);
+}
+
+TierUpCompiler::~TierUpCompiler()
+{
+    m_threadPool.waitForDone();
+    qDeleteAll(m_pendingJobs);
+}
+
+// Units that kept no IR, for example because they were loaded from the disk cache, stay
+// interpreted. So do the units whose IR can only be compiled on the engine's thread, their
+// functions are compiled right away.
+void TierUpCompiler::functionIsHot(Function *function)
+{
+    if (function->tierUpRequested)
+        return;
+    function->tierUpRequested = true;
+
+    CompiledData::CompilationUnit *unit = function->compilationUnit;
+    RecompilationData *recompilationData = unit->recompilationData;
+    if (!recompilationData || !recompilationData->module)
+        return;
+
+    if (!recompilationData->backgroundRecompilation) {
+        if (CompiledData::CompilationUnit *code = compile(function, unit->runtimeTypeFeedback))
+            install(function, code);
+        return;
+    }
+
+    Job *job = new Job(this, function);
+    m_pendingJobs.append(job);
+    m_threadPool.start(job);
+}
+
+void TierUpCompiler::installFinishedJobs()
+{
+    QVector<Job *> doneJobs;
+    {
+        QMutexLocker locker(&m_mutex);
+        qSwap(doneJobs, m_doneJobs);
+        m_finishedJobs.store(0);
+    }
+
+    foreach (Job *job, doneJobs) {
+        m_pendingJobs.removeOne(job);
+        if (job->code) {
+            install(job->function, job->code);
+            job->code = 0;
+        }
+        delete job;
+    }
+}
+
+void TierUpCompiler::waitForDone()
+{
+    m_threadPool.waitForDone();
+    installFinishedJobs();
+}
+
+CompiledData::CompilationUnit *TierUpCompiler::compile(Function *function, const uchar *typeFeedback)
+{
+    CompiledData::CompilationUnit *unit = function->compilationUnit;
+    RecompilationData *recompilationData = unit->recompilationData;
+    const int functionIndex = unit->runtimeFunctions.indexOf(function);
+    Q_ASSERT(functionIndex >= 0);
+
+    QScopedPointer<EvalInstructionSelection> isel(m_factory->create(QQmlEnginePrivate::get(m_engine), m_engine->executableAllocator, recompilationData->module.data(), /*jsGenerator*/0));
+    isel->setUseFastLookups(recompilationData->useFastLookups);
+    return isel->recompile(functionIndex, unit->data, recompilationData->lookupSites, typeFeedback);
+}
+
+// Makes later calls of the function run the new code. Calls that are already running
+// stay in the interpreter.
+void TierUpCompiler::install(Function *function, CompiledData::CompilationUnit *code)
+{
+    CompiledData::CompilationUnit *unit = function->compilationUnit;
+    if (!unit->engine) {
+        delete code;
+        return;
+    }
+
+    code->ref();
+    unit->recompilationData->recompiledUnits.append(code);
+
+    // Generated code reads runtime strings directly instead of resolving them on first use.
+    for (uint i = 0; i < unit->data->stringTableSize; ++i)
+        unit->runtimeString(i);
+
+    code->replaceCode(unit->runtimeFunctions.indexOf(function), function);
+    ++m_compiledFunctions;
+}
+
+void TierUpCompiler::finished(Job *job)
+{
+    QMutexLocker locker(&m_mutex);
+    m_doneJobs.append(job);
+    m_finishedJobs.store(1);
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4TIERUP_H
+#define QV4TIERUP_H
+
+#include "qv4global_p.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QThreadPool>
+#include <QList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QQmlEnginePrivate;
+
+namespace QV4 {
+
+struct ExecutionEngine;
+struct Function;
+class EvalISelFactory;
+
+namespace CompiledData {
+struct CompilationUnit;
+}
+
+// Recompiles functions that the interpreter found to be hot with the JIT. Units are
+// compiled for the interpreter, which counts calls and loop iterations per function.
+// When a function crosses the threshold, it is compiled again in the background from
+// the IR its unit kept and the type feedback recorded so far. The new code is installed
+// on the engine's thread, the next time the interpreter is entered.
+class Q_QML_PRIVATE_EXPORT TierUpCompiler
+{
+public:
+    enum {
+        DefaultCallThreshold = 10,
+        // The number of backward jumps that count as much as one call.
+        BackEdgesPerCall = 100
+    };
+
+    TierUpCompiler(ExecutionEngine *engine, EvalISelFactory *factory, uint callThreshold);
+    ~TierUpCompiler();
+
+    uint callThreshold() const { return m_callThreshold; }
+    uint backEdgeThreshold() const { return m_backEdgeThreshold; }
+
+    // Called by the interpreter once a function crossed one of the thresholds.
+    void functionIsHot(Function *function);
+
+    bool hasFinishedJobs() const { return m_finishedJobs.load() != 0; }
+    void installFinishedJobs();
+
+    // Blocks until all requested functions are compiled, and installs their code.
+    void waitForDone();
+
+    uint compiledFunctionCount() const { return m_compiledFunctions; }
+
+private:
+    struct Job;
+    friend struct Job;
+
+    CompiledData::CompilationUnit *compile(Function *function, const uchar *typeFeedback);
+    void install(Function *function, CompiledData::CompilationUnit *code);
+    void finished(Job *job);
+
+    ExecutionEngine *m_engine;
+    QScopedPointer<EvalISelFactory> m_factory;
+    uint m_callThreshold;
+    uint m_backEdgeThreshold;
+    uint m_compiledFunctions;
+
+    // Jobs share the IR modules of the units, so only one of them runs at a time.
+    QThreadPool m_threadPool;
+    QMutex m_mutex;
+    QList<Job *> m_pendingJobs;
+    QVector<Job *> m_doneJobs; // guarded by m_mutex
+    QAtomicInt m_finishedJobs;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif // QV4TIERUP_H
@@ -0,0 +1,439 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4typedarray_p.h"
+#include "qv4scopedvalue_p.h"
+#include "qv4mm_p.h"
+
+#include <QtCore/qnumeric.h>
+
+#include <cmath>
+
+using namespace QV4;
+
+DEFINE_OBJECT_VTABLE(TypedArrayCtor);
+DEFINE_OBJECT_VTABLE(TypedArray);
+
+template <typename T>
+static ReturnedValue readInteger(const char *data, uint index)
+{
+    return Encode(int(reinterpret_cast<const T *>(data)[index]));
+}
+
+static ReturnedValue readUInt32(const char *data, uint index)
+{
+    return Encode(uint(reinterpret_cast<const quint32 *>(data)[index]));
+}
+
+// The buffer can hold NaNs with any payload, which must not be mistaken for the
+// tags of other values.
+template <typename T>
+static ReturnedValue readFloat(const char *data, uint index)
+{
+    double d = reinterpret_cast<const T *>(data)[index];
+    if (qIsNaN(d))
+        return Encode(qQNaN());
+    return Encode(d);
+}
+
+// ToInt32 wraps modulo 2^32, the narrower integer types keep its low bits.
+template <typename T>
+static void writeInteger(char *data, uint index, double value)
+{
+    reinterpret_cast<T *>(data)[index] = T(Primitive::toInt32(value));
+}
+
+// Clamps to 0..255 and rounds half to even.
+static void writeUInt8Clamped(char *data, uint index, double value)
+{
+    quint8 c;
+    if (!(value > 0)) {
+        c = 0; // also for NaN
+    } else if (value >= 255) {
+        c = 255;
+    } else {
+        double f = std::floor(value);
+        double d = value - f;
+        c = quint8(f);
+        if (d > 0.5 || (d == 0.5 && (c & 1)))
+            ++c;
+    }
+    reinterpret_cast<quint8 *>(data)[index] = c;
+}
+
+template <typename T>
+static void writeFloat(char *data, uint index, double value)
+{
+    reinterpret_cast<T *>(data)[index] = T(value);
+}
+
+const TypedArrayOperations TypedArray::operations[TypedArray::NTypes] = {
+    { 1, "Int8Array", readInteger<qint8>, writeInteger<qint8> },
+    { 1, "Uint8Array", readInteger<quint8>, writeInteger<quint8> },
+    { 1, "Uint8ClampedArray", readInteger<quint8>, writeUInt8Clamped },
+    { 2, "Int16Array", readInteger<qint16>, writeInteger<qint16> },
+    { 2, "Uint16Array", readInteger<quint16>, writeInteger<quint16> },
+    { 4, "Int32Array", readInteger<qint32>, writeInteger<qint32> },
+    { 4, "Uint32Array", readUInt32, writeInteger<quint32> },
+    { 4, "Float32Array", readFloat<float>, writeFloat<float> },
+    { 8, "Float64Array", readFloat<double>, writeFloat<double> }
+};
+
+static inline double numberValue(ReturnedValue v)
+{
+    return Value::fromReturnedValue(v).toNumber();
+}
+
+TypedArray::TypedArray(ExecutionEngine *engine, Type t)
+    : Object(engine->typedArrayClasses[t])
+    , buffer(0)
+    , byteLength(0)
+    , byteOffset(0)
+{
+    subtype = t;
+}
+
+Returned<TypedArray> *TypedArray::create(ExecutionEngine *engine, Type t, const QByteArray &data)
+{
+    Scope scope(engine);
+    Scoped<ArrayBuffer> buffer(scope, engine->newArrayBuffer(data));
+    TypedArray *array = new (engine->memoryManager) TypedArray(engine, t);
+    array->buffer = buffer.getPointer();
+    array->byteLength = buffer->byteLength() / array->type().bytesPerElement * array->type().bytesPerElement;
+    return array->asReturned<TypedArray>();
+}
+
+ReturnedValue TypedArray::getIndexed(Managed *m, uint index, bool *hasProperty)
+{
+    TypedArray *a = static_cast<TypedArray *>(m);
+    if (index >= a->length()) {
+        if (hasProperty)
+            *hasProperty = false;
+        return Encode::undefined();
+    }
+
+    if (hasProperty)
+        *hasProperty = true;
+    return a->type().read(a->constData(), index);
+}
+
+void TypedArray::putIndexed(Managed *m, uint index, const ValueRef value)
+{
+    ExecutionEngine *v4 = m->engine();
+    if (v4->hasException)
+        return;
+
+    TypedArray *a = static_cast<TypedArray *>(m);
+    double d = value->toNumber();
+    if (v4->hasException || index >= a->length())
+        return;
+    a->type().write(a->writableData(), index, d);
+}
+
+PropertyAttributes TypedArray::queryIndexed(const Managed *m, uint index)
+{
+    const TypedArray *a = static_cast<const TypedArray *>(m);
+    if (index < a->length())
+        return Attr_NotConfigurable;
+    return Attr_Invalid;
+}
+
+uint TypedArray::getLength(const Managed *m)
+{
+    return static_cast<const TypedArray *>(m)->length();
+}
+
+void TypedArray::markObjects(Managed *that, ExecutionEngine *e)
+{
+    TypedArray *a = static_cast<TypedArray *>(that);
+    if (a->buffer)
+        a->buffer->mark(e);
+
+    Object::markObjects(that, e);
+}
+
+TypedArrayCtor::TypedArrayCtor(ExecutionContext *scope, TypedArray::Type t)
+    : FunctionObject(scope, QString::fromLatin1(TypedArray::operations[t].name))
+    , type(t)
+{
+    setVTable(staticVTable());
+}
+
+ReturnedValue TypedArrayCtor::construct(Managed *m, CallData *callData)
+{
+    ExecutionEngine *v4 = m->engine();
+    Scope scope(v4);
+    const TypedArray::Type type = static_cast<TypedArrayCtor *>(m)->type;
+    const TypedArrayOperations &operations = TypedArray::operations[type];
+    const uint elementSize = operations.bytesPerElement;
+
+    Scoped<ArrayBuffer> buffer(scope, callData->argument(0));
+    if (!!buffer) {
+        // a view on the buffer: (buffer, byteOffset, length)
+        ScopedValue v(scope, callData->argument(1));
+        double offset = v->toInteger();
+        v = callData->argument(2);
+        double length = v->isUndefined() ? -1 : v->toInteger();
+        if (v4->hasException)
+            return Encode::undefined();
+
+        const uint bufferLength = buffer->byteLength();
+        if (offset < 0 || offset > bufferLength || uint(offset) % elementSize)
+            return v4->currentContext()->throwRangeError(QStringLiteral("TypedArray: invalid byteOffset"));
+        const uint byteOffset = uint(offset);
+
+        uint byteLength;
+        if (v->isUndefined()) {
+            byteLength = bufferLength - byteOffset;
+            if (byteLength % elementSize)
+                return v4->currentContext()->throwRangeError(QStringLiteral("TypedArray: invalid length"));
+        } else {
+            if (length < 0 || byteOffset + length * elementSize > bufferLength)
+                return v4->currentContext()->throwRangeError(QStringLiteral("TypedArray: invalid length"));
+            byteLength = uint(length) * elementSize;
+        }
+
+        Scoped<TypedArray> array(scope, new (v4->memoryManager) TypedArray(v4, type));
+        array->buffer = buffer.getPointer();
+        array->byteOffset = byteOffset;
+        array->byteLength = byteLength;
+        return array.asReturnedValue();
+    }
+
+    // otherwise the array gets a buffer of its own, with the length or the elements of the argument
+    Scoped<TypedArray> source(scope, callData->argument(0));
+    ScopedObject arrayLike(scope, callData->argument(0));
+    double length;
+    if (!!source) {
+        length = source->length();
+    } else if (!!arrayLike) {
+        length = arrayLike->getLength();
+    } else {
+        ScopedValue v(scope, callData->argument(0));
+        length = v->toInteger();
+        if (v4->hasException)
+            return Encode::undefined();
+    }
+    if (length < 0 || length > INT_MAX / elementSize)
+        return v4->currentContext()->throwRangeError(QStringLiteral("TypedArray: invalid length"));
+    const uint len = uint(length);
+
+    buffer = v4->newArrayBuffer(len * elementSize);
+    Scoped<TypedArray> array(scope, new (v4->memoryManager) TypedArray(v4, type));
+    array->buffer = buffer.getPointer();
+    array->byteLength = len * elementSize;
+
+    if (!!source) {
+        char *dest = array->writableData();
+        if (source->arrayType() == type) {
+            memcpy(dest, source->constData(), array->byteLength);
+        } else {
+            const TypedArrayOperations &sourceOperations = source->type();
+            const char *src = source->constData();
+            for (uint i = 0; i < len; ++i)
+                operations.write(dest, i, numberValue(sourceOperations.read(src, i)));
+        }
+    } else if (!!arrayLike) {
+        ScopedValue v(scope);
+        for (uint i = 0; i < len; ++i) {
+            v = arrayLike->getIndexed(i);
+            double d = v->toNumber();
+            if (v4->hasException)
+                return Encode::undefined();
+            operations.write(array->writableData(), i, d);
+        }
+    }
+    return array.asReturnedValue();
+}
+
+ReturnedValue TypedArrayCtor::call(Managed *that, CallData *)
+{
+    return that->engine()->currentContext()->throwTypeError();
+}
+
+TypedArrayPrototype::TypedArrayPrototype(InternalClass *ic, TypedArray::Type t)
+    : Object(ic)
+    , type(t)
+{
+}
+
+void TypedArrayPrototype::init(ExecutionEngine *engine, ObjectRef ctor)
+{
+    Scope scope(engine);
+    ScopedObject o(scope);
+    ScopedValue bytesPerElement(scope, Primitive::fromInt32(TypedArray::operations[type].bytesPerElement));
+    ctor->defineReadonlyProperty(engine->id_length, Primitive::fromInt32(3));
+    ctor->defineReadonlyProperty(engine->id_prototype, (o = this));
+    ctor->defineReadonlyProperty(QStringLiteral("BYTES_PER_ELEMENT"), bytesPerElement);
+    defineDefaultProperty(QStringLiteral("constructor"), (o = ctor));
+    defineReadonlyProperty(QStringLiteral("BYTES_PER_ELEMENT"), bytesPerElement);
+    defineAccessorProperty(QStringLiteral("buffer"), method_get_buffer, 0);
+    defineAccessorProperty(QStringLiteral("byteLength"), method_get_byteLength, 0);
+    defineAccessorProperty(QStringLiteral("byteOffset"), method_get_byteOffset, 0);
+    defineAccessorProperty(QStringLiteral("length"), method_get_length, 0);
+    defineDefaultProperty(QStringLiteral("set"), method_set, 1);
+    defineDefaultProperty(QStringLiteral("subarray"), method_subarray, 2);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_buffer(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return v->buffer->asReturnedValue();
+}
+
+ReturnedValue TypedArrayPrototype::method_get_byteLength(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteLength);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_byteOffset(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->byteOffset);
+}
+
+ReturnedValue TypedArrayPrototype::method_get_length(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> v(scope, ctx->callData->thisObject);
+    if (!v)
+        return ctx->throwTypeError();
+
+    return Encode(v->length());
+}
+
+ReturnedValue TypedArrayPrototype::method_set(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    ScopedValue v(scope, ctx->argument(1));
+    double offset = v->toInteger();
+    if (scope.engine->hasException)
+        return Encode::undefined();
+
+    const TypedArrayOperations &operations = a->type();
+    Scoped<TypedArray> source(scope, ctx->argument(0));
+    if (!source) {
+        ScopedObject arrayLike(scope, ctx->argument(0));
+        if (!arrayLike)
+            return ctx->throwTypeError();
+
+        double length = arrayLike->getLength();
+        if (offset < 0 || offset + length > a->length())
+            return ctx->throwRangeError(QStringLiteral("TypedArray.set: out of range"));
+
+        const uint start = uint(offset);
+        for (uint i = 0; i < uint(length); ++i) {
+            v = arrayLike->getIndexed(i);
+            double d = v->toNumber();
+            if (scope.engine->hasException)
+                return Encode::undefined();
+            operations.write(a->writableData(), start + i, d);
+        }
+        return Encode::undefined();
+    }
+
+    const uint len = source->length();
+    if (offset < 0 || offset + len > a->length())
+        return ctx->throwRangeError(QStringLiteral("TypedArray.set: out of range"));
+
+    char *dest = a->writableData();
+    if (source->arrayType() == a->arrayType()) {
+        memmove(dest + uint(offset) * operations.bytesPerElement, source->constData(), source->byteLength);
+        return Encode::undefined();
+    }
+
+    // the source may overlap the destination in the same buffer, convert from a copy
+    QByteArray copy;
+    const char *src = source->constData();
+    if (source->buffer == a->buffer) {
+        copy = QByteArray(src, source->byteLength);
+        src = copy.constData();
+    }
+    const TypedArrayOperations &sourceOperations = source->type();
+    const uint start = uint(offset);
+    for (uint i = 0; i < len; ++i)
+        operations.write(dest, start + i, numberValue(sourceOperations.read(src, i)));
+    return Encode::undefined();
+}
+
+ReturnedValue TypedArrayPrototype::method_subarray(CallContext *ctx)
+{
+    Scope scope(ctx);
+    Scoped<TypedArray> a(scope, ctx->callData->thisObject);
+    if (!a)
+        return ctx->throwTypeError();
+
+    double len = a->length();
+    ScopedValue v(scope, ctx->argument(0));
+    double start = v->toInteger();
+    v = ctx->argument(1);
+    double end = v->isUndefined() ? len : v->toInteger();
+    if (scope.engine->hasException)
+        return Encode::undefined();
+
+    double first = (start < 0) ? qMax(len + start, 0.) : qMin(start, len);
+    double final = (end < 0) ? qMax(len + end, 0.) : qMin(end, len);
+    const uint newLen = uint(qMax(final - first, 0.));
+    const uint elementSize = a->type().bytesPerElement;
+
+    Scoped<TypedArray> array(scope, new (scope.engine->memoryManager) TypedArray(scope.engine, a->arrayType()));
+    array->buffer = a->buffer;
+    array->byteOffset = a->byteOffset + uint(first) * elementSize;
+    array->byteLength = newLen * elementSize;
+    return array.asReturnedValue();
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QV4TYPEDARRAY_H
+#define QV4TYPEDARRAY_H
+
+#include "qv4object_p.h"
+#include "qv4functionobject_p.h"
+#include "qv4arraybuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+
+// Element access for one kind of typed array. The index is not checked, values are
+// written after their conversion to a number.
+struct TypedArrayOperations {
+    typedef ReturnedValue (*Read)(const char *data, uint index);
+    typedef void (*Write)(char *data, uint index, double value);
+
+    int bytesPerElement;
+    const char *name;
+    Read read;
+    Write write;
+};
+
+struct Q_QML_PRIVATE_EXPORT TypedArray : Object
+{
+    V4_OBJECT
+    Q_MANAGED_TYPE(TypedArray)
+
+    enum Type {
+        Int8Array,
+        UInt8Array,
+        UInt8ClampedArray,
+        Int16Array,
+        UInt16Array,
+        Int32Array,
+        UInt32Array,
+        Float32Array,
+        Float64Array,
+        NTypes
+    };
+
+    static const TypedArrayOperations operations[NTypes];
+
+    TypedArray(ExecutionEngine *engine, Type t);
+    // An array of the given type on a buffer that shares the contents of the byte array.
+    static Returned<TypedArray> *create(ExecutionEngine *engine, Type t, const QByteArray &data);
+
+    Type arrayType() const { return Type(subtype); }
+    const TypedArrayOperations &type() const { return operations[subtype]; }
+    uint length() const { return byteLength / type().bytesPerElement; }
+
+    // The elements are only valid until the buffer is written to through another view.
+    const char *constData() const { return buffer->constData() + byteOffset; }
+    char *writableData() { return buffer->writableData() + byteOffset; }
+
+    ArrayBuffer *buffer;
+    uint byteLength;
+    uint byteOffset;
+
+    static ReturnedValue getIndexed(Managed *m, uint index, bool *hasProperty);
+    static void putIndexed(Managed *m, uint index, const ValueRef value);
+    static PropertyAttributes queryIndexed(const Managed *m, uint index);
+    static uint getLength(const Managed *m);
+    static void markObjects(Managed *that, ExecutionEngine *e);
+};
+
+DEFINE_REF(TypedArray, Object);
+
+struct TypedArrayCtor: FunctionObject
+{
+    V4_OBJECT
+    TypedArrayCtor(ExecutionContext *scope, TypedArray::Type t);
+
+    TypedArray::Type type;
+
+    static ReturnedValue construct(Managed *m, CallData *callData);
+    static ReturnedValue call(Managed *that, CallData *callData);
+};
+
+struct TypedArrayPrototype : Object
+{
+    TypedArrayPrototype(InternalClass *ic, TypedArray::Type t);
+    void init(ExecutionEngine *engine, ObjectRef ctor);
+
+    TypedArray::Type type;
+
+    static ReturnedValue method_get_buffer(CallContext *ctx);
+    static ReturnedValue method_get_byteLength(CallContext *ctx);
+    static ReturnedValue method_get_byteOffset(CallContext *ctx);
+    static ReturnedValue method_get_length(CallContext *ctx);
+    static ReturnedValue method_set(CallContext *ctx);
+    static ReturnedValue method_subarray(CallContext *ctx);
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif
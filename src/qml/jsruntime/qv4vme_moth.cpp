@@ -46,6 +46,10 @@
 #include <private/qv4math_p.h>
 #include <private/qv4scopedvalue_p.h>
 #include <private/qv4lookup_p.h>
+#include <private/qv4isel_p.h>
+#include <private/qv4functionobject_p.h>
+#include <private/qv4tierup_p.h>
+#include <private/qv4profiling_p.h>
 #include <iostream>
 
 #include "qv4alloca_p.h"
@@ -158,7 +162,32 @@ Param traceParam(const Param &param)
     if (engine->hasException) \
         goto catchException
 
-QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
+static inline uchar typeFeedbackFor(const QV4::Value *v)
+{
+    if (v->isInteger())
+        return TypeFeedback::Int32;
+    if (v->isDouble())
+        return TypeFeedback::Double;
+    if (v->isString())
+        return TypeFeedback::String;
+    return TypeFeedback::Other;
+}
+
+#define RECORD_TYPE_FEEDBACK(instr) \
+    if (typeFeedback && instr.feedbackSlot >= 0) \
+        typeFeedback[instr.feedbackSlot] |= typeFeedbackFor(VALUEPTR(instr.lhs)) \
+                                            | (typeFeedbackFor(VALUEPTR(instr.rhs)) << TypeFeedback::RightShift)
+
+// Back edges are also where a sampling profiler gets to look at long running loops
+#define COUNT_BACK_EDGE(instr) \
+    if (instr.offset < 0) { \
+        if (profiledFunction && ++profiledFunction->interpreterBackEdgeCount == backEdgeThreshold) \
+            engine->tierUpCompiler->functionIsHot(profiledFunction); \
+        if (sampler) \
+            sampler->checkSample(engine->currentContext()); \
+    }
+
+QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code, QV4::Function *profiledFunction
 #ifdef MOTH_THREADED_INTERPRETER
         , void ***storeJumpTable
 #endif
@@ -192,7 +221,12 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     qDebug("Starting VME with context=%p and code=%p", context, code);
 #endif // DO_TRACE_INSTR
 
-    QV4::StringValue * const runtimeStrings = context->compilationUnit->runtimeStrings;
+    QV4::CompiledData::CompilationUnit * const compilationUnit = context->compilationUnit;
+    uchar * const typeFeedback = compilationUnit->runtimeTypeFeedback;
+    const uint backEdgeThreshold = profiledFunction ? engine->tierUpCompiler->backEdgeThreshold() : 0;
+    QV4::Profiling::Profiler * const sampler = (engine->profiler && engine->profiler->enabled
+                                                && engine->profiler->samplingInterval())
+            ? engine->profiler : 0;
 
     // setup lookup scopes
     int scopeDepth = 0;
@@ -248,12 +282,12 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
 
     MOTH_BEGIN_INSTR(LoadRuntimeString)
 //        TRACE(value, "%s", instr.value.toString(context)->toQString().toUtf8().constData());
-        VALUE(instr.result) = runtimeStrings[instr.stringId].asReturnedValue();
+        VALUE(instr.result) = compilationUnit->runtimeString(instr.stringId).asReturnedValue();
     MOTH_END_INSTR(LoadRuntimeString)
 
     MOTH_BEGIN_INSTR(LoadRegExp)
 //        TRACE(value, "%s", instr.value.toString(context)->toQString().toUtf8().constData());
-        VALUE(instr.result) = context->compilationUnit->runtimeRegularExpressions[instr.regExpId];
+        VALUE(instr.result) = compilationUnit->runtimeRegularExpression(instr.regExpId);
     MOTH_END_INSTR(LoadRegExp)
 
     MOTH_BEGIN_INSTR(LoadClosure)
@@ -261,19 +295,19 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(LoadClosure)
 
     MOTH_BEGIN_INSTR(LoadName)
-        TRACE(inline, "property name = %s", runtimeStrings[instr.name]->toQString().toUtf8().constData());
-        STOREVALUE(instr.result, Runtime::getActivationProperty(context, runtimeStrings[instr.name]));
+        TRACE(inline, "property name = %s", compilationUnit->runtimeString(instr.name)->toQString().toUtf8().constData());
+        STOREVALUE(instr.result, Runtime::getActivationProperty(context, compilationUnit->runtimeString(instr.name)));
     MOTH_END_INSTR(LoadName)
 
     MOTH_BEGIN_INSTR(GetGlobalLookup)
-        TRACE(inline, "property name = %s", runtimeStrings[instr.name]->toQString().toUtf8().constData());
+        TRACE(inline, "property name = %s", compilationUnit->runtimeString(instr.name)->toQString().toUtf8().constData());
         QV4::Lookup *l = context->lookups + instr.index;
         STOREVALUE(instr.result, l->globalGetter(l, context));
     MOTH_END_INSTR(GetGlobalLookup)
 
     MOTH_BEGIN_INSTR(StoreName)
-        TRACE(inline, "property name = %s", runtimeStrings[instr.name]->toQString().toUtf8().constData());
-        Runtime::setActivationProperty(context, runtimeStrings[instr.name], VALUEPTR(instr.source));
+        TRACE(inline, "property name = %s", compilationUnit->runtimeString(instr.name)->toQString().toUtf8().constData());
+        Runtime::setActivationProperty(context, compilationUnit->runtimeString(instr.name), VALUEPTR(instr.source));
         CHECK_EXCEPTION;
     MOTH_END_INSTR(StoreName)
 
@@ -286,6 +320,10 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
         STOREVALUE(instr.result, l->indexedGetter(l, VALUEPTR(instr.base), VALUEPTR(instr.index)));
     MOTH_END_INSTR(LoadElementLookup)
 
+    MOTH_BEGIN_INSTR(LoadArrayElement)
+        STOREVALUE(instr.result, Runtime::getArrayElement(context, VALUEPTR(instr.base), VALUEPTR(instr.index)));
+    MOTH_END_INSTR(LoadArrayElement)
+
     MOTH_BEGIN_INSTR(StoreElement)
         Runtime::setElement(context, VALUEPTR(instr.base), VALUEPTR(instr.index), VALUEPTR(instr.source));
         CHECK_EXCEPTION;
@@ -298,7 +336,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(StoreElementLookup)
 
     MOTH_BEGIN_INSTR(LoadProperty)
-        STOREVALUE(instr.result, Runtime::getProperty(context, VALUEPTR(instr.base), runtimeStrings[instr.name]));
+        STOREVALUE(instr.result, Runtime::getProperty(context, VALUEPTR(instr.base), compilationUnit->runtimeString(instr.name)));
     MOTH_END_INSTR(LoadProperty)
 
     MOTH_BEGIN_INSTR(GetLookup)
@@ -307,7 +345,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(GetLookup)
 
     MOTH_BEGIN_INSTR(StoreProperty)
-        Runtime::setProperty(context, VALUEPTR(instr.base), runtimeStrings[instr.name], VALUEPTR(instr.source));
+        Runtime::setProperty(context, VALUEPTR(instr.base), compilationUnit->runtimeString(instr.name), VALUEPTR(instr.source));
         CHECK_EXCEPTION;
     MOTH_END_INSTR(StoreProperty)
 
@@ -360,17 +398,17 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallValue)
 
     MOTH_BEGIN_INSTR(CallProperty)
-        TRACE(property name, "%s, args=%u, argc=%u, this=%s", qPrintable(runtimeStrings[instr.name]->toQString()), instr.callData, instr.argc, (VALUE(instr.base)).toString(context)->toQString().toUtf8().constData());
+        TRACE(property name, "%s, args=%u, argc=%u, this=%s", qPrintable(compilationUnit->runtimeString(instr.name)->toQString()), instr.callData, instr.argc, (VALUE(instr.base)).toString(context)->toQString().toUtf8().constData());
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
         callData->tag = QV4::Value::Integer_Type;
         callData->argc = instr.argc;
         callData->thisObject = VALUE(instr.base);
-        STOREVALUE(instr.result, Runtime::callProperty(context, runtimeStrings[instr.name], callData));
+        STOREVALUE(instr.result, Runtime::callProperty(context, compilationUnit->runtimeString(instr.name), callData));
     MOTH_END_INSTR(CallProperty)
 
     MOTH_BEGIN_INSTR(CallPropertyLookup)
-        TRACE(property name, "%s, args=%u, argc=%u, this=%s", qPrintable(runtimeStrings[instr.name]->toQString()), instr.callData, instr.argc, (VALUE(instr.base)).toString(context)->toQString().toUtf8().constData());
+        TRACE(property name, "%s, args=%u, argc=%u, this=%s", qPrintable(compilationUnit->runtimeString(instr.name)->toQString()), instr.callData, instr.argc, (VALUE(instr.base)).toString(context)->toQString().toUtf8().constData());
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
         callData->tag = QV4::Value::Integer_Type;
@@ -395,7 +433,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
         callData->tag = QV4::Value::Integer_Type;
         callData->argc = instr.argc;
         callData->thisObject = QV4::Primitive::undefinedValue();
-        STOREVALUE(instr.result, Runtime::callActivationProperty(context, runtimeStrings[instr.name], callData));
+        STOREVALUE(instr.result, Runtime::callActivationProperty(context, compilationUnit->runtimeString(instr.name), callData));
     MOTH_END_INSTR(CallActivationProperty)
 
     MOTH_BEGIN_INSTR(CallGlobalLookup)
@@ -422,7 +460,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallBuiltinUnwindException)
 
     MOTH_BEGIN_INSTR(CallBuiltinPushCatchScope)
-        context = Runtime::pushCatchScope(context, runtimeStrings[instr.name]);
+        context = Runtime::pushCatchScope(context, compilationUnit->runtimeString(instr.name));
     MOTH_END_INSTR(CallBuiltinPushCatchScope)
 
     MOTH_BEGIN_INSTR(CallBuiltinPushScope)
@@ -442,7 +480,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallBuiltinForeachNextPropertyName)
 
     MOTH_BEGIN_INSTR(CallBuiltinDeleteMember)
-        STOREVALUE(instr.result, Runtime::deleteMember(context, VALUEPTR(instr.base), runtimeStrings[instr.member]));
+        STOREVALUE(instr.result, Runtime::deleteMember(context, VALUEPTR(instr.base), compilationUnit->runtimeString(instr.member)));
     MOTH_END_INSTR(CallBuiltinDeleteMember)
 
     MOTH_BEGIN_INSTR(CallBuiltinDeleteSubscript)
@@ -450,11 +488,11 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallBuiltinDeleteSubscript)
 
     MOTH_BEGIN_INSTR(CallBuiltinDeleteName)
-        STOREVALUE(instr.result, Runtime::deleteName(context, runtimeStrings[instr.name]));
+        STOREVALUE(instr.result, Runtime::deleteName(context, compilationUnit->runtimeString(instr.name)));
     MOTH_END_INSTR(CallBuiltinDeleteName)
 
     MOTH_BEGIN_INSTR(CallBuiltinTypeofMember)
-        STOREVALUE(instr.result, Runtime::typeofMember(context, VALUEPTR(instr.base), runtimeStrings[instr.member]));
+        STOREVALUE(instr.result, Runtime::typeofMember(context, VALUEPTR(instr.base), compilationUnit->runtimeString(instr.member)));
     MOTH_END_INSTR(CallBuiltinTypeofMember)
 
     MOTH_BEGIN_INSTR(CallBuiltinTypeofSubscript)
@@ -462,7 +500,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallBuiltinTypeofSubscript)
 
     MOTH_BEGIN_INSTR(CallBuiltinTypeofName)
-        STOREVALUE(instr.result, Runtime::typeofName(context, runtimeStrings[instr.name]));
+        STOREVALUE(instr.result, Runtime::typeofName(context, compilationUnit->runtimeString(instr.name)));
     MOTH_END_INSTR(CallBuiltinTypeofName)
 
     MOTH_BEGIN_INSTR(CallBuiltinTypeofValue)
@@ -470,7 +508,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(CallBuiltinTypeofValue)
 
     MOTH_BEGIN_INSTR(CallBuiltinDeclareVar)
-        Runtime::declareVar(context, instr.isDeletable, runtimeStrings[instr.varName]);
+        Runtime::declareVar(context, instr.isDeletable, compilationUnit->runtimeString(instr.varName));
     MOTH_END_INSTR(CallBuiltinDeclareVar)
 
     MOTH_BEGIN_INSTR(CallBuiltinDefineArray)
@@ -488,11 +526,19 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
         STOREVALUE(instr.result, Runtime::setupArgumentsObject(context));
     MOTH_END_INSTR(CallBuiltinSetupArgumentsObject)
 
+    MOTH_BEGIN_INSTR(CallBuiltinArgumentCount)
+        STOREVALUE(instr.result, Runtime::argumentCount(context));
+    MOTH_END_INSTR(CallBuiltinArgumentCount)
+
     MOTH_BEGIN_INSTR(CallBuiltinConvertThisToObject)
         Runtime::convertThisToObject(context);
         CHECK_EXCEPTION;
     MOTH_END_INSTR(CallBuiltinConvertThisToObject)
 
+    MOTH_BEGIN_INSTR(CallBuiltinIsClosure)
+        STOREVALUE(instr.result, Runtime::isClosure(context, VALUEPTR(instr.value), instr.functionId, instr.scopeDepth));
+    MOTH_END_INSTR(CallBuiltinIsClosure)
+
     MOTH_BEGIN_INSTR(CreateValue)
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
@@ -508,7 +554,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
         callData->tag = QV4::Value::Integer_Type;
         callData->argc = instr.argc;
         callData->thisObject = VALUE(instr.base);
-        STOREVALUE(instr.result, Runtime::constructProperty(context, runtimeStrings[instr.name], callData));
+        STOREVALUE(instr.result, Runtime::constructProperty(context, compilationUnit->runtimeString(instr.name), callData));
     MOTH_END_INSTR(CreateProperty)
 
     MOTH_BEGIN_INSTR(ConstructPropertyLookup)
@@ -521,17 +567,17 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(ConstructPropertyLookup)
 
     MOTH_BEGIN_INSTR(CreateActivationProperty)
-        TRACE(inline, "property name = %s, args = %d, argc = %d", runtimeStrings[instr.name]->toQString().toUtf8().constData(), instr.args, instr.argc);
+        TRACE(inline, "property name = %s, args = %d, argc = %d", compilationUnit->runtimeString(instr.name)->toQString().toUtf8().constData(), instr.args, instr.argc);
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
         callData->tag = QV4::Value::Integer_Type;
         callData->argc = instr.argc;
         callData->thisObject = QV4::Primitive::undefinedValue();
-        STOREVALUE(instr.result, Runtime::constructActivationProperty(context, runtimeStrings[instr.name], callData));
+        STOREVALUE(instr.result, Runtime::constructActivationProperty(context, compilationUnit->runtimeString(instr.name), callData));
     MOTH_END_INSTR(CreateActivationProperty)
 
     MOTH_BEGIN_INSTR(ConstructGlobalLookup)
-        TRACE(inline, "property name = %s, args = %d, argc = %d", runtimeStrings[instr.name]->toQString().toUtf8().constData(), instr.args, instr.argc);
+        TRACE(inline, "property name = %s, args = %d, argc = %d", compilationUnit->runtimeString(instr.name)->toQString().toUtf8().constData(), instr.args, instr.argc);
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
         callData->tag = QV4::Value::Integer_Type;
@@ -541,21 +587,26 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(ConstructGlobalLookup)
 
     MOTH_BEGIN_INSTR(Jump)
+        COUNT_BACK_EDGE(instr);
         code = ((uchar *)&instr.offset) + instr.offset;
     MOTH_END_INSTR(Jump)
 
     MOTH_BEGIN_INSTR(JumpEq)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (cond)
+        if (cond) {
+            COUNT_BACK_EDGE(instr);
             code = ((uchar *)&instr.offset) + instr.offset;
+        }
     MOTH_END_INSTR(JumpEq)
 
     MOTH_BEGIN_INSTR(JumpNe)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (!cond)
+        if (!cond) {
+            COUNT_BACK_EDGE(instr);
             code = ((uchar *)&instr.offset) + instr.offset;
+        }
     MOTH_END_INSTR(JumpNe)
 
     MOTH_BEGIN_INSTR(UNot)
@@ -592,10 +643,12 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(Decrement)
 
     MOTH_BEGIN_INSTR(Binop)
+        RECORD_TYPE_FEEDBACK(instr);
         STOREVALUE(instr.result, instr.alu(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Binop)
 
     MOTH_BEGIN_INSTR(Add)
+        RECORD_TYPE_FEEDBACK(instr);
         STOREVALUE(instr.result, Runtime::add(context, VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Add)
 
@@ -643,10 +696,12 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(ShlConst)
 
     MOTH_BEGIN_INSTR(Mul)
+        RECORD_TYPE_FEEDBACK(instr);
         STOREVALUE(instr.result, Runtime::mul(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Mul)
 
     MOTH_BEGIN_INSTR(Sub)
+        RECORD_TYPE_FEEDBACK(instr);
         STOREVALUE(instr.result, Runtime::sub(VALUEPTR(instr.lhs), VALUEPTR(instr.rhs)));
     MOTH_END_INSTR(Sub)
 
@@ -692,7 +747,7 @@ QV4::ReturnedValue VME::run(QV4::ExecutionContext *context, const uchar *code
     MOTH_END_INSTR(LoadScopeObject)
 
     MOTH_BEGIN_INSTR(LoadQmlSingleton)
-        VALUE(instr.result) = Runtime::getQmlSingleton(static_cast<QV4::NoThrowContext*>(context), runtimeStrings[instr.name]);
+        VALUE(instr.result) = Runtime::getQmlSingleton(static_cast<QV4::NoThrowContext*>(context), compilationUnit->runtimeString(instr.name));
     MOTH_END_INSTR(LoadQmlSingleton)
 
 #ifdef MOTH_THREADED_INTERPRETER
@@ -723,7 +778,7 @@ void **VME::instructionJumpTable()
     static void **jumpTable = 0;
     if (!jumpTable) {
         const uchar *code = 0;
-        VME().run(0, code, &jumpTable);
+        VME().run(0, code, 0, &jumpTable);
     }
     return jumpTable;
 }
@@ -732,10 +787,24 @@ void **VME::instructionJumpTable()
 QV4::ReturnedValue VME::exec(QV4::ExecutionContext *ctxt, const uchar *code)
 {
     VME vme;
-    QV4::Debugging::Debugger *debugger = ctxt->engine->debugger;
+    QV4::ExecutionEngine *engine = ctxt->engine;
+    QV4::Function *profiledFunction = 0;
+    if (QV4::TierUpCompiler *tierUpCompiler = engine->tierUpCompiler.data()) {
+        if (tierUpCompiler->hasFinishedJobs())
+            tierUpCompiler->installFinishedJobs();
+        QV4::CallContext *callContext = ctxt->asCallContext();
+        QV4::Function *function = callContext && callContext->function ? callContext->function->function : 0;
+        // The current call stays in the interpreter, later ones run the recompiled code.
+        if (function && function->codeData == code && !function->tierUpRequested) {
+            profiledFunction = function;
+            if (++function->interpreterCallCount == tierUpCompiler->callThreshold())
+                tierUpCompiler->functionIsHot(function);
+        }
+    }
+    QV4::Debugging::Debugger *debugger = engine->debugger;
     if (debugger)
         debugger->enteringFunction();
-    QV4::ReturnedValue retVal = vme.run(ctxt, code);
+    QV4::ReturnedValue retVal = vme.run(ctxt, code, profiledFunction);
     if (debugger)
         debugger->leavingFunction(retVal);
     return retVal;
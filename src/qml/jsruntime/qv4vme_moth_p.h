@@ -60,7 +60,7 @@ public:
 #endif
 
 private:
-    QV4::ReturnedValue run(QV4::ExecutionContext *, const uchar *code
+    QV4::ReturnedValue run(QV4::ExecutionContext *, const uchar *code, QV4::Function *profiledFunction
 #ifdef MOTH_THREADED_INTERPRETER
             , void ***storeJumpTable = 0
 #endif
@@ -55,6 +55,8 @@
 
 #include <QVariant>
 #include <QtCore/qdebug.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qthreadstorage.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -104,8 +106,135 @@ static QQmlJavaScriptExpression::VTable QQmlBinding_jsvtable = {
     QQmlBinding::expressionChanged
 };
 
+/*
+    When QQmlEnginePrivate::deferredBindingUpdates is set, a binding whose
+    dependencies change is not updated from within the change notification.
+    It is queued instead, and the queued bindings of the thread are updated
+    together by QQmlBinding::flushPendingUpdates(), which QQuickWindow calls
+    before polishing the items for a frame. Without a window the queue is
+    flushed from the event loop. A binding that is dirtied several times
+    before the flush is only updated once.
+
+    The queue is bucketed by update rank. A binding dirtied by the update of
+    another binding ranks after it, and ranks are kept across flushes, so
+    that bindings are mostly updated after the bindings they depend on.
+*/
+class QQmlBindingUpdateQueue : public QObject
+{
+public:
+    enum { RankCount = 32, MaxCascadeLength = 1000 };
+
+    QQmlBindingUpdateQueue();
+
+    static QQmlBindingUpdateQueue *instance();
+    static QQmlBindingUpdateQueue *existingInstance();
+
+    void enqueue(QQmlBinding *);
+    void flush();
+
+protected:
+    virtual bool event(QEvent *);
+
+private:
+    typedef QIntrusiveList<QQmlBinding, &QQmlBinding::m_pendingNode> BindingList;
+    BindingList pending[RankCount];
+    int firstRank;
+
+    // Rank and cascade length of the binding being updated, or -1
+    int currentRank;
+    int currentCascadeLength;
+
+    bool flushPosted;
+};
+
+namespace {
+    QThreadStorage<QQmlBindingUpdateQueue *> bindingUpdateQueue;
+}
+
+QQmlBindingUpdateQueue::QQmlBindingUpdateQueue()
+: firstRank(RankCount), currentRank(-1), currentCascadeLength(0), flushPosted(false)
+{
+}
+
+QQmlBindingUpdateQueue *QQmlBindingUpdateQueue::instance()
+{
+    if (!bindingUpdateQueue.hasLocalData())
+        bindingUpdateQueue.setLocalData(new QQmlBindingUpdateQueue);
+    return bindingUpdateQueue.localData();
+}
+
+QQmlBindingUpdateQueue *QQmlBindingUpdateQueue::existingInstance()
+{
+    return bindingUpdateQueue.hasLocalData() ? bindingUpdateQueue.localData() : 0;
+}
+
+void QQmlBindingUpdateQueue::enqueue(QQmlBinding *b)
+{
+    int rank = b->m_updateRank;
+    if (currentRank != -1) {
+        if (currentCascadeLength >= MaxCascadeLength) {
+            // The bindings keep dirtying each other
+            b->m_cascadeLength = 0;
+            QQmlProperty p = b->property();
+            QQmlAbstractBinding::printBindingLoopError(p);
+            return;
+        }
+        b->m_cascadeLength = qMax<int>(b->m_cascadeLength, currentCascadeLength + 1);
+        rank = qMax(rank, qMin<int>(currentRank + 1, RankCount - 1));
+    }
+
+    if (b->m_pendingNode.isInList()) {
+        if (rank == b->m_updateRank)
+            return;
+        pending[b->m_updateRank].remove(b);
+    }
+
+    b->m_updateRank = rank;
+    pending[rank].insert(b);
+    firstRank = qMin(firstRank, rank);
+
+    if (!flushPosted) {
+        flushPosted = true;
+        QCoreApplication::postEvent(this, new QEvent(QEvent::User));
+    }
+}
+
+void QQmlBindingUpdateQueue::flush()
+{
+    if (currentRank != -1)
+        return;
+
+    while (firstRank < RankCount) {
+        QQmlBinding *b = pending[firstRank].first();
+        if (!b) {
+            ++firstRank;
+            continue;
+        }
+
+        pending[firstRank].remove(b);
+        currentRank = firstRank;
+        currentCascadeLength = b->m_cascadeLength;
+        b->m_cascadeLength = 0;
+
+        b->update();
+
+        currentRank = -1;
+    }
+}
+
+bool QQmlBindingUpdateQueue::event(QEvent *e)
+{
+    if (e->type() == QEvent::User) {
+        flushPosted = false;
+        flush();
+        return true;
+    }
+    return QObject::event(e);
+}
+
 QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContext *ctxt)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_updateRank(0), m_cascadeLength(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(QQmlContextData::get(ctxt));
@@ -115,7 +244,8 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContext *ctxt)
 }
 
 QQmlBinding::QQmlBinding(const QQmlScriptString &script, QObject *obj, QQmlContext *ctxt)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_updateRank(0), m_cascadeLength(0)
 {
     if (ctxt && !ctxt->isValid())
         return;
@@ -155,7 +285,8 @@ QQmlBinding::QQmlBinding(const QQmlScriptString &script, QObject *obj, QQmlConte
 }
 
 QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContextData *ctxt)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_updateRank(0), m_cascadeLength(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(ctxt);
@@ -167,7 +298,8 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj, QQmlContextData *ctxt
 QQmlBinding::QQmlBinding(const QString &str, QObject *obj,
                          QQmlContextData *ctxt,
                          const QString &url, quint16 lineNumber, quint16 columnNumber)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_updateRank(0), m_cascadeLength(0)
 {
     Q_UNUSED(columnNumber);
     setNotifyOnValueChanged(true);
@@ -178,7 +310,8 @@ QQmlBinding::QQmlBinding(const QString &str, QObject *obj,
 }
 
 QQmlBinding::QQmlBinding(const QV4::ValueRef functionPtr, QObject *obj, QQmlContextData *ctxt)
-: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding)
+: QQmlJavaScriptExpression(&QQmlBinding_jsvtable), QQmlAbstractBinding(Binding),
+  m_updateRank(0), m_cascadeLength(0)
 {
     setNotifyOnValueChanged(true);
     QQmlAbstractExpression::setContext(ctxt);
@@ -324,9 +457,24 @@ QString QQmlBinding::expressionIdentifier(QQmlJavaScriptExpression *e)
 void QQmlBinding::expressionChanged(QQmlJavaScriptExpression *e)
 {
     QQmlBinding *This = static_cast<QQmlBinding *>(e);
+    QQmlContextData *ctxt = This->context();
+    if (ctxt && ctxt->engine && QQmlEnginePrivate::get(ctxt->engine)->deferredBindingUpdates) {
+        QQmlBindingUpdateQueue::instance()->enqueue(This);
+        return;
+    }
     This->update();
 }
 
+/*
+    Updates the bindings whose updates were deferred on the current thread.
+    Does nothing unless an engine has deferred binding updates enabled.
+*/
+void QQmlBinding::flushPendingUpdates()
+{
+    if (QQmlBindingUpdateQueue *queue = QQmlBindingUpdateQueue::existingInstance())
+        queue->flush();
+}
+
 void QQmlBinding::refresh()
 {
     update();
@@ -64,6 +64,7 @@
 #include <QtCore/QMetaProperty>
 
 #include <private/qpointervaluepair_p.h>
+#include <private/qintrusivelist_p.h>
 #include <private/qqmlabstractbinding_p.h>
 #include <private/qqmlabstractexpression_p.h>
 #include <private/qqmljavascriptexpression_p.h>
@@ -119,8 +120,11 @@ public:
     static QString expressionIdentifier(QQmlJavaScriptExpression *);
     static void expressionChanged(QQmlJavaScriptExpression *);
 
+    static void flushPendingUpdates();
+
 protected:
     friend class QQmlAbstractBinding;
+    friend class QQmlBindingUpdateQueue;
     ~QQmlBinding();
 
 private:
@@ -142,6 +146,13 @@ private:
     //    m_ctxt:flag1 - updatingFlag
     //    m_ctxt:flag2 - enabledFlag
     QFlagPointer<QQmlContextData> m_ctxt;
+
+    // Used when the engine defers binding updates, see QQmlBindingUpdateQueue.
+    //    m_updateRank - how far down a chain of dependent bindings this one was seen
+    //    m_cascadeLength - number of updates that led to this one in the current flush
+    QIntrusiveListNode m_pendingNode;
+    quint16 m_updateRank;
+    quint16 m_cascadeLength;
 };
 
 bool QQmlBinding::updatingFlag() const
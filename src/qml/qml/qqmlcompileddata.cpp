@@ -78,6 +78,10 @@ QQmlCompiledData::~QQmlCompiledData()
 
     clear();
 
+    // The IR kept for recompiling hot functions refers to the property caches released below.
+    if (compilationUnit)
+        compilationUnit->releaseRecompilationIR();
+
     for (QHash<int, TypeReference*>::Iterator resolvedType = resolvedTypes.begin(), end = resolvedTypes.end();
          resolvedType != end; ++resolvedType) {
         if ((*resolvedType)->component)
@@ -288,10 +288,8 @@ void QmlContextWrapper::put(Managed *m, const StringRef name, const ValueRef val
         return;
     }
 
-    PropertyAttributes attrs;
-    Property *pd  = wrapper->__getOwnProperty__(name, &attrs);
-    if (pd) {
-        wrapper->putValue(pd, attrs, value);
+    if (wrapper->__getOwnProperty__(name)) {
+        Object::put(m, name, value);
         return;
     }
 
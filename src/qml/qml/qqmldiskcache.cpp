@@ -0,0 +1,268 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qqmldiskcache_p.h"
+
+#include <private/qv4compileddata_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4instr_moth_p.h>
+#include <private/qv4isel_p.h>
+
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qsysinfo.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+static const char cacheMagic[] = "qv4cache";
+
+enum { CacheFormatVersion = 3 };
+
+struct CacheFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 unitOffset; // Aligned to 8 bytes, so that the unit can be used in place
+    quint32 unitSize;
+    quint32 codeOffset;
+    quint32 codeSize;
+    quint32 reserved;
+    char buildId[20];
+    char sourceHash[20];
+};
+
+Q_STATIC_ASSERT((sizeof(CacheFileHeader) & 7) == 0);
+
+inline quint32 alignedSize(quint32 size)
+{
+    return (size + 7) & ~7;
+}
+
+template <typename T>
+void addToHash(QCryptographicHash *hash, T value)
+{
+    hash->addData(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// The id only depends on what determines the compatibility of cached units: the
+// version of the compiled data, the revision of the code generator, the layout of
+// the structures and the instruction set of the interpreter.  It is the same for
+// every build of the same sources.
+QByteArray computeBuildId()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray(QT_VERSION_STR));
+    addToHash(&hash, int(QV4::CompiledData::DataStructureVersion));
+    addToHash(&hash, int(QV4::CompiledData::CompilerRevision));
+    addToHash(&hash, int(QSysInfo::WordSize));
+    addToHash(&hash, int(QSysInfo::ByteOrder));
+
+    addToHash(&hash, sizeof(QV4::Value));
+    addToHash(&hash, sizeof(QV4::CompiledData::Unit));
+    addToHash(&hash, sizeof(QV4::CompiledData::QmlUnit));
+    addToHash(&hash, sizeof(QV4::CompiledData::Function));
+    addToHash(&hash, sizeof(QV4::CompiledData::Lookup));
+    addToHash(&hash, sizeof(QV4::CompiledData::Object));
+
+#ifdef MOTH_THREADED_INTERPRETER
+    hash.addData(QByteArray("threaded"));
+#endif
+#define MOTH_INSTR_HASH(I, FMT) \
+    hash.addData(QByteArray(#I)); \
+    addToHash(&hash, int(MOTH_INSTR_SIZE(I, FMT)));
+    FOR_EACH_MOTH_INSTR(MOTH_INSTR_HASH)
+#undef MOTH_INSTR_HASH
+
+    return hash.result();
+}
+
+QByteArray sourceHash(const QByteArray &source)
+{
+    return QCryptographicHash::hash(source, QCryptographicHash::Sha1);
+}
+
+}
+
+QQmlDiskCache::QQmlDiskCache(const QString &directory)
+    : m_directory(directory), m_loadCount(0)
+{
+}
+
+/*!
+Returns the cache directory configured through the QML_DISK_CACHE_PATH
+environment variable, or an empty string if the disk cache is disabled.
+*/
+QString QQmlDiskCache::defaultDirectory()
+{
+    const QByteArray path = qgetenv("QML_DISK_CACHE_PATH");
+    if (path.isEmpty())
+        return QString();
+    return QDir(QFile::decodeName(path)).absolutePath();
+}
+
+/*!
+Returns an identifier of the engine build. Compilation units written by an
+incompatible build are never loaded.
+*/
+QByteArray QQmlDiskCache::buildId()
+{
+    static const QByteArray id = computeBuildId();
+    return id;
+}
+
+QString QQmlDiskCache::cacheFilePath(const QUrl &url) const
+{
+    const QByteArray name = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(name) + QLatin1String(".qmlc");
+}
+
+/*!
+Returns the compilation unit stored for \a url if it was generated from
+\a source by this build of the engine, otherwise returns 0.
+
+The unit data is used in place from a read-only mapping of the cache file
+where the platform supports it, so that it is paged in on demand and shared
+between processes. The returned unit is not yet linked to \a engine.
+*/
+QV4::CompiledData::CompilationUnit *QQmlDiskCache::load(QV4::ExecutionEngine *engine, const QUrl &url, const QByteArray &source) const
+{
+    QScopedPointer<QFile> file(new QFile(cacheFilePath(url)));
+    if (!file->open(QIODevice::ReadOnly))
+        return 0;
+
+    CacheFileHeader header;
+    if (file->read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header))
+        return 0;
+    if (memcmp(header.magic, cacheMagic, sizeof(header.magic)) != 0
+        || header.version != CacheFormatVersion
+        || memcmp(header.buildId, buildId().constData(), sizeof(header.buildId)) != 0
+        || memcmp(header.sourceHash, sourceHash(source).constData(), sizeof(header.sourceHash)) != 0)
+        return 0;
+
+    const qint64 fileSize = file->size();
+    if (header.unitSize < sizeof(QV4::CompiledData::QmlUnit)
+        || (header.unitOffset & 7) || (header.codeOffset & 7)
+        || header.codeOffset < header.unitOffset + header.unitSize
+        || qint64(header.codeOffset) + header.codeSize > fileSize)
+        return 0;
+
+    QScopedPointer<QV4::CompiledData::CompilationUnit> unit(engine->iselFactory->createUnitForLoading());
+    if (!unit)
+        return 0;
+
+    // Unit and code are loaded as one block, which is owned by the unit through its data pointer.
+    const qint64 blockSize = header.codeOffset + header.codeSize - header.unitOffset;
+    char *block = reinterpret_cast<char *>(file->map(header.unitOffset, blockSize));
+    if (block) {
+        unit->data = reinterpret_cast<QV4::CompiledData::Unit *>(block);
+        unit->mappedFile = file.take();
+    } else {
+        block = (char *)malloc(blockSize);
+        if (!block)
+            return 0;
+        if (!file->seek(header.unitOffset) || file->read(block, blockSize) != blockSize) {
+            free(block);
+            return 0;
+        }
+        unit->data = reinterpret_cast<QV4::CompiledData::Unit *>(block);
+    }
+
+    const QV4::CompiledData::QmlUnit *qmlUnit = reinterpret_cast<const QV4::CompiledData::QmlUnit *>(block);
+    if (memcmp(qmlUnit->header.magic, QV4::CompiledData::magic_str, sizeof(qmlUnit->header.magic)) != 0
+        || !(qmlUnit->header.flags & QV4::CompiledData::Unit::IsQml)
+        || (qmlUnit->header.flags & QV4::CompiledData::Unit::StaticData)
+        || qmlUnit->qmlUnitSize != header.unitSize)
+        return 0;
+
+    const char *code = block + (header.codeOffset - header.unitOffset);
+    if (!unit->loadBackendCode(code, header.codeSize))
+        return 0;
+
+    m_loadCount.ref();
+    return unit.take();
+}
+
+/*!
+Writes \a unit, which was compiled from \a source, to the cache entry of
+\a url. Returns false if the backend that generated \a unit does not
+support caching or if the entry could not be written.
+*/
+bool QQmlDiskCache::store(const QUrl &url, const QByteArray &source, QV4::CompiledData::CompilationUnit *unit) const
+{
+    Q_ASSERT(unit && unit->data);
+    if (!(unit->data->flags & QV4::CompiledData::Unit::IsQml))
+        return false;
+
+    QByteArray code;
+    if (!unit->saveBackendCode(&code))
+        return false;
+
+    const QV4::CompiledData::QmlUnit *qmlUnit = reinterpret_cast<const QV4::CompiledData::QmlUnit *>(unit->data);
+
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(header.magic));
+    header.version = CacheFormatVersion;
+    header.unitOffset = sizeof(header);
+    header.unitSize = qmlUnit->qmlUnitSize;
+    header.codeOffset = header.unitOffset + alignedSize(header.unitSize);
+    header.codeSize = code.size();
+    memcpy(header.buildId, buildId().constData(), sizeof(header.buildId));
+    memcpy(header.sourceHash, sourceHash(source).constData(), sizeof(header.sourceHash));
+
+    if (!QDir().mkpath(m_directory))
+        return false;
+
+    QSaveFile file(cacheFilePath(url));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(qmlUnit), header.unitSize);
+    file.write(QByteArray(alignedSize(header.unitSize) - header.unitSize, '\0'));
+    file.write(code);
+    return file.commit();
+}
+
+QT_END_NAMESPACE
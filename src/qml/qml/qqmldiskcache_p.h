@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQMLDISKCACHE_P_H
+#define QQMLDISKCACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qurl.h>
+#include <private/qtqmlglobal_p.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+struct ExecutionEngine;
+namespace CompiledData {
+struct CompilationUnit;
+}
+}
+
+// Persists the compilation units generated for source files across process
+// runs. Entries are keyed by the url of the source file and validated against
+// a hash of the source and the build of the engine that generated them.
+class Q_QML_PRIVATE_EXPORT QQmlDiskCache
+{
+    Q_DISABLE_COPY(QQmlDiskCache)
+public:
+    QQmlDiskCache(const QString &directory);
+
+    static QString defaultDirectory();
+
+    QString directory() const { return m_directory; }
+    QString cacheFilePath(const QUrl &url) const;
+
+    QV4::CompiledData::CompilationUnit *load(QV4::ExecutionEngine *engine, const QUrl &url, const QByteArray &source) const;
+    bool store(const QUrl &url, const QByteArray &source, QV4::CompiledData::CompilationUnit *unit) const;
+
+    // Number of units returned by load()
+    int loadCount() const { return m_loadCount.load(); }
+
+    static QByteArray buildId();
+
+private:
+    QString m_directory;
+    mutable QAtomicInt m_loadCount;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLDISKCACHE_P_H
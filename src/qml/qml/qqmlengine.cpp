@@ -553,6 +553,40 @@ the same object as is returned from the Qt.include() call.
 */
 // Qt.include() is implemented in qv4include.cpp
 
+/*!
+\qmlmethod Qt::parseJson(string text, function callback)
+\since 5.4
+
+Parses the JSON \a text on a worker thread and calls \a callback with the
+result, so that parsing large documents does not block the engine's thread.
+Only the conversion of the parsed document into JavaScript objects happens on
+the engine's thread.
+
+The callback is passed two arguments: the parsed value, and \c null. If
+\a text is not valid JSON, the first argument is \c undefined and the second
+is a \c SyntaxError describing the problem.
+
+The result is the same as the one of \c JSON.parse(): the members of objects
+keep the order they have in \a text, and if a name occurs more than once in an
+object, the last value wins.
+
+\code
+var xhr = new XMLHttpRequest();
+xhr.onreadystatechange = function() {
+    if (xhr.readyState === XMLHttpRequest.DONE) {
+        Qt.parseJson(xhr.responseText, function(result, error) {
+            if (!error)
+                model = result.items;
+        });
+    }
+}
+\endcode
+
+The callback is not called if the context that called Qt.parseJson() was
+destroyed in the meantime.
+*/
+// Qt.parseJson() is implemented in qv4jsonparsejob.cpp
+
 QQmlEnginePrivate::QQmlEnginePrivate(QQmlEngine *e)
 : propertyCapture(0), rootContext(0), isDebugging(false),
   profiler(0), outputWarningsToStdErr(true),
@@ -561,9 +595,11 @@ QQmlEnginePrivate::QQmlEnginePrivate(QQmlEngine *e)
   activeObjectCreator(0),
   networkAccessManager(0), networkAccessManagerFactory(0), urlInterceptor(0),
   scarceResourcesRefCount(0), typeLoader(e), importDatabase(e), uniqueId(1),
-  incubatorCount(0), incubationController(0), mutex(QMutex::Recursive)
+  incubatorCount(0), incubationController(0), mutex(QMutex::Recursive),
+  memberResolutionMutex(QMutex::Recursive)
 {
     useNewCompiler = true;
+    deferredBindingUpdates = !qgetenv("QML_DEFERRED_BINDINGS").isEmpty();
 }
 
 QQmlEnginePrivate::~QQmlEnginePrivate()
@@ -147,6 +147,8 @@ public:
     QQmlContext *rootContext;
     bool isDebugging;
     bool useNewCompiler;
+    // Queue dirtied bindings and re-evaluate them in one pass (QML_DEFERRED_BINDINGS)
+    bool deferredBindingUpdates;
     QQmlProfiler *profiler;
     void enableProfiler();
 
@@ -269,6 +271,10 @@ public:
     static bool qml_debugging_enabled;
 
     mutable QMutex mutex;
+    // Serializes member resolution of the functions of one document, which the instruction
+    // selection may optimize on several threads. Recursive, as resolving a member can resolve
+    // the members of the resulting type.
+    QMutex memberResolutionMutex;
 
 private:
     // Locker locks the QQmlEnginePrivate data structures for read and write, if necessary.
@@ -54,6 +54,7 @@
 #include <private/qqmlglobal_p.h>
 #include <private/qqmltypenamecache_p.h>
 #include <private/qqmlengine_p.h>
+#include <private/qqmlimportindex_p.h>
 #include <private/qfieldlist_p.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonarray.h>
@@ -1090,34 +1091,50 @@ bool QQmlImportsPrivate::locateQmldir(const QString &uri, int vmaj, int vmin, QQ
 
     QStringList localImportPaths = database->importPathList(QQmlImportDatabase::Local);
 
-    // Search local import paths for a matching version
-    for (int version = QQmlImports::FullyVersioned; version <= QQmlImports::Unversioned; ++version) {
-        foreach (const QString &path, localImportPaths) {
-            QString qmldirPath = QQmlImports::completeQmldirPath(uri, path, vmaj, vmin, static_cast<QQmlImports::ImportVersion>(version));
-
-            QString absoluteFilePath = typeLoader.absoluteFilePath(qmldirPath);
-            if (!absoluteFilePath.isEmpty()) {
-                QString url;
-                QString absolutePath = absoluteFilePath.left(absoluteFilePath.lastIndexOf(Slash)+1);
-                if (absolutePath.at(0) == Colon)
-                    url = QLatin1String("qrc://") + absolutePath.mid(1);
-                else
-                    url = QUrl::fromLocalFile(absolutePath).toString();
+    // Then the index of modules located by earlier runs
+    QQmlImportIndex *importIndex = typeLoader.importIndex();
+    if (importIndex)
+        importIndex->setImportPaths(localImportPaths);
+
+    QString absoluteFilePath;
+    if (!importIndex || !importIndex->lookupModule(uri, vmaj, vmin, &absoluteFilePath)) {
+        // Search local import paths for a matching version
+        QStringList misses;
+        for (int version = QQmlImports::FullyVersioned; absoluteFilePath.isEmpty() && version <= QQmlImports::Unversioned; ++version) {
+            foreach (const QString &path, localImportPaths) {
+                QString qmldirPath = QQmlImports::completeQmldirPath(uri, path, vmaj, vmin, static_cast<QQmlImports::ImportVersion>(version));
+
+                absoluteFilePath = typeLoader.absoluteFilePath(qmldirPath);
+                if (!absoluteFilePath.isEmpty())
+                    break;
+                misses.append(qmldirPath);
+            }
+        }
 
-                QQmlImportDatabase::QmldirCache *cache = new QQmlImportDatabase::QmldirCache;
-                cache->versionMajor = vmaj;
-                cache->versionMinor = vmin;
-                cache->qmldirFilePath = absoluteFilePath;
-                cache->qmldirPathUrl = url;
-                cache->next = cacheHead;
-                database->qmldirCache.insert(uri, cache);
+        if (importIndex && !absoluteFilePath.isEmpty())
+            importIndex->insertModule(uri, vmaj, vmin, absoluteFilePath, misses);
+    }
 
-                *outQmldirFilePath = absoluteFilePath;
-                *outQmldirPathUrl = url;
+    if (!absoluteFilePath.isEmpty()) {
+        QString url;
+        QString absolutePath = absoluteFilePath.left(absoluteFilePath.lastIndexOf(Slash)+1);
+        if (absolutePath.at(0) == Colon)
+            url = QLatin1String("qrc://") + absolutePath.mid(1);
+        else
+            url = QUrl::fromLocalFile(absolutePath).toString();
 
-                return true;
-            }
-        }
+        QQmlImportDatabase::QmldirCache *cache = new QQmlImportDatabase::QmldirCache;
+        cache->versionMajor = vmaj;
+        cache->versionMinor = vmin;
+        cache->qmldirFilePath = absoluteFilePath;
+        cache->qmldirPathUrl = url;
+        cache->next = cacheHead;
+        database->qmldirCache.insert(uri, cache);
+
+        *outQmldirFilePath = absoluteFilePath;
+        *outQmldirPathUrl = url;
+
+        return true;
     }
 
     QQmlImportDatabase::QmldirCache *cache = new QQmlImportDatabase::QmldirCache;
@@ -1603,6 +1620,18 @@ QString QQmlImportDatabase::resolvePlugin(QQmlTypeLoader *typeLoader,
     if (!qmldirPluginPathIsRelative)
         searchPaths.prepend(qmldirPluginPath);
 
+    QQmlImportIndex *importIndex = typeLoader->importIndex();
+    QString indexKey;
+    if (importIndex) {
+        indexKey = searchPaths.join(QLatin1Char(';')) + QLatin1Char('\n') + qmldirPath
+                 + QLatin1Char('\n') + qmldirPluginPath + QLatin1Char('\n') + prefix + baseName
+                 + QLatin1Char('\n') + suffixes.join(QLatin1Char(';'));
+        QString pluginFilePath;
+        if (importIndex->lookupPlugin(indexKey, &pluginFilePath))
+            return pluginFilePath;
+    }
+
+    QStringList misses;
     foreach (const QString &pluginPath, searchPaths) {
 
         QString resolvedPath;
@@ -1632,8 +1661,12 @@ QString QQmlImportDatabase::resolvePlugin(QQmlTypeLoader *typeLoader,
             pluginFileName += suffix;
 
             QString absolutePath = typeLoader->absoluteFilePath(resolvedPath + pluginFileName);
-            if (!absolutePath.isEmpty())
+            if (!absolutePath.isEmpty()) {
+                if (importIndex)
+                    importIndex->insertPlugin(indexKey, absolutePath, misses);
                 return absolutePath;
+            }
+            misses.append(resolvedPath + pluginFileName);
         }
     }
 
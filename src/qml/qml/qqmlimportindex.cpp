@@ -0,0 +1,303 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qqmlimportindex_p.h"
+
+#include <private/qqmldiskcache_p.h>
+
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdatastream.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+static const char indexMagic[] = "qmlimpix";
+
+enum { IndexFormatVersion = 3 };
+
+QString moduleKey(const QString &uri, int vmaj, int vmin)
+{
+    return uri + QLatin1Char(' ') + QString::number(vmaj) + QLatin1Char('.') + QString::number(vmin);
+}
+
+}
+
+QQmlImportIndex::QQmlImportIndex(const QString &directory)
+    : m_directory(directory), m_hasImportPaths(false), m_dirty(false)
+{
+}
+
+QString QQmlImportIndex::indexFilePath(const QStringList &importPaths) const
+{
+    const QByteArray name = QCryptographicHash::hash(importPaths.join(QLatin1Char('\n')).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(name) + QLatin1String(".qmlimports");
+}
+
+/*!
+Switches the index to the one stored for \a importPaths.  Entries collected
+for the previous import paths are saved first.
+*/
+void QQmlImportIndex::setImportPaths(const QStringList &importPaths)
+{
+    if (m_hasImportPaths && importPaths == m_importPaths)
+        return;
+
+    save();
+    clear();
+
+    m_hasImportPaths = true;
+    m_importPaths = importPaths;
+    m_importPathsModified.clear();
+    foreach (const QString &path, importPaths)
+        m_importPathsModified.append(lastModified(path));
+
+    if (!load())
+        clear();
+}
+
+/*!
+Returns true and sets \a qmldirFilePath if the qmldir file for version
+\a vmaj.vmin of module \a uri is known and still exists, and none of the
+directories that could hold a qmldir file taking precedence over it has
+changed since.
+*/
+bool QQmlImportIndex::lookupModule(const QString &uri, int vmaj, int vmin, QString *qmldirFilePath) const
+{
+    Entries::ConstIterator it = m_modules.constFind(moduleKey(uri, vmaj, vmin));
+    if (it == m_modules.constEnd() || !isCurrent(*it, it->value))
+        return false;
+
+    *qmldirFilePath = it->value;
+    return true;
+}
+
+/*!
+Records \a qmldirFilePath for version \a vmaj.vmin of module \a uri.  \a misses
+are the qmldir files that were searched for before it.
+*/
+void QQmlImportIndex::insertModule(const QString &uri, int vmaj, int vmin, const QString &qmldirFilePath,
+                                   const QStringList &misses)
+{
+    m_modules.insert(moduleKey(uri, vmaj, vmin), Entry(lastModified(qmldirFilePath), qmldirFilePath, missDirectories(misses)));
+    m_dirty = true;
+}
+
+/*!
+Returns true and sets \a content if the qmldir file at \a qmldirFilePath was
+read before and hasn't been modified since.
+*/
+bool QQmlImportIndex::lookupQmldir(const QString &qmldirFilePath, QString *content) const
+{
+    Entries::ConstIterator it = m_qmldirs.constFind(qmldirFilePath);
+    if (it == m_qmldirs.constEnd() || !isCurrent(*it, qmldirFilePath))
+        return false;
+
+    *content = it->value;
+    return true;
+}
+
+void QQmlImportIndex::insertQmldir(const QString &qmldirFilePath, const QString &content)
+{
+    m_qmldirs.insert(qmldirFilePath, Entry(lastModified(qmldirFilePath), content));
+    m_dirty = true;
+}
+
+/*!
+Returns true and sets \a pluginFilePath if a plugin was found for \a key
+before, the plugin file hasn't been modified since and none of the directories
+of the files searched for before it has changed.  The key has to describe everything the
+plugin search depends on.
+*/
+bool QQmlImportIndex::lookupPlugin(const QString &key, QString *pluginFilePath) const
+{
+    Entries::ConstIterator it = m_plugins.constFind(key);
+    if (it == m_plugins.constEnd() || !isCurrent(*it, it->value))
+        return false;
+
+    *pluginFilePath = it->value;
+    return true;
+}
+
+void QQmlImportIndex::insertPlugin(const QString &key, const QString &pluginFilePath, const QStringList &misses)
+{
+    m_plugins.insert(key, Entry(lastModified(pluginFilePath), pluginFilePath, missDirectories(misses)));
+    m_dirty = true;
+}
+
+/*!
+Writes the index for the current import paths if it has new entries.
+Returns false if it could not be written.
+*/
+bool QQmlImportIndex::save()
+{
+    if (!m_hasImportPaths || !m_dirty)
+        return true;
+    m_dirty = false;
+
+    if (!QDir().mkpath(m_directory))
+        return false;
+
+    QSaveFile file(indexFilePath(m_importPaths));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.writeRawData(indexMagic, sizeof(indexMagic) - 1);
+    stream << quint32(IndexFormatVersion) << QQmlDiskCache::buildId()
+           << m_importPaths << m_importPathsModified;
+
+    const Entries *tables[] = { &m_modules, &m_qmldirs, &m_plugins };
+    for (int ii = 0; ii < int(sizeof(tables) / sizeof(tables[0])); ++ii) {
+        const Entries &entries = *tables[ii];
+        stream << quint32(entries.count());
+        for (Entries::ConstIterator it = entries.constBegin(), end = entries.constEnd(); it != end; ++it)
+            stream << it.key() << it->modified << it->value << it->directories;
+    }
+
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+qint64 QQmlImportIndex::lastModified(const QString &path) const
+{
+    Stamps::ConstIterator it = m_lastModified.constFind(path);
+    if (it != m_lastModified.constEnd())
+        return *it;
+
+    QFileInfo info(path);
+    const qint64 modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    m_lastModified.insert(path, modified);
+    return modified;
+}
+
+/*
+    Creating a missing file, or any missing directory above it, changes the
+    modification time of the deepest directory above it that exists.  Misses
+    usually share those directories, so an entry only has to check a few.
+*/
+QQmlImportIndex::Stamps QQmlImportIndex::missDirectories(const QStringList &misses) const
+{
+    Stamps directories;
+    foreach (const QString &miss, misses) {
+        QString directory = miss;
+        qint64 modified = -1;
+        for (int slash = directory.lastIndexOf(QLatin1Char('/')); slash >= 0 && modified == -1;
+             slash = directory.lastIndexOf(QLatin1Char('/'), -2)) {
+            directory.truncate(qMax(slash, 1));
+            modified = lastModified(directory);
+        }
+        if (modified == -1)
+            directories.insert(miss, -1);
+        else
+            directories.insert(directory, modified);
+    }
+    return directories;
+}
+
+bool QQmlImportIndex::isCurrent(const Entry &entry, const QString &filePath) const
+{
+    if (entry.modified == -1 || entry.modified != lastModified(filePath))
+        return false;
+    for (Stamps::ConstIterator it = entry.directories.constBegin(), end = entry.directories.constEnd(); it != end; ++it) {
+        if (lastModified(it.key()) != *it)
+            return false;
+    }
+    return true;
+}
+
+void QQmlImportIndex::clear()
+{
+    m_modules.clear();
+    m_qmldirs.clear();
+    m_plugins.clear();
+    m_lastModified.clear();
+    m_dirty = false;
+}
+
+/*!
+Reads the stored index for the current import paths.  Returns false if there is
+none, or if it was written by another build or for import paths that changed since.
+*/
+bool QQmlImportIndex::load()
+{
+    QFile file(indexFilePath(m_importPaths));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    char magic[sizeof(indexMagic) - 1];
+    if (stream.readRawData(magic, sizeof(magic)) != int(sizeof(magic))
+        || memcmp(magic, indexMagic, sizeof(magic)) != 0)
+        return false;
+
+    quint32 version;
+    QByteArray buildId;
+    QStringList importPaths;
+    QList<qint64> importPathsModified;
+    stream >> version >> buildId >> importPaths >> importPathsModified;
+    if (stream.status() != QDataStream::Ok
+        || version != IndexFormatVersion
+        || buildId != QQmlDiskCache::buildId()
+        || importPaths != m_importPaths
+        || importPathsModified != m_importPathsModified)
+        return false;
+
+    Entries *tables[] = { &m_modules, &m_qmldirs, &m_plugins };
+    for (int ii = 0; ii < int(sizeof(tables) / sizeof(tables[0])); ++ii) {
+        quint32 count;
+        stream >> count;
+        for (quint32 jj = 0; jj < count && stream.status() == QDataStream::Ok; ++jj) {
+            QString key;
+            Entry entry;
+            stream >> key >> entry.modified >> entry.value >> entry.directories;
+            tables[ii]->insert(key, entry);
+        }
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,133 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQMLIMPORTINDEX_P_H
+#define QQMLIMPORTINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <private/qtqmlglobal_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Persists the results of import resolution across process runs: the qmldir
+// file found for a module version, the contents of qmldir files and the plugin
+// files they refer to.  An index belongs to one list of import paths and is
+// discarded when the modification time of any of those paths changes.  Each
+// entry is also validated against the modification time of its file.  Module
+// and plugin entries record the deepest existing directory above each candidate
+// that was tried before the file was found, and are dropped as soon as one of
+// those directories changes, so that a better match installed later is not
+// shadowed.  Modification times are read once per index and import paths, like
+// the in-memory import caches of the engine.
+class Q_QML_PRIVATE_EXPORT QQmlImportIndex
+{
+    Q_DISABLE_COPY(QQmlImportIndex)
+public:
+    QQmlImportIndex(const QString &directory);
+
+    QString directory() const { return m_directory; }
+    QString indexFilePath(const QStringList &importPaths) const;
+
+    QStringList importPaths() const { return m_importPaths; }
+    void setImportPaths(const QStringList &importPaths);
+
+    bool lookupModule(const QString &uri, int vmaj, int vmin, QString *qmldirFilePath) const;
+    void insertModule(const QString &uri, int vmaj, int vmin, const QString &qmldirFilePath,
+                      const QStringList &misses);
+
+    bool lookupQmldir(const QString &qmldirFilePath, QString *content) const;
+    void insertQmldir(const QString &qmldirFilePath, const QString &content);
+
+    bool lookupPlugin(const QString &key, QString *pluginFilePath) const;
+    void insertPlugin(const QString &key, const QString &pluginFilePath, const QStringList &misses);
+
+    bool save();
+
+private:
+    typedef QHash<QString, qint64> Stamps; // path -> modification time, -1 if missing
+
+    struct Entry {
+        Entry() : modified(-1) {}
+        Entry(qint64 modified, const QString &value, const Stamps &directories = Stamps())
+            : modified(modified), value(value), directories(directories) {}
+
+        qint64 modified;
+        QString value;
+        Stamps directories; // the deepest existing directories above the files looked for first
+    };
+    typedef QHash<QString, Entry> Entries;
+
+    qint64 lastModified(const QString &path) const;
+    Stamps missDirectories(const QStringList &misses) const;
+    bool isCurrent(const Entry &entry, const QString &filePath) const;
+
+    void clear();
+    bool load();
+
+    QString m_directory;
+    QStringList m_importPaths;
+    QList<qint64> m_importPathsModified;
+    bool m_hasImportPaths;
+
+    Entries m_modules;  // "uri vmaj.vmin" -> qmldir file, stamped with the qmldir file
+    Entries m_qmldirs;  // qmldir file -> content
+    Entries m_plugins;  // search key -> plugin file, stamped with the plugin file
+    mutable Stamps m_lastModified;
+    bool m_dirty;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLIMPORTINDEX_P_H
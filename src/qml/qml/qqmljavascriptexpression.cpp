@@ -48,6 +48,7 @@
 #include <private/qv4script_p.h>
 #include <private/qv4errorobject_p.h>
 #include <private/qv4scopedvalue_p.h>
+#include <private/qv4compileddata_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -145,11 +146,15 @@ QV4::ReturnedValue QQmlJavaScriptExpression::evaluate(QQmlContextData *context,
     Q_ASSERT(notifyOnValueChanged() || activeGuards.isEmpty());
     GuardCapture capture(context->engine, this, &watcher);
 
+    bool captureRequired = notifyOnValueChanged();
+    if (captureRequired && !activeGuards.isEmpty() && hasStaticDependencies(function))
+        captureRequired = !reuseGuards();
+
     QQmlEnginePrivate::PropertyCapture *lastPropertyCapture = ep->propertyCapture;
-    ep->propertyCapture = notifyOnValueChanged()?&capture:0;
+    ep->propertyCapture = captureRequired?&capture:0;
 
 
-    if (notifyOnValueChanged())
+    if (captureRequired)
         capture.guards.copyAndClearPrepend(activeGuards);
 
     QV4::ExecutionEngine *v4 = QV8Engine::getV4(ep->v8engine());
@@ -186,35 +191,110 @@ QV4::ReturnedValue QQmlJavaScriptExpression::evaluate(QQmlContextData *context,
         capture.errorString = 0;
     }
 
-    while (Guard *g = capture.guards.takeFirst())
-        g->Delete();
+    capture.deleteUnusedGuards();
 
     ep->propertyCapture = lastPropertyCapture;
 
     return result.asReturnedValue();
 }
 
+/*
+    The compiler flags functions that only read QML properties recorded in their
+    dependency tables. Such a function registers the same dependencies on every
+    call, so once they are guarded there is nothing left to capture.
+*/
+bool QQmlJavaScriptExpression::hasStaticDependencies(const QV4::ValueRef function)
+{
+    QV4::FunctionObject *f = function->asFunctionObject();
+    if (!f || !f->function)
+        return false;
+    return f->function->compiledFunction->flags & QV4::CompiledData::Function::HasStaticQmlDependencies;
+}
+
+/*
+    Keeps the guards of the previous evaluation. Returns false if one of them
+    was disconnected in the meantime, in which case the dependencies have to be
+    captured again.
+*/
+bool QQmlJavaScriptExpression::reuseGuards()
+{
+    for (Guard *g = activeGuards.first(); g; g = activeGuards.next(g)) {
+        if (!g->isConnected())
+            return false;
+    }
+    for (Guard *g = activeGuards.first(); g; g = activeGuards.next(g))
+        g->cancelNotify();
+    return true;
+}
+
+/*
+    Moves the guard of the previous evaluation for \a key to the active guards.
+    Returns false if there is none and the dependency isn't guarded in this
+    evaluation yet either, in which case the caller connects a new guard.
+*/
+bool QQmlJavaScriptExpression::GuardCapture::reuseGuard(const GuardKey &key)
+{
+    // Dependencies are mostly captured in the same order as in the previous
+    // evaluation, so the matching guard is usually the first one.
+    Guard *g = guards.first();
+    if (g && g->sender() == key.first && g->signalIndex() == key.second) {
+        guards.takeFirst();
+    } else {
+        if (!indexed)
+            indexGuards();
+        g = unusedGuards.take(key);
+        if (!g) {
+            if (guardedKeys.contains(key))
+                return true;
+            guardedKeys.insert(key);
+            return false;
+        }
+    }
+
+    if (indexed)
+        guardedKeys.insert(key);
+    g->cancelNotify();
+    expression->activeGuards.prepend(g);
+    return true;
+}
+
+void QQmlJavaScriptExpression::GuardCapture::indexGuards()
+{
+    Q_ASSERT(!indexed);
+    indexed = true;
+    while (Guard *g = guards.takeFirst()) {
+        if (g->isConnected()) {
+            GuardKey key(g->sender(), g->signalIndex());
+            Q_ASSERT(!unusedGuards.contains(key));
+            unusedGuards.insert(key, g);
+        } else {
+            g->Delete();
+        }
+    }
+    for (Guard *g = expression->activeGuards.first(); g; g = expression->activeGuards.next(g))
+        guardedKeys.insert(GuardKey(g->sender(), g->signalIndex()));
+}
+
+void QQmlJavaScriptExpression::GuardCapture::deleteUnusedGuards()
+{
+    while (Guard *g = guards.takeFirst())
+        g->Delete();
+    for (QHash<GuardKey, Guard *>::ConstIterator it = unusedGuards.constBegin(); it != unusedGuards.constEnd(); ++it)
+        (*it)->Delete();
+    unusedGuards.clear();
+}
+
 void QQmlJavaScriptExpression::GuardCapture::captureProperty(QQmlNotifier *n)
 {
     if (watcher->wasDeleted())
         return;
 
     Q_ASSERT(expression);
-    // Try and find a matching guard
-    while (!guards.isEmpty() && !guards.first()->isConnected(n))
-        guards.takeFirst()->Delete();
-
-    Guard *g = 0;
-    if (!guards.isEmpty()) {
-        g = guards.takeFirst();
-        g->cancelNotify();
-        Q_ASSERT(g->isConnected(n));
-    } else {
-        g = Guard::New(expression, engine);
+    if (!reuseGuard(GuardKey(n, -1))) {
+        Guard *g = Guard::New(expression, engine);
         g->connect(n);
+        expression->activeGuards.prepend(g);
     }
-
-    expression->activeGuards.prepend(g);
 }
 
 /*! \internal
@@ -246,21 +326,11 @@ void QQmlJavaScriptExpression::GuardCapture::captureProperty(QObject *o, int c,
         errorString->append(error);
     } else {
 
-        // Try and find a matching guard
-        while (!guards.isEmpty() && !guards.first()->isConnected(o, n))
-            guards.takeFirst()->Delete();
-
-        Guard *g = 0;
-        if (!guards.isEmpty()) {
-            g = guards.takeFirst();
-            g->cancelNotify();
-            Q_ASSERT(g->isConnected(o, n));
-        } else {
-            g = Guard::New(expression, engine);
+        if (!reuseGuard(GuardKey(o, n))) {
+            Guard *g = Guard::New(expression, engine);
             g->connect(o, n, engine);
+            expression->activeGuards.prepend(g);
         }
-
-        expression->activeGuards.prepend(g);
     }
 }
 
@@ -54,6 +54,8 @@
 //
 
 #include <QtCore/qglobal.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
 #include <QtQml/qqmlerror.h>
 #include <private/qqmlengine_p.h>
 #include <private/qpointervaluepair_p.h>
@@ -160,22 +162,38 @@ private:
     typedef QQmlJavaScriptExpressionGuard Guard;
     friend void QQmlJavaScriptExpressionGuard_callback(QQmlNotifierEndpoint *, void **);
 
+    static bool hasStaticDependencies(const QV4::ValueRef function);
+    bool reuseGuards();
+
     struct GuardCapture : public QQmlEnginePrivate::PropertyCapture {
         GuardCapture(QQmlEngine *engine, QQmlJavaScriptExpression *e, DeleteWatcher *w)
-        : engine(engine), expression(e), watcher(w), errorString(0) { }
+        : engine(engine), expression(e), watcher(w), indexed(false), errorString(0) { }
 
         ~GuardCapture()  {
             Q_ASSERT(guards.isEmpty());
+            Q_ASSERT(unusedGuards.isEmpty());
             Q_ASSERT(errorString == 0);
         }
 
         virtual void captureProperty(QQmlNotifier *);
         virtual void captureProperty(QObject *, int, int);
 
+        // The sender and signal index of a guard, -1 for a QQmlNotifier
+        typedef QPair<const void *, int> GuardKey;
+        bool reuseGuard(const GuardKey &key);
+        void indexGuards();
+        void deleteUnusedGuards();
+
         QQmlEngine *engine;
         QQmlJavaScriptExpression *expression;
         DeleteWatcher *watcher;
         QFieldList<Guard, &Guard::next> guards;
+        // Once a dependency is captured out of order, the remaining guards of the
+        // previous evaluation move to unusedGuards and the dependencies guarded in
+        // this evaluation are tracked in guardedKeys.
+        bool indexed;
+        QHash<GuardKey, Guard *> unusedGuards;
+        QSet<GuardKey> guardedKeys;
         QStringList *errorString;
     };
 
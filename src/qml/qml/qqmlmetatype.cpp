@@ -52,6 +52,8 @@
 #include <QtCore/qmetaobject.h>
 #include <QtCore/qbitarray.h>
 #include <QtCore/qreadwritelock.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/private/qmetaobject_p.h>
 
 #include <qmetatype.h>
@@ -67,10 +69,97 @@
 
 QT_BEGIN_NAMESPACE
 
-struct QQmlMetaTypeData
+// Copies of lookup tables that are only modified while holding metaTypeDataLock
+// for writing. Readers use the current copy without locking.
+//
+// Copies aren't cheap: QStringHash copies all of its nodes, and the next
+// modification has to detach the implicitly shared containers of the live tables.
+// After a modification, readers therefore take metaTypeDataLock for reading and
+// use the live tables, until there have been as many of these reads as there are
+// types. Only then a copy is published, so bursts of registrations don't copy at
+// all and the cost of a copy is spread over the reads that preceded it.
+//
+// A modification retires the current copy. Readers register in the slot of the
+// current epoch while they use a copy. The epoch only advances once the slot it
+// reuses is empty, so when the slot of the previous epoch is empty as well, no
+// reader can use a copy retired before the current epoch anymore. Whoever empties
+// a slot frees those copies and advances the epoch past the copies retired in it.
+// Readers that keep overlapping can't delay this forever, as new ones register in
+// the other slot.
+template<typename T>
+class QQmlMetaTypeSnapshot
 {
-    QQmlMetaTypeData();
-    ~QQmlMetaTypeData();
+public:
+    QQmlMetaTypeSnapshot() {}
+    ~QQmlMetaTypeSnapshot()
+    {
+        delete current.load();
+        for (int ii = 0; ii < retired.count(); ++ii)
+            delete retired.at(ii).tables;
+    }
+
+    class ReadGuard
+    {
+    public:
+        ReadGuard(QQmlMetaTypeSnapshot<T> &snapshot, const T &tables)
+        : snapshot(snapshot), epoch(snapshot.enter()), locked(false)
+        {
+            t = snapshot.get(tables, &locked);
+        }
+        ~ReadGuard();
+
+        const T *operator->() const { return t; }
+
+    private:
+        Q_DISABLE_COPY(ReadGuard)
+
+        QQmlMetaTypeSnapshot<T> &snapshot;
+        const int epoch;
+        bool locked; // t points to the live tables
+        const T *t;
+    };
+
+    // Caller must hold a QWriteLocker on metaTypeDataLock
+    void invalidate()
+    {
+        lockedReads.store(0);
+        if (T *t = current.fetchAndStoreOrdered(0)) {
+            QMutexLocker lock(&retiredMutex);
+            Retired r = { t, epoch.load() };
+            retired.append(r);
+            pending.storeRelease(retired.count());
+        }
+        if (pending.loadAcquire())
+            reclaim();
+    }
+
+private:
+    Q_DISABLE_COPY(QQmlMetaTypeSnapshot)
+
+    int enter();
+    void leave(int e);
+    void reclaim();
+    const T *get(const T &tables, bool *locked);
+
+    struct Retired {
+        T *tables;
+        int epoch;
+    };
+
+    QAtomicPointer<T> current;
+    QAtomicInt lockedReads; // reads of the live tables since the last modification
+    QAtomicInt epoch;
+    QAtomicInt readers[2]; // by the parity of the epoch they entered in
+    QAtomicInt pending; // retired.count(), for readers leaving
+    QMutex retiredMutex;
+    QVector<Retired> retired;
+};
+
+// The parts of QQmlMetaTypeData that lookups read
+struct QQmlMetaTypeTables
+{
+    QQmlMetaTypeTables();
+
     QList<QQmlType *> types;
     typedef QHash<int, QQmlType *> Ids;
     Ids idToType;
@@ -107,6 +196,14 @@ struct QQmlMetaTypeData
 
     QList<QQmlPrivate::AutoParentFunction> parentFunctions;
     QQmlPrivate::QmlUnitCacheLookupFunction lookupCachedQmlUnit;
+};
+
+struct QQmlMetaTypeData : public QQmlMetaTypeTables
+{
+    QQmlMetaTypeData();
+    ~QQmlMetaTypeData();
+
+    QQmlMetaTypeSnapshot<QQmlMetaTypeTables> snapshot;
 
     QSet<QString> protectedNamespaces;
 
@@ -130,8 +227,12 @@ public:
 
     void add(QQmlType *);
 
-    QStringHash<QList<QQmlType *> > typeHash;
-    QList<QQmlType *> types;
+    struct Tables {
+        QStringHash<QList<QQmlType *> > typeHash;
+        QList<QQmlType *> types;
+    };
+    Tables tables;
+    QQmlMetaTypeSnapshot<Tables> snapshot;
 };
 
 Q_GLOBAL_STATIC(QQmlMetaTypeData, metaTypeData)
@@ -142,11 +243,100 @@ static uint qHash(const QQmlMetaTypeData::VersionedUri &v)
     return v.uri.hash() ^ qHash(v.majorVersion);
 }
 
-QQmlMetaTypeData::QQmlMetaTypeData()
+template<typename T>
+QQmlMetaTypeSnapshot<T>::ReadGuard::~ReadGuard()
+{
+    if (locked)
+        metaTypeDataLock()->unlock();
+    snapshot.leave(epoch);
+}
+
+template<typename T>
+int QQmlMetaTypeSnapshot<T>::enter()
+{
+    forever {
+        const int e = epoch.loadAcquire();
+        readers[e & 1].ref();
+        // If the epoch moved on meanwhile, the slot may have been found empty before we
+        // registered in it
+        if (epoch.loadAcquire() == e)
+            return e;
+        leave(e);
+    }
+}
+
+template<typename T>
+void QQmlMetaTypeSnapshot<T>::leave(int e)
+{
+    if (!readers[e & 1].deref() && pending.loadAcquire())
+        reclaim();
+}
+
+template<typename T>
+void QQmlMetaTypeSnapshot<T>::reclaim()
+{
+    QMutexLocker lock(&retiredMutex);
+    forever {
+        const int e = epoch.load();
+        // A read-modify-write, so that it is ordered against readers registering
+        if (readers[(e - 1) & 1].fetchAndAddOrdered(0) != 0)
+            break;
+
+        bool retiredInEpoch = false;
+        for (int ii = retired.count() - 1; ii >= 0; --ii) {
+            if (retired.at(ii).epoch == e) {
+                retiredInEpoch = true;
+            } else {
+                delete retired.at(ii).tables;
+                retired.remove(ii);
+            }
+        }
+        if (!retiredInEpoch)
+            break;
+        epoch.storeRelease(e + 1);
+    }
+    pending.storeRelease(retired.count());
+}
+
+template<typename T>
+const T *QQmlMetaTypeSnapshot<T>::get(const T &tables, bool *locked)
+{
+    if (const T *t = current.loadAcquire())
+        return t;
+
+    metaTypeDataLock()->lockForRead();
+    if (lockedReads.fetchAndAddRelaxed(1) < tables.types.count()) {
+        *locked = true;
+        return &tables;
+    }
+
+    // Writers are excluded while copying, so racing readers publish equal copies
+    T *t = new T(tables);
+    if (!current.testAndSetOrdered(0, t)) {
+        delete t;
+        t = current.loadAcquire();
+    }
+    metaTypeDataLock()->unlock();
+    return t;
+}
+
+// Reads the registry, without taking metaTypeDataLock once a snapshot is published
+class QQmlMetaTypeReader : public QQmlMetaTypeSnapshot<QQmlMetaTypeTables>::ReadGuard
+{
+public:
+    QQmlMetaTypeReader()
+    : ReadGuard(metaTypeData()->snapshot, *metaTypeData()) {}
+};
+
+QQmlMetaTypeTables::QQmlMetaTypeTables()
     : lookupCachedQmlUnit(0)
 {
 }
 
+QQmlMetaTypeData::QQmlMetaTypeData()
+{
+}
+
 QQmlMetaTypeData::~QQmlMetaTypeData()
 {
     for (int i = 0; i < types.count(); ++i)
@@ -995,21 +1185,19 @@ void QQmlTypeModulePrivate::add(QQmlType *type)
     minMinorVersion = qMin(minMinorVersion, type->minorVersion());
     maxMinorVersion = qMax(maxMinorVersion, type->minorVersion());
 
-    QList<QQmlType *> &list = typeHash[type->elementName()];
-    for (int ii = 0; ii < list.count(); ++ii) {
-        if (list.at(ii)->minorVersion() < type->minorVersion()) {
-            list.insert(ii, type);
-            return;
-        }
-    }
-    list.append(type);
+    QList<QQmlType *> &list = tables.typeHash[type->elementName()];
+    int ii = 0;
+    while (ii < list.count() && list.at(ii)->minorVersion() >= type->minorVersion())
+        ++ii;
+    list.insert(ii, type);
+
+    snapshot.invalidate();
 }
 
 QQmlType *QQmlTypeModule::type(const QHashedStringRef &name, int minor)
 {
-    QReadLocker lock(metaTypeDataLock());
-
-    QList<QQmlType *> *types = d->typeHash.value(name);
+    QQmlMetaTypeSnapshot<QQmlTypeModulePrivate::Tables>::ReadGuard tables(d->snapshot, d->tables);
+    QList<QQmlType *> *types = tables->typeHash.value(name);
     if (!types) return 0;
 
     for (int ii = 0; ii < types->count(); ++ii)
@@ -1021,9 +1209,8 @@ QQmlType *QQmlTypeModule::type(const QHashedStringRef &name, int minor)
 
 QQmlType *QQmlTypeModule::type(const QV4::String *name, int minor)
 {
-    QReadLocker lock(metaTypeDataLock());
-
-    QList<QQmlType *> *types = d->typeHash.value(name);
+    QQmlMetaTypeSnapshot<QQmlTypeModulePrivate::Tables>::ReadGuard tables(d->snapshot, d->tables);
+    QList<QQmlType *> *types = tables->typeHash.value(name);
     if (!types) return 0;
 
     for (int ii = 0; ii < types->count(); ++ii)
@@ -1035,11 +1222,12 @@ QQmlType *QQmlTypeModule::type(const QV4::String *name, int minor)
 
 QList<QQmlType*> QQmlTypeModule::singletonTypes(int minor) const
 {
-    QReadLocker lock(metaTypeDataLock());
+    QQmlMetaTypeSnapshot<QQmlTypeModulePrivate::Tables>::ReadGuard tables(d->snapshot, d->tables);
+    const QList<QQmlType *> &types = tables->types;
 
     QList<QQmlType *> retn;
-    for (int ii = 0; ii < d->types.count(); ++ii) {
-        QQmlType *curr = d->types.at(ii);
+    for (int ii = 0; ii < types.count(); ++ii) {
+        QQmlType *curr = types.at(ii);
         if (curr->isSingleton() && curr->minorVersion() <= minor)
             retn.append(curr);
     }
@@ -1113,6 +1301,7 @@ void qmlClearTypeRegistrations() // Declared in qqml.h
     data->urlToNonFileImportType.clear();
     data->metaObjectToType.clear();
     data->uriToModule.clear();
+    data->snapshot.invalidate();
 
     QQmlEnginePrivate::baseModulesUninitialized = true; //So the engine re-registers its types
     qmlClearEnginePlugins();
@@ -1124,6 +1313,7 @@ int registerAutoParentFunction(QQmlPrivate::RegisterAutoParent &autoparent)
     QQmlMetaTypeData *data = metaTypeData();
 
     data->parentFunctions.append(autoparent.function);
+    data->snapshot.invalidate();
 
     return data->parentFunctions.count() - 1;
 }
@@ -1153,6 +1343,7 @@ int registerInterface(const QQmlPrivate::RegisterInterface &interface)
         data->lists.resize(interface.listId + 16);
     data->interfaces.setBit(interface.typeId, true);
     data->lists.setBit(interface.listId, true);
+    data->snapshot.invalidate();
 
     return index;
 }
@@ -1275,6 +1466,7 @@ int registerType(const QQmlPrivate::RegisterType &type)
     addTypeToData(dtype, data);
     if (!type.typeId)
         data->idToType.insert(dtype->typeId(), dtype);
+    data->snapshot.invalidate();
 
     return index;
 }
@@ -1293,6 +1485,7 @@ int registerSingletonType(const QQmlPrivate::RegisterSingletonType &type)
 
     data->types.append(dtype);
     addTypeToData(dtype, data);
+    data->snapshot.invalidate();
 
     return index;
 }
@@ -1318,6 +1511,7 @@ int registerCompositeSingletonType(const QQmlPrivate::RegisterCompositeSingleton
 
     QQmlMetaTypeData::Files *files = fileImport ? &(data->urlToType) : &(data->urlToNonFileImportType);
     files->insertMulti(type.url, dtype);
+    data->snapshot.invalidate();
 
     return index;
 }
@@ -1342,6 +1536,7 @@ int registerCompositeType(const QQmlPrivate::RegisterCompositeType &type)
 
     QQmlMetaTypeData::Files *files = fileImport ? &(data->urlToType) : &(data->urlToNonFileImportType);
     files->insertMulti(type.url, dtype);
+    data->snapshot.invalidate();
 
     return index;
 }
@@ -1353,6 +1548,7 @@ int registerQmlUnitCacheHook(const QQmlPrivate::RegisterQmlUnitCacheHook &hookRe
     QWriteLocker lock(metaTypeDataLock());
     QQmlMetaTypeData *data = metaTypeData();
     data->lookupCachedQmlUnit = hookRegistration.lookupCachedQmlUnit;
+    data->snapshot.invalidate();
     return 0;
 }
 
@@ -1442,8 +1638,7 @@ QReadWriteLock *QQmlMetaType::typeRegistrationLock()
 */
 bool QQmlMetaType::isAnyModule(const QString &uri)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     for (QQmlMetaTypeData::TypeModules::ConstIterator iter = data->uriToModule.begin();
          iter != data->uriToModule.end(); ++iter) {
@@ -1459,8 +1654,7 @@ bool QQmlMetaType::isAnyModule(const QString &uri)
 */
 bool QQmlMetaType::isLockedModule(const QString &uri, int majVersion)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlMetaTypeData::VersionedUri versionedUri;
     versionedUri.uri = uri;
@@ -1480,9 +1674,7 @@ bool QQmlMetaType::isLockedModule(const QString &uri, int majVersion)
 bool QQmlMetaType::isModule(const QString &module, int versionMajor, int versionMinor)
 {
     Q_ASSERT(versionMajor >= 0 && versionMinor >= 0);
-    QReadLocker lock(metaTypeDataLock());
-
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     // first, check Types
     QQmlTypeModule *tm =
@@ -1495,15 +1687,13 @@ bool QQmlMetaType::isModule(const QString &module, int versionMajor, int version
 
 QQmlTypeModule *QQmlMetaType::typeModule(const QString &uri, int majorVersion)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return data->uriToModule.value(QQmlMetaTypeData::VersionedUri(uri, majorVersion));
 }
 
 QList<QQmlPrivate::AutoParentFunction> QQmlMetaType::parentFunctions()
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return data->parentFunctions;
 }
 
@@ -1524,8 +1714,7 @@ bool QQmlMetaType::isQObject(int userType)
     if (userType == QMetaType::QObjectStar)
         return true;
 
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return userType >= 0 && userType < data->objects.size() && data->objects.testBit(userType);
 }
 
@@ -1534,8 +1723,7 @@ bool QQmlMetaType::isQObject(int userType)
  */
 int QQmlMetaType::listType(int id)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     QQmlType *type = data->idToType.value(id);
     if (type && type->qListTypeId() == id)
         return type->typeId();
@@ -1545,8 +1733,7 @@ int QQmlMetaType::listType(int id)
 
 int QQmlMetaType::attachedPropertiesFuncId(const QMetaObject *mo)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlType *type = data->metaObjectToType.value(mo);
     if (type && type->attachedPropertiesFunction())
@@ -1559,8 +1746,7 @@ QQmlAttachedPropertiesFunc QQmlMetaType::attachedPropertiesFuncById(int id)
 {
     if (id < 0)
         return 0;
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return data->types.at(id)->attachedPropertiesFunction();
 }
 
@@ -1623,8 +1809,7 @@ QQmlMetaType::TypeCategory QQmlMetaType::typeCategory(int userType)
     if (userType == QMetaType::QObjectStar)
         return Object;
 
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     if (userType < data->objects.size() && data->objects.testBit(userType))
         return Object;
     else if (userType < data->lists.size() && data->lists.testBit(userType))
@@ -1635,17 +1820,14 @@ QQmlMetaType::TypeCategory QQmlMetaType::typeCategory(int userType)
 
 bool QQmlMetaType::isInterface(int userType)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return userType >= 0 && userType < data->interfaces.size() && data->interfaces.testBit(userType);
 }
 
 const char *QQmlMetaType::interfaceIId(int userType)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     QQmlType *type = data->idToType.value(userType);
-    lock.unlock();
     if (type && type->isInterface() && type->typeId() == userType)
         return type->interfaceIId();
     else
@@ -1654,8 +1836,7 @@ const char *QQmlMetaType::interfaceIId(int userType)
 
 bool QQmlMetaType::isList(int userType)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return userType >= 0 && userType < data->lists.size() && data->lists.testBit(userType);
 }
 
@@ -1682,6 +1863,7 @@ void QQmlMetaType::registerCustomStringConverter(int type, StringConverter conve
     if (data->stringConverters.contains(type))
         return;
     data->stringConverters.insert(type, converter);
+    data->snapshot.invalidate();
 }
 
 /*!
@@ -1690,9 +1872,7 @@ void QQmlMetaType::registerCustomStringConverter(int type, StringConverter conve
  */
 QQmlMetaType::StringConverter QQmlMetaType::customStringConverter(int type)
 {
-    QReadLocker lock(metaTypeDataLock());
-
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     return data->stringConverters.value(type);
 }
 
@@ -1719,8 +1899,7 @@ QQmlType *QQmlMetaType::qmlType(const QString &qualifiedName, int version_major,
 QQmlType *QQmlMetaType::qmlType(const QHashedStringRef &name, const QHashedStringRef &module, int version_major, int version_minor)
 {
     Q_ASSERT(version_major >= 0 && version_minor >= 0);
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlMetaTypeData::Names::ConstIterator it = data->nameToType.constFind(name);
     while (it != data->nameToType.end() && it.key() == name) {
@@ -1739,8 +1918,7 @@ QQmlType *QQmlMetaType::qmlType(const QHashedStringRef &name, const QHashedStrin
 */
 QQmlType *QQmlMetaType::qmlType(const QMetaObject *metaObject)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     return data->metaObjectToType.value(metaObject);
 }
@@ -1753,8 +1931,7 @@ QQmlType *QQmlMetaType::qmlType(const QMetaObject *metaObject)
 QQmlType *QQmlMetaType::qmlType(const QMetaObject *metaObject, const QHashedStringRef &module, int version_major, int version_minor)
 {
     Q_ASSERT(version_major >= 0 && version_minor >= 0);
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlMetaTypeData::MetaObjects::const_iterator it = data->metaObjectToType.constFind(metaObject);
     while (it != data->metaObjectToType.end() && it.key() == metaObject) {
@@ -1773,8 +1950,7 @@ QQmlType *QQmlMetaType::qmlType(const QMetaObject *metaObject, const QHashedStri
 */
 QQmlType *QQmlMetaType::qmlType(int userType)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlType *type = data->idToType.value(userType);
     if (type && type->typeId() == userType)
@@ -1791,8 +1967,7 @@ QQmlType *QQmlMetaType::qmlType(int userType)
 */
 QQmlType *QQmlMetaType::qmlType(const QUrl &url, bool includeNonFileImports /* = false */)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QQmlType *type = data->urlToType.value(url);
     if (!type && includeNonFileImports)
@@ -1811,8 +1986,7 @@ QQmlType *QQmlMetaType::qmlType(const QUrl &url, bool includeNonFileImports /* =
 */
 QQmlType *QQmlMetaType::qmlTypeFromIndex(int idx)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     if (idx < 0 || idx >= data->types.count())
             return 0;
@@ -1824,8 +1998,7 @@ QQmlType *QQmlMetaType::qmlTypeFromIndex(int idx)
 */
 QList<QString> QQmlMetaType::qmlTypeNames()
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QList<QString> names;
     QQmlMetaTypeData::Names::ConstIterator it = data->nameToType.begin();
@@ -1842,8 +2015,7 @@ QList<QString> QQmlMetaType::qmlTypeNames()
 */
 QList<QQmlType*> QQmlMetaType::qmlTypes()
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     return data->nameToType.values();
 }
@@ -1853,8 +2025,7 @@ QList<QQmlType*> QQmlMetaType::qmlTypes()
 */
 QList<QQmlType*> QQmlMetaType::qmlAllTypes()
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     return data->types;
 }
@@ -1864,8 +2035,7 @@ QList<QQmlType*> QQmlMetaType::qmlAllTypes()
 */
 QList<QQmlType*> QQmlMetaType::qmlSingletonTypes()
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
 
     QList<QQmlType*> alltypes = data->nameToType.values();
     QList<QQmlType*> retn;
@@ -1880,8 +2050,7 @@ QList<QQmlType*> QQmlMetaType::qmlSingletonTypes()
 
 const QQmlPrivate::CachedQmlUnit *QQmlMetaType::findCachedCompilationUnit(const QUrl &uri)
 {
-    QReadLocker lock(metaTypeDataLock());
-    QQmlMetaTypeData *data = metaTypeData();
+    QQmlMetaTypeReader data;
     if (data->lookupCachedQmlUnit)
         return data->lookupCachedQmlUnit(uri);
     return 0;
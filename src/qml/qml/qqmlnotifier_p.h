@@ -90,6 +90,11 @@ public:
     inline bool isConnected(QObject *source, int sourceSignal);
     inline bool isConnected(QQmlNotifier *);
 
+    // The QObject or QQmlNotifier this endpoint is connected to, and the signal index
+    // (-1 for a QQmlNotifier).  Together they identify the connection.
+    inline const void *sender() const { return senderAsObject(); }
+    inline int signalIndex() const { return sourceSignal; }
+
     void connect(QObject *source, int sourceSignal, QQmlEngine *engine);
     inline void connect(QQmlNotifier *);
     inline void disconnect();
@@ -287,6 +287,15 @@ public:
         return findProperty(stringCache.find(key), object, context);
     }
 
+    // True if nothing else is called key, then property() resolves it the same way
+    // for every object and context
+    template<typename K>
+    bool isUniqueName(const K &key) const
+    {
+        StringCache::ConstIterator it = stringCache.find(key);
+        return it != stringCache.end() && stringCache.findNext(it) == stringCache.end();
+    }
+
     QQmlPropertyData *property(int) const;
     QQmlPropertyData *method(int) const;
     QQmlPropertyData *signal(int index) const { return signal(index, 0); }
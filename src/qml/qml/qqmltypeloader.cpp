@@ -52,6 +52,8 @@
 #include <private/qqmlprofiler_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
 #include <private/qqmltypecompiler_p.h>
+#include <private/qqmldiskcache_p.h>
+#include <private/qqmlimportindex_p.h>
 
 #include <QtCore/qdir.h>
 #include <QtCore/qfile.h>
@@ -59,7 +61,9 @@
 #include <QtCore/qmutex.h>
 #include <QtCore/qthread.h>
 #include <QtQml/qqmlfile.h>
+#include <QtCore/qrunnable.h>
 #include <QtCore/qdiriterator.h>
+#include <QtCore/qthreadpool.h>
 #include <QtQml/qqmlcomponent.h>
 #include <QtCore/qwaitcondition.h>
 #include <QtQml/qqmlextensioninterface.h>
@@ -169,6 +173,19 @@ private:
     mutable QQmlDataLoaderNetworkReplyProxy *m_networkReplyProxy;
 };
 
+// Reads and prepares one blob in a worker thread of the loader.
+class QQmlDataLoaderPrepareTask : public QRunnable
+{
+public:
+    QQmlDataLoaderPrepareTask(QQmlDataLoader *loader, QQmlDataBlob *blob)
+    : m_loader(loader), m_blob(blob) {}
+
+    virtual void run() { m_loader->prepareThread(m_blob); }
+
+private:
+    QQmlDataLoader *m_loader;
+    QQmlDataBlob *m_blob;
+};
 
 QQmlDataLoaderNetworkReplyProxy::QQmlDataLoaderNetworkReplyProxy(QQmlDataLoader *l)
 : l(l)
@@ -244,7 +261,7 @@ Create a new QQmlDataBlob for \a url and of the provided \a type.
 */
 QQmlDataBlob::QQmlDataBlob(const QUrl &url, Type type)
 : m_type(type), m_url(url), m_finalUrl(url), m_manager(0), m_redirectCount(0),
-  m_inCallback(false), m_isDone(false)
+  m_inCallback(false), m_isDone(false), m_isPreparing(false)
 {
 }
 
@@ -364,11 +381,11 @@ Returns the final url of the data.  Initially this is the same as
 url(), but if a network redirect happens while fetching the data, this url
 is updated to reflect the new location.
 
-May only be called from the load thread, or after the blob isCompleteOrError().
+May only be called from the load thread, from prepare(), or after the blob isCompleteOrError().
 */
 QUrl QQmlDataBlob::finalUrl() const
 {
-    Q_ASSERT(isCompleteOrError() || (m_manager && m_manager->m_thread->isThisThread()));
+    Q_ASSERT(isCompleteOrError() || m_isPreparing || (m_manager && m_manager->m_thread->isThisThread()));
     return m_finalUrl;
 }
 
@@ -377,7 +394,7 @@ Returns the finalUrl() as a string.
 */
 QString QQmlDataBlob::finalUrlString() const
 {
-    Q_ASSERT(isCompleteOrError() || (m_manager && m_manager->m_thread->isThisThread()));
+    Q_ASSERT(isCompleteOrError() || m_isPreparing || (m_manager && m_manager->m_thread->isThisThread()));
     if (m_finalUrlString.isEmpty())
         m_finalUrlString = m_finalUrl.toString();
 
@@ -569,6 +586,23 @@ void QQmlDataBlob::allDependenciesDone()
 {
 }
 
+/*!
+Invoked in a worker thread of the loader with the data of a local file, before
+dataReceived() is called with the same data in the load thread.  Worker threads are
+only used if the QML_TYPELOADER_THREADS environment variable is set.
+
+Implementors can use this callback to do expensive processing that does not depend
+on other blobs, such as parsing.  Other blobs and the loader must not be accessed,
+the engine must not be modified, and neither setError() nor addDependency() may be
+called.  The blob's finalUrl() and finalUrlString() are available.
+
+The default implementation does nothing.
+*/
+void QQmlDataBlob::prepare(const Data &data)
+{
+    Q_UNUSED(data);
+}
+
 /*!
 Called when the download progress of this blob changes.  \a progress goes
 from 0 to 1.
@@ -821,18 +855,21 @@ void QQmlDataLoaderThread::shutdownThread()
 void QQmlDataLoaderThread::loadThread(QQmlDataBlob *b)
 {
     m_loader->loadThread(b);
+    m_loader->processPreparedBlobs();
     b->release();
 }
 
 void QQmlDataLoaderThread::loadWithStaticDataThread(QQmlDataBlob *b, const QByteArray &d)
 {
     m_loader->loadWithStaticDataThread(b, d);
+    m_loader->processPreparedBlobs();
     b->release();
 }
 
 void QQmlDataLoaderThread::loadWithCachedUnitThread(QQmlDataBlob *b, const QQmlPrivate::CachedQmlUnit *unit)
 {
     m_loader->loadWithCachedUnitThread(b, unit);
+    m_loader->processPreparedBlobs();
     b->release();
 }
 
@@ -891,14 +928,27 @@ one of these three preconditions are met.
 \endlist
 
 Thus QQmlDataBlob::done() will always eventually be called, even if the blob has an error set.
+
+If the QML_TYPELOADER_THREADS environment variable is set to a positive number, local files
+are read by a pool of that many worker threads, which also call QQmlDataBlob::prepare() so
+that independent blobs can be parsed in parallel.  All other callbacks are still made in the
+load thread, which waits for the outstanding blobs before returning to its event loop.
+Synchronous loads therefore behave as if the worker threads weren't there.
 */
 
 /*!
 Create a new QQmlDataLoader for \a engine.
 */
 QQmlDataLoader::QQmlDataLoader(QQmlEngine *engine)
-: m_engine(engine), m_thread(new QQmlDataLoaderThread(this))
+: m_engine(engine), m_thread(new QQmlDataLoaderThread(this)), m_workers(0),
+  m_pendingPrepares(0), m_processingPrepared(false)
 {
+    bool ok = false;
+    const int workerCount = qgetenv("QML_TYPELOADER_THREADS").toInt(&ok);
+    if (ok && workerCount > 0) {
+        m_workers = new QThreadPool;
+        m_workers->setMaxThreadCount(workerCount);
+    }
 }
 
 /*! \internal */
@@ -909,6 +959,7 @@ QQmlDataLoader::~QQmlDataLoader()
 
     shutdownThread();
     delete m_thread;
+    delete m_workers;
 }
 
 void QQmlDataLoader::lock()
@@ -1063,7 +1114,9 @@ void QQmlDataLoader::loadThread(QQmlDataBlob *blob)
         }
     }
 
-    if (QQmlFile::isSynchronous(blob->m_url)) {
+    if (m_workers && QQmlFile::isLocalFile(blob->m_url)) {
+        prepareInWorker(blob);
+    } else if (QQmlFile::isSynchronous(blob->m_url)) {
         QQmlFile file(m_engine, blob->m_url);
 
         if (file.isError()) {
@@ -1142,6 +1195,8 @@ void QQmlDataLoader::networkReplyFinished(QNetworkReply *reply)
     }
 
     blob->release();
+
+    processPreparedBlobs();
 }
 
 void QQmlDataLoader::networkReplyProgress(QNetworkReply *reply,
@@ -1239,6 +1294,95 @@ void QQmlDataLoader::setCachedUnit(QQmlDataBlob *blob, const QQmlPrivate::Cached
     blob->tryDone();
 }
 
+void QQmlDataLoader::prepareInWorker(QQmlDataBlob *blob)
+{
+    ASSERT_LOADTHREAD();
+
+    // The url string is cached lazily, so make sure it is there before
+    // the worker starts reading it.
+    blob->finalUrlString();
+    blob->m_isPreparing = true;
+    blob->addref();
+
+    {
+        QMutexLocker locker(&m_preparedMutex);
+        ++m_pendingPrepares;
+    }
+
+    m_workers->start(new QQmlDataLoaderPrepareTask(this, blob));
+}
+
+void QQmlDataLoader::prepareThread(QQmlDataBlob *blob)
+{
+    PreparedBlob prepared;
+    prepared.blob = blob;
+
+    {
+        QQmlFile file(m_engine, blob->m_url);
+        if (file.isError()) {
+            prepared.error = file.error();
+        } else {
+            prepared.data = file.dataByteArray();
+            QQmlDataBlob::Data d;
+            d.d = &prepared.data;
+            blob->prepare(d);
+        }
+    }
+
+    QMutexLocker locker(&m_preparedMutex);
+    m_preparedBlobs.append(prepared);
+    m_preparedCondition.wakeOne();
+}
+
+/*!
+Makes the remaining callbacks for the blobs handed to the worker threads, in the order
+in which they were prepared, until none are outstanding.  Blobs loaded by these callbacks
+are waited for as well.
+*/
+void QQmlDataLoader::processPreparedBlobs()
+{
+    ASSERT_LOADTHREAD();
+
+    if (!m_workers || m_processingPrepared)
+        return;
+
+    m_processingPrepared = true;
+
+    QMutexLocker locker(&m_preparedMutex);
+    while (m_pendingPrepares) {
+        if (m_preparedBlobs.isEmpty()) {
+            m_preparedCondition.wait(&m_preparedMutex);
+            continue;
+        }
+
+        PreparedBlob prepared = m_preparedBlobs.takeFirst();
+        --m_pendingPrepares;
+        locker.unlock();
+
+        QQmlDataBlob *blob = prepared.blob;
+        blob->m_isPreparing = false;
+
+        if (!prepared.error.isNull()) {
+            QQmlError error;
+            error.setUrl(blob->m_url);
+            error.setDescription(prepared.error);
+            blob->setError(error);
+        } else {
+            blob->m_data.setProgress(0xFF);
+            if (blob->m_data.isAsync())
+                m_thread->callDownloadProgressChanged(blob, 1.);
+
+            setData(blob, prepared.data);
+        }
+
+        blob->release();
+
+        locker.relock();
+    }
+
+    m_processingPrepared = false;
+}
+
 void QQmlDataLoader::shutdownThread()
 {
     if (!m_thread->isShutdown())
@@ -1577,6 +1721,11 @@ Constructs a new type loader that uses the given \a engine.
 QQmlTypeLoader::QQmlTypeLoader(QQmlEngine *engine)
 : QQmlDataLoader(engine)
 {
+    const QString diskCacheDirectory = QQmlDiskCache::defaultDirectory();
+    if (!diskCacheDirectory.isEmpty()) {
+        m_diskCache.reset(new QQmlDiskCache(diskCacheDirectory));
+        m_importIndex.reset(new QQmlImportIndex(diskCacheDirectory));
+    }
 }
 
 /*!
@@ -1588,6 +1737,9 @@ QQmlTypeLoader::~QQmlTypeLoader()
     // Stop the loader thread before releasing resources
     shutdownThread();
 
+    if (m_importIndex)
+        m_importIndex->save();
+
     clearCache();
 }
 
@@ -1927,8 +2079,11 @@ const QQmlTypeLoader::QmldirContent *QQmlTypeLoader::qmldirContent(const QString
         } else {
 
             QFile file(filePath);
+            QString content;
             if (!QQml_isFileCaseCorrect(filePath)) {
                 ERROR(CASE_MISMATCH_ERROR.arg(filePath));
+            } else if (m_importIndex && m_importIndex->lookupQmldir(filePath, &content)) {
+                qmldir->setContent(filePath, content);
             } else if (file.open(QFile::ReadOnly)) {
                 QByteArray data = file.read(QQmlBundle::bundleHeaderLength());
 
@@ -1948,7 +2103,10 @@ const QQmlTypeLoader::QmldirContent *QQmlTypeLoader::qmldirContent(const QString
                     }
                 } else {
                     data += file.readAll();
-                    qmldir->setContent(filePath, QString::fromUtf8(data));
+                    content = QString::fromUtf8(data);
+                    qmldir->setContent(filePath, content);
+                    if (m_importIndex)
+                        m_importIndex->insertQmldir(filePath, content);
                 }
             } else {
                 ERROR(NOT_READABLE_ERROR.arg(filePath));
@@ -2211,6 +2369,25 @@ bool QQmlTypeData::loadImplicitImport()
 }
 
 void QQmlTypeData::dataReceived(const Data &data)
+{
+    // The document may already have been parsed by prepare()
+    if (!m_document)
+        parse(data);
+
+    if (!m_parseErrors.isEmpty()) {
+        setError(m_parseErrors);
+        return;
+    }
+
+    continueLoadFromIR();
+}
+
+void QQmlTypeData::prepare(const Data &data)
+{
+    parse(data);
+}
+
+void QQmlTypeData::parse(const Data &data)
 {
     QString code = QString::fromUtf8(data.data(), data.size());
     QByteArray preparseData;
@@ -2221,20 +2398,15 @@ void QQmlTypeData::dataReceived(const Data &data)
     m_document.reset(new QmlIR::Document(QV8Engine::getV4(qmlEngine)->debugger != 0));
     QmlIR::IRBuilder compiler(QV8Engine::get(qmlEngine)->illegalNames());
     if (!compiler.generateFromQml(code, finalUrlString(), finalUrlString(), m_document.data())) {
-        QList<QQmlError> errors;
         foreach (const QQmlJS::DiagnosticMessage &msg, compiler.errors) {
             QQmlError e;
             e.setUrl(finalUrl());
             e.setLine(msg.loc.startLine);
             e.setColumn(msg.loc.startColumn);
             e.setDescription(msg.message);
-            errors << e;
+            m_parseErrors << e;
         }
-        setError(errors);
-        return;
     }
-
-    continueLoadFromIR();
 }
 
 void QQmlTypeData::initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit)
@@ -2672,12 +2844,16 @@ void QQmlScriptData::clear()
 }
 
 QQmlScriptBlob::QQmlScriptBlob(const QUrl &url, QQmlTypeLoader *loader)
-: QQmlTypeLoader::Blob(url, JavaScriptFile, loader), m_scriptData(0)
+: QQmlTypeLoader::Blob(url, JavaScriptFile, loader), m_scriptData(0), m_preparedUnit(0),
+  m_isPrepared(false)
 {
 }
 
 QQmlScriptBlob::~QQmlScriptBlob()
 {
+    if (m_preparedUnit)
+        m_preparedUnit->deref();
+
     if (m_scriptData) {
         m_scriptData->release();
         m_scriptData = 0;
@@ -2691,9 +2867,49 @@ QQmlScriptData *QQmlScriptBlob::scriptData() const
 
 void QQmlScriptBlob::dataReceived(const Data &data)
 {
-    QString source = QString::fromUtf8(data.data(), data.size());
+    QList<QQmlError> errors;
+    QV4::CompiledData::CompilationUnit *unit = 0;
+    if (m_isPrepared) {
+        unit = m_preparedUnit;
+        errors = m_preparedErrors;
+        m_preparedUnit = 0;
+        m_preparedErrors.clear();
+    } else {
+        unit = compile(data, &errors);
+    }
+
+    if (!errors.isEmpty()) {
+        setError(errors);
+        return;
+    }
 
+    initializeFromCompilationUnit(unit);
+    unit->deref();
+}
+
+void QQmlScriptBlob::prepare(const Data &data)
+{
+    m_preparedUnit = compile(data, &m_preparedErrors);
+    m_isPrepared = true;
+}
+
+// Returns a referenced unit, or 0 if \a errors were reported.
+QV4::CompiledData::CompilationUnit *QQmlScriptBlob::compile(const Data &data, QList<QQmlError> *errors)
+{
     QV4::ExecutionEngine *v4 = QV8Engine::getV4(m_typeLoader->engine());
+
+    // Byte code generated for the debugger differs, so don't cache that.
+    QQmlDiskCache *diskCache = v4->debugger ? 0 : m_typeLoader->diskCache();
+    const QByteArray rawSource = QByteArray::fromRawData(data.data(), data.size());
+    if (diskCache) {
+        if (QV4::CompiledData::CompilationUnit *unit = diskCache->load(v4, finalUrl(), rawSource)) {
+            unit->ref();
+            return unit;
+        }
+    }
+
+    QString source = QString::fromUtf8(data.data(), data.size());
+
     QmlIR::Document irUnit(v4->debugger != 0);
     QQmlJS::DiagnosticMessage metaDataError;
     irUnit.extractScriptMetaData(source, &metaDataError);
@@ -2703,20 +2919,18 @@ void QQmlScriptBlob::dataReceived(const Data &data)
         e.setLine(metaDataError.loc.startLine);
         e.setColumn(metaDataError.loc.startColumn);
         e.setDescription(metaDataError.message);
-        setError(e);
-        return;
+        *errors << e;
+        return 0;
     }
 
-    QList<QQmlError> errors;
-    QV4::CompiledData::CompilationUnit *unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, finalUrl(), source, &errors);
+    QV4::CompiledData::CompilationUnit *unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, finalUrl(), source, errors);
     if (unit)
         unit->ref();
     source.clear();
-    if (!errors.isEmpty()) {
+    if (!errors->isEmpty()) {
         if (unit)
             unit->deref();
-        setError(errors);
-        return;
+        return 0;
     }
     irUnit.javaScriptCompilationUnit = unit;
 
@@ -2727,8 +2941,10 @@ void QQmlScriptBlob::dataReceived(const Data &data)
     // The js unit owns the data and will free the qml unit.
     unit->data = &qmlUnit->header;
 
-    initializeFromCompilationUnit(unit);
-    unit->deref();
+    if (diskCache)
+        diskCache->store(finalUrl(), rawSource, unit);
+
+    return unit;
 }
 
 void QQmlScriptBlob::initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit)
@@ -55,6 +55,8 @@
 
 #include <QtCore/qobject.h>
 #include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
 #include <QtNetwork/qnetworkreply.h>
 #include <QtQml/qqmlerror.h>
 #include <QtQml/qqmlengine.h>
@@ -83,6 +85,9 @@ class QQmlComponentPrivate;
 class QQmlTypeData;
 class QQmlDataLoader;
 class QQmlExtensionInterface;
+class QQmlDiskCache;
+class QQmlImportIndex;
+class QThreadPool;
 
 namespace QmlIR {
 struct Document;
@@ -162,6 +167,9 @@ protected:
     virtual void dependencyComplete(QQmlDataBlob *);
     virtual void allDependenciesDone();
 
+    // Callback made in a worker thread of the loader, before dataReceived()
+    virtual void prepare(const Data &);
+
     // Callbacks made in main thread
     virtual void downloadProgressChanged(qreal);
     virtual void completed();
@@ -208,9 +216,10 @@ private:
 
     // Manager that is currently fetching data for me
     QQmlDataLoader *m_manager;
-    int m_redirectCount:30;
+    int m_redirectCount:29;
     bool m_inCallback:1;
     bool m_isDone:1;
+    bool m_isPreparing:1;
 };
 
 class QQmlDataLoaderThread;
@@ -241,6 +250,7 @@ private:
     friend class QQmlDataBlob;
     friend class QQmlDataLoaderThread;
     friend class QQmlDataLoaderNetworkReplyProxy;
+    friend class QQmlDataLoaderPrepareTask;
 
     void loadThread(QQmlDataBlob *);
     void loadWithStaticDataThread(QQmlDataBlob *, const QByteArray &);
@@ -255,9 +265,28 @@ private:
     void setData(QQmlDataBlob *, const QQmlDataBlob::Data &);
     void setCachedUnit(QQmlDataBlob *blob, const QQmlPrivate::CachedQmlUnit *unit);
 
+    void prepareInWorker(QQmlDataBlob *);
+    void prepareThread(QQmlDataBlob *);
+    void processPreparedBlobs();
+
+    struct PreparedBlob {
+        QQmlDataBlob *blob;
+        QByteArray data;
+        QString error;
+    };
+
     QQmlEngine *m_engine;
     QQmlDataLoaderThread *m_thread;
     NetworkReplies m_networkReplies;
+
+    // Worker threads that read and parse local files.  Only the load thread
+    // makes blob callbacks; it waits for the prepared blobs and feeds them back.
+    QThreadPool *m_workers;
+    QMutex m_preparedMutex;
+    QWaitCondition m_preparedCondition;
+    QList<PreparedBlob> m_preparedBlobs;
+    int m_pendingPrepares;
+    bool m_processingPrepared;
 };
 
 class QQmlBundleData : public QQmlBundle,
@@ -336,6 +365,8 @@ public:
     ~QQmlTypeLoader();
 
     QQmlImportDatabase *importDatabase();
+    QQmlDiskCache *diskCache() const { return m_diskCache.data(); }
+    QQmlImportIndex *importIndex() const { return m_importIndex.data(); }
 
     QQmlTypeData *getType(const QUrl &url, Mode mode = PreferSynchronous);
     QQmlTypeData *getType(const QByteArray &, const QUrl &url);
@@ -395,6 +426,8 @@ private:
     ImportQmlDirCache m_importQmlDirCache;
     BundleCache m_bundleCache;
     QmldirBundleIdCache m_qmldirBundleIdCache;
+    QScopedPointer<QQmlDiskCache> m_diskCache;
+    QScopedPointer<QQmlImportIndex> m_importIndex;
 };
 
 class Q_AUTOTEST_EXPORT QQmlTypeData : public QQmlTypeLoader::Blob
@@ -453,11 +486,13 @@ protected:
     virtual void dataReceived(const Data &);
     virtual void initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit);
     virtual void allDependenciesDone();
+    virtual void prepare(const Data &);
     virtual void downloadProgressChanged(qreal);
 
     virtual QString stringAt(int index) const;
 
 private:
+    void parse(const Data &);
     void continueLoadFromIR();
     void resolveTypes();
     void compile();
@@ -466,6 +501,7 @@ private:
     virtual void scriptImported(QQmlScriptBlob *blob, const QV4::CompiledData::Location &location, const QString &qualifier, const QString &nameSpace);
 
     QScopedPointer<QmlIR::Document> m_document;
+    QList<QQmlError> m_parseErrors;
 
     QList<ScriptReference> m_scripts;
 
@@ -549,15 +585,22 @@ protected:
     virtual void dataReceived(const Data &);
     virtual void initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit);
     virtual void done();
+    virtual void prepare(const Data &);
 
     virtual QString stringAt(int index) const;
 
 private:
     virtual void scriptImported(QQmlScriptBlob *blob, const QV4::CompiledData::Location &location, const QString &qualifier, const QString &nameSpace);
+    QV4::CompiledData::CompilationUnit *compile(const Data &, QList<QQmlError> *errors);
     void initializeFromCompilationUnit(QV4::CompiledData::CompilationUnit *unit);
 
     QList<ScriptReference> m_scripts;
     QQmlScriptData *m_scriptData;
+
+    // Result of prepare(), consumed by dataReceived()
+    QV4::CompiledData::CompilationUnit *m_preparedUnit;
+    QList<QQmlError> m_preparedErrors;
+    bool m_isPrepared;
 };
 
 class Q_AUTOTEST_EXPORT QQmlQmldirData : public QQmlTypeLoader::Blob
@@ -56,6 +56,7 @@
 #include <private/qv4engine_p.h>
 #include <private/qv4functionobject_p.h>
 #include <private/qv4include_p.h>
+#include <private/qv4jsonparsejob_p.h>
 #include <private/qv4context_p.h>
 #include <private/qv4stringobject_p.h>
 #include <private/qv4mm_p.h>
@@ -109,6 +110,7 @@ QV4::QtObject::QtObject(ExecutionEngine *v4, QQmlEngine *qmlEngine)
     put((str = v4->newString(QStringLiteral("Synchronous"))), (v = QV4::Primitive::fromInt32(1)));
 
     defineDefaultProperty(QStringLiteral("include"), QV4Include::method_include);
+    defineDefaultProperty(QStringLiteral("parseJson"), QV4JsonParseJob::method_parseJson);
     defineDefaultProperty(QStringLiteral("isQtObject"), method_isQtObject);
     defineDefaultProperty(QStringLiteral("rgba"), method_rgba);
     defineDefaultProperty(QStringLiteral("hsla"), method_hsla);
@@ -66,6 +66,7 @@
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonvalue.h>
 #include <QtCore/qdatetime.h>
+#include <QtCore/qvector.h>
 #include <private/qsimd_p.h>
 
 #include <private/qv4value_inl_p.h>
@@ -76,6 +77,8 @@
 #include <private/qv4globalobject_p.h>
 #include <private/qv4regexpobject_p.h>
 #include <private/qv4variantobject_p.h>
+#include <private/qv4arraybuffer_p.h>
+#include <private/qv4typedarray_p.h>
 #include <private/qv4script_p.h>
 #include <private/qv4include_p.h>
 #include <private/qv4jsonobject_p.h>
@@ -124,6 +127,42 @@ QV8Engine::~QV8Engine()
     delete m_v4Engine;
 }
 
+// Copies the elements of a Float32Array or a Float64Array into a vector of the same
+// element type with one memcpy. Returns false for other types of arrays or vectors.
+static bool typedArrayToVector(QV4::TypedArray *array, int type, void *data)
+{
+    if (type == qMetaTypeId<QVector<float> >() && array->arrayType() == QV4::TypedArray::Float32Array) {
+        QVector<float> *vector = reinterpret_cast<QVector<float> *>(data);
+        vector->resize(array->length());
+        memcpy(vector->data(), array->constData(), array->byteLength);
+        return true;
+    }
+    if (type == qMetaTypeId<QVector<double> >() && array->arrayType() == QV4::TypedArray::Float64Array) {
+        QVector<double> *vector = reinterpret_cast<QVector<double> *>(data);
+        vector->resize(array->length());
+        memcpy(vector->data(), array->constData(), array->byteLength);
+        return true;
+    }
+    return false;
+}
+
+// Copies a vector of floats or doubles into a new Float32Array or Float64Array with
+// one memcpy. Returns 0 for other types.
+static QV4::Returned<QV4::TypedArray> *vectorToTypedArray(QV4::ExecutionEngine *v4, int type, const void *data)
+{
+    if (type == qMetaTypeId<QVector<float> >()) {
+        const QVector<float> *vector = reinterpret_cast<const QVector<float> *>(data);
+        return QV4::TypedArray::create(v4, QV4::TypedArray::Float32Array,
+                                       QByteArray(reinterpret_cast<const char *>(vector->constData()), vector->size() * int(sizeof(float))));
+    }
+    if (type == qMetaTypeId<QVector<double> >()) {
+        const QVector<double> *vector = reinterpret_cast<const QVector<double> *>(data);
+        return QV4::TypedArray::create(v4, QV4::TypedArray::Float64Array,
+                                       QByteArray(reinterpret_cast<const char *>(vector->constData()), vector->size() * int(sizeof(double))));
+    }
+    return 0;
+}
+
 QVariant QV8Engine::toVariant(const QV4::ValueRef value, int typeHint)
 {
     Q_ASSERT (!value->isEmpty());
@@ -156,6 +195,14 @@ QVariant QV8Engine::toVariant(const QV4::ValueRef value, int typeHint)
             return v->toVariant();
         } else if (QV4::QmlListWrapper *l = object->as<QV4::QmlListWrapper>()) {
             return l->toVariant();
+        } else if (QV4::ArrayBuffer *b = object->as<QV4::ArrayBuffer>()) {
+            return b->asByteArray();
+        } else if (QV4::TypedArray *a = object->as<QV4::TypedArray>()) {
+            if (typeHint > 0) {
+                QVariant vector(typeHint, (const void *)0);
+                if (typedArrayToVector(a, typeHint, vector.data()))
+                    return vector;
+            }
         } else if (object->isListType())
             return QV4::SequencePrototype::toVariant(object);
     }
@@ -338,6 +385,8 @@ QV4::ReturnedValue QV8Engine::fromVariant(const QVariant &variant)
             return a.asReturnedValue();
         } else if (QMetaType::typeFlags(type) & QMetaType::PointerToQObject) {
             return QV4::QObjectWrapper::wrap(m_v4Engine, *reinterpret_cast<QObject* const *>(ptr));
+        } else if (QV4::Returned<QV4::TypedArray> *array = vectorToTypedArray(m_v4Engine, type, ptr)) {
+            return QV4::Encode(array);
         }
 
         bool objOk;
@@ -409,6 +458,8 @@ QVariant QV8Engine::toBasicVariant(const QV4::ValueRef value)
 
     if (QV4::RegExpObject *re = o->as<QV4::RegExpObject>())
         return re->toQRegExp();
+    if (QV4::ArrayBuffer *b = o->as<QV4::ArrayBuffer>())
+        return b->asByteArray();
     if (o->asArrayObject()) {
         QV4::ScopedArrayObject a(scope, o);
         QV4::ScopedValue v(scope);
@@ -717,6 +768,8 @@ QV4::ReturnedValue QV8Engine::metaTypeToJS(int type, const void *data)
     default:
         if (type == qMetaTypeId<QJSValue>()) {
             return QJSValuePrivate::get(*reinterpret_cast<const QJSValue*>(data))->getValue(m_v4Engine);
+        } else if (QV4::Returned<QV4::TypedArray> *array = vectorToTypedArray(m_v4Engine, type, data)) {
+            return QV4::Encode(array);
         } else {
             QByteArray typeName = QMetaType::typeName(type);
             if (typeName.endsWith('*') && !*reinterpret_cast<void* const *>(data)) {
@@ -852,8 +905,16 @@ bool QV8Engine::metaTypeFromJS(const QV4::ValueRef value, int type, void *data)
         }
         break;
     }
+    case QMetaType::QByteArray:
+        if (QV4::ArrayBuffer *b = value->as<QV4::ArrayBuffer>()) {
+            *reinterpret_cast<QByteArray *>(data) = b->asByteArray();
+            return true;
+        } break;
     default:
-    ;
+        if (QV4::TypedArray *a = value->as<QV4::TypedArray>()) {
+            if (typedArrayToVector(a, type, data))
+                return true;
+        }
     }
 
 #if 0
@@ -970,6 +1031,8 @@ QVariant QV8Engine::variantFromJS(const QV4::ValueRef value,
         return re->toQRegExp();
     if (QV4::VariantObject *v = value->as<QV4::VariantObject>())
         return v->data;
+    if (QV4::ArrayBuffer *b = value->as<QV4::ArrayBuffer>())
+        return b->asByteArray();
     if (value->as<QV4::QObjectWrapper>())
         return qVariantFromValue(qtObjectFromJS(value));
     if (QV4::QmlValueTypeWrapper *v = value->as<QV4::QmlValueTypeWrapper>())
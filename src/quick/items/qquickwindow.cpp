@@ -72,6 +72,10 @@
 
 #include <private/qqmlprofilerservice_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
+#include <private/qqmlbinding_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4mm_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -137,6 +141,12 @@ public slots:
                     incubateAgain();
             }
         }
+
+        // Spread lazy sweeping over the frames as well. Incremental marking is not
+        // driven from here: without write barriers the cycle ends with a rescan of
+        // the whole marked heap, so its final pause is not bounded.
+        if (QQmlEngine *e = engine())
+            QV8Engine::getV4(e)->memoryManager->runSweepSlice();
     }
 
     void animationStopped() { incubate(); }
@@ -261,6 +271,9 @@ void QQuickWindowPrivate::polishItems()
 {
     int maxPolishCycles = 100000;
 
+    // Bring deferred binding updates in before the items are polished
+    QQmlBinding::flushPendingUpdates();
+
     while (!itemsToPolish.isEmpty() && --maxPolishCycles > 0) {
         QSet<QQuickItem *> itms = itemsToPolish;
         itemsToPolish.clear();
@@ -270,6 +283,8 @@ void QQuickWindowPrivate::polishItems()
             QQuickItemPrivate::get(item)->polishScheduled = false;
             item->updatePolish();
         }
+
+        QQmlBinding::flushPendingUpdates();
     }
 
     if (maxPolishCycles == 0)
@@ -0,0 +1,12 @@
+import QtQuick 2.0
+
+Item {
+    Component.onCompleted: {
+        var garbage = [];
+        for (var i = 0; i < 10000; ++i)
+            garbage.push({ index: i });
+        garbage = null;
+        gc();
+        console.log("done");
+    }
+}
@@ -0,0 +1,34 @@
+import QtQuick 2.0
+
+Item {
+    function leaf(i) {
+        return Math.sqrt(i);
+    }
+
+    function work() {
+        var sum = 0;
+        var start = Date.now();
+        while (Date.now() - start < 200) {
+            for (var i = 0; i < 1000; ++i)
+                sum += leaf(i);
+        }
+        return sum;
+    }
+
+    function tiny() {
+        return 1;
+    }
+
+    function spin() {
+        // no JS calls inside the loop, samples have to be taken at its back edge
+        var start = Date.now();
+        while (Date.now() - start < 200) {}
+        return tiny();
+    }
+
+    Component.onCompleted: {
+        work();
+        spin();
+        console.log("done");
+    }
+}
@@ -61,6 +61,8 @@ struct QQmlProfilerData
     int column;         //used by RangeLocation
     int framerate;      //used by animation events
     int animationcount; //used by animation events
+    double totalTime;   //used by call tree entries, in ms
+    double selfTime;    //used by call tree entries, in ms
 
     QByteArray toByteArray() const;
 };
@@ -79,6 +81,8 @@ public:
         Complete, // end of transmission
         PixmapCacheEvent,
         SceneGraphFrame,
+        HeapStatistics,
+        JavascriptCallTree,
 
         MaximumMessage
     };
@@ -131,6 +135,13 @@ public:
         MaximumSceneGraphFrameType
     };
 
+    enum HeapStatisticsType {
+        HeapSizeClass,
+        HeapLargeItems,
+
+        MaximumHeapStatisticsType
+    };
+
     QQmlProfilerClient(QQmlDebugConnection *connection)
         : QQmlDebugClient(QLatin1String("CanvasFrameRate"), connection)
     {
@@ -140,6 +151,8 @@ public:
     QList<QQmlProfilerData> javascriptMessages;
     QList<QQmlProfilerData> asynchronousMessages;
     QList<QQmlProfilerData> pixmapMessages;
+    QList<QQmlProfilerData> heapMessages;
+    QList<QQmlProfilerData> callTreeMessages;
 
     void setTraceState(bool enabled) {
         QByteArray message;
@@ -173,7 +186,7 @@ private:
     QQmlDebugConnection *m_connection;
     QQmlProfilerClient *m_client;
 
-    void connect(bool block, const QString &testFile);
+    void connect(bool block, const QString &testFile, const QStringList &environment = QStringList());
     void checkTraceReceived();
 
 private slots:
@@ -188,6 +201,8 @@ private slots:
     void controlFromJS();
     void signalSourceLocation();
     void javascript();
+    void heapStatistics();
+    void javascriptSampling();
 };
 
 void QQmlProfilerClient::messageReceived(const QByteArray &message)
@@ -203,6 +218,8 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
     data.line = -1;
     data.framerate = -1;
     data.animationcount = -1;
+    data.totalTime = -1;
+    data.selfTime = -1;
 
     stream >> data.time >> data.messageType;
 
@@ -303,6 +320,32 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
         }
         break;
     }
+    case QQmlProfilerClient::HeapStatistics: {
+        stream >> data.detailType;
+        uint itemSize, chunks, usedItems, freeItems, allocations, largeItems;
+        qint64 memory;
+        switch (data.detailType) {
+        case QQmlProfilerClient::HeapSizeClass:
+            stream >> itemSize >> chunks >> memory >> usedItems >> freeItems >> allocations;
+            QVERIFY(itemSize > 0 && itemSize % 16 == 0);
+            QVERIFY(memory > 0);
+            break;
+        case QQmlProfilerClient::HeapLargeItems:
+            stream >> largeItems >> memory;
+            break;
+        default:
+            QFAIL("Unknown heap statistics type");
+            break;
+        }
+        break;
+    }
+    case QQmlProfilerClient::JavascriptCallTree: {
+        QString file;
+        stream >> data.detailType >> file >> data.detailData >> data.line >> data.totalTime >> data.selfTime;
+        QVERIFY(data.detailType >= 0);
+        QVERIFY(data.totalTime >= data.selfTime);
+        break;
+    }
     default:
         QString failMsg = QString("Unknown message type:") + data.messageType;
         QFAIL(qPrintable(failMsg));
@@ -311,6 +354,10 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
     QVERIFY(stream.atEnd());
     if (data.messageType == QQmlProfilerClient::PixmapCacheEvent)
         pixmapMessages.append(data);
+    else if (data.messageType == QQmlProfilerClient::HeapStatistics)
+        heapMessages.append(data);
+    else if (data.messageType == QQmlProfilerClient::JavascriptCallTree)
+        callTreeMessages.append(data);
     else if (data.messageType == QQmlProfilerClient::SceneGraphFrame ||
             data.messageType == QQmlProfilerClient::Event)
         asynchronousMessages.append(data);
@@ -320,7 +367,7 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
         qmlMessages.append(data);
 }
 
-void tst_QQmlProfilerService::connect(bool block, const QString &testFile)
+void tst_QQmlProfilerService::connect(bool block, const QString &testFile, const QStringList &environment)
 {
     // ### Still using qmlscene due to QTBUG-33377
     const QString executable = QLibraryInfo::location(QLibraryInfo::BinariesPath) + "/qmlscene";
@@ -333,6 +380,8 @@ void tst_QQmlProfilerService::connect(bool block, const QString &testFile)
     arguments << QQmlDataTest::instance()->testFile(testFile);
 
     m_process = new QQmlDebugProcess(executable, this);
+    if (!environment.isEmpty())
+        m_process->setEnvironment(QProcess::systemEnvironment() + environment);
     m_process->start(QStringList() << arguments);
     QVERIFY2(m_process->waitForSessionStart(), "Could not launch application, or did not get 'Waiting for connection'.");
 
@@ -592,6 +641,59 @@ void tst_QQmlProfilerService::javascript()
     QCOMPARE(m_client->javascriptMessages[21].detailType, (int)QQmlProfilerClient::Javascript);
 }
 
+void tst_QQmlProfilerService::heapStatistics()
+{
+    connect(true, "heapStatistics.qml", QStringList() << "QV4_PROFILE_HEAP=1");
+    QVERIFY(m_client);
+    QTRY_COMPARE(m_client->state(), QQmlDebugClient::Enabled);
+
+    m_client->setTraceState(true);
+    while (!(m_process->output().contains(QLatin1String("done"))))
+        QVERIFY(QQmlDebugTest::waitForSignal(m_process, SIGNAL(readyReadStandardOutput())));
+    m_client->setTraceState(false);
+    checkTraceReceived();
+
+    // Each collection reports its size classes, followed by the large items.
+    QVERIFY(m_client->heapMessages.count() >= 2);
+    QCOMPARE(m_client->heapMessages.first().detailType, (int)QQmlProfilerClient::HeapSizeClass);
+    QCOMPARE(m_client->heapMessages.last().detailType, (int)QQmlProfilerClient::HeapLargeItems);
+}
+
+void tst_QQmlProfilerService::javascriptSampling()
+{
+    connect(true, "javascriptSampling.qml", QStringList() << "QV4_PROFILE_SAMPLING=500");
+    QVERIFY(m_client);
+    QTRY_COMPARE(m_client->state(), QQmlDebugClient::Enabled);
+
+    m_client->setTraceState(true);
+    while (!(m_process->output().contains(QLatin1String("done"))))
+        QVERIFY(QQmlDebugTest::waitForSignal(m_process, SIGNAL(readyReadStandardOutput())));
+    m_client->setTraceState(false);
+    checkTraceReceived();
+
+    // leaf() is only ever called from work(), so it can't be at the top level
+    QVERIFY(!m_client->callTreeMessages.isEmpty());
+    bool leafFound = false;
+    double spinSelfTime = 0;
+    double tinyTime = 0;
+    foreach (const QQmlProfilerData &entry, m_client->callTreeMessages) {
+        if (entry.detailData == QLatin1String("leaf")) {
+            QVERIFY(entry.detailType > 0);
+            leafFound = true;
+        } else if (entry.detailData == QLatin1String("spin")) {
+            spinSelfTime += entry.selfTime;
+        } else if (entry.detailData == QLatin1String("tiny")) {
+            tinyTime += entry.totalTime;
+        }
+    }
+    QVERIFY(leafFound);
+
+    // spin() loops for 200ms without calling into JS. Its time has to be sampled at the
+    // loop's back edge, not attributed to tiny() when that is entered afterwards.
+    QVERIFY(spinSelfTime > 100);
+    QVERIFY(spinSelfTime > tinyTime);
+}
+
 QTEST_MAIN(tst_QQmlProfilerService)
 
 #include "tst_qqmlprofilerservice.moc"
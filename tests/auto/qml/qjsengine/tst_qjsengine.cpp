@@ -51,6 +51,20 @@
 #include <qqmlcomponent.h>
 #include <stdlib.h>
 #include <private/qv4alloca_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4compileddata_p.h>
+#include <private/qv4lookup_p.h>
+#include <private/qv4mm_p.h>
+#include <private/qjsengine_p.h>
+#include <private/qjsvalue_p.h>
+#include <private/qv4arraydata_p.h>
+#include <private/qv4executableallocator_p.h>
+#include <private/qv4tierup_p.h>
+#include <QtCore/qbuffer.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
 
 #ifdef Q_CC_MSVC
 #define NO_INLINE __declspec(noinline)
@@ -155,6 +169,18 @@ private slots:
 
     void prototypeChainGc();
     void prototypeChainGc_QTBUG38299();
+    void incrementalGc();
+    void lazySweep();
+    void heapStatistics();
+    void heapSnapshot();
+    void polymorphicLookups();
+    void tieredCompilation();
+    void inlinedCalls();
+    void loopOptimizations();
+    void scalarReplacement();
+    void typedArrays();
+    void packedArrays();
+    void jsonParseAndStringify();
 
     void dynamicProperties();
 
@@ -789,6 +815,16 @@ void tst_QJSEngine::globalObjectProperties_enumerate()
         << "unescape"
         << "SyntaxError"
         << "undefined"
+        << "ArrayBuffer"
+        << "Int8Array"
+        << "Uint8Array"
+        << "Uint8ClampedArray"
+        << "Int16Array"
+        << "Uint16Array"
+        << "Int32Array"
+        << "Uint32Array"
+        << "Float32Array"
+        << "Float64Array"
         // JavaScriptCore
         << "JSON"
         ;
@@ -3049,6 +3085,654 @@ void tst_QJSEngine::prototypeChainGc_QTBUG38299()
     engine.collectGarbage();
 }
 
+void tst_QJSEngine::incrementalGc()
+{
+    QJSEngine engine;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    mm->setIncrementalMarkingBudget(1);
+
+    engine.evaluate("var holder = { items: [] };\n"
+                    "function churn(from) {\n"
+                    "    for (var i = from; i < from + 1000; ++i) {\n"
+                    "        holder.last = { index: i, text: 'item' + i };\n"
+                    "        if (i % 100 == 0)\n"
+                    "            holder.items.push({ index: i, text: 'kept' + i });\n"
+                    "    }\n"
+                    "}");
+
+    // Objects get stored into already marked ones between the slices, which
+    // the allocator runs while marking is in progress.
+    for (int batch = 0; batch < 50; ++batch)
+        engine.evaluate(QString::fromLatin1("churn(%1)").arg(batch * 1000));
+    const QV4::MemoryManager::Statistics stats = mm->statistics();
+    QVERIFY(stats.markingSlices > 0);
+    QVERIFY(stats.collections > 0);
+
+    QJSValue result = engine.evaluate("var sum = 0;\n"
+                                      "for (var j = 0; j < holder.items.length; ++j)\n"
+                                      "    sum += holder.items[j].index;\n"
+                                      "sum");
+    QCOMPARE(result.toInt(), 12475000);
+
+    while (mm->runGCSlice()) {}
+    engine.collectGarbage();
+    QCOMPARE(engine.evaluate("holder.items[499].text").toString(), QStringLiteral("kept49900"));
+    QCOMPARE(engine.evaluate("holder.last.index").toInt(), 49999);
+}
+
+void tst_QJSEngine::lazySweep()
+{
+    qputenv("QV4_MM_LAZY_SWEEP", "1");
+    QJSEngine engine;
+    qunsetenv("QV4_MM_LAZY_SWEEP");
+
+    // Regexps are cached by pattern, the cache must not return dead ones.
+    QJSValue result = engine.evaluate("var kept = [];\n"
+                                      "for (var i = 0; i < 20000; ++i) {\n"
+                                      "    var re = new RegExp('a' + (i % 50) + 'b');\n"
+                                      "    if (i % 100 == 0)\n"
+                                      "        kept.push({ re: re, text: 'xa' + (i % 50) + 'b' });\n"
+                                      "}\n"
+                                      "var matches = 0;\n"
+                                      "for (var j = 0; j < kept.length; ++j) {\n"
+                                      "    if (kept[j].re.test(kept[j].text))\n"
+                                      "        ++matches;\n"
+                                      "}\n"
+                                      "matches");
+    QCOMPARE(result.toInt(), 200);
+
+    // Collecting leaves the chunks for small items to the allocator and to slices.
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+    engine.collectGarbage();
+    QVERIFY(mm->statistics().unsweptChunks > 0);
+    QVERIFY(engine.evaluate("kept[199].re.test('a0b')").toBool());
+    QCOMPARE(engine.evaluate("kept[199].text").toString(), QStringLiteral("xa0b"));
+    while (mm->runGCSlice()) {}
+    QCOMPARE(mm->statistics().unsweptChunks, 0u);
+}
+
+void tst_QJSEngine::heapStatistics()
+{
+    QJSEngine engine;
+    engine.evaluate("var kept = [];\n"
+                    "for (var i = 0; i < 10000; ++i)\n"
+                    "    kept.push({ index: i });");
+    engine.collectGarbage();
+
+    QVariantMap stats = QJSEnginePrivate::heapStatistics(&engine);
+    const uint collections = stats.value("collections").toUInt();
+    QVERIFY(collections > 0);
+    QVERIFY(stats.value("liveMemory").toULongLong() >= 10000 * 16);
+    QVERIFY(stats.contains("largeItems"));
+    QVERIFY(stats.contains("largeItemMemory"));
+    const QVariantList sizeClasses = stats.value("sizeClasses").toList();
+    QVERIFY(!sizeClasses.isEmpty());
+    uint usedItems = 0;
+    foreach (const QVariant &sizeClassValue, sizeClasses) {
+        const QVariantMap sizeClass = sizeClassValue.toMap();
+        const uint itemSize = sizeClass.value("itemSize").toUInt();
+        const uint used = sizeClass.value("usedItems").toUInt();
+        const uint unused = sizeClass.value("freeItems").toUInt();
+        QVERIFY(itemSize > 0 && itemSize % 16 == 0);
+        QVERIFY(sizeClass.value("chunks").toUInt() > 0);
+        QVERIFY(sizeClass.value("chunkMemory").toULongLong() >= qulonglong(used + unused) * itemSize);
+        QCOMPARE(sizeClass.value("allocationsSinceGC").toUInt(), 0u);
+        usedItems += used;
+    }
+    QVERIFY(usedItems >= 10000);
+
+    // With the adaptive trigger, churning through garbage still collects.
+    QJSEnginePrivate::setHeapGrowthTrigger(&engine, 50);
+    QJSValue result = engine.evaluate("for (var j = 0; j < 100000; ++j)\n"
+                                      "    kept[j % 10000] = { index: j };\n"
+                                      "kept[9999].index");
+    QCOMPARE(result.toInt(), 99999);
+    QVERIFY(QJSEnginePrivate::heapStatistics(&engine).value("collections").toUInt() > collections);
+}
+
+void tst_QJSEngine::heapSnapshot()
+{
+    QJSEngine engine;
+    QObject *object = new QObject;
+    object->setObjectName(QStringLiteral("snapshotObject"));
+    engine.globalObject().setProperty("wrapped", engine.newQObject(object));
+    engine.evaluate("var snapshotHolder = { snapshotValue: { nested: 'snapshotString' } };");
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(QJSEnginePrivate::writeHeapSnapshot(&engine, &buffer));
+
+    QJsonParseError error;
+    QJsonObject snapshot = QJsonDocument::fromJson(buffer.data(), &error).object();
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    const QJsonObject meta = snapshot.value("snapshot").toObject();
+    const int nodeFields = meta.value("meta").toObject().value("node_fields").toArray().size();
+    const int edgeFields = meta.value("meta").toObject().value("edge_fields").toArray().size();
+    const QJsonArray nodes = snapshot.value("nodes").toArray();
+    const QJsonArray edges = snapshot.value("edges").toArray();
+    const QJsonArray strings = snapshot.value("strings").toArray();
+    QCOMPARE(nodeFields, 6);
+    QCOMPARE(edgeFields, 3);
+    QCOMPARE(nodes.size(), meta.value("node_count").toInt() * nodeFields);
+    QCOMPARE(edges.size(), meta.value("edge_count").toInt() * edgeFields);
+
+    // The edge counts of the nodes add up, and every edge points to a node.
+    int edgeCount = 0;
+    for (int i = 0; i < nodes.size(); i += nodeFields)
+        edgeCount += nodes.at(i + 4).toInt();
+    QCOMPARE(edgeCount * edgeFields, edges.size());
+    for (int i = 0; i < edges.size(); i += edgeFields) {
+        const int toNode = edges.at(i + 2).toInt();
+        QVERIFY(toNode >= 0 && toNode < nodes.size() && toNode % nodeFields == 0);
+    }
+
+    QVERIFY(strings.contains(QStringLiteral("snapshotValue")));
+    QVERIFY(strings.contains(QStringLiteral("snapshotString")));
+    QVERIFY(strings.contains(QStringLiteral("QObjectWrapper QObject 'snapshotObject'")));
+}
+
+void tst_QJSEngine::polymorphicLookups()
+{
+    QJSEngine engine;
+    // More shapes than the polymorphic caches hold, so the lookups end up in the
+    // stub cache. Every object has x at a different position, some inherit it,
+    // and some have an accessor for it.
+    QJSValue result = engine.evaluate(
+            "var proto = { x: 'inherited' };\n"
+            "var accessorProto = { get x() { return 'accessor'; } };\n"
+            "function make(i) {\n"
+            "    var o = (i % 5 == 3) ? Object.create(proto) : (i % 5 == 4) ? Object.create(accessorProto) : {};\n"
+            "    for (var j = 0; j < i % 12; ++j)\n"
+            "        o['p' + j] = j;\n"
+            "    if (i % 5 < 3)\n"
+            "        o.x = i;\n"
+            "    return o;\n"
+            "}\n"
+            "function getX(o) { return o.x; }\n"
+            "function setY(o, v) { o.y = v; }\n"
+            "var objects = [];\n"
+            "for (var i = 0; i < 60; ++i)\n"
+            "    objects.push(make(i));\n"
+            "var errors = [];\n"
+            "for (var round = 0; round < 3; ++round) {\n"
+            "    for (var i = 0; i < objects.length; ++i) {\n"
+            "        var expected = (i % 5 == 3) ? 'inherited' : (i % 5 == 4) ? 'accessor' : i;\n"
+            "        if (getX(objects[i]) !== expected)\n"
+            "            errors.push('x of ' + i + ' in round ' + round);\n"
+            "        setY(objects[i], i + round);\n"
+            "        if (objects[i].y !== i + round)\n"
+            "            errors.push('y of ' + i + ' in round ' + round);\n"
+            "    }\n"
+            "}\n"
+            "proto.x = 'changed';\n"
+            "if (getX(objects[3]) !== 'changed')\n"
+            "    errors.push('changed prototype');\n"
+            "var indexed = [[1, 2, 3], 'abc', { 0: 'a', 1: 'b', 2: 'c' }];\n"
+            "indexed[3] = [];\n"
+            "indexed[3][1000] = 'sparse';\n"
+            "function at(o, i) { return o[i]; }\n"
+            "if (at(indexed[0], 1) !== 2 || at(indexed[1], 1) !== 'b' || at(indexed[2], 1) !== 'b'\n"
+            "        || at(indexed[3], 1000) !== 'sparse' || at(indexed[3], 5) !== undefined)\n"
+            "    errors.push('indexed');\n"
+            "errors.join(', ')");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.toString(), QString());
+
+    // Array lengths are cached like other properties, and a lookup that also sees
+    // QObject properties keeps the classes it cached instead of resolving every object.
+    engine.globalObject().setProperty("qobject", engine.newQObject(new QObject));
+    result = engine.evaluate(
+            "function getLength(o) { return o.length; }\n"
+            "function getName(o) { return o.objectName; }\n"
+            "var other = [1, 2, 3];\n"
+            "other.foo = 'bar';\n"
+            "var lengths = [[1, 2], { length: 'object' }, other];\n"
+            "var names = [{ objectName: 'object' }, qobject];\n"
+            "qobject.objectName = 'qobject';\n"
+            "var errors = [];\n"
+            "for (var i = 0; i < 100; ++i) {\n"
+            "    if (getLength(lengths[i % 3]) !== [2, 'object', 3][i % 3])\n"
+            "        errors.push('length ' + i);\n"
+            "    if (getName(names[i % 2]) !== ['object', 'qobject'][i % 2])\n"
+            "        errors.push('name ' + i);\n"
+            "}\n"
+            "errors.join(', ')", QStringLiteral("lookups.js"));
+    QVERIFY(!result.isError());
+    QCOMPARE(result.toString(), QString());
+
+    // Once the classes are cached a lookup doesn't miss anymore. Check every copy of the
+    // lookups, in case getLength() and getName() were inlined into the loop.
+    int lengthLookups = 0;
+    int nameLookups = 0;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    foreach (QV4::CompiledData::CompilationUnit *unit, v4->compilationUnits) {
+        if (unit->fileName() != QLatin1String("lookups.js"))
+            continue;
+        const QV4::CompiledData::Lookup *compiledLookups = unit->data->lookupTable();
+        for (uint i = 0; i < unit->data->lookupTableSize; ++i) {
+            const QString name = unit->data->stringAt(compiledLookups[i].nameIndex);
+            const QV4::Lookup &l = unit->runtimeLookups[i];
+            if (name == QLatin1String("length") && l.missCount) {
+                ++lengthLookups;
+                QVERIFY(l.missCount <= 3);
+                QVERIFY(l.polymorphicCache);
+                QCOMPARE(l.polymorphicCache->count, 3u);
+            } else if (name == QLatin1String("objectName") && l.polymorphicCache) {
+                ++nameLookups;
+                QCOMPARE(l.polymorphicCache->count, 1u);
+            }
+        }
+    }
+    QVERIFY(lengthLookups > 0);
+    QVERIFY(nameLookups > 0);
+}
+
+void tst_QJSEngine::tieredCompilation()
+{
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    QV4::TierUpCompiler *tierUpCompiler = v4->tierUpCompiler.data();
+    if (!tierUpCompiler)
+        QSKIP("Functions are not compiled in tiers in this configuration");
+
+    // Code that runs once stays in the interpreter.
+    QJSValue add = engine.evaluate("(function(a, b) { return a + b; })");
+    QJSValue lessThan = engine.evaluate("(function(a, b) { if (a < b) return 'less'; return 'not less'; })");
+    QJSValue sum = engine.evaluate("(function(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; })");
+    QCOMPARE(v4->executableAllocator->usedMemory(), size_t(0));
+
+    // Hot calls with integers, and a single call that spends its time in a loop.
+    for (int i = 0; i < int(tierUpCompiler->callThreshold()); ++i) {
+        QCOMPARE(add.call(QJSValueList() << i << 1).toInt(), i + 1);
+        QCOMPARE(lessThan.call(QJSValueList() << i << 5).toString(), QLatin1String(i < 5 ? "less" : "not less"));
+    }
+    QCOMPARE(sum.call(QJSValueList() << 100000).toNumber(), 4999950000.);
+    tierUpCompiler->waitForDone();
+    QCOMPARE(tierUpCompiler->compiledFunctionCount(), 3u);
+    QVERIFY(v4->executableAllocator->usedMemory() > 0);
+
+    // The recompiled code still handles the types it has not seen before.
+    QCOMPARE(add.call(QJSValueList() << 2 << 3).toInt(), 5);
+    QCOMPARE(add.call(QJSValueList() << 0x7fffffff << 1).toNumber(), 2147483648.);
+    QCOMPARE(add.call(QJSValueList() << 0.5 << 1).toNumber(), 1.5);
+    QCOMPARE(add.call(QJSValueList() << "a" << 1).toString(), QStringLiteral("a1"));
+    QJSValue valueOf = engine.evaluate("({ valueOf: function() { return 41; } })");
+    QCOMPARE(add.call(QJSValueList() << valueOf << 1).toInt(), 42);
+
+    QCOMPARE(lessThan.call(QJSValueList() << 1.5 << 2).toString(), QStringLiteral("less"));
+    QCOMPARE(lessThan.call(QJSValueList() << "b" << "a").toString(), QStringLiteral("not less"));
+    QCOMPARE(lessThan.call(QJSValueList() << qQNaN() << 1).toString(), QStringLiteral("not less"));
+    QCOMPARE(lessThan.call(QJSValueList() << QJSValue() << 1).toString(), QStringLiteral("not less"));
+    QCOMPARE(lessThan.call(QJSValueList() << valueOf << 42).toString(), QStringLiteral("less"));
+
+    QCOMPARE(sum.call(QJSValueList() << 10).toInt(), 45);
+    QCOMPARE(sum.call(QJSValueList() << 2.5).toInt(), 3);
+    QCOMPARE(sum.call(QJSValueList() << "3").toInt(), 3);
+
+    // Recompiled code uses the lookups the interpreter used for the same accesses, so
+    // two accesses of x on objects of different classes stay monomorphic.
+    QJSValue sumX = engine.evaluate("(function(a, b) { return a.x + b.x; })", QStringLiteral("sumx.js"));
+    QJSValue a = engine.evaluate("({ x: 1 })");
+    QJSValue b = engine.evaluate("({ y: 0, x: 2 })");
+    for (int i = 0; i < int(tierUpCompiler->callThreshold()); ++i)
+        QCOMPARE(sumX.call(QJSValueList() << a << b).toInt(), 3);
+    tierUpCompiler->waitForDone();
+    QCOMPARE(tierUpCompiler->compiledFunctionCount(), 4u);
+    for (int i = 0; i < 10; ++i)
+        QCOMPARE(sumX.call(QJSValueList() << a << b).toInt(), 3);
+
+    int xLookups = 0;
+    foreach (QV4::CompiledData::CompilationUnit *unit, v4->compilationUnits) {
+        if (unit->fileName() != QLatin1String("sumx.js"))
+            continue;
+        const QV4::CompiledData::Lookup *compiledLookups = unit->data->lookupTable();
+        for (uint i = 0; i < unit->data->lookupTableSize; ++i) {
+            if (unit->data->stringAt(compiledLookups[i].nameIndex) != QLatin1String("x"))
+                continue;
+            ++xLookups;
+            QCOMPARE(unit->runtimeLookups[i].missCount, 1u);
+            QVERIFY(!unit->runtimeLookups[i].polymorphicCache);
+        }
+    }
+    QCOMPARE(xLookups, 2);
+}
+
+void tst_QJSEngine::inlinedCalls()
+{
+    QJSEngine engine;
+    QJSValue result = engine.evaluate(
+        "function clamp(v, lo, hi) { var r = v; if (r < lo) r = lo; if (r > hi) r = hi; return r; }\n"
+        "function log(msg) { messages.push(msg); }\n"
+        "var messages = [];\n"
+        "function run(n) { var s = 0; for (var i = 0; i < n; ++i) s += clamp(i, 2, 5); log(s); return s; }\n"
+        "function shadowed(clamp) { return clamp(1); }\n"
+        "var first = run(10);\n"
+        "clamp = function() { return -1; };\n"
+        "[first, run(3), shadowed(function(x) { return x * 10; }), messages.length, clamp(7)]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toInt(), 38);
+    // The guard falls back to a regular call once the function has been replaced.
+    QCOMPARE(result.property(1).toInt(), -3);
+    QCOMPARE(result.property(2).toInt(), 10);
+    QCOMPARE(result.property(3).toInt(), 2);
+    QCOMPARE(result.property(4).toInt(), -1);
+}
+
+void tst_QJSEngine::loopOptimizations()
+{
+    QJSEngine engine;
+    QJSValue result = engine.evaluate(
+        "function sum(a) { var s = 0; for (var i = 0; i < 5; ++i) s += a[i]; return s; }\n"
+        "function scaled(a, k) { var r = []; for (var i = 4; i >= 0; i--) r.push(a[i] * (k + 1)); return r.join(); }\n"
+        "function last() { var n = 0, i; for (i = 2147483645; i <= 2147483647; ++i) { if (++n > 5) break; } return i; }\n"
+        "function half(a, i) { return a[i * 0.5]; }\n"
+        "var dense = sum([1, 2, 3, 4, 5]);\n"
+        "Array.prototype[1] = 10;\n"
+        "var holey = sum([1, , 3, 4, 5]);\n"
+        "delete Array.prototype[1];\n"
+        "var odd = [1, 2, 3]; odd[-1] = 7; odd[1.5] = 9;\n"
+        "var sparse = []; sparse[100000] = 1; sparse[3] = 4;\n"
+        "[dense, holey, sum([1, 2]), sum('12345'), scaled([1, 2, 3, 4, 5], 1), last(),\n"
+        " half(odd, -2), half(odd, 3), half(odd, 4), half(sparse, 6)]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toInt(), 15);
+    // Holes are looked up on the prototype chain.
+    QCOMPARE(result.property(1).toInt(), 23);
+    QVERIFY(qIsNaN(result.property(2).toNumber()));
+    QCOMPARE(result.property(3).toString(), QString("012345"));
+    QCOMPARE(result.property(4).toString(), QString("10,8,6,4,2"));
+    // The counter may not be typed as int32 when it can step past INT_MAX.
+    QCOMPARE(result.property(5).toNumber(), 2147483648.0);
+    QCOMPARE(result.property(6).toInt(), 7);
+    QCOMPARE(result.property(7).toInt(), 9);
+    QCOMPARE(result.property(8).toInt(), 3);
+    QCOMPARE(result.property(9).toInt(), 4);
+}
+
+void tst_QJSEngine::scalarReplacement()
+{
+    QJSEngine engine;
+    QJSValue result = engine.evaluate(
+        "function dist(a, b) { var p = {x: a, y: b}; return p.x * p.x + p.y * p.y; }\n"
+        "function moved(a) { var p = {x: a, y: 1}; p.x = p.x + 1; p.y = p.x * 2; return p.x + p.y; }\n"
+        "function branchy(a) { var p = {v: 0}; if (a) p.v = a; return p.v; }\n"
+        "function nested(a) { var o = {inner: {v: a}}; return o.inner.v; }\n"
+        "function point(a) { var q = [a, a + 1]; return q[0] + q[1] + q.length; }\n"
+        "function hole() { var q = [1, , 3]; return q[1]; }\n"
+        "function argc() { return arguments.length; }\n"
+        "function first(a) { return arguments[0]; }\n"
+        "function changed(a) { a = 2; return arguments[0]; }\n"
+        "function strictChanged(a) { 'use strict'; a = 2; return arguments[0]; }\n"
+        "function escaped() { var o = {x: 1}; return o.toString(); }\n"
+        "Array.prototype[1] = 'p';\n"
+        "var fromPrototype = hole();\n"
+        "delete Array.prototype[1];\n"
+        "[dist(3, 4), moved(1), branchy(5), branchy(0), nested(7), point(1), fromPrototype,\n"
+        " argc(1, 2, 3), argc(), first(), first(9), changed(1), changed(), strictChanged(1), escaped()]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toInt(), 25);
+    QCOMPARE(result.property(1).toInt(), 6);
+    QCOMPARE(result.property(2).toInt(), 5);
+    QCOMPARE(result.property(3).toInt(), 0);
+    QCOMPARE(result.property(4).toInt(), 7);
+    QCOMPARE(result.property(5).toInt(), 5);
+    QCOMPARE(result.property(6).toString(), QString("p"));
+    QCOMPARE(result.property(7).toInt(), 3);
+    QCOMPARE(result.property(8).toInt(), 0);
+    QVERIFY(result.property(9).isUndefined());
+    QCOMPARE(result.property(10).toInt(), 9);
+    // Writing a formal parameter changes the mapped arguments object, but only in sloppy mode
+    // and only for arguments that were actually passed.
+    QCOMPARE(result.property(11).toInt(), 2);
+    QVERIFY(result.property(12).isUndefined());
+    QCOMPARE(result.property(13).toInt(), 1);
+    QCOMPARE(result.property(14).toString(), QString("[object Object]"));
+}
+
+void tst_QJSEngine::typedArrays()
+{
+    QJSEngine engine;
+    QJSValue result = engine.evaluate(
+        "var f = new Float64Array(4);\n"
+        "for (var i = 0; i < f.length; ++i) f[i] = i / 2;\n"
+        "var b = new Int8Array([127, 128, -129]);\n"
+        "var c = new Uint8ClampedArray([-1, 1.5, 2.5, 300]);\n"
+        "var u = new Uint8Array(new ArrayBuffer(8), 2, 4);\n"
+        "u[0] = 7; u[4] = 9;\n"
+        "var sub = f.subarray(1, 3); sub[0] = 42;\n"
+        "var i16 = new Int16Array(4); i16.set([1, 2], 2);\n"
+        "[f[3], b[0], b[1], b[2], c[0], c[1], c[2], c[3], u.byteOffset, u.length, u[0], u[4],\n"
+        " f[1], sub.length, i16[3], Object.prototype.toString.call(f), ArrayBuffer.isView(u),\n"
+        " Float32Array.BYTES_PER_ELEMENT, u.buffer.byteLength]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toNumber(), 1.5);
+    QCOMPARE(result.property(1).toInt(), 127);
+    QCOMPARE(result.property(2).toInt(), -128);
+    QCOMPARE(result.property(3).toInt(), 127);
+    QCOMPARE(result.property(4).toInt(), 0);
+    QCOMPARE(result.property(5).toInt(), 2);
+    QCOMPARE(result.property(6).toInt(), 2);
+    QCOMPARE(result.property(7).toInt(), 255);
+    QCOMPARE(result.property(8).toInt(), 2);
+    QCOMPARE(result.property(9).toInt(), 4);
+    QCOMPARE(result.property(10).toInt(), 7);
+    QVERIFY(result.property(11).isUndefined());
+    QCOMPARE(result.property(12).toInt(), 42);
+    QCOMPARE(result.property(13).toInt(), 2);
+    QCOMPARE(result.property(14).toInt(), 2);
+    QCOMPARE(result.property(15).toString(), QString("[object Float64Array]"));
+    QVERIFY(result.property(16).toBool());
+    QCOMPARE(result.property(17).toInt(), 4);
+    QCOMPARE(result.property(18).toInt(), 8);
+
+    QVERIFY(engine.evaluate("new Int8Array(-1)").isError());
+    QVERIFY(engine.evaluate("Int8Array(1)").isError());
+
+    // NaNs in the buffer are read as the canonical NaN, whatever their payload
+    QVERIFY(engine.evaluate("var nan = new Float32Array(new Int32Array([-1]).buffer)[0];\n"
+                            "typeof nan == 'number' && isNaN(nan) && nan !== nan && isNaN(nan + 1)").toBool());
+    QVERIFY(engine.evaluate("isNaN(new Float64Array(new Int32Array([-1, -1]).buffer)[0])").toBool());
+
+    // Byte arrays are passed as variants, an ArrayBuffer constructed from one shares its contents.
+    QByteArray bytes("\x01\x02\x03", 3);
+    QJSValue variant = engine.toScriptValue(bytes);
+    QCOMPARE(variant.toVariant().userType(), int(QMetaType::QByteArray));
+    engine.globalObject().setProperty("bytes", variant);
+    QJSValue buffer = engine.evaluate("new ArrayBuffer(bytes)");
+    QCOMPARE(buffer.property("byteLength").toInt(), 3);
+    engine.globalObject().setProperty("sharedBuffer", buffer);
+    QCOMPARE(engine.evaluate("new Uint8Array(sharedBuffer)[2]").toInt(), 3);
+    QByteArray roundTrip = engine.fromScriptValue<QByteArray>(buffer);
+    QCOMPARE(roundTrip, bytes);
+    QVERIFY(roundTrip.constData() == bytes.constData());
+    QCOMPARE(engine.fromScriptValue<QByteArray>(engine.evaluate("new Uint8Array([65, 66]).buffer")), QByteArray("AB"));
+
+    // float vectors are copied into typed arrays and back with one memcpy
+    QVector<double> vector = engine.fromScriptValue<QVector<double> >(engine.evaluate("f"));
+    QCOMPARE(vector, QVector<double>() << 0 << 42 << 1 << 1.5);
+    QJSValue doubles = engine.toScriptValue(QVector<double>() << 0.5 << 2);
+    QCOMPARE(doubles.property("length").toInt(), 2);
+    QCOMPARE(doubles.property(1).toNumber(), 2.);
+    engine.globalObject().setProperty("doubles", doubles);
+    QCOMPARE(engine.evaluate("Object.prototype.toString.call(doubles)").toString(), QString("[object Float64Array]"));
+    QJSValue floats = engine.toScriptValue(QVector<float>() << 0.25f << 3);
+    engine.globalObject().setProperty("floats", floats);
+    QCOMPARE(engine.evaluate("Object.prototype.toString.call(floats)").toString(), QString("[object Float32Array]"));
+    QCOMPARE(engine.fromScriptValue<QVector<float> >(floats), QVector<float>() << 0.25f << 3);
+
+    // element accesses are specialized to typed arrays in their lookups
+    result = engine.evaluate(
+        "function sum(a) { var s = 0; for (var i = 0; i < a.length; ++i) s += a[i]; return s; }\n"
+        "function scale(a, f) { for (var i = 0; i < a.length; ++i) a[i] *= f; }\n"
+        "var v = new Float64Array([1, 2, 3]);\n"
+        "scale(v, 2);\n"
+        "sum(v)", QStringLiteral("typedArrays.js"));
+    QCOMPARE(result.toNumber(), 12.);
+    int getters = 0;
+    int setters = 0;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    foreach (QV4::CompiledData::CompilationUnit *unit, v4->compilationUnits) {
+        if (unit->fileName() != QLatin1String("typedArrays.js"))
+            continue;
+        const QV4::CompiledData::Lookup *compiledLookups = unit->data->lookupTable();
+        for (uint i = 0; i < unit->data->lookupTableSize; ++i) {
+            const QV4::Lookup &l = unit->runtimeLookups[i];
+            if (compiledLookups[i].type_and_flags == QV4::CompiledData::Lookup::Type_IndexedGetter
+                    && l.indexedGetter == QV4::Lookup::indexedGetterTypedArray)
+                ++getters;
+            else if (compiledLookups[i].type_and_flags == QV4::CompiledData::Lookup::Type_IndexedSetter
+                    && l.indexedSetter == QV4::Lookup::indexedSetterTypedArray)
+                ++setters;
+        }
+    }
+    QVERIFY(getters > 0);
+    QVERIFY(setters > 0);
+
+    // The contents of buffers count as memory of the heap, so allocating them triggers collections.
+    QV4::MemoryManager *mm = v4->memoryManager;
+    const QV4::MemoryManager::Statistics stats = mm->statistics();
+    engine.evaluate("var big = new ArrayBuffer(1 << 20);");
+    QVERIFY(mm->statistics().unmanagedMemory >= stats.unmanagedMemory + (1 << 20));
+    engine.evaluate("big = undefined; for (var i = 0; i < 64; ++i) new ArrayBuffer(1 << 20);");
+    QVERIFY(mm->statistics().collections > stats.collections);
+    QVERIFY(mm->statistics().unmanagedMemory < std::size_t(64 << 20));
+}
+
+// The element kind of the simple array data of an array, -1 if it has none.
+static int elementKind(QJSEngine *engine, const QJSValue &array)
+{
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
+    QV4::Scope scope(v4);
+    QV4::ScopedObject o(scope, QJSValuePrivate::get(array)->getValue(v4));
+    if (!o || !o->arrayData || o->arrayData->isSparse())
+        return -1;
+    return static_cast<QV4::SimpleArrayData *>(o->arrayData)->elementKind();
+}
+
+void tst_QJSEngine::packedArrays()
+{
+    QJSEngine engine;
+    // Arrays stay packed as long as they hold numbers without holes.
+    QJSValue kinds = engine.evaluate(
+        "var packedInts = [1, 2, 3]; packedInts.push(4); packedInts[4] = 5;\n"
+        "var packedDoubles = [1, 2]; packedDoubles[1] = 2.5; packedDoubles.unshift(0.5);\n"
+        "var filled = []; for (var i = 0; i < 10; ++i) filled[i] = i;\n"
+        "var withHole = [1, 2]; withHole[3] = 4;\n"
+        "var deleted = [1, 2]; delete deleted[0];\n"
+        "var strings = [1, 2]; strings[0] = 'one';\n"
+        "var read = [1, 2, 3]; var readValues = [Object.getOwnPropertyDescriptor(read, 1).value,\n"
+        "    Object.create(read)[2], read.propertyIsEnumerable(0)];\n"
+        "[packedInts, packedDoubles, filled, withHole, deleted, strings, read, readValues]");
+    QVERIFY(!kinds.isError());
+    QCOMPARE(elementKind(&engine, kinds.property(0)), int(QV4::ArrayData::PackedInt));
+    QCOMPARE(elementKind(&engine, kinds.property(1)), int(QV4::ArrayData::PackedDouble));
+    QCOMPARE(elementKind(&engine, kinds.property(2)), int(QV4::ArrayData::PackedInt));
+    QCOMPARE(elementKind(&engine, kinds.property(3)), int(QV4::ArrayData::Generic));
+    QCOMPARE(elementKind(&engine, kinds.property(4)), int(QV4::ArrayData::Generic));
+    QCOMPARE(elementKind(&engine, kinds.property(5)), int(QV4::ArrayData::Generic));
+    // Reading elements through property descriptors or the prototype chain leaves them alone.
+    QCOMPARE(elementKind(&engine, kinds.property(6)), int(QV4::ArrayData::PackedInt));
+    QCOMPARE(kinds.property(7).property(0).toInt(), 2);
+    QCOMPARE(kinds.property(7).property(1).toInt(), 3);
+    QVERIFY(kinds.property(7).property(2).toBool());
+    QCOMPARE(engine.evaluate("var sum = 0; for (var i = 0; i < packedDoubles.length; ++i) sum += packedDoubles[i]; sum").toNumber(), 4.);
+
+    // Arrays of numbers stop being packed on the first store of anything else, the
+    // objects stored afterwards have to survive garbage collection.
+    engine.evaluate(
+        "var ints = [1, 2, 3]; ints[1] = {v: 'set'};\n"
+        "var doubles = [1.5, 2]; doubles.push({v: 'pushed'});\n"
+        "var front = [1, 2]; front.unshift({v: 'unshifted'});\n"
+        "var appended = []; for (var i = 0; i < 10; ++i) appended[i] = i / 2; appended[10] = {v: 'appended'};\n"
+        "var holes = [1, 2, 3]; delete holes[0]; holes[2] = {v: 'hole'};\n"
+        "var copied = [1, 2].concat([{v: 'copied'}]);\n"
+        "var defined = [1, 2]; Object.defineProperty(defined, 0, {value: {v: 'defined'}});\n"
+        "var lookup = [1, 2]; function store(a, v) { a[0] = v; } store(lookup, {v: 'stored'});\n");
+    engine.collectGarbage();
+    QJSValue result = engine.evaluate(
+        "[ints[1].v, doubles[2].v, front[0].v, appended[10].v, appended[3], holes[2].v, 0 in holes,\n"
+        " copied[2].v, defined[0].v, lookup[0].v, [3, 1, 2].sort().join()]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toString(), QString("set"));
+    QCOMPARE(result.property(1).toString(), QString("pushed"));
+    QCOMPARE(result.property(2).toString(), QString("unshifted"));
+    QCOMPARE(result.property(3).toString(), QString("appended"));
+    QCOMPARE(result.property(4).toNumber(), 1.5);
+    QCOMPARE(result.property(5).toString(), QString("hole"));
+    QVERIFY(!result.property(6).toBool());
+    QCOMPARE(result.property(7).toString(), QString("copied"));
+    QCOMPARE(result.property(8).toString(), QString("defined"));
+    QCOMPARE(result.property(9).toString(), QString("stored"));
+    QCOMPARE(result.property(10).toString(), QString("1,2,3"));
+    QCOMPARE(elementKind(&engine, engine.globalObject().property("ints")), int(QV4::ArrayData::Generic));
+    QCOMPARE(elementKind(&engine, engine.globalObject().property("lookup")), int(QV4::ArrayData::Generic));
+}
+
+static QV4::InternalClass *internalClass(QJSEngine *engine, const QJSValue &object)
+{
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(engine);
+    QV4::Scope scope(v4);
+    QV4::ScopedObject o(scope, QJSValuePrivate::get(object)->getValue(v4));
+    return o ? o->internalClass : 0;
+}
+
+void tst_QJSEngine::jsonParseAndStringify()
+{
+    QJSEngine engine;
+    // Objects reuse the member names of the previous object at the same depth,
+    // objects and arrays bigger than one batch are stored in several steps.
+    engine.evaluate(
+        "var records = JSON.parse('[{\"a\":1,\"b\":\"x\"},{\"a\":2,\"b\":\"y\"},{\"b\":3,\"a\":4},"
+        "{\"a\":5,\"a\":6,\"2\":\"two\",\"c\\\\u0041\":7}]');\n"
+        "var src = {}; for (var i = 0; i < 40; ++i) src['k' + i] = [i, {v: i}];\n"
+        "var big = JSON.parse(JSON.stringify(src));\n"
+        "var list = []; for (var i = 0; i < 200; ++i) list.push(i % 3 ? i : 'e' + i);\n"
+        "var longList = JSON.parse(JSON.stringify(list));\n"
+        "var numbers = JSON.parse('[0, -0, 33554432, 1.5e3, -12, 12345678901]');\n"
+        "var invalid; try { JSON.parse('[1, -]'); } catch (e) { invalid = e instanceof SyntaxError; }\n");
+    engine.collectGarbage();
+    QJSValue result = engine.evaluate(
+        "[records[1].b, Object.keys(records[2]).join(), records[3].a, records[3][2], records[3].cA,\n"
+        " Object.keys(big).length, big.k39[1].v, longList.length, longList[199], longList[198],\n"
+        " 1 / numbers[1], numbers[2], numbers[3], numbers[4], numbers[5], invalid]");
+    QVERIFY(!result.isError());
+    QCOMPARE(result.property(0).toString(), QString("y"));
+    QCOMPARE(result.property(1).toString(), QString("b,a"));
+    QCOMPARE(result.property(2).toInt(), 6);
+    QCOMPARE(result.property(3).toString(), QString("two"));
+    QCOMPARE(result.property(4).toInt(), 7);
+    QCOMPARE(result.property(5).toInt(), 40);
+    QCOMPARE(result.property(6).toInt(), 39);
+    QCOMPARE(result.property(7).toInt(), 200);
+    QCOMPARE(result.property(8).toInt(), 199);
+    QCOMPARE(result.property(9).toString(), QString("e198"));
+    QCOMPARE(result.property(10).toNumber(), -qInf());
+    QCOMPARE(result.property(11).toNumber(), 33554432.);
+    QCOMPARE(result.property(12).toNumber(), 1500.);
+    QCOMPARE(result.property(13).toInt(), -12);
+    QCOMPARE(result.property(14).toNumber(), 12345678901.);
+    QVERIFY(result.property(15).toBool());
+
+    // Objects with the same members in the same order get the class that adding the
+    // members one by one would give them.
+    QJSValue shapes = engine.evaluate("var manual = {}; manual.a = 0; manual.b = 0;\n"
+                                      "[records[0], records[1], records[2], manual, big.k0[1], big.k39[1]]");
+    QCOMPARE(internalClass(&engine, shapes.property(0)), internalClass(&engine, shapes.property(1)));
+    QCOMPARE(internalClass(&engine, shapes.property(0)), internalClass(&engine, shapes.property(3)));
+    QVERIFY(internalClass(&engine, shapes.property(0)) != internalClass(&engine, shapes.property(2)));
+    QCOMPARE(internalClass(&engine, shapes.property(4)), internalClass(&engine, shapes.property(5)));
+
+    QCOMPARE(engine.evaluate("JSON.stringify({a: [1, 'q\"\\n', {}], b: undefined, c: {toJSON: function(k) { return k + '!'; }}})").toString(),
+             QString("{\"a\":[1,\"q\\\"\\n\",{}],\"c\":\"c!\"}"));
+    QCOMPARE(engine.evaluate("JSON.stringify({a: [1], b: {}}, null, 2)").toString(),
+             QString("{\n  \"a\": [\n    1\n  ],\n  \"b\": {}\n}"));
+    QCOMPARE(engine.evaluate("JSON.stringify([1, 'x', {a: 2.5}], function(k, v) { return typeof v === 'number' ? v * 10 : v; })").toString(),
+             QString("[10,\"x\",{\"a\":25}]"));
+    QCOMPARE(engine.evaluate("JSON.stringify([function() {}, undefined, 0.1])").toString(), QString("[null,null,0.1]"));
+    QVERIFY(engine.evaluate("JSON.stringify(undefined)").isUndefined());
+}
+
 void tst_QJSEngine::dynamicProperties()
 {
     {
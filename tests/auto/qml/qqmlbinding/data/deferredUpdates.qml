@@ -0,0 +1,10 @@
+import QtQuick 2.0
+
+QtObject {
+    property int a: 1
+    property int b: a * 2
+    property int c: a + b
+
+    property int cChanges: 0
+    onCChanged: cChanges++
+}
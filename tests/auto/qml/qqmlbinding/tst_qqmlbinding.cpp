@@ -42,6 +42,8 @@
 #include <QtQml/qqmlengine.h>
 #include <QtQml/qqmlcomponent.h>
 #include <private/qqmlbind_p.h>
+#include <private/qqmlbinding_p.h>
+#include <private/qqmlengine_p.h>
 #include <QtQuick/private/qquickrectangle_p.h>
 #include "../../shared/util.h"
 
@@ -58,6 +60,7 @@ private slots:
     void restoreBindingWithLoop();
     void restoreBindingWithoutCrash();
     void deletedObject();
+    void deferredUpdates();
 
 private:
     QQmlEngine engine;
@@ -232,6 +235,43 @@ void tst_qqmlbinding::deletedObject()
     delete rect;
 }
 
+void tst_qqmlbinding::deferredUpdates()
+{
+    QQmlEngine engine;
+    QQmlEnginePrivate::get(&engine)->deferredBindingUpdates = true;
+    QQmlComponent c(&engine, testFileUrl("deferredUpdates.qml"));
+    QScopedPointer<QObject> object(c.create());
+    QVERIFY(object != 0);
+    QQmlBinding::flushPendingUpdates();
+    QCOMPARE(object->property("c").toInt(), 3);
+    object->setProperty("cChanges", 0);
+
+    // Changes are coalesced until the queue is flushed
+    object->setProperty("a", 2);
+    object->setProperty("a", 3);
+    QCOMPARE(object->property("b").toInt(), 2);
+    QCOMPARE(object->property("c").toInt(), 3);
+    QCOMPARE(object->property("cChanges").toInt(), 0);
+
+    QQmlBinding::flushPendingUpdates();
+    QCOMPARE(object->property("b").toInt(), 6);
+    QCOMPARE(object->property("c").toInt(), 9);
+    QVERIFY(object->property("cChanges").toInt() <= 2);
+
+    // c is known to depend on b now and is only updated after it
+    object->setProperty("cChanges", 0);
+    object->setProperty("a", 4);
+    object->setProperty("a", 5);
+    QQmlBinding::flushPendingUpdates();
+    QCOMPARE(object->property("c").toInt(), 15);
+    QCOMPARE(object->property("cChanges").toInt(), 1);
+
+    // Without an explicit flush the queue is flushed from the event loop
+    object->setProperty("a", 6);
+    QCOMPARE(object->property("c").toInt(), 15);
+    QTRY_COMPARE(object->property("c").toInt(), 18);
+}
+
 QTEST_MAIN(tst_qqmlbinding)
 
 #include "tst_qqmlbinding.moc"
@@ -0,0 +1,7 @@
+import Qt.test 1.0
+
+ConnectNotifyCounter {
+    property int staticBinding: a * 2 + b
+    property int dynamicBinding: useA ? a + c : c + b
+    property int repeatedBinding: a + a + a
+}
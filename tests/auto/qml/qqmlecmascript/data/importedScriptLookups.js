@@ -0,0 +1,10 @@
+function readRoot() {
+    return root.value
+}
+
+function readChild() {
+    var total = 0;
+    for (var i = 0; i < 10; ++i)
+        total += child.value;
+    return total + Math.max(0, 1)
+}
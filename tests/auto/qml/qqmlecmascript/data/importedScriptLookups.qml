@@ -0,0 +1,12 @@
+import QtQml 2.0
+import "importedScriptLookups.js" as Script
+
+QtObject {
+    id: root
+
+    property int value: 7
+    property QtObject inner: QtObject { id: child; property int value: 3 }
+    property bool test: false
+
+    Component.onCompleted: test = Script.readRoot() == 7 && Script.readChild() == 31
+}
@@ -0,0 +1,82 @@
+import QtQuick 2.0
+import QtQuick 2.0 as Q
+
+Item {
+    id: root
+    width: 10
+    property int result: 0
+
+    Item { id: child; x: 3 }
+
+    function f0() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 0; }
+    function f1() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 1; }
+    function f2() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 2; }
+    function f3() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 3; }
+    function f4() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 4; }
+    function f5() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 5; }
+    function f6() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 6; }
+    function f7() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 7; }
+    function f8() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 8; }
+    function f9() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 9; }
+    function f10() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 10; }
+    function f11() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 11; }
+    function f12() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 12; }
+    function f13() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 13; }
+    function f14() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 14; }
+    function f15() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 15; }
+    function f16() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 16; }
+    function f17() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 17; }
+    function f18() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 18; }
+    function f19() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 19; }
+    function f20() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 20; }
+    function f21() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 21; }
+    function f22() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 22; }
+    function f23() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 23; }
+    function f24() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 24; }
+    function f25() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 25; }
+    function f26() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 26; }
+    function f27() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 27; }
+    function f28() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 28; }
+    function f29() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 29; }
+    function f30() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 30; }
+    function f31() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 31; }
+    function f32() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 32; }
+    function f33() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 33; }
+    function f34() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 34; }
+    function f35() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 35; }
+    function f36() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 36; }
+    function f37() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 37; }
+    function f38() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 38; }
+    function f39() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 39; }
+    function f40() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 40; }
+    function f41() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 41; }
+    function f42() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 42; }
+    function f43() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 43; }
+    function f44() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 44; }
+    function f45() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 45; }
+    function f46() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 46; }
+    function f47() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 47; }
+    function f48() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 48; }
+    function f49() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 49; }
+    function f50() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 50; }
+    function f51() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 51; }
+    function f52() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 52; }
+    function f53() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 53; }
+    function f54() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 54; }
+    function f55() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 55; }
+    function f56() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 56; }
+    function f57() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 57; }
+    function f58() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 58; }
+    function f59() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 59; }
+    function f60() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 60; }
+    function f61() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 61; }
+    function f62() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 62; }
+    function f63() { return root.width + child.x + Text.AlignHCenter + Q.Text.AlignRight + 63; }
+
+    Component.onCompleted: {
+        var sum = 0;
+        for (var i = 0; i < 64; ++i)
+            sum += root["f" + i]();
+        result = sum;
+    }
+}
@@ -0,0 +1,25 @@
+import QtQml 2.0
+
+QtObject {
+    id: root
+
+    property QtObject first: QtObject { property int value: 10 }
+    property QtObject second: QtObject { property int value: 20; property string name: "second" }
+    property var plain: ({ value: 30 })
+    property int bound: first.value + 1
+    property bool test: false
+
+    function read(o) { return o.value }
+    function write(o, v) { o.value = v }
+
+    Component.onCompleted: {
+        var total = 0;
+        for (var i = 0; i < 10; ++i)
+            total += read(first) + read(second) + read(plain);
+        write(first, 11);
+        write(second, 21);
+        write(plain, 31);
+        test = total == 600 && first.value == 11 && second.value == 21 && plain.value == 31
+                && read(root) === undefined && read(first) == 11 && second.name == "second";
+    }
+}
@@ -413,6 +413,7 @@ void registerTypes()
 
     qmlRegisterType<MyDynamicCreationDestructionObject>("Qt.test", 1, 0, "MyDynamicCreationDestructionObject");
     qmlRegisterType<WriteCounter>("Qt.test", 1, 0, "WriteCounter");
+    qmlRegisterType<ConnectNotifyCounter>("Qt.test", 1, 0, "ConnectNotifyCounter");
 
     qmlRegisterType<MySequenceConversionObject>("Qt.test", 1, 0, "MySequenceConversionObject");
 
@@ -1344,6 +1344,47 @@ private:
     int m_count;
 };
 
+class ConnectNotifyCounter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int a READ a WRITE setA NOTIFY aChanged)
+    Q_PROPERTY(int b READ b WRITE setB NOTIFY bChanged)
+    Q_PROPERTY(int c READ c WRITE setC NOTIFY cChanged)
+    Q_PROPERTY(bool useA READ useA WRITE setUseA NOTIFY useAChanged)
+public:
+    ConnectNotifyCounter() : m_a(1), m_b(2), m_c(10), m_useA(true), m_connects(0), m_disconnects(0) {}
+
+    int a() const { return m_a; }
+    void setA(int v) { if (v != m_a) { m_a = v; emit aChanged(); } }
+    int b() const { return m_b; }
+    void setB(int v) { if (v != m_b) { m_b = v; emit bChanged(); } }
+    int c() const { return m_c; }
+    void setC(int v) { if (v != m_c) { m_c = v; emit cChanged(); } }
+    bool useA() const { return m_useA; }
+    void setUseA(bool v) { if (v != m_useA) { m_useA = v; emit useAChanged(); } }
+
+    int connects() const { return m_connects; }
+    int disconnects() const { return m_disconnects; }
+
+signals:
+    void aChanged();
+    void bChanged();
+    void cChanged();
+    void useAChanged();
+
+protected:
+    void connectNotify(const QMetaMethod &) { ++m_connects; }
+    void disconnectNotify(const QMetaMethod &) { ++m_disconnects; }
+
+private:
+    int m_a;
+    int m_b;
+    int m_c;
+    bool m_useA;
+    int m_connects;
+    int m_disconnects;
+};
+
 class MySequenceConversionObject : public QObject
 {
     Q_OBJECT
@@ -324,6 +324,10 @@ private slots:
     void importedScriptsWithoutQmlMode();
     void contextObjectOnLazyBindings();
     void garbageCollectionDuringCreation();
+    void qobjectPropertyLookups();
+    void importedScriptLookups();
+    void bindingDependencyReuse();
+    void parallelFunctionPreparation();
 
 private:
 //    static void propertyVarWeakRefCallback(v8::Persistent<v8::Value> object, void* parameter);
@@ -7659,6 +7663,87 @@ void tst_qqmlecmascript::garbageCollectionDuringCreation()
     QCOMPARE(container->dataChildren.count(), 0);
 }
 
+void tst_qqmlecmascript::qobjectPropertyLookups()
+{
+    QQmlComponent component(&engine, testFileUrl("qobjectPropertyLookups.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY(!object.isNull());
+    QCOMPARE(object->property("test").toBool(), true);
+    QCOMPARE(object->property("bound").toInt(), 12);
+}
+
+void tst_qqmlecmascript::importedScriptLookups()
+{
+    QQmlComponent component(&engine, testFileUrl("importedScriptLookups.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY(!object.isNull());
+    QCOMPARE(object->property("test").toBool(), true);
+}
+
+void tst_qqmlecmascript::bindingDependencyReuse()
+{
+    QQmlComponent component(&engine, testFileUrl("bindingDependencyReuse.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY(!object.isNull());
+    QCOMPARE(object->property("staticBinding").toInt(), 4);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 11);
+    QCOMPARE(object->property("repeatedBinding").toInt(), 3);
+
+    // One guard per distinct dependency of each binding
+    ConnectNotifyCounter *counter = qobject_cast<ConnectNotifyCounter *>(object.data());
+    QVERIFY(counter);
+    QCOMPARE(counter->connects(), 6);
+    QCOMPARE(counter->disconnects(), 0);
+
+    // Bindings whose guards are kept between evaluations keep updating
+    for (int i = 2; i < 5; ++i) {
+        object->setProperty("a", i);
+        QCOMPARE(object->property("staticBinding").toInt(), i * 2 + 2);
+        QCOMPARE(object->property("dynamicBinding").toInt(), i + 10);
+        QCOMPARE(object->property("repeatedBinding").toInt(), i * 3);
+    }
+    object->setProperty("b", 5);
+    QCOMPARE(object->property("staticBinding").toInt(), 13);
+    QCOMPARE(counter->connects(), 6);
+    QCOMPARE(counter->disconnects(), 0);
+
+    // The dependencies of dynamicBinding change and are captured in a different order.
+    // Only the guard of the dependency that was dropped or added is disconnected or connected.
+    object->setProperty("useA", false);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 15);
+    QCOMPARE(counter->connects(), 7);
+    QCOMPARE(counter->disconnects(), 1);
+    object->setProperty("a", 7);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 15);
+    object->setProperty("b", 6);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 16);
+    object->setProperty("useA", true);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 17);
+    QCOMPARE(counter->connects(), 8);
+    QCOMPARE(counter->disconnects(), 2);
+    object->setProperty("c", 20);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 27);
+    object->setProperty("a", 1);
+    QCOMPARE(object->property("dynamicBinding").toInt(), 21);
+}
+
+void tst_qqmlecmascript::parallelFunctionPreparation()
+{
+    // The 64 functions are prepared on several threads, each resolving ids, properties,
+    // enums and import namespaces through the engine's type information.
+    if (QThread::idealThreadCount() < 2)
+        QSKIP("Functions are only prepared in parallel on multi-core machines");
+    if (!qgetenv("QV4_NO_PARALLEL_ISEL").isEmpty())
+        QSKIP("Parallel function preparation is disabled");
+
+    QQmlEngine engine;
+    QQmlComponent component(&engine, testFileUrl("parallelFunctionPreparation.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY2(!object.isNull(), qPrintable(component.errorString()));
+    // Every function returns 10 + 3 + Qt::AlignHCenter + Qt::AlignRight + its index
+    QCOMPARE(object->property("result").toInt(), 64 * 19 + 63 * 64 / 2);
+}
+
 QTEST_MAIN(tst_qqmlecmascript)
 
 #include "tst_qqmlecmascript.moc"
@@ -44,6 +44,7 @@
 #include <qqmlprivate.h>
 #include <qqmlengine.h>
 #include <qqmlcomponent.h>
+#include <QtCore/qthread.h>
 
 #include <private/qqmlmetatype_p.h>
 #include <private/qqmlpropertyvalueinterceptor_p.h>
@@ -70,6 +71,8 @@ private slots:
     void isList();
 
     void defaultObject();
+
+    void lookupDuringRegistration();
 };
 
 class TestType : public QObject
@@ -284,6 +287,49 @@ void tst_qqmlmetatype::compositeType()
     QCOMPARE(type->sourceUrl(), testFileUrl("ImplicitType.qml"));
 }
 
+class TypeLookupThread : public QThread
+{
+public:
+    TypeLookupThread() : failures(0) {}
+
+    void run()
+    {
+        for (int ii = 0; ii < 2000; ++ii) {
+            if (!QQmlMetaType::qmlType(QString("TestType"), QString("Test"), 1, 0))
+                ++failures;
+            if (!QQmlMetaType::qmlType(&TestType::staticMetaObject))
+                ++failures;
+            if (!QQmlMetaType::isModule(QString("Test"), 1, 0))
+                ++failures;
+        }
+    }
+
+    int failures;
+};
+
+void tst_qqmlmetatype::lookupDuringRegistration()
+{
+    QVERIFY(!QQmlMetaType::qmlType(QString("LookupTestType0"), QString("LookupTest"), 1, 0));
+
+    TypeLookupThread threads[4];
+    for (int ii = 0; ii < 4; ++ii)
+        threads[ii].start();
+
+    // Lookups made after a registration see the new type
+    for (int ii = 0; ii < 50; ++ii) {
+        QByteArray name = "LookupTestType" + QByteArray::number(ii);
+        QVERIFY(qmlRegisterType<TestType>("LookupTest", 1, 0, name.constData()) >= 0);
+        QQmlType *type = QQmlMetaType::qmlType(QString::fromLatin1(name), QString("LookupTest"), 1, 0);
+        QVERIFY(type);
+        QCOMPARE(QQmlMetaType::qmlTypeFromIndex(type->index()), type);
+    }
+
+    for (int ii = 0; ii < 4; ++ii) {
+        QVERIFY(threads[ii].wait());
+        QCOMPARE(threads[ii].failures, 0);
+    }
+}
+
 QTEST_MAIN(tst_qqmlmetatype)
 
 #include "tst_qqmlmetatype.moc"
@@ -0,0 +1,42 @@
+import QtQuick 2.0
+
+QtObject {
+    property bool test1: false
+    property int test2: 0
+    property string test3
+    property bool test4: false
+    property bool test5: false
+    property bool test6: false
+    property bool test7: false
+    property bool test8: false
+
+    Component.onCompleted: {
+        Qt.parseJson('{"items": [{"name": "a"}, {"name": "b"}], "count": 2}', function(result, error) {
+            test1 = (error === null);
+            test2 = result.count;
+            test3 = result.items[1].name;
+        });
+        Qt.parseJson('{"items": [', function(result, error) {
+            test4 = (result === undefined) && (error instanceof SyntaxError);
+            test5 = true;
+        });
+        var members = '{"b": 1, "a": 2, "b": 3, "2": "two", "nested": {"z": [1, {"y": null}], "x": true}}';
+        Qt.parseJson(members, function(result, error) {
+            var expected = JSON.parse(members);
+            test6 = error === null && Object.keys(result).join() === Object.keys(expected).join()
+                    && result.b === 3 && Object.keys(result.nested).join() === "z,x"
+                    && JSON.stringify(result) === JSON.stringify(expected);
+        });
+        Qt.parseJson(' "\\u0041\\n" ', function(result, error) {
+            test7 = error === null && result === "A\n";
+        });
+        var trapped = false;
+        Object.defineProperty(Object.prototype, "trap", { set: function(v) { trapped = true; }, configurable: true });
+        Qt.parseJson('{"__proto__": {"polluted": true}, "trap": 5, "0": "zero"}', function(result, error) {
+            delete Object.prototype.trap;
+            test8 = error === null && Object.getPrototypeOf(result) === Object.prototype
+                    && result.polluted === undefined && !trapped
+                    && result.hasOwnProperty("trap") && result.trap === 5 && result[0] === "zero";
+        });
+    }
+}
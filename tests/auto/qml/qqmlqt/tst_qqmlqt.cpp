@@ -99,6 +99,7 @@ private slots:
     void fontFamilies();
     void quit();
     void resolvedUrl();
+    void parseJson();
 
 private:
     QQmlEngine engine;
@@ -924,6 +925,28 @@ void tst_qqmlqt::resolvedUrl()
     delete object;
 }
 
+void tst_qqmlqt::parseJson()
+{
+    QQmlComponent component(&engine, testFileUrl("parseJson.qml"));
+
+    QObject *object = component.create();
+    QVERIFY(object != 0);
+
+    // the callbacks run once the worker thread has parsed the text
+    QTRY_VERIFY(object->property("test5").toBool());
+    QTRY_VERIFY(object->property("test1").toBool());
+    QCOMPARE(object->property("test2").toInt(), 2);
+    QCOMPARE(object->property("test3").toString(), QString("b"));
+    QVERIFY(object->property("test4").toBool());
+    // objects are created like JSON.parse() creates them, not like a QJsonObject
+    QTRY_VERIFY(object->property("test6").toBool());
+    QTRY_VERIFY(object->property("test7").toBool());
+    // members are defined, so neither the prototype nor setters on it are involved
+    QTRY_VERIFY(object->property("test8").toBool());
+
+    delete object;
+}
+
 QTEST_MAIN(tst_qqmlqt)
 
 #include "tst_qqmlqt.moc"
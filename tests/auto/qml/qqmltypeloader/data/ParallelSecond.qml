@@ -0,0 +1,6 @@
+import QtQml 2.0
+
+QtObject {
+    property QtObject nested: ParallelThird {}
+    property int value: nested.value * 10
+}
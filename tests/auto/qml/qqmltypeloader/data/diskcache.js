@@ -0,0 +1,12 @@
+.pragma library
+
+function sum(values) {
+    var total = 0;
+    for (var i = 0; i < values.length; ++i)
+        total += values[i];
+    return total;
+}
+
+function greet(name) {
+    return "hello " + name;
+}
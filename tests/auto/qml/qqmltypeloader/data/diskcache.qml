@@ -0,0 +1,7 @@
+import QtQml 2.0
+import "diskcache.js" as Helper
+
+QtObject {
+    property int result: Helper.sum([5, 10, 27])
+    property string greeting: Helper.greet("cache")
+}
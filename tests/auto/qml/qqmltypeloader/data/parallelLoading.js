@@ -0,0 +1,3 @@
+.pragma library
+
+var offset = 1000;
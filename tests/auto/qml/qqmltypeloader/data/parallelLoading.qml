@@ -0,0 +1,9 @@
+import QtQml 2.0
+import "parallelLoading.js" as Helper
+
+QtObject {
+    property QtObject first: ParallelFirst {}
+    property QtObject second: ParallelSecond {}
+    property QtObject third: ParallelThird {}
+    property int result: first.value + second.value + third.value + Helper.offset
+}
@@ -43,6 +43,14 @@
 #include <QtQml/qqmlengine.h>
 #include <QtQuick/qquickview.h>
 #include <QtQuick/qquickitem.h>
+#include <QtCore/qtemporarydir.h>
+#include <private/qqmldiskcache_p.h>
+#include <private/qqmlengine_p.h>
+#include <private/qv4compileddata_p.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4isel_p.h>
+#include <private/qv8engine_p.h>
+#include <private/qqmlimportindex_p.h>
 #include "../../shared/util.h"
 
 class tst_QQMLTypeLoader : public QQmlDataTest
@@ -51,6 +59,9 @@ class tst_QQMLTypeLoader : public QQmlDataTest
 
 private slots:
     void testLoadComplete();
+    void diskCache();
+    void parallelLoading();
+    void importIndex();
 };
 
 void tst_QQMLTypeLoader::testLoadComplete()
@@ -70,6 +81,138 @@ void tst_QQMLTypeLoader::testLoadComplete()
     delete window;
 }
 
+void tst_QQMLTypeLoader::diskCache()
+{
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheDir.path()));
+
+    // The first run populates the cache, the second one loads from it.
+    for (int run = 0; run < 2; ++run) {
+        QQmlEngine engine;
+        QQmlComponent component(&engine, testFileUrl("diskcache.qml"));
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("result").toInt(), 42);
+        QCOMPARE(object->property("greeting").toString(), QStringLiteral("hello cache"));
+
+        // Only code generated for the interpreter can be cached. By default the
+        // engine interprets everything first, also when the JIT is enabled.
+        QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+        QScopedPointer<QV4::CompiledData::CompilationUnit> loadableUnit(v4->iselFactory->createUnitForLoading());
+        QVERIFY(loadableUnit);
+
+        QQmlDiskCache *diskCache = QQmlEnginePrivate::get(&engine)->typeLoader.diskCache();
+        QVERIFY(diskCache);
+        QVERIFY(QFile::exists(diskCache->cacheFilePath(testFileUrl("diskcache.js"))));
+        QCOMPARE(diskCache->loadCount(), run);
+    }
+
+    qunsetenv("QML_DISK_CACHE_PATH");
+}
+
+void tst_QQMLTypeLoader::parallelLoading()
+{
+    qputenv("QML_TYPELOADER_THREADS", "4");
+
+    {
+        QQmlEngine engine;
+
+        // Local files are prepared on the worker threads, but synchronous loads
+        // still complete before the component constructor returns.
+        QQmlComponent component(&engine, testFileUrl("parallelLoading.qml"));
+        QCOMPARE(component.status(), QQmlComponent::Ready);
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("result").toInt(), 2101);
+
+        QQmlComponent broken(&engine, testFileUrl("parallelLoadingError.qml"));
+        QCOMPARE(broken.status(), QQmlComponent::Error);
+        QVERIFY(broken.errorString().contains(QLatin1String("ParallelBroken unavailable")));
+
+        QQmlComponent asyncComponent(&engine, testFileUrl("parallelLoading.qml"), QQmlComponent::Asynchronous);
+        QTRY_COMPARE(asyncComponent.status(), QQmlComponent::Ready);
+    }
+
+    qunsetenv("QML_TYPELOADER_THREADS");
+}
+
+void tst_QQMLTypeLoader::importIndex()
+{
+    QTemporaryDir cacheDir;
+    QVERIFY(cacheDir.isValid());
+    QTemporaryDir importDir;
+    QVERIFY(importDir.isValid());
+
+    // A nested module, so that installing another version of it doesn't touch
+    // the modification time of the import path itself.
+    QVERIFY(QDir(importDir.path()).mkpath(QStringLiteral("Index/Test")));
+    const QString qmldirPath = importDir.path() + QStringLiteral("/Index/Test/qmldir");
+    QFile qmldir(qmldirPath);
+    QVERIFY(qmldir.open(QIODevice::WriteOnly));
+    qmldir.write("module Index.Test\nIndexItem 1.0 IndexItem.qml\n");
+    qmldir.close();
+    QFile item(importDir.path() + QStringLiteral("/Index/Test/IndexItem.qml"));
+    QVERIFY(item.open(QIODevice::WriteOnly));
+    item.write("import QtQml 2.0\nQtObject { property int value: 7 }\n");
+    item.close();
+
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheDir.path()));
+
+    // The first run writes the index, the second one resolves the import from it.
+    QStringList importPaths;
+    for (int run = 0; run < 2; ++run) {
+        QQmlEngine engine;
+        engine.addImportPath(importDir.path());
+        importPaths = engine.importPathList();
+        QQmlComponent component(&engine);
+        component.setData("import Index.Test 1.0\nIndexItem {}", QUrl());
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("value").toInt(), 7);
+    }
+
+    qunsetenv("QML_DISK_CACHE_PATH");
+
+    const QString uri = QStringLiteral("Index.Test");
+    QString indexedQmldirPath;
+    QString content;
+    {
+        QQmlImportIndex index(cacheDir.path());
+        QVERIFY(QFile::exists(index.indexFilePath(importPaths)));
+        index.setImportPaths(importPaths);
+
+        QVERIFY(index.lookupModule(uri, 1, 0, &indexedQmldirPath));
+        QCOMPARE(QFileInfo(indexedQmldirPath).canonicalFilePath(), QFileInfo(qmldirPath).canonicalFilePath());
+        QVERIFY(index.lookupQmldir(indexedQmldirPath, &content));
+        QVERIFY(content.contains(QLatin1String("IndexItem.qml")));
+    }
+
+    // A better matching qmldir installed later is not shadowed by the entry.
+    const qint64 importDirModified = QFileInfo(importDir.path()).lastModified().toMSecsSinceEpoch();
+    QVERIFY(QDir(importDir.path()).mkpath(QStringLiteral("Index/Test.1.0")));
+    QFile versionedQmldir(importDir.path() + QStringLiteral("/Index/Test.1.0/qmldir"));
+    QVERIFY(versionedQmldir.open(QIODevice::WriteOnly));
+    versionedQmldir.write("module Index.Test\n");
+    versionedQmldir.close();
+    QCOMPARE(QFileInfo(importDir.path()).lastModified().toMSecsSinceEpoch(), importDirModified);
+    {
+        QQmlImportIndex index(cacheDir.path());
+        index.setImportPaths(importPaths);
+        QVERIFY(!index.lookupModule(uri, 1, 0, &indexedQmldirPath));
+        QVERIFY(index.lookupQmldir(indexedQmldirPath, &content));
+    }
+
+    // Entries whose files are gone are not used.
+    QVERIFY(QFile::remove(qmldirPath));
+    {
+        QQmlImportIndex index(cacheDir.path());
+        index.setImportPaths(importPaths);
+        QVERIFY(!index.lookupModule(uri, 1, 0, &indexedQmldirPath));
+        QVERIFY(!index.lookupQmldir(indexedQmldirPath, &content));
+    }
+}
+
 QTEST_MAIN(tst_QQMLTypeLoader)
 
 #include "tst_qqmltypeloader.moc"
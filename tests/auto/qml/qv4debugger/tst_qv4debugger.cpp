@@ -41,6 +41,9 @@
 #include <QtTest/QtTest>
 
 #include <QJSEngine>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
 #include <private/qv4engine_p.h>
 #include <private/qv4debugging_p.h>
 #include <private/qv8engine_p.h>
@@ -168,6 +171,9 @@ public:
     TestAgent()
         : m_wasPaused(false)
         , m_captureContextInfo(false)
+        , m_heapSnapshotChunks(0)
+        , m_heapSnapshotSuccess(false)
+        , m_heapSnapshotSequenceNr(-1)
     {
     }
 
@@ -203,6 +209,24 @@ public:
         Q_UNUSED(requestSequenceNr);
     }
 
+    virtual void heapSnapshotChunk(Debugger *debugger, QByteArray chunk, int requestSequenceNr)
+    {
+        Q_UNUSED(debugger);
+        Q_UNUSED(requestSequenceNr);
+        m_heapSnapshot.append(chunk);
+        ++m_heapSnapshotChunks;
+    }
+
+    virtual void heapSnapshotTaken(Debugger *debugger, bool success, QString fileName,
+                                   int requestSequenceNr)
+    {
+        Q_UNUSED(debugger);
+        Q_UNUSED(fileName);
+        m_heapSnapshotSuccess = success;
+        m_heapSnapshotSequenceNr = requestSequenceNr;
+        emit heapSnapshotFinished();
+    }
+
     int debuggerCount() const { return m_debuggers.count(); }
 
     struct TestBreakPoint
@@ -240,6 +264,10 @@ public:
     QList<QVariantMap> m_capturedArguments;
     QList<QVariantMap> m_capturedLocals;
     QVariant m_thrownValue;
+    QByteArray m_heapSnapshot;
+    int m_heapSnapshotChunks;
+    bool m_heapSnapshotSuccess;
+    int m_heapSnapshotSequenceNr;
 
     // Utility methods:
     void dumpStackTrace() const
@@ -249,6 +277,9 @@ public:
             qDebug("\t%s (%s:%d:%d)", qPrintable(frame.function), qPrintable(frame.source),
                    frame.line, frame.column);
     }
+
+signals:
+    void heapSnapshotFinished();
 };
 
 class tst_qv4debugger : public QObject
@@ -276,6 +307,9 @@ private slots:
     // exceptions:
     void pauseOnThrow();
 
+    // heap snapshots:
+    void heapSnapshotWhileIdle();
+
 private:
     void evaluateJavaScript(const QString &script, const QString &fileName, int lineNumber = 1)
     {
@@ -540,6 +574,30 @@ void tst_qv4debugger::pauseOnThrow()
     QCOMPARE(m_debuggerAgent->m_thrownValue.toString(), QString("hard"));
 }
 
+void tst_qv4debugger::heapSnapshotWhileIdle()
+{
+    QString script =
+            "var kept = [];\n"
+            "for (var i = 0; i < 20000; ++i)\n"
+            "    kept.push({ index: i });\n"
+            "var snapshotHolder = { snapshotValue: 'snapshotString' };\n";
+    evaluateJavaScript(script, "heapSnapshotWhileIdle");
+
+    // The engine's thread is idle in its event loop, the snapshot is taken from there.
+    m_v4->debugger->takeHeapSnapshot(42);
+    QVERIFY(waitForSignal(m_debuggerAgent, SIGNAL(heapSnapshotFinished())));
+    QVERIFY(m_debuggerAgent->m_heapSnapshotSuccess);
+    QCOMPARE(m_debuggerAgent->m_heapSnapshotSequenceNr, 42);
+
+    // It is large enough to be sent in several chunks.
+    QVERIFY(m_debuggerAgent->m_heapSnapshotChunks > 1);
+    QJsonParseError error;
+    QJsonObject snapshot = QJsonDocument::fromJson(m_debuggerAgent->m_heapSnapshot, &error).object();
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QVERIFY(snapshot.value("nodes").toArray().size() > 20000);
+    QVERIFY(snapshot.value("strings").toArray().contains(QStringLiteral("snapshotString")));
+}
+
 QTEST_MAIN(tst_qv4debugger)
 
 #include "tst_qv4debugger.moc"
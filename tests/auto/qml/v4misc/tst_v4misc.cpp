@@ -42,6 +42,10 @@
 #include <qtest.h>
 
 #include <private/qv4ssa_p.h>
+#include <private/qv4codegen_p.h>
+#include <private/qqmljsengine_p.h>
+#include <private/qqmljslexer_p.h>
+#include <private/qqmljsparser_p.h>
 
 class tst_v4misc: public QObject
 {
@@ -53,6 +57,10 @@ private slots:
     void rangeSplitting_1();
     void rangeSplitting_2();
     void rangeSplitting_3();
+
+    void inlining();
+    void loopOptimizations();
+    void scalarReplacement();
 };
 
 QT_BEGIN_NAMESPACE
@@ -62,6 +70,160 @@ QT_END_NAMESPACE
 
 using namespace QT_PREPEND_NAMESPACE(QV4::IR);
 
+// Generates the IR of a JavaScript program.
+static void generateIR(const QString &source, Module *module)
+{
+    QQmlJS::Engine ee;
+    QQmlJS::Lexer lexer(&ee);
+    lexer.setCode(source, /*line*/1, /*qml mode*/false);
+    QQmlJS::Parser parser(&ee);
+    QVERIFY(parser.parseProgram());
+
+    QQmlJS::Codegen cg(/*strict mode*/false);
+    cg.generateFromProgram(QStringLiteral("test.js"), source, QQmlJS::AST::cast<QQmlJS::AST::Program *>(parser.rootNode()),
+                           module, QQmlJS::Codegen::EvalCode);
+    QVERIFY(cg.qmlErrors().isEmpty());
+}
+
+static Function *functionNamed(Module *module, const QString &name)
+{
+    foreach (Function *function, module->functions) {
+        if (function->name && *function->name == name)
+            return function;
+    }
+    return 0;
+}
+
+// Collects the expressions of a function, including the nested ones.
+struct ExpressionCollector: ExprVisitor
+{
+    QVector<Expr *> expressions;
+
+    ExpressionCollector(Function *function)
+    {
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                if (Move *m = s->asMove()) {
+                    collect(m->target);
+                    collect(m->source);
+                } else if (CJump *j = s->asCJump()) {
+                    collect(j->cond);
+                } else if (Exp *e = s->asExp()) {
+                    collect(e->expr);
+                } else if (Ret *r = s->asRet()) {
+                    collect(r->expr);
+                } else if (Phi *phi = s->asPhi()) {
+                    foreach (Expr *e, phi->d->incoming)
+                        collect(e);
+                }
+            }
+        }
+    }
+
+    void collect(Expr *e)
+    {
+        expressions.append(e);
+        e->accept(this);
+    }
+
+    void collect(ExprList *list)
+    {
+        for (; list; list = list->next)
+            collect(list->expr);
+    }
+
+    virtual void visitConst(Const *) {}
+    virtual void visitString(String *) {}
+    virtual void visitRegExp(RegExp *) {}
+    virtual void visitName(Name *) {}
+    virtual void visitTemp(Temp *) {}
+    virtual void visitClosure(Closure *) {}
+    virtual void visitConvert(Convert *e) { collect(e->expr); }
+    virtual void visitUnop(Unop *e) { collect(e->expr); }
+    virtual void visitBinop(Binop *e) { collect(e->left); collect(e->right); }
+    virtual void visitCall(Call *e) { collect(e->base); collect(e->args); }
+    virtual void visitNew(New *e) { collect(e->base); collect(e->args); }
+    virtual void visitSubscript(Subscript *e) { collect(e->base); collect(e->index); }
+    virtual void visitMember(Member *e) { collect(e->base); }
+};
+
+static int binopCount(Function *function, AluOp op)
+{
+    int count = 0;
+    foreach (Expr *e, ExpressionCollector(function).expressions) {
+        if (Binop *b = e->asBinop())
+            count += b->op == op;
+    }
+    return count;
+}
+
+// Counts the calls of a builtin, or of a function by name if builtin is builtin_invalid.
+static int callCount(Function *function, Name::Builtin builtin, const QString &name = QString())
+{
+    int count = 0;
+    foreach (Expr *e, ExpressionCollector(function).expressions) {
+        Call *c = e->asCall();
+        Name *n = c ? c->base->asName() : 0;
+        if (n && n->builtin == builtin && (builtin != Name::builtin_invalid || (n->id && *n->id == name)))
+            ++count;
+    }
+    return count;
+}
+
+// The statement reading a property of the given name, if there is exactly one.
+static Move *propertyRead(Function *function, const QString &name, BasicBlock **block)
+{
+    Move *read = 0;
+    foreach (BasicBlock *bb, function->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        foreach (Stmt *s, bb->statements()) {
+            Move *m = s->asMove();
+            Member *member = m ? m->source->asMember() : 0;
+            if (!member || *member->name != name)
+                continue;
+            if (read)
+                return 0;
+            read = m;
+            *block = bb;
+        }
+    }
+    return read;
+}
+
+static bool isInLoop(BasicBlock *block)
+{
+    QSet<BasicBlock *> seen;
+    QVector<BasicBlock *> worklist = block->out;
+    while (!worklist.isEmpty()) {
+        BasicBlock *bb = worklist.last();
+        worklist.removeLast();
+        if (bb == block)
+            return true;
+        if (seen.contains(bb))
+            continue;
+        seen.insert(bb);
+        worklist += bb->out;
+    }
+    return false;
+}
+
+static bool hasInt32Phi(Function *function)
+{
+    foreach (BasicBlock *bb, function->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        foreach (Stmt *s, bb->statements()) {
+            if (Phi *phi = s->asPhi())
+                if (phi->targetTemp->type == SInt32Type)
+                    return true;
+        }
+    }
+    return false;
+}
+
 void tst_v4misc::initTestCase()
 {
     qt_qhash_seed.store(0);
@@ -152,6 +314,121 @@ void tst_v4misc::rangeSplitting_3()
     QCOMPARE(interval.end(), 71);
 }
 
+void tst_v4misc::inlining()
+{
+    Module module(/*debugMode*/false);
+    generateIR(QStringLiteral(
+            "function clamp(v, lo, hi) { var r = v; if (r < lo) r = lo; if (r > hi) r = hi; return r; }\n"
+            "function run(n) { var s = 0; for (var i = 0; i < n; ++i) s += clamp(i, 2, 5); return s; }\n"
+            "function countDown(n) { return n > 0 ? countDown(n - 1) : 0; }\n"
+            "function shadowed(clamp) { return clamp(1); }\n"), &module);
+    Function *run = functionNamed(&module, QStringLiteral("run"));
+    Function *countDown = functionNamed(&module, QStringLiteral("countDown"));
+    Function *shadowed = functionNamed(&module, QStringLiteral("shadowed"));
+    QVERIFY(run && countDown && shadowed);
+    QCOMPARE(binopCount(run, OpLt), 1);
+    QCOMPARE(binopCount(run, OpGt), 0);
+
+    Inliner(&module).run();
+
+    // The body of clamp() is copied into run(), behind a guard that falls back to the call.
+    QCOMPARE(callCount(run, Name::builtin_is_closure), 1);
+    QCOMPARE(callCount(run, Name::builtin_invalid, QStringLiteral("clamp")), 1);
+    QCOMPARE(binopCount(run, OpLt), 2);
+    QCOMPARE(binopCount(run, OpGt), 1);
+
+    // Recursive calls and calls of a parameter are left alone.
+    QCOMPARE(callCount(countDown, Name::builtin_is_closure), 0);
+    QCOMPARE(callCount(shadowed, Name::builtin_is_closure), 0);
+}
+
+void tst_v4misc::loopOptimizations()
+{
+    Module module(/*debugMode*/false);
+    generateIR(QStringLiteral(
+            "function sum() { var a = [1, 2, 3]; var s = 0; for (var i = 0; i < a.length; ++i) s += a[i]; return s; }\n"
+            "function fill(n) {\n"
+            "    var a = [0, 0, 0];\n"
+            "    a[1] = n;\n"
+            "    var s = 0;\n"
+            "    for (var j = 0; j < a.length; ++j) s += a[j];\n"
+            "    return s;\n"
+            "}\n"
+            "function holes() { var a = [1, , 3]; var s = 0; for (var i = 0; i < a.length; ++i) s += a[i]; return s; }\n"
+            "function pastTheEnd() { var a = [1, 2, 3]; var s = 0; for (var i = 0; i < a.length; ++i) s += a[i + 1]; return s; }\n"
+            "function grow() { var a = [1]; var i = 0; while (i < a.length && i < 10) { a[i + 1] = i; ++i; } return a[0]; }\n"
+            "function escaping(f) { var a = [1, 2]; var s = 0; for (var i = 0; i < a.length; ++i) s += f(a); return s; }\n"), &module);
+    foreach (Function *function, module.functions)
+        Optimizer(function).run(/*qmlEngine*/0);
+
+    // Nothing is stored into the array and every element read is below its length, so its length
+    // is known, and with it the range of the loop counter.
+    Function *sum = functionNamed(&module, QStringLiteral("sum"));
+    QVERIFY(sum);
+    BasicBlock *block = 0;
+    QVERIFY(!propertyRead(sum, QStringLiteral("length"), &block));
+    QVERIFY(hasInt32Phi(sum));
+
+    // An element is overwritten before the loop, which keeps the length of the array.
+    Function *fill = functionNamed(&module, QStringLiteral("fill"));
+    QVERIFY(fill);
+    QVERIFY(propertyRead(fill, QStringLiteral("length"), &block));
+    QVERIFY(!isInLoop(block));
+
+    // Reading a hole, or past the end, runs the indexed accessors on the prototype chain, which
+    // can change the array.
+    Function *holes = functionNamed(&module, QStringLiteral("holes"));
+    QVERIFY(holes);
+    QVERIFY(propertyRead(holes, QStringLiteral("length"), &block));
+    QVERIFY(isInLoop(block));
+    Function *pastTheEnd = functionNamed(&module, QStringLiteral("pastTheEnd"));
+    QVERIFY(pastTheEnd);
+    QVERIFY(propertyRead(pastTheEnd, QStringLiteral("length"), &block));
+    QVERIFY(isInLoop(block));
+
+    // Elements are stored into the array in the loop.
+    Function *grow = functionNamed(&module, QStringLiteral("grow"));
+    QVERIFY(grow);
+    QVERIFY(propertyRead(grow, QStringLiteral("length"), &block));
+    QVERIFY(isInLoop(block));
+
+    // The array is passed to a function, which could change it.
+    Function *escaping = functionNamed(&module, QStringLiteral("escaping"));
+    QVERIFY(escaping);
+    QVERIFY(propertyRead(escaping, QStringLiteral("length"), &block));
+    QVERIFY(isInLoop(block));
+}
+
+void tst_v4misc::scalarReplacement()
+{
+    Module module(/*debugMode*/false);
+    generateIR(QStringLiteral(
+            "function point() { var p = { x: 1, y: 2 }; p.y = 3; return p.x + p.y; }\n"
+            "function pair() { var a = [4, 5]; return a[0] * a[1] + a.length; }\n"
+            "function args(a, b) { return arguments.length + arguments[1]; }\n"
+            "function escaping(f) { var o = { x: 1 }; f(o); return o.x; }\n"
+            "function hole() { var a = [1, , 3]; return a[1]; }\n"), &module);
+    foreach (Function *function, module.functions)
+        Optimizer(function).run(/*qmlEngine*/0);
+
+    Function *point = functionNamed(&module, QStringLiteral("point"));
+    Function *pair = functionNamed(&module, QStringLiteral("pair"));
+    Function *args = functionNamed(&module, QStringLiteral("args"));
+    Function *escaping = functionNamed(&module, QStringLiteral("escaping"));
+    Function *hole = functionNamed(&module, QStringLiteral("hole"));
+    QVERIFY(point && pair && args && escaping && hole);
+
+    // The allocations are gone, their values are used directly.
+    QCOMPARE(callCount(point, Name::builtin_define_object_literal), 0);
+    QCOMPARE(callCount(pair, Name::builtin_define_array), 0);
+    QCOMPARE(callCount(args, Name::builtin_setup_argument_object), 0);
+    QCOMPARE(callCount(args, Name::builtin_argument_count), 1);
+
+    // Passing the object to a function, or reading a hole, which comes from the prototype.
+    QCOMPARE(callCount(escaping, Name::builtin_define_object_literal), 1);
+    QCOMPARE(callCount(hole, Name::builtin_define_array), 1);
+}
+
 QTEST_MAIN(tst_v4misc)
 
 #include "tst_v4misc.moc"
@@ -189,6 +189,16 @@ void QmlProfilerClient::messageReceived(const QByteArray &data)
     } else if (messageType == QQmlProfilerService::Complete) {
         emit complete();
 
+    } else if (messageType == QQmlProfilerService::HeapStatistics) {
+        // not recorded in the trace
+        d->maximumTime = qMax(time, d->maximumTime);
+    } else if (messageType == QQmlProfilerService::JavascriptCallTree) {
+        QString filename;
+        QString function;
+        int depth, lineNumber;
+        double totalTime, selfTime;
+        stream >> depth >> filename >> function >> lineNumber >> totalTime >> selfTime;
+        emit this->callTreeEntry(depth, function, filename, lineNumber, totalTime, selfTime);
     } else {
         int range;
         stream >> range;
@@ -103,6 +103,8 @@ signals:
                const QStringList &data,
                const QmlEventLocation &location);
     void frame(qint64 time, int frameRate, int animationCount, int threadId);
+    void callTreeEntry(int depth, const QString &function, const QString &filename,
+                       int lineNumber, double totalTime, double selfTime);
 
 protected:
     virtual void messageReceived(const QByteArray &);
@@ -59,6 +59,7 @@
 
 #include <private/qabstractanimation_p.h>
 #include <private/qopenglcontext_p.h>
+#include <private/qjsengine_p.h>
 
 #ifdef QT_WIDGETS_LIB
 #include <QtWidgets/QApplication>
@@ -175,6 +176,7 @@ struct Options
     bool multisample;
     bool contextSharing;
     QString translationFile;
+    QString heapSnapshotFile;
 };
 
 #if defined(QMLSCENE_BUNDLE)
@@ -361,6 +363,7 @@ static void usage()
     qWarning("  -I <path> ................................. Add <path> to the list of import paths");
     qWarning("  -B <name> <file> .......................... Add a named bundle");
     qWarning("  -translation <translationfile> ............ Set the language to run in");
+    qWarning("  --heap-snapshot <file> .................... Write a JavaScript heap snapshot to <file> on exit");
 
     qWarning(" ");
     exit(1);
@@ -399,6 +402,8 @@ int main(int argc, char ** argv)
                 options.multisample = true;
             else if (lowerArgument == QLatin1String("--disable-context-sharing"))
                 options.contextSharing = false;
+            else if (lowerArgument == QLatin1String("--heap-snapshot") && i + 1 < argc)
+                options.heapSnapshotFile = QFile::decodeName(argv[++i]);
             else if (lowerArgument == QLatin1String("-i") && i + 1 < argc)
                 imports.append(QString::fromLatin1(argv[++i]));
             else if (lowerArgument == QLatin1String("-b") && i + 2 < argc) {
@@ -550,6 +555,12 @@ int main(int argc, char ** argv)
 #ifdef QML_RUNTIME_TESTING
             RenderStatistics::printTotalStats();
 #endif
+            if (!options.heapSnapshotFile.isEmpty()) {
+                QFile snapshotFile(options.heapSnapshotFile);
+                if (!snapshotFile.open(QIODevice::WriteOnly)
+                        || !QJSEnginePrivate::writeHeapSnapshot(&engine, &snapshotFile))
+                    qWarning("qmlscene: could not write a heap snapshot to %s", qPrintable(options.heapSnapshotFile));
+            }
             // Ready to exit. Notice that the component might be owned by
             // QQuickView if one was created. That case is tracked by
             // QPointer, so it is safe to delete the component here.